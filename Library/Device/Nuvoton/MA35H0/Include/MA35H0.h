@@ -564,6 +564,7 @@ int  sysIsKbHit(void);
 /*                         Peripheral header files                            */
 /******************************************************************************/
 #include "adc.h"
+#include "boottime.h"
 #include "canfd.h"
 #include "clk.h"
 #include "crypto.h"
@@ -0,0 +1,140 @@
+/**************************************************************************//**
+ * @file     boottime.h
+ * @brief    Boot stage time stamp log header file
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __BOOTTIME_H__
+#define __BOOTTIME_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup BOOTTIME_Driver BOOTTIME Driver
+  @{
+*/
+
+/** @addtogroup BOOTTIME_EXPORTED_CONSTANTS BOOTTIME Exported Constants
+  @{
+*/
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Boot Time Log Constant Definitions                                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+/* The log is kept in the last 4 KB of SRAM1. The Loader leaves this part out of its link map and the
+   applications run from DDR, so the marks of the Loader are still there after the jump to the application. */
+#ifndef BOOTTIME_BASE
+#define BOOTTIME_BASE           (SRAM1_BASE + 0x3F000UL)   /*!< Boot time log address \hideinitializer */
+#endif
+#define BOOTTIME_MAGIC          (0x454D4954UL)      /*!< "TIME", log is valid \hideinitializer */
+#define BOOTTIME_MAX_MARKS      (32UL)              /*!< Number of stage marks the log holds \hideinitializer */
+#define BOOTTIME_NAME_LEN       (16UL)              /*!< Stage name length, including the terminating zero \hideinitializer */
+#define BOOTTIME_TICKS_PER_US   (12UL)              /*!< Generic timer counter runs at 12 MHz \hideinitializer */
+
+/*! @}*/ /* end of group BOOTTIME_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup BOOTTIME_EXPORTED_STRUCTS BOOTTIME Exported Structs
+  @{
+*/
+
+typedef struct
+{
+    char        acName[BOOTTIME_NAME_LEN];  /*!< Stage name */
+    uint64_t    u64Time;                    /*!< Physical counter value when the stage is reached */
+} BOOTTIME_MARK_T;
+
+typedef struct
+{
+    uint32_t        u32Magic;               /*!< BOOTTIME_MAGIC when the log is valid */
+    uint32_t        u32Count;               /*!< Number of marks in the log */
+    uint32_t        u32Dropped;             /*!< Marks lost because the log is full */
+    uint32_t        u32Reserved;
+    BOOTTIME_MARK_T asMark[BOOTTIME_MAX_MARKS];
+} BOOTTIME_LOG_T;
+
+#define BOOTTIME_LOG            ((BOOTTIME_LOG_T *)(uint64_t)BOOTTIME_BASE)    /*!< Boot time log \hideinitializer */
+
+/*! @}*/ /* end of group BOOTTIME_EXPORTED_STRUCTS */
+
+
+/** @addtogroup BOOTTIME_EXPORTED_FUNCTIONS BOOTTIME Exported Functions
+  @{
+*/
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* static inline functions                                                                                 */
+/*---------------------------------------------------------------------------------------------------------*/
+/* The Loader does not link the driver library, so the functions that record marks are inline. Only byte
+   and aligned accesses are used, the Loader runs with MMU off and the application maps SRAM as device. */
+__STATIC_INLINE void BOOTTIME_Start(void);
+__STATIC_INLINE void BOOTTIME_Mark(const char *pcName);
+
+/**
+  * @brief      Start a new boot time log
+  *
+  * @details    Clear the log in SRAM. Called once by the first stage that keeps a log, the Loader.
+  */
+__STATIC_INLINE void BOOTTIME_Start(void)
+{
+    BOOTTIME_LOG->u32Count = 0UL;
+    BOOTTIME_LOG->u32Dropped = 0UL;
+    BOOTTIME_LOG->u32Magic = BOOTTIME_MAGIC;
+}
+
+/**
+  * @brief      Record a boot stage
+  *
+  * @param[in]  pcName  Stage name. Only the first \ref BOOTTIME_NAME_LEN - 1 characters are kept.
+  *
+  * @details    Save the physical counter value with the stage name. Nothing is recorded if no log was
+  *             started, for example when the application is run from a debugger.
+  */
+__STATIC_INLINE void BOOTTIME_Mark(const char *pcName)
+{
+    BOOTTIME_LOG_T *psLog = BOOTTIME_LOG;
+    BOOTTIME_MARK_T *psMark;
+    uint64_t u64Time = EL0_GetCurrentPhysicalValue();
+    uint32_t i;
+
+    if (psLog->u32Magic != BOOTTIME_MAGIC)
+        return;
+    if (psLog->u32Count >= BOOTTIME_MAX_MARKS)
+    {
+        psLog->u32Dropped++;
+        return;
+    }
+
+    psMark = &psLog->asMark[psLog->u32Count];
+    for (i = 0UL; (i < BOOTTIME_NAME_LEN - 1UL) && (pcName[i] != '\0'); i++)
+        psMark->acName[i] = pcName[i];
+    psMark->acName[i] = '\0';
+    psMark->u64Time = u64Time;
+    psLog->u32Count++;
+}
+
+int32_t  BOOTTIME_IsValid(void);
+uint32_t BOOTTIME_GetStageTime(const char *pcName);
+uint32_t BOOTTIME_GetTotalTime(void);
+void     BOOTTIME_Print(void);
+int32_t  BOOTTIME_CheckBudget(uint32_t u32BudgetUs);
+
+/*! @}*/ /* end of group BOOTTIME_EXPORTED_FUNCTIONS */
+
+/*! @}*/ /* end of group BOOTTIME_Driver */
+
+/*! @}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOTTIME_H__ */
@@ -94,6 +94,44 @@ extern "C"
 #define CRYPTO_DMA_CONTINUE     0x6UL   /*!< MA35 continuous encrypt/decrypt in DMA cascade \hideinitializer */
 #define CRYPTO_DMA_LAST         0x7UL   /*!< MA35 last encrypt/decrypt in DMA cascade          \hideinitializer */
 
+#define CRYPTO_EVT_PRNG         (1UL << 0)  /*!< PRNG key generated                  \hideinitializer */
+#define CRYPTO_EVT_AES          (1UL << 1)  /*!< AES DMA transfer done               \hideinitializer */
+#define CRYPTO_EVT_AES_ERR      (1UL << 2)  /*!< AES error                           \hideinitializer */
+#define CRYPTO_EVT_SHA          (1UL << 3)  /*!< SHA/HMAC DMA transfer done          \hideinitializer */
+#define CRYPTO_EVT_SHA_ERR      (1UL << 4)  /*!< SHA/HMAC error                      \hideinitializer */
+#define CRYPTO_EVT_ECC          (1UL << 5)  /*!< ECC operation done                  \hideinitializer */
+
+/*! Completion callback, called from CRYPTO_IRQHandler() with CRYPTO_EVT_xxx flags */
+typedef void (*CRYPTO_CALLBACK_T)(uint32_t u32Events);
+
+#define CRYPTO_AES_FDBCK_SIZE   64UL    /*!< AES_RunSG() feedback buffer size, whole cache lines   \hideinitializer */
+#define CRYPTO_SHA_FDBCK_SIZE   384UL   /*!< SHA_RunSG() feedback buffer size, whole cache lines   \hideinitializer */
+
+/*! One buffer of a scatter-gather list for AES_RunSG() and SHA_RunSG() */
+typedef struct
+{
+	const void  *pvSrc;     /*!< Source address, below 4 GB              */
+	void        *pvDst;     /*!< AES destination address, may be pvSrc   */
+	uint32_t    u32Len;     /*!< Byte count                              */
+} CRYPTO_SG_T;
+
+/*! AES stream state for AES_SaveContext() and AES_RestoreContext(), register keys only */
+typedef struct
+{
+	uint32_t  au32Fdbck[CRYPTO_AES_FDBCK_SIZE / 4] __attribute__((aligned(64))); /*!< AES_RunSG() feedback buffer */
+	uint32_t  u32Ctl;       /*!< AES_Open() settings   */
+	uint32_t  au32Key[8];   /*!< Key                   */
+	uint32_t  au32IV[4];    /*!< Initial vector        */
+} CRYPTO_AES_CTX_T;
+
+/*! SHA/HMAC stream state for SHA_SaveContext() and SHA_RestoreContext() */
+typedef struct
+{
+	uint32_t  au32Fdbck[CRYPTO_SHA_FDBCK_SIZE / 4] __attribute__((aligned(64))); /*!< SHA_RunSG() feedback buffer */
+	uint32_t  u32Ctl;       /*!< SHA_Open() settings   */
+	uint32_t  u32KeyCnt;    /*!< HMAC key byte count   */
+} CRYPTO_SHA_CTX_T;
+
 /*! ECC curve   */
 typedef enum
 {
@@ -125,6 +163,19 @@ typedef enum
 }
 E_ECC_CURVE;                            /*!< ECC curve                \hideinitializer */
 
+/*! One signature of ECC_VerifyBatch_Bin() */
+typedef struct
+{
+	const uint8_t  *pu8Msg;     /*!< Message hashed on the SHA engine, below 4 GB; NULL to use pu8Hash */
+	uint32_t       u32MsgLen;   /*!< Message byte count, 0 for the empty message                       */
+	const uint8_t  *pu8Hash;    /*!< Hash already truncated to ECC_CurveBytes(), if pu8Msg is NULL     */
+	const uint8_t  *pu8PubX;    /*!< Public key X                                                      */
+	const uint8_t  *pu8PubY;    /*!< Public key Y                                                      */
+	const uint8_t  *pu8R;       /*!< Signature R                                                       */
+	const uint8_t  *pu8S;       /*!< Signature S                                                       */
+	int32_t        i32Result;   /*!< 0: valid, -2: verification failed, -1: hash or engine error       */
+} ECC_VERIFY_ITEM_T;
+
 /*! @}*/ /* end of group CRYPTO_EXPORTED_CONSTANTS */
 
 /** @addtogroup CRYPTO_EXPORTED_MACROS CRYPTO Exported Macros
@@ -300,27 +351,45 @@ E_ECC_CURVE;                            /*!< ECC curve                \hideiniti
 /*---------------------------------------------------------------------------------------------------------*/
 
 void Crypto_Init(void);
+CRYPTO_CALLBACK_T CRYPTO_SetCallback(CRYPTO_CALLBACK_T pfnCallback);
 void PRNG_Config(CRPT_T *crpt, uint32_t u32KeySize, uint32_t u32SeedReload, uint32_t u32Seed);
 int  PRNG_Start(CRPT_T *crpt);
 void PRNG_Read(CRPT_T *crpt, uint32_t u32RandKey[]);
 int  PRNG_ReSeed(CRPT_T *crpt, uint32_t u32Seed);
 void AES_Open(CRPT_T *crpt, uint32_t u32EncDec, uint32_t u32OpMode, uint32_t u32KeySize, uint32_t u32SwapType);
 int  AES_Start(CRPT_T *crpt, int is_sm4, uint32_t u32DMAMode);
+void AES_Trigger(CRPT_T *crpt, int is_sm4, uint32_t u32DMAMode);
 void AES_SetKey(CRPT_T *crpt, uint32_t au32Keys[], uint32_t u32KeySize);
 void AES_SetInitVect(CRPT_T *crpt, uint32_t au32IV[]);
 void AES_SetDMATransfer(CRPT_T *crpt, uint32_t u32FBIAddr, uint32_t u32FBOAddr, uint32_t u32SrcAddr, uint32_t u32DstAddr, uint32_t u32TransCnt);
 void SHA_Open(CRPT_T *crpt, uint32_t u32OpMode, uint32_t u32SwapType, uint32_t hmac_key_len);
 int  SHA_Start(CRPT_T *crpt, uint32_t u32DMAMode);
+void SHA_Trigger(CRPT_T *crpt, uint32_t u32DMAMode);
+int  SHA_Wait(CRPT_T *crpt);
 void SHA_SetDMATransfer(CRPT_T *crpt, uint32_t u32SrcAddr, uint32_t u32TransCnt);
 void SHA_Read(CRPT_T *crpt, uint32_t u32Digest[]);
+int  AES_RunSG(CRPT_T *crpt, int is_sm4, const CRYPTO_SG_T sg[], int nseg, uint32_t u32DMAMode, void *fdbck);
+int  SHA_RunSG(CRPT_T *crpt, const CRYPTO_SG_T sg[], int nseg, uint32_t u32DMAMode, void *fdbck);
+int  AES_SaveContext(CRPT_T *crpt, CRYPTO_AES_CTX_T *ctx);
+void AES_RestoreContext(CRPT_T *crpt, const CRYPTO_AES_CTX_T *ctx);
+void SHA_SaveContext(CRPT_T *crpt, CRYPTO_SHA_CTX_T *ctx);
+void SHA_RestoreContext(CRPT_T *crpt, const CRYPTO_SHA_CTX_T *ctx);
 int ECC_IsPrivateKeyValid(CRPT_T *crpt, E_ECC_CURVE ecc_curve,  char private_k[]);
 int ECC_GeneratePublicKey(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, char public_k1[], char public_k2[]);
 int ECC_Mutiply(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char x1[], char y1[], char *k, char x2[], char y2[]);
 int ECC_GenerateSecretZ(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, char public_k1[], char public_k2[], char secret_z[]);
 int ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message, char *d, char *k, char *R, char *S);
 int ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message, char *public_k1, char *public_k2, char *R, char *S);
+int ECC_CurveBytes(E_ECC_CURVE ecc_curve);
+int ECC_GeneratePublicKey_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t private_k[], uint8_t public_x[], uint8_t public_y[]);
+int ECC_Mutiply_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t x1[], const uint8_t y1[], const uint8_t k[], uint8_t x2[], uint8_t y2[]);
+int ECC_GenerateSecretZ_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t private_k[], const uint8_t public_x[], const uint8_t public_y[], uint8_t secret_z[]);
+int ECC_GenerateSignature_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t message[], const uint8_t d[], const uint8_t k[], uint8_t R[], uint8_t S[]);
+int ECC_VerifySignature_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t message[], const uint8_t public_x[], const uint8_t public_y[], const uint8_t R[], const uint8_t S[]);
+int ECC_VerifyBatch_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, uint32_t u32ShaMode, ECC_VERIFY_ITEM_T items[], int count);
 
 int AES_Start_KS(CRPT_T *crpt, uint32_t u32DMAMode, int ksel, int knum);
+void AES_Trigger_KS(CRPT_T *crpt, uint32_t u32DMAMode, int ksel, int knum);
 int ECC_Write_N(CRPT_T *crpt, E_ECC_CURVE ecc_curve);
 int ECC_GeneratePublicKey_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, int k_ksnum, int is_ecdh, char public_k1[], char public_k2[]);
 int ECC_Mutiply_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, int x1_ksnum, char x1[], int y1_ksnum, char y1[], int k_ksnum, char *k, char x2[], char y2[]);
@@ -331,6 +400,8 @@ int ECC_VerifySignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message, i
 void Hex2Reg(char input[], uint32_t volatile reg[]);
 void Reg2Hex(int count, uint32_t volatile reg[], char output[]);
 void Hex2RegEx(char input[], uint32_t volatile reg[], int shift);
+void Bin2Reg(const uint8_t input[], int len, uint32_t volatile reg[]);
+void Reg2Bin(int len, uint32_t volatile reg[], uint8_t output[]);
 
 /*@}*/ /* end of group CRYPTO_EXPORTED_FUNCTIONS */
 
@@ -512,6 +512,8 @@ struct sk_buff {
     unsigned int len;
     unsigned int volatile rdy;
     void *pData;
+    unsigned int ts_sec;     /* receive timestamp seconds, 0 if not captured  */
+    unsigned int ts_subsec;  /* receive timestamp sub-seconds                 */
 };
 
 struct net_device_stats {
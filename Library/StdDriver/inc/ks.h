@@ -32,6 +32,10 @@ extern "C"
 #define KS_SRAM_KEY_CNT     (32)   /*!< Maximum SRAM key count of Key Store */
 #define KS_OTP_KEY_CNT      (9)    /*!< Maximum OTP key count of Key Store */
 
+#ifndef KS_HANDLE_CNT
+#define KS_HANDLE_CNT       (64)   /*!< Maximum logical key count of the key handle manager */
+#endif
+
 #define KS_TOMETAKEY(x)     (((x) << KS_METADATA_NUMBER_Pos) & KS_METADATA_NUMBER_Msk) /*!< translate key number to meta data */
 #define KS_TOKEYIDX(x)      (((x) & KS_METADATA_NUMBER_Msk) >> KS_METADATA_NUMBER_Pos) /*!< get key number from meta data */
 
@@ -105,6 +109,17 @@ int32_t KS_RevokeKey(KS_MEM_Type eType, int32_t i32KeyIdx);
 int KS_GetSRAMRemain(uint32_t *bcnt, uint32_t *kcnt);
 int32_t KS_WriteOTP(int32_t i32KeyIdx, uint32_t u32Meta, uint32_t au32Key[]);
 int32_t KS_TrigReman(void);
+int32_t KS_AddKey(uint32_t u32Meta, uint32_t au32Key[]);
+int32_t KS_RemoveKey(int32_t i32Handle);
+int32_t KS_UseKey(int32_t i32Handle);
+int32_t KS_UseKeys(const int32_t ai32Handle[], int32_t ai32KeyIdx[], int32_t i32Cnt);
+int AES_Start_KSH(CRPT_T *crpt, uint32_t u32DMAMode, int32_t i32Handle);
+int ECC_GenerateSignature_KSH(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
+							  int32_t d_handle, int32_t k_handle, char *R, char *S);
+int ECC_VerifySignature_KSH(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
+							int32_t x_handle, int32_t y_handle, char *R, char *S);
+int ECC_GenerateSecretZ_KSH(CRPT_T *crpt, E_ECC_CURVE ecc_curve, int32_t k_handle,
+							char public_x[], char public_y[], char secret_z[]);
 
 /*! @}*/ /* end of group TRNG_EXPORTED_FUNCTIONS */
 /*! @}*/ /* end of group KS_Driver */
@@ -0,0 +1,137 @@
+/**************************************************************************//**
+ * @file     boottime.c
+ * @brief    Boot stage time stamp log source file
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "NuMicro.h"
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup BOOTTIME_Driver BOOTTIME Driver
+  @{
+*/
+
+/** @addtogroup BOOTTIME_EXPORTED_FUNCTIONS BOOTTIME Exported Functions
+  @{
+*/
+
+/**
+  * @brief      Check the boot time log
+  *
+  * @retval     1   The log was started by an earlier boot stage.
+  * @retval     0   No log, for example the application was not started by the Loader.
+  */
+int32_t BOOTTIME_IsValid(void)
+{
+    return ((BOOTTIME_LOG->u32Magic == BOOTTIME_MAGIC) && (BOOTTIME_LOG->u32Count <= BOOTTIME_MAX_MARKS)) ? 1 : 0;
+}
+
+/**
+  * @brief      Get the time a stage was reached
+  *
+  * @param[in]  pcName  Stage name given to \ref BOOTTIME_Mark.
+  *
+  * @return     Microseconds from power on to the first mark of the stage, or 0xFFFFFFFF if it is not in the log.
+  */
+uint32_t BOOTTIME_GetStageTime(const char *pcName)
+{
+    BOOTTIME_MARK_T *psMark;
+    uint32_t i, j;
+
+    if (!BOOTTIME_IsValid())
+        return 0xFFFFFFFFUL;
+
+    for (i = 0UL; i < BOOTTIME_LOG->u32Count; i++)
+    {
+        psMark = &BOOTTIME_LOG->asMark[i];
+        /* names longer than the log keeps are matched on the saved part */
+        for (j = 0UL; j < BOOTTIME_NAME_LEN - 1UL; j++)
+        {
+            if ((psMark->acName[j] != pcName[j]) || (pcName[j] == '\0'))
+                break;
+        }
+        if ((j == BOOTTIME_NAME_LEN - 1UL) || ((psMark->acName[j] == '\0') && (pcName[j] == '\0')))
+            return (uint32_t)(psMark->u64Time / BOOTTIME_TICKS_PER_US);
+    }
+    return 0xFFFFFFFFUL;
+}
+
+/**
+  * @brief      Get the boot time so far
+  *
+  * @return     Microseconds from power on to the last mark, or 0 if there is no log.
+  */
+uint32_t BOOTTIME_GetTotalTime(void)
+{
+    if (!BOOTTIME_IsValid() || (BOOTTIME_LOG->u32Count == 0UL))
+        return 0UL;
+
+    return (uint32_t)(BOOTTIME_LOG->asMark[BOOTTIME_LOG->u32Count - 1UL].u64Time / BOOTTIME_TICKS_PER_US);
+}
+
+/**
+  * @brief      Print the boot time log
+  *
+  * @details    Each stage is printed with the time from power on and the time from the stage before it,
+  *             both in microseconds.
+  */
+void BOOTTIME_Print(void)
+{
+    BOOTTIME_MARK_T *psMark;
+    uint64_t u64Prev = 0ULL;
+    uint32_t i;
+
+    if (!BOOTTIME_IsValid())
+    {
+        sysprintf("No boot time log.\n");
+        return;
+    }
+
+    sysprintf("%-16s %10s %10s\n", "stage", "at(us)", "delta(us)");
+    for (i = 0UL; i < BOOTTIME_LOG->u32Count; i++)
+    {
+        psMark = &BOOTTIME_LOG->asMark[i];
+        sysprintf("%-16s %10u %10u\n", psMark->acName,
+                  (uint32_t)(psMark->u64Time / BOOTTIME_TICKS_PER_US),
+                  (uint32_t)((psMark->u64Time - u64Prev) / BOOTTIME_TICKS_PER_US));
+        u64Prev = psMark->u64Time;
+    }
+    if (BOOTTIME_LOG->u32Dropped)
+        sysprintf("%u marks dropped, log full\n", BOOTTIME_LOG->u32Dropped);
+}
+
+/**
+  * @brief      Check the boot time against a budget
+  *
+  * @param[in]  u32BudgetUs  Time allowed from power on to the last mark, in microseconds.
+  *
+  * @retval     0   Within the budget.
+  * @retval     -1  Over the budget, or there is no log to check.
+  */
+int32_t BOOTTIME_CheckBudget(uint32_t u32BudgetUs)
+{
+    uint32_t u32Total = BOOTTIME_GetTotalTime();
+
+    if (u32Total == 0UL)
+    {
+        sysprintf("Boot time unknown, budget %u us\n", u32BudgetUs);
+        return -1;
+    }
+    if (u32Total > u32BudgetUs)
+    {
+        sysprintf("Boot time %u us is over the budget %u us!\n", u32Total, u32BudgetUs);
+        return -1;
+    }
+    return 0;
+}
+
+/*! @}*/ /* end of group BOOTTIME_EXPORTED_FUNCTIONS */
+
+/*! @}*/ /* end of group BOOTTIME_Driver */
+
+/*! @}*/ /* end of group Standard_Driver */
@@ -48,14 +48,18 @@ static int  get_nibble_value(char c);
 
 volatile int  g_PRNG_done, g_AES_done, g_AESERR_done;
 static volatile int g_HMAC_error, g_HMAC_done;
+static CRYPTO_CALLBACK_T g_pfnCallback;
 
 static void ECC_Complete(CRPT_T *crpt);
 
 void CRYPTO_IRQHandler(void)
 {
+	uint32_t u32Events = 0;
+
 	if (PRNG_GET_INT_FLAG(CRPT))
 	{
 		g_PRNG_done = 1;
+		u32Events |= CRYPTO_EVT_PRNG;
 		PRNG_CLR_INT_FLAG(CRPT);
 	}
 	if (CRPT->INTSTS & CRPT_INTSTS_AESEIF_Msk)
@@ -65,10 +69,12 @@ void CRYPTO_IRQHandler(void)
 		{
 			sysprintf("    Not an error. AES_CNT is not multiple of 16.\n");
 			g_AES_done = 1;
+			u32Events |= CRYPTO_EVT_AES;
 		}
 		else
 		{
 			g_AESERR_done = 1;
+			u32Events |= CRYPTO_EVT_AES_ERR;
 		}
 		CRPT->INTSTS = CRPT_INTSTS_AESEIF_Msk;
 	}
@@ -76,21 +82,29 @@ void CRYPTO_IRQHandler(void)
 	{
 		// sysprintf("AESIF!\n");
 		g_AES_done = 1;
+		u32Events |= CRYPTO_EVT_AES;
 		CRPT->INTSTS = CRPT_INTSTS_AESIF_Msk;
 	}
 	if (CRPT->INTSTS & CRPT_INTSTS_HMACEIF_Msk)
 	{
 		// sysprintf("SHAERRIF is set!!\n");
 		g_HMAC_error = 1;
+		u32Events |= CRYPTO_EVT_SHA_ERR;
 		CRPT->INTSTS = CRPT_INTSTS_HMACEIF_Msk;
 	}
 	if (CRPT->INTSTS & CRPT_INTSTS_HMACIF_Msk)
 	{
 		g_HMAC_done = 1;
+		u32Events |= CRYPTO_EVT_SHA;
 		CRPT->INTSTS = CRPT_INTSTS_HMACIF_Msk;
 	}
+	if (CRPT->INTSTS & CRPT_INTSTS_ECCIF_Msk)
+		u32Events |= CRYPTO_EVT_ECC;
 
 	ECC_Complete(CRPT);
+
+	if ((g_pfnCallback != NULL) && (u32Events != 0))
+		g_pfnCallback(u32Events);
 }
 
 /** @endcond HIDDEN_SYMBOLS */
@@ -112,6 +126,24 @@ void Crypto_Init(void)
 	ECC_ENABLE_INT(CRPT);
 }
 
+/**
+  * @brief  Install a completion callback
+  * @param[in]  pfnCallback  Called from CRYPTO_IRQHandler() with the CRYPTO_EVT_xxx flags
+  *                          of the interrupts just handled, NULL to remove.
+  * @return The callback installed before, NULL if none.
+  * @details  Lets an application start a job with AES_Trigger(), AES_Trigger_KS() or
+  *           SHA_Trigger() and be told when it is done instead of polling.
+  *           A module that shares the engine with others keeps the returned callback
+  *           and passes every event on to it.
+  */
+CRYPTO_CALLBACK_T CRYPTO_SetCallback(CRYPTO_CALLBACK_T pfnCallback)
+{
+	CRYPTO_CALLBACK_T pfnPrev = g_pfnCallback;
+
+	g_pfnCallback = pfnCallback;
+	return pfnPrev;
+}
+
 /**
   * @brief  Configure PRNG function
   * @param[in]  crpt   Reference to Crypto module.
@@ -257,13 +289,7 @@ int AES_Start(CRPT_T *crpt, int is_sm4, uint32_t u32DMAMode)
 {
 	uint64_t t0;
 
-	crpt->AES_CTL = g_AES_CTL;
-	if (is_sm4)
-		crpt->AES_CTL |= CRPT_AES_CTL_SM4EN_Msk;
-
-	g_AES_done = g_AESERR_done = 0;
-	__DSB();
-	crpt->AES_CTL |= CRPT_AES_CTL_START_Msk | (u32DMAMode << CRPT_AES_CTL_DMALAST_Pos);
+	AES_Trigger(crpt, is_sm4, u32DMAMode);
 
 	t0 = EL0_GetCurrentPhysicalValue();
 	while (!g_AES_done && !g_AESERR_done)
@@ -274,6 +300,27 @@ int AES_Start(CRPT_T *crpt, int is_sm4, uint32_t u32DMAMode)
 	return 0;
 }
 
+/**
+  * @brief  Start AES encrypt/decrypt without waiting for it to finish
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  is_sm4      1 for SM4, 0 for AES
+  * @param[in]  u32DMAMode  AES DMA control, see AES_Start().
+  * @return None
+  * @details  Completion is reported to the callback installed by CRYPTO_SetCallback()
+  *           with CRYPTO_EVT_AES or CRYPTO_EVT_AES_ERR.
+  */
+void AES_Trigger(CRPT_T *crpt, int is_sm4, uint32_t u32DMAMode)
+{
+	crpt->AES_KSCTL = 0;     /* key from AES_SetKey(), not left over from AES_Start_KS() */
+	crpt->AES_CTL = g_AES_CTL;
+	if (is_sm4)
+		crpt->AES_CTL |= CRPT_AES_CTL_SM4EN_Msk;
+
+	g_AES_done = g_AESERR_done = 0;
+	__DSB();
+	crpt->AES_CTL |= CRPT_AES_CTL_START_Msk | (u32DMAMode << CRPT_AES_CTL_DMALAST_Pos);
+}
+
 /**
   * @brief  Start AES encrypt/decrypt
   * @param[in]  crpt        Reference to Crypto module.
@@ -291,6 +338,28 @@ int AES_Start_KS(CRPT_T *crpt, uint32_t u32DMAMode, int ksel, int knum)
 {
 	uint64_t t0;
 
+	AES_Trigger_KS(crpt, u32DMAMode, ksel, knum);
+
+	t0 = EL0_GetCurrentPhysicalValue();
+	while (!g_AES_done && !g_AESERR_done)
+	{
+		if (EL0_GetCurrentPhysicalValue() - t0 > 12000000)  /* 1 second timeout */
+			return -1;
+	}
+	return 0;
+}
+
+/**
+  * @brief  Start AES encrypt/decrypt with a Key Store key without waiting for it to finish
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  u32DMAMode  AES DMA control, see AES_Start_KS().
+  * @param[in]  ksel        0: key from Key Store SRAM, 2: key from Key Store OTP
+  * @param[in]  knum        Key Store key number
+  * @return None
+  * @details  Completion is reported as for AES_Trigger().
+  */
+void AES_Trigger_KS(CRPT_T *crpt, uint32_t u32DMAMode, int ksel, int knum)
+{
 	if (ksel == 0)
 		CRPT->AES_KSCTL = CRPT_AES_KSCTL_RSRC_Msk | knum;     /* from KS SRAM */
 	else
@@ -300,14 +369,6 @@ int AES_Start_KS(CRPT_T *crpt, uint32_t u32DMAMode, int ksel, int knum)
 	g_AES_done = g_AESERR_done = 0;
 	__DSB();
 	crpt->AES_CTL |= CRPT_AES_CTL_START_Msk | (u32DMAMode << CRPT_AES_CTL_DMALAST_Pos);
-
-	t0 = EL0_GetCurrentPhysicalValue();
-	while (!g_AES_done && !g_AESERR_done)
-	{
-		if (EL0_GetCurrentPhysicalValue() - t0 > 12000000)  /* 1 second timeout */
-			return -1;
-	}
-	return 0;
 }
 
 /**
@@ -428,11 +489,48 @@ int SHA_Start(CRPT_T *crpt, uint32_t u32DMAMode)
 {
 	uint64_t t0;
 
+	SHA_Trigger(crpt, u32DMAMode);
+
+	t0 = EL0_GetCurrentPhysicalValue();
+	while (!g_HMAC_done && !g_HMAC_error)
+	{
+		if (EL0_GetCurrentPhysicalValue() - t0 > 12000000)  /* 1 second timeout */
+			return -1;
+	}
+	return 0;
+}
+
+/**
+  * @brief  Start SHA encrypt without waiting for it to finish
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  u32DMAMode  SHA DMA control, see SHA_Start().
+  * @return None
+  * @details  Completion is reported to the callback installed by CRYPTO_SetCallback()
+  *           with CRYPTO_EVT_SHA or CRYPTO_EVT_SHA_ERR.
+  */
+void SHA_Trigger(CRPT_T *crpt, uint32_t u32DMAMode)
+{
 	crpt->HMAC_CTL &= ~(0x7UL << CRPT_HMAC_CTL_DMALAST_Pos);
 
 	g_HMAC_done = g_HMAC_error = 0;
 	__DSB();
 	crpt->HMAC_CTL |= CRPT_HMAC_CTL_START_Msk | (u32DMAMode << CRPT_HMAC_CTL_DMALAST_Pos);
+}
+
+/**
+  * @brief  Wait for the SHA run started by SHA_Trigger()
+  * @param[in]  crpt        Reference to Crypto module.
+  * @retval   0     Success.
+  * @retval   -1    Time-out
+  * @retval   -2    SHA engine error
+  * @details  The caller may do other work, such as reading the next part of
+  *           the message, between SHA_Trigger() and SHA_Wait().
+  */
+int SHA_Wait(CRPT_T *crpt)
+{
+	uint64_t t0;
+
+	(void)crpt;
 
 	t0 = EL0_GetCurrentPhysicalValue();
 	while (!g_HMAC_done && !g_HMAC_error)
@@ -440,7 +538,7 @@ int SHA_Start(CRPT_T *crpt, uint32_t u32DMAMode)
 		if (EL0_GetCurrentPhysicalValue() - t0 > 12000000)  /* 1 second timeout */
 			return -1;
 	}
-	return 0;
+	return g_HMAC_error ? -2 : 0;
 }
 
 /**
@@ -501,6 +599,272 @@ void SHA_Read(CRPT_T *crpt, uint32_t u32Digest[])
 
 /** @cond HIDDEN_SYMBOLS */
 
+/* DMA mode of segment i of a list of nseg segments run with u32DMAMode */
+static uint32_t crypto_sg_mode(uint32_t u32DMAMode, int i, int nseg)
+{
+	int  first, last;
+
+	first = (i == 0) && ((u32DMAMode == CRYPTO_DMA_ONE_SHOT) || (u32DMAMode == CRYPTO_DMA_FIRST));
+	last = (i == nseg - 1) && ((u32DMAMode == CRYPTO_DMA_ONE_SHOT) || (u32DMAMode == CRYPTO_DMA_LAST));
+
+	if (first && last)
+		return CRYPTO_DMA_ONE_SHOT;
+	if (first)
+		return CRYPTO_DMA_FIRST;
+	if (last)
+		return CRYPTO_DMA_LAST;
+	return CRYPTO_DMA_CONTINUE;
+}
+
+static int crypto_sg_addr_ok(const void *addr, uint32_t len)
+{
+	/* DMA address registers are 32 bits */
+	return ((((uint64_t)addr + len - 1UL) >> 32) == 0UL);
+}
+
+static int crypto_sg_check(const CRYPTO_SG_T sg[], int nseg, uint32_t u32DMAMode,
+						   uint32_t u32Block, int has_dst)
+{
+	uint32_t  mode;
+	int  i;
+
+	if ((sg == NULL) || (nseg <= 0) || (u32DMAMode < CRYPTO_DMA_FIRST) || (u32DMAMode > CRYPTO_DMA_LAST))
+		return -1;
+
+	for (i = 0; i < nseg; i++)
+	{
+		if ((sg[i].u32Len == 0UL) || !crypto_sg_addr_ok(sg[i].pvSrc, sg[i].u32Len))
+			return -1;
+
+		if (has_dst && ((sg[i].pvDst == NULL) || !crypto_sg_addr_ok(sg[i].pvDst, sg[i].u32Len)))
+			return -1;
+
+		/* Only the end of the message may be a partial block */
+		mode = crypto_sg_mode(u32DMAMode, i, nseg);
+		if ((sg[i].u32Len % u32Block != 0UL) && (mode != CRYPTO_DMA_LAST) && (mode != CRYPTO_DMA_ONE_SHOT))
+			return -1;
+	}
+	return 0;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  AES encrypt/decrypt a scatter-gather list of buffers.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  is_sm4      1 for SM4, 0 for AES
+  * @param[in]  sg          Segments in data order. Each segment is processed from pvSrc to pvDst,
+  *                         which may be the same buffer.
+  * @param[in]  nseg        Number of segments.
+  * @param[in]  u32DMAMode  Position of this list in the message, including:
+  *         - \ref CRYPTO_DMA_ONE_SHOT   The list is the whole message.
+  *         - \ref CRYPTO_DMA_FIRST      The list starts a message continued by later calls.
+  *         - \ref CRYPTO_DMA_CONTINUE   The list continues a message.
+  *         - \ref CRYPTO_DMA_LAST       The list ends a message.
+  * @param[in]  fdbck       NULL, or a 64-byte aligned feedback buffer of CRYPTO_AES_FDBCK_SIZE bytes.
+  *                         The engine saves its chaining state there after every segment and
+  *                         reloads it before every segment that continues a message, so the
+  *                         state survives other use of the engine between calls.
+  * @retval   0     Success.
+  * @retval   -1    Invalid segment list.
+  * @retval   -2    Time-out or AES error.
+  * @details  Set up the operation with AES_Open(), AES_SetKey() and AES_SetInitVect() as for AES_Start().
+  *           The key is always the one of AES_SetKey(), Key Store keys are not supported.
+  *           Every segment except the end of the message must be a multiple of 16 bytes.
+  *           Each source is cleaned and each destination invalidated in the data cache around its
+  *           transfer, so a destination must not share a cache line with data the CPU writes meanwhile.
+  */
+int AES_RunSG(CRPT_T *crpt, int is_sm4, const CRYPTO_SG_T sg[], int nseg, uint32_t u32DMAMode, void *fdbck)
+{
+	uint32_t  mode;
+	int  i, ret = 0;
+
+	if (crypto_sg_check(sg, nseg, u32DMAMode, 16UL, 1) != 0)
+		return -1;
+
+	if ((fdbck != NULL) && !crypto_sg_addr_ok(fdbck, CRYPTO_AES_FDBCK_SIZE))
+		return -1;
+
+	if (fdbck != NULL)
+	{
+		dcache_clean_invalidate_by_mva(fdbck, CRYPTO_AES_FDBCK_SIZE);
+		crpt->AES_FBADDR = ptr_to_u32(fdbck);
+	}
+
+	for (i = 0; i < nseg; i++)
+	{
+		mode = crypto_sg_mode(u32DMAMode, i, nseg);
+
+		g_AES_CTL &= ~(CRPT_AES_CTL_FBIN_Msk | CRPT_AES_CTL_FBOUT_Msk);
+		if (fdbck != NULL)
+		{
+			g_AES_CTL |= CRPT_AES_CTL_FBOUT_Msk;
+			if ((mode == CRYPTO_DMA_CONTINUE) || (mode == CRYPTO_DMA_LAST))
+				g_AES_CTL |= CRPT_AES_CTL_FBIN_Msk;
+		}
+
+		dcache_clean_by_mva(sg[i].pvSrc, sg[i].u32Len);
+		dcache_clean_invalidate_by_mva(sg[i].pvDst, sg[i].u32Len);
+
+		crpt->AES0_SADDR = ptr_to_u32(sg[i].pvSrc);
+		crpt->AES0_DADDR = ptr_to_u32(sg[i].pvDst);
+		crpt->AES0_CNT = sg[i].u32Len;
+
+		if ((AES_Start(crpt, is_sm4, mode) != 0) || g_AESERR_done)
+		{
+			ret = -2;
+			break;
+		}
+
+		/* Drop lines the CPU may have speculatively fetched during the transfer */
+		dcache_invalidate_by_mva(sg[i].pvDst, sg[i].u32Len);
+	}
+
+	g_AES_CTL &= ~(CRPT_AES_CTL_FBIN_Msk | CRPT_AES_CTL_FBOUT_Msk);
+	if (fdbck != NULL)
+		dcache_invalidate_by_mva(fdbck, CRYPTO_AES_FDBCK_SIZE);
+
+	return ret;
+}
+
+/**
+  * @brief  SHA hash a scatter-gather list of buffers.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  sg          Segments in data order, pvDst is not used.
+  * @param[in]  nseg        Number of segments.
+  * @param[in]  u32DMAMode  Position of this list in the message, see AES_RunSG().
+  * @param[in]  fdbck       NULL, or a 64-byte aligned feedback buffer of CRYPTO_SHA_FDBCK_SIZE bytes
+  *                         carrying the intermediate digest between segments, see AES_RunSG().
+  * @retval   0     Success.
+  * @retval   -1    Invalid segment list.
+  * @retval   -2    Time-out or SHA error.
+  * @details  Set up the operation with SHA_Open() and read the digest with SHA_Read() after the
+  *           end of the message. Every segment except the end of the message must be a multiple
+  *           of the block size, 64 bytes for SHA-1/SHA-224/SHA-256 and 128 bytes for SHA-384/SHA-512.
+  *           Each source is cleaned from the data cache before its transfer.
+  */
+int SHA_RunSG(CRPT_T *crpt, const CRYPTO_SG_T sg[], int nseg, uint32_t u32DMAMode, void *fdbck)
+{
+	uint32_t  mode, opmode;
+	int  i;
+
+	opmode = (crpt->HMAC_CTL & CRPT_HMAC_CTL_OPMODE_Msk) >> CRPT_HMAC_CTL_OPMODE_Pos;
+
+	if (crypto_sg_check(sg, nseg, u32DMAMode,
+						((opmode == SHA_MODE_SHA384) || (opmode == SHA_MODE_SHA512)) ? 128UL : 64UL, 0) != 0)
+		return -1;
+
+	if ((fdbck != NULL) && !crypto_sg_addr_ok(fdbck, CRYPTO_SHA_FDBCK_SIZE))
+		return -1;
+
+	if (fdbck != NULL)
+	{
+		dcache_clean_invalidate_by_mva(fdbck, CRYPTO_SHA_FDBCK_SIZE);
+		crpt->HMAC_FBADDR = ptr_to_u32(fdbck);
+	}
+
+	for (i = 0; i < nseg; i++)
+	{
+		mode = crypto_sg_mode(u32DMAMode, i, nseg);
+
+		crpt->HMAC_CTL &= ~(CRPT_HMAC_CTL_FBIN_Msk | CRPT_HMAC_CTL_FBOUT_Msk);
+		if (fdbck != NULL)
+		{
+			crpt->HMAC_CTL |= CRPT_HMAC_CTL_FBOUT_Msk;
+			if ((mode == CRYPTO_DMA_CONTINUE) || (mode == CRYPTO_DMA_LAST))
+				crpt->HMAC_CTL |= CRPT_HMAC_CTL_FBIN_Msk;
+		}
+
+		dcache_clean_by_mva(sg[i].pvSrc, sg[i].u32Len);
+		SHA_SetDMATransfer(crpt, ptr_to_u32(sg[i].pvSrc), sg[i].u32Len);
+
+		if ((SHA_Start(crpt, mode) != 0) || g_HMAC_error)
+			break;
+	}
+
+	crpt->HMAC_CTL &= ~(CRPT_HMAC_CTL_FBIN_Msk | CRPT_HMAC_CTL_FBOUT_Msk);
+	if (fdbck != NULL)
+		dcache_invalidate_by_mva(fdbck, CRYPTO_SHA_FDBCK_SIZE);
+
+	return (i < nseg) ? -2 : 0;
+}
+
+/**
+  * @brief  Save the AES set-up of a stream so that the engine can serve other streams.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[out] ctx         Context of the stream.
+  * @retval   0     Success.
+  * @retval   -1    The last operation used a Key Store key, see below.
+  * @details  Captures the AES_Open() settings, the key and the initial vector. The chaining state
+  *           is kept in ctx->au32Fdbck when that is the feedback buffer of the stream's AES_RunSG()
+  *           calls. After AES_RestoreContext() the stream goes on with CRYPTO_DMA_CONTINUE or
+  *           CRYPTO_DMA_LAST. The context holds the key in clear, erase it when the stream ends.
+  *           Only streams keyed by AES_SetKey() can be saved. AES_Start() and AES_RunSG() always
+  *           take the key registers, so a stream run by AES_Start_KS() is refused rather than
+  *           resumed with whatever key is left in the registers.
+  */
+int AES_SaveContext(CRPT_T *crpt, CRYPTO_AES_CTX_T *ctx)
+{
+	int  i;
+
+	if (crpt->AES_KSCTL & CRPT_AES_KSCTL_RSRC_Msk)
+		return -1;
+
+	ctx->u32Ctl = g_AES_CTL & ~(CRPT_AES_CTL_FBIN_Msk | CRPT_AES_CTL_FBOUT_Msk);
+	for (i = 0; i < 8; i++)
+		ctx->au32Key[i] = crpt->AES0_KEY[i];
+	for (i = 0; i < 4; i++)
+		ctx->au32IV[i] = crpt->AES0_IV[i];
+	return 0;
+}
+
+/**
+  * @brief  Load the AES set-up of a stream saved by AES_SaveContext().
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ctx         Context of the stream.
+  * @return None
+  * @details  The stream goes on with the key registers; continue it with AES_Start() or AES_RunSG().
+  */
+void AES_RestoreContext(CRPT_T *crpt, const CRYPTO_AES_CTX_T *ctx)
+{
+	int  i;
+
+	g_AES_CTL = ctx->u32Ctl;
+	for (i = 0; i < 8; i++)
+		crpt->AES0_KEY[i] = ctx->au32Key[i];
+	for (i = 0; i < 4; i++)
+		crpt->AES0_IV[i] = ctx->au32IV[i];
+}
+
+/**
+  * @brief  Save the SHA/HMAC set-up of a stream so that the engine can serve other streams.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[out] ctx         Context of the stream.
+  * @return None
+  * @details  Captures the SHA_Open() settings and HMAC key length. The intermediate digest is kept
+  *           in ctx->au32Fdbck when that is the feedback buffer of the stream's SHA_RunSG() calls.
+  */
+void SHA_SaveContext(CRPT_T *crpt, CRYPTO_SHA_CTX_T *ctx)
+{
+	ctx->u32Ctl = crpt->HMAC_CTL & ~(CRPT_HMAC_CTL_START_Msk | CRPT_HMAC_CTL_FBIN_Msk | CRPT_HMAC_CTL_FBOUT_Msk |
+									 (0x7UL << CRPT_HMAC_CTL_DMALAST_Pos));
+	ctx->u32KeyCnt = crpt->HMAC_KEYCNT;
+}
+
+/**
+  * @brief  Load the SHA/HMAC set-up of a stream saved by SHA_SaveContext().
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ctx         Context of the stream.
+  * @return None
+  */
+void SHA_RestoreContext(CRPT_T *crpt, const CRYPTO_SHA_CTX_T *ctx)
+{
+	crpt->HMAC_KEYCNT = ctx->u32KeyCnt;
+	crpt->HMAC_CTL = ctx->u32Ctl;
+}
+
+/** @cond HIDDEN_SYMBOLS */
+
 /*-----------------------------------------------------------------------------------------------*/
 /*                                                                                               */
 /*    ECC                                                                                        */
@@ -966,6 +1330,12 @@ static ECC_CURVE _Curve[] =
 static ECC_CURVE  *pCurve;
 static ECC_CURVE  Curve_Copy;
 
+/* Parameters of the last curve used in register format, so that they are
+   converted from hex once per curve change instead of on every call */
+static E_ECC_CURVE  ecc_cached_curve = CURVE_UNDEF;
+static uint32_t  ecc_curve_a[18], ecc_curve_b[18], ecc_curve_gx[18], ecc_curve_gy[18];
+static uint32_t  ecc_curve_n[18], ecc_curve_order[18];
+
 static ECC_CURVE * get_curve(E_ECC_CURVE ecc_curve);
 static void run_ecc_codec(CRPT_T *crpt, uint32_t mode, int enable_scap);
 
@@ -1109,6 +1479,60 @@ void Reg2Hex(int count, uint32_t volatile reg[], char output[])
 	}
 }
 
+/**
+  * @brief  Load a big-endian byte string into ECC registers, least significant word first.
+  * @param[in]  input   The value, big-endian.
+  * @param[in]  len     Length of input in bytes, at most 72.
+  * @param[out] reg     18 register words, the words above the value are cleared.
+  * @return None
+  */
+void Bin2Reg(const uint8_t input[], int len, uint32_t volatile reg[])
+{
+	int  i, ri;
+
+	for (ri = 0; len >= 4; ri++)
+	{
+		len -= 4;
+		reg[ri] = ((uint32_t)input[len] << 24) | ((uint32_t)input[len + 1] << 16) |
+				  ((uint32_t)input[len + 2] << 8) | (uint32_t)input[len + 3];
+	}
+
+	if (len > 0)
+	{
+		/* The leading 1 to 3 bytes make the top word */
+		reg[ri] = 0UL;
+		for (i = 0; i < len; i++)
+		{
+			reg[ri] = (reg[ri] << 8) | input[i];
+		}
+		ri++;
+	}
+
+	for ( ; ri < 18; ri++)
+	{
+		reg[ri] = 0UL;
+	}
+}
+
+/**
+  * @brief  Store the low len bytes of ECC registers as a big-endian byte string.
+  * @param[in]  len     Length of output in bytes, at most 72.
+  * @param[in]  reg     Register words, least significant word first.
+  * @param[out] output  The value, big-endian.
+  * @return None
+  */
+void Reg2Bin(int len, uint32_t volatile reg[], uint8_t output[])
+{
+	uint32_t  val32;
+	int  i;
+
+	for (i = 0; i < len; i++)
+	{
+		val32 = reg[i / 4];
+		output[len - 1 - i] = (uint8_t)(val32 >> ((i % 4) * 8));
+	}
+}
+
 static ECC_CURVE * get_curve(E_ECC_CURVE ecc_curve)
 {
 	uint32_t   i;
@@ -1129,57 +1553,117 @@ static ECC_CURVE * get_curve(E_ECC_CURVE ecc_curve)
 	return ret;
 }
 
-int ecc_init_curve(CRPT_T *crpt, E_ECC_CURVE ecc_curve)
+static void ecc_words_from_hex(char input[], uint32_t words[])
 {
-	int  i, ret = 0;
+	int  i;
 
-	pCurve = get_curve(ecc_curve);
-	if (pCurve == NULL)
+	for (i = 0; i < 18; i++)
 	{
-		CRPT_DBGMSG("Cannot find curve %d!!\n", ecc_curve);
-		ret = -1;
+		words[i] = 0UL;
 	}
+	Hex2Reg(input, words);
+}
 
-	if (ret == 0)
-	{
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_A[i] = 0UL;
-			crpt->ECC_B[i] = 0UL;
-			crpt->ECC_X1[i] = 0UL;
-			crpt->ECC_Y1[i] = 0UL;
-			crpt->ECC_X2[i] = 0UL;
-			crpt->ECC_Y2[i] = 0UL;
-			crpt->ECC_N[i] = 0UL;
-		}
-
-		Hex2Reg(pCurve->Ea, crpt->ECC_A);
-		Hex2Reg(pCurve->Eb, crpt->ECC_B);
-		Hex2Reg(pCurve->Px, crpt->ECC_X1);
-		Hex2Reg(pCurve->Py, crpt->ECC_Y1);
-
-		CRPT_DBGMSG("Key length = %d\n", pCurve->key_len);
-		// dump_ecc_reg("CRPT_ECC_CURVE_A", crpt->ECC_A, 10);
-		// dump_ecc_reg("CRPT_ECC_CURVE_B", crpt->ECC_B, 10);
-		// dump_ecc_reg("CRPT_ECC_POINT_X1", crpt->ECC_X1, 10);
-		// dump_ecc_reg("CRPT_ECC_POINT_Y1", crpt->ECC_Y1, 10);
+static void ecc_write_reg(uint32_t volatile reg[], const uint32_t words[])
+{
+	int  i;
 
-		if (pCurve->GF == (int)CURVE_GF_2M)
-		{
-			crpt->ECC_N[0] = 0x1UL;
-			crpt->ECC_N[(pCurve->key_len) / 32] |= (1UL << ((pCurve->key_len) % 32));
-			crpt->ECC_N[(pCurve->irreducible_k1) / 32] |= (1UL << ((pCurve->irreducible_k1) % 32));
-			crpt->ECC_N[(pCurve->irreducible_k2) / 32] |= (1UL << ((pCurve->irreducible_k2) % 32));
-			crpt->ECC_N[(pCurve->irreducible_k3) / 32] |= (1UL << ((pCurve->irreducible_k3) % 32));
-		}
-		else
-		{
-			Hex2Reg(pCurve->Pp, crpt->ECC_N);
-		}
+	for (i = 0; i < 18; i++)
+	{
+		reg[i] = words[i];
 	}
-
-	//dump_ecc_reg("CRPT_ECC_CURVE_N", crpt->ECC_N, 10);
-	return ret;
+}
+
+/* Write words * 2^shift, shift is 0 to 31 */
+static void ecc_write_reg_shl(uint32_t volatile reg[], const uint32_t words[], int shift)
+{
+	int  i;
+
+	if (shift == 0)
+	{
+		ecc_write_reg(reg, words);
+		return;
+	}
+
+	reg[0] = words[0] << shift;
+	for (i = 1; i < 18; i++)
+	{
+		reg[i] = (words[i] << shift) | (words[i - 1] >> (32 - shift));
+	}
+}
+
+static void ecc_read_reg(uint32_t words[], uint32_t volatile reg[])
+{
+	int  i;
+
+	for (i = 0; i < 18; i++)
+	{
+		words[i] = reg[i];
+	}
+}
+
+static int ecc_cache_curve(E_ECC_CURVE ecc_curve)
+{
+	pCurve = get_curve(ecc_curve);
+	if (pCurve == NULL)
+	{
+		CRPT_DBGMSG("Cannot find curve %d!!\n", ecc_curve);
+		ecc_cached_curve = CURVE_UNDEF;
+		return -1;
+	}
+
+	ecc_words_from_hex(pCurve->Ea, ecc_curve_a);
+	ecc_words_from_hex(pCurve->Eb, ecc_curve_b);
+	ecc_words_from_hex(pCurve->Px, ecc_curve_gx);
+	ecc_words_from_hex(pCurve->Py, ecc_curve_gy);
+	ecc_words_from_hex(pCurve->Eorder, ecc_curve_order);
+
+	CRPT_DBGMSG("Key length = %d\n", pCurve->key_len);
+
+	if (pCurve->GF == (int)CURVE_GF_2M)
+	{
+		memset(ecc_curve_n, 0, sizeof(ecc_curve_n));
+		ecc_curve_n[0] = 0x1UL;
+		ecc_curve_n[(pCurve->key_len) / 32] |= (1UL << ((pCurve->key_len) % 32));
+		ecc_curve_n[(pCurve->irreducible_k1) / 32] |= (1UL << ((pCurve->irreducible_k1) % 32));
+		ecc_curve_n[(pCurve->irreducible_k2) / 32] |= (1UL << ((pCurve->irreducible_k2) % 32));
+		ecc_curve_n[(pCurve->irreducible_k3) / 32] |= (1UL << ((pCurve->irreducible_k3) % 32));
+	}
+	else
+	{
+		ecc_words_from_hex(pCurve->Pp, ecc_curve_n);
+	}
+
+	ecc_cached_curve = ecc_curve;
+	return 0;
+}
+
+int ecc_init_curve(CRPT_T *crpt, E_ECC_CURVE ecc_curve)
+{
+	int  i;
+
+	/* ECC_IsPrivateKeyValid() may have loaded another curve into Curve_Copy */
+	if ((ecc_curve != ecc_cached_curve) || (Curve_Copy.curve_id != ecc_curve))
+	{
+		if (ecc_cache_curve(ecc_curve) != 0)
+		{
+			return -1;
+		}
+	}
+	pCurve = &Curve_Copy;
+
+	for (i = 0; i < 18; i++)
+	{
+		crpt->ECC_A[i] = ecc_curve_a[i];
+		crpt->ECC_B[i] = ecc_curve_b[i];
+		crpt->ECC_X1[i] = ecc_curve_gx[i];
+		crpt->ECC_Y1[i] = ecc_curve_gy[i];
+		crpt->ECC_X2[i] = 0UL;
+		crpt->ECC_Y2[i] = 0UL;
+		crpt->ECC_N[i] = ecc_curve_n[i];
+	}
+
+	return 0;
 }
 
 static int  get_nibble_value(char c)
@@ -1255,6 +1739,26 @@ static void ECC_Complete(CRPT_T *crpt)
 	}
 }
 
+/**
+  * @brief  Get the operand length of the binary ECC functions.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @return  > 0  Bytes per operand of the xxx_Bin functions on this curve.
+  * @return  -1   Invalid curve.
+  */
+int ECC_CurveBytes(E_ECC_CURVE ecc_curve)
+{
+	uint32_t   i;
+
+	for (i = 0UL; i < sizeof(_Curve) / sizeof(ECC_CURVE); i++)
+	{
+		if (ecc_curve == _Curve[i].curve_id)
+		{
+			return (_Curve[i].key_len + 7) / 8;
+		}
+	}
+	return -1;
+}
+
 /**
   * @brief  Check if the private key is located in valid range of curve.
   * @param[in]  crpt        Reference to Crypto module.
@@ -1301,19 +1805,11 @@ int ECC_IsPrivateKeyValid(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char private_k[])
 	return ret;
 }
 
-/**
-  * @brief  Given a private key and curve to generate the public key pair.
-  * @param[in]  crpt        Reference to Crypto module.
-  * @param[in]  private_k   The input private key.
-  * @param[in]  ecc_curve   The pre-defined ECC curve.
-  * @param[out] public_k1   The output public key 1.
-  * @param[out] public_k2   The output public key 2.
-  * @return  0    Success.
-  * @return  -1   "ecc_curve" value is invalid.
-  */
-int  ECC_GeneratePublicKey(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, char public_k1[], char public_k2[])
+/** @cond HIDDEN_SYMBOLS */
+
+static int ecc_public_key(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t k[], uint32_t x[], uint32_t y[])
 {
-	int  i, ret = 0;
+	int  ret = 0;
 
 	if (ecc_init_curve(crpt, ecc_curve) != 0)
 	{
@@ -1322,11 +1818,7 @@ int  ECC_GeneratePublicKey(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k,
 
 	if (ret == 0)
 	{
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_K[i] = 0UL;
-		}
-		Hex2Reg(private_k, crpt->ECC_K);
+		ecc_write_reg(crpt->ECC_K, k);
 
 		/* set FSEL (Field selection) */
 		if (pCurve->GF == (int)CURVE_GF_2M)
@@ -1339,11 +1831,7 @@ int  ECC_GeneratePublicKey(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k,
 			crpt->ECC_CTL = CRPT_ECC_CTL_FSEL_Msk;
 		}
 
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X2[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_X2);
+		ecc_write_reg(crpt->ECC_X2, ecc_curve_order);
 
 		if  (ecc_curve == CURVE_25519)
 		{
@@ -1364,10 +1852,71 @@ int  ECC_GeneratePublicKey(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k,
 			//sysprintf("ECC_CTL = 0x%x, ECC_STS = 0x%x\n",  crpt->ECC_CTL, crpt->ECC_STS);
 		}
 
-		Reg2Hex(pCurve->Echar, crpt->ECC_X1, public_k1);
-		Reg2Hex(pCurve->Echar, crpt->ECC_Y1, public_k2);
+		ecc_read_reg(x, crpt->ECC_X1);
+		ecc_read_reg(y, crpt->ECC_Y1);
+	}
+
+	return ret;
+}
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  Given a private key and curve to generate the public key pair.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  private_k   The input private key.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[out] public_k1   The output public key 1.
+  * @param[out] public_k2   The output public key 2.
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  */
+int  ECC_GeneratePublicKey(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, char public_k1[], char public_k2[])
+{
+	uint32_t  k[18], x[18], y[18];
+	int  ret;
+
+	ecc_words_from_hex(private_k, k);
+
+	ret = ecc_public_key(crpt, ecc_curve, k, x, y);
+	if (ret == 0)
+	{
+		Reg2Hex(pCurve->Echar, x, public_k1);
+		Reg2Hex(pCurve->Echar, y, public_k2);
+	}
+	return ret;
+}
+
+/**
+  * @brief  Given a private key and curve to generate the public key pair, binary operands.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  private_k   The input private key.
+  * @param[out] public_x    The output public key X.
+  * @param[out] public_y    The output public key Y.
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @note   All operands are big-endian, ECC_CurveBytes() bytes long.
+  */
+int  ECC_GeneratePublicKey_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t private_k[],
+							   uint8_t public_x[], uint8_t public_y[])
+{
+	uint32_t  k[18], x[18], y[18];
+	int  len, ret;
+
+	len = ECC_CurveBytes(ecc_curve);
+	if (len < 0)
+	{
+		return -1;
 	}
 
+	Bin2Reg(private_k, len, k);
+
+	ret = ecc_public_key(crpt, ecc_curve, k, x, y);
+	if (ret == 0)
+	{
+		Reg2Bin(len, x, public_x);
+		Reg2Bin(len, y, public_y);
+	}
 	return ret;
 }
 
@@ -1428,11 +1977,7 @@ int  ECC_GeneratePublicKey_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, int k_ksnum,
 			crpt->ECC_CTL = CRPT_ECC_CTL_FSEL_Msk;
 		}
 
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X2[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_X2);
+		ecc_write_reg(crpt->ECC_X2, ecc_curve_order);
 
 		g_ECC_done = g_ECCERR_done = 0UL;
 		crpt->ECC_CTL |= ((uint32_t)pCurve->key_len << CRPT_ECC_CTL_CURVEM_Pos) |
@@ -1450,21 +1995,12 @@ int  ECC_GeneratePublicKey_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, int k_ksnum,
 	return ret;
 }
 
-/**
-  * @brief  Given a private key and curve to generate the public key pair.
-  * @param[in]  crpt        Reference to Crypto module.
-  * @param[out] x1          The x-coordinate of input point.
-  * @param[out] y1          The y-coordinate of input point.
-  * @param[in]  k           The private key
-  * @param[in]  ecc_curve   The pre-defined ECC curve.
-  * @param[out] x2          The x-coordinate of output point.
-  * @param[out] y2          The y-coordinate of output point.
-  * @return  0    Success.
-  * @return  -1   "ecc_curve" value is invalid.
-  */
-int  ECC_Mutiply(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char x1[], char y1[], char *k, char x2[], char y2[])
+/** @cond HIDDEN_SYMBOLS */
+
+static int ecc_multiply(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t x1[], const uint32_t y1[],
+						const uint32_t k[], uint32_t x2[], uint32_t y2[])
 {
-	int  i, ret = 0;
+	int  ret = 0;
 
 	if (ecc_init_curve(crpt, ecc_curve) != 0)
 	{
@@ -1473,15 +2009,9 @@ int  ECC_Mutiply(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char x1[], char y1[], char
 
 	if (ret == 0)
 	{
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X1[i] = 0UL;
-			crpt->ECC_Y1[i] = 0UL;
-			crpt->ECC_K[i] = 0UL;
-		}
-		Hex2Reg(x1, crpt->ECC_X1);
-		Hex2Reg(y1, crpt->ECC_Y1);
-		Hex2Reg(k, crpt->ECC_K);
+		ecc_write_reg(crpt->ECC_X1, x1);
+		ecc_write_reg(crpt->ECC_Y1, y1);
+		ecc_write_reg(crpt->ECC_K, k);
 
 		/* set FSEL (Field selection) */
 		if (pCurve->GF == (int)CURVE_GF_2M)
@@ -1502,10 +2032,79 @@ int  ECC_Mutiply(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char x1[], char y1[], char
 		{
 		}
 
-		Reg2Hex(pCurve->Echar, crpt->ECC_X1, x2);
-		Reg2Hex(pCurve->Echar, crpt->ECC_Y1, y2);
+		ecc_read_reg(x2, crpt->ECC_X1);
+		ecc_read_reg(y2, crpt->ECC_Y1);
+	}
+
+	return ret;
+}
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  Given a private key and curve to generate the public key pair.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[out] x1          The x-coordinate of input point.
+  * @param[out] y1          The y-coordinate of input point.
+  * @param[in]  k           The private key
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[out] x2          The x-coordinate of output point.
+  * @param[out] y2          The y-coordinate of output point.
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  */
+int  ECC_Mutiply(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char x1[], char y1[], char *k, char x2[], char y2[])
+{
+	uint32_t  px[18], py[18], pk[18], qx[18], qy[18];
+	int  ret;
+
+	ecc_words_from_hex(x1, px);
+	ecc_words_from_hex(y1, py);
+	ecc_words_from_hex(k, pk);
+
+	ret = ecc_multiply(crpt, ecc_curve, px, py, pk, qx, qy);
+	if (ret == 0)
+	{
+		Reg2Hex(pCurve->Echar, qx, x2);
+		Reg2Hex(pCurve->Echar, qy, y2);
 	}
+	return ret;
+}
+
+/**
+  * @brief  Multiply a point by a scalar, binary operands.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  x1          The x-coordinate of input point.
+  * @param[in]  y1          The y-coordinate of input point.
+  * @param[in]  k           The multiplier.
+  * @param[out] x2          The x-coordinate of output point.
+  * @param[out] y2          The y-coordinate of output point.
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @note   All operands are big-endian, ECC_CurveBytes() bytes long.
+  */
+int  ECC_Mutiply_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t x1[], const uint8_t y1[],
+					 const uint8_t k[], uint8_t x2[], uint8_t y2[])
+{
+	uint32_t  px[18], py[18], pk[18], qx[18], qy[18];
+	int  len, ret;
 
+	len = ECC_CurveBytes(ecc_curve);
+	if (len < 0)
+	{
+		return -1;
+	}
+
+	Bin2Reg(x1, len, px);
+	Bin2Reg(y1, len, py);
+	Bin2Reg(k, len, pk);
+
+	ret = ecc_multiply(crpt, ecc_curve, px, py, pk, qx, qy);
+	if (ret == 0)
+	{
+		Reg2Bin(len, qx, x2);
+		Reg2Bin(len, qy, y2);
+	}
 	return ret;
 }
 
@@ -1620,18 +2219,10 @@ int  ECC_Mutiply_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, int x1_ksnum, char x1[]
 	return ret;
 }
 
-/**
-  * @brief  Given a curve parameter, the other party's public key, and one's own private key to generate the secret Z.
-  * @param[in]  crpt        Reference to Crypto module.
-  * @param[in]  ecc_curve   The pre-defined ECC curve.
-  * @param[in]  private_k   One's own private key.
-  * @param[in]  public_k1   The other party's publick key 1.
-  * @param[in]  public_k2   The other party's publick key 2.
-  * @param[out] secret_z    The ECC CDH secret Z.
-  * @return  0    Success.
-  * @return  -1   "ecc_curve" value is invalid.
-  */
-int  ECC_GenerateSecretZ(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, char public_k1[], char public_k2[], char secret_z[])
+/** @cond HIDDEN_SYMBOLS */
+
+static int ecc_secret_z(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t k[], const uint32_t x[],
+						const uint32_t y[], uint32_t z[])
 {
 	int  i, ret = 0;
 
@@ -1644,29 +2235,26 @@ int  ECC_GenerateSecretZ(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, c
 	{
 		for (i = 0; i < 18; i++)
 		{
-			crpt->ECC_K[i] = 0UL;
-			crpt->ECC_X1[i] = 0UL;
-			crpt->ECC_Y1[i] = 0UL;
 			crpt->ECC_X2[i] = 0UL;
 		}
 
 		if ((ecc_curve == CURVE_B_163) || (ecc_curve == CURVE_B_233) || (ecc_curve == CURVE_B_283) ||
 				(ecc_curve == CURVE_B_409) || (ecc_curve == CURVE_B_571) || (ecc_curve == CURVE_K_163))
 		{
-			Hex2RegEx(private_k, crpt->ECC_K, 1);
+			ecc_write_reg_shl(crpt->ECC_K, k, 1);
 		}
 		else if ((ecc_curve == CURVE_K_233) || (ecc_curve == CURVE_K_283) ||
 				 (ecc_curve == CURVE_K_409) || (ecc_curve == CURVE_K_571))
 		{
-			Hex2RegEx(private_k, crpt->ECC_K, 2);
+			ecc_write_reg_shl(crpt->ECC_K, k, 2);
 		}
 		else
 		{
-			Hex2Reg(private_k, crpt->ECC_K);
+			ecc_write_reg(crpt->ECC_K, k);
 		}
 
-		Hex2Reg(public_k1, crpt->ECC_X1);
-		Hex2Reg(public_k2, crpt->ECC_Y1);
+		ecc_write_reg(crpt->ECC_X1, x);
+		ecc_write_reg(crpt->ECC_Y1, y);
 
 		/* set FSEL (Field selection) */
 		if (pCurve->GF == (int)CURVE_GF_2M)
@@ -1686,11 +2274,76 @@ int  ECC_GenerateSecretZ(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, c
 		{
 		}
 
-		Reg2Hex(pCurve->Echar, crpt->ECC_X1, secret_z);
+		ecc_read_reg(z, crpt->ECC_X1);
 	}
 
 	return ret;
 }
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  Given a curve parameter, the other party's public key, and one's own private key to generate the secret Z.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  private_k   One's own private key.
+  * @param[in]  public_k1   The other party's publick key 1.
+  * @param[in]  public_k2   The other party's publick key 2.
+  * @param[out] secret_z    The ECC CDH secret Z.
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  */
+int  ECC_GenerateSecretZ(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, char public_k1[], char public_k2[], char secret_z[])
+{
+	uint32_t  k[18], x[18], y[18], z[18];
+	int  ret;
+
+	ecc_words_from_hex(private_k, k);
+	ecc_words_from_hex(public_k1, x);
+	ecc_words_from_hex(public_k2, y);
+
+	ret = ecc_secret_z(crpt, ecc_curve, k, x, y, z);
+	if (ret == 0)
+	{
+		Reg2Hex(pCurve->Echar, z, secret_z);
+	}
+	return ret;
+}
+
+/**
+  * @brief  Generate the ECC CDH secret Z, binary operands.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  private_k   One's own private key.
+  * @param[in]  public_x    The other party's public key X.
+  * @param[in]  public_y    The other party's public key Y.
+  * @param[out] secret_z    The ECC CDH secret Z.
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @note   All operands are big-endian, ECC_CurveBytes() bytes long.
+  */
+int  ECC_GenerateSecretZ_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t private_k[],
+							 const uint8_t public_x[], const uint8_t public_y[], uint8_t secret_z[])
+{
+	uint32_t  k[18], x[18], y[18], z[18];
+	int  len, ret;
+
+	len = ECC_CurveBytes(ecc_curve);
+	if (len < 0)
+	{
+		return -1;
+	}
+
+	Bin2Reg(private_k, len, k);
+	Bin2Reg(public_x, len, x);
+	Bin2Reg(public_y, len, y);
+
+	ret = ecc_secret_z(crpt, ecc_curve, k, x, y, z);
+	if (ret == 0)
+	{
+		Reg2Bin(len, z, secret_z);
+	}
+	return ret;
+}
 
 
 /**
@@ -1854,20 +2507,10 @@ static void run_ecc_codec(CRPT_T *crpt, uint32_t mode, int enable_scap)
 }
 /** @endcond HIDDEN_SYMBOLS */
 
-/**
-  * @brief  ECDSA digital signature generation.
-  * @param[in]  crpt        Reference to Crypto module.
-  * @param[in]  ecc_curve   The pre-defined ECC curve.
-  * @param[in]  message     The hash value of source context.
-  * @param[in]  d           The private key.
-  * @param[in]  k           The selected random integer.
-  * @param[out] R           R of the (R,S) pair digital signature
-  * @param[out] S           S of the (R,S) pair digital signature
-  * @return  0    Success.
-  * @return  -1   "ecc_curve" value is invalid.
-  */
-int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
-							   char *d, char *k, char *R, char *S)
+/** @cond HIDDEN_SYMBOLS */
+
+static int ecc_sign(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t e[], const uint32_t d[],
+					const uint32_t k[], uint32_t R[], uint32_t S[])
 {
 	uint32_t volatile temp_result1[18], temp_result2[18];
 	int  i, ret = 0;
@@ -1908,26 +2551,14 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		 */
 
 		/* 3-(4) Write the random integer k to K register */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_K[i] = 0UL;
-		}
-		Hex2Reg(k, crpt->ECC_K);
+		ecc_write_reg(crpt->ECC_K, k);
 
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X2[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_X2);
+		ecc_write_reg(crpt->ECC_X2, ecc_curve_order);
 
 		run_ecc_codec(crpt, ECCOP_POINT_MUL, 1);
 
 		/*  3-(9) Write the curve order to N registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/* 3-(10) Write 0x0 to Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -1943,7 +2574,10 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 			temp_result1[i] = crpt->ECC_X1[i];
 		}
 
-		Reg2Hex(pCurve->Echar, temp_result1, R);
+		for (i = 0; i < 18; i++)
+		{
+			R[i] = temp_result1[i];
+		}
 
 		/*
 		 *   4. Compute s = k ? 1  (e + d  r)(mod n). If s = 0, go to step 2
@@ -1979,11 +2613,7 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		/* S/W: GFp_add_mod_order(pCurve->key_len+2, 0, x1, a, R); */
 
 		/*  4-(1) Write the curve order to N registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*  4-(2) Write 0x1 to Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -1993,11 +2623,7 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		crpt->ECC_Y1[0] = 0x1UL;
 
 		/*  4-(3) Write the random integer k to X1 registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X1[i] = 0UL;
-		}
-		Hex2Reg(k, crpt->ECC_X1);
+		ecc_write_reg(crpt->ECC_X1, k);
 
 		run_ecc_codec(crpt, ECCOP_MODULE | MODOP_DIV, 0);
 
@@ -2019,11 +2645,7 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 #endif
 
 		/*  4-(9) Write the curve order and curve length to N ,M registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*  4-(10) Write r, d to X1, Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -2031,11 +2653,7 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 			crpt->ECC_X1[i] = temp_result1[i];
 		}
 
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_Y1[i] = 0UL;
-		}
-		Hex2Reg(d, crpt->ECC_Y1);
+		ecc_write_reg(crpt->ECC_Y1, d);
 
 		run_ecc_codec(crpt, ECCOP_MODULE | MODOP_MUL, 0);
 
@@ -2045,18 +2663,10 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 #endif
 
 		/*  4-(15) Write the curve order to N registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*  4-(16) Write e to Y1 registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_Y1[i] = 0UL;
-		}
-		Hex2Reg(message, crpt->ECC_Y1);
+		ecc_write_reg(crpt->ECC_Y1, e);
 
 		run_ecc_codec(crpt, ECCOP_MODULE | MODOP_ADD, 0);
 
@@ -2066,46 +2676,109 @@ int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 #endif
 
 		/*  4-(21) Write the curve order and curve length to N ,M registers */
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
+
+		/*  4-(22) Write k^-1 to Y1 registers */
 		for (i = 0; i < 18; i++)
 		{
-			crpt->ECC_N[i] = 0UL;
+			crpt->ECC_Y1[i] = temp_result2[i];
 		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
 
-		/*  4-(22) Write k^-1 to Y1 registers */
+		run_ecc_codec(crpt, ECCOP_MODULE | MODOP_MUL, 0);
+
+		/*  4-(27) Read X1 registers to get s */
 		for (i = 0; i < 18; i++)
 		{
-			crpt->ECC_Y1[i] = temp_result2[i];
+			temp_result2[i] = crpt->ECC_X1[i];
+		}
+
+		for (i = 0; i < 18; i++)
+		{
+			S[i] = temp_result2[i];
 		}
 
-		run_ecc_codec(crpt, ECCOP_MODULE | MODOP_MUL, 0);
+	}  /* ret == 0 */
+
+	return ret;
+}
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  ECDSA digital signature generation.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  message     The hash value of source context.
+  * @param[in]  d           The private key.
+  * @param[in]  k           The selected random integer.
+  * @param[out] R           R of the (R,S) pair digital signature
+  * @param[out] S           S of the (R,S) pair digital signature
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  */
+int  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
+							   char *d, char *k, char *R, char *S)
+{
+	uint32_t  e[18], dw[18], kw[18], r[18], sw[18];
+	int  ret;
+
+	ecc_words_from_hex(message, e);
+	ecc_words_from_hex(d, dw);
+	ecc_words_from_hex(k, kw);
 
-		/*  4-(27) Read X1 registers to get s */
-		for (i = 0; i < 18; i++)
-		{
-			temp_result2[i] = crpt->ECC_X1[i];
-		}
+	ret = ecc_sign(crpt, ecc_curve, e, dw, kw, r, sw);
+	if (ret == 0)
+	{
+		Reg2Hex(pCurve->Echar, r, R);
+		Reg2Hex(pCurve->Echar, sw, S);
+	}
+	return ret;
+}
 
-		Reg2Hex(pCurve->Echar, temp_result2, S);
+/**
+  * @brief  ECDSA digital signature generation, binary operands.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  message     The hash value of source context, already truncated to the curve order length.
+  * @param[in]  d           The private key.
+  * @param[in]  k           The selected random integer.
+  * @param[out] R           R of the (R,S) pair digital signature
+  * @param[out] S           S of the (R,S) pair digital signature
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @note   All operands are big-endian, ECC_CurveBytes() bytes long.
+  */
+int  ECC_GenerateSignature_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t message[],
+							   const uint8_t d[], const uint8_t k[], uint8_t R[], uint8_t S[])
+{
+	uint32_t  e[18], dw[18], kw[18], r[18], sw[18];
+	int  len, ret;
 
-	}  /* ret == 0 */
+	len = ECC_CurveBytes(ecc_curve);
+	if (len < 0)
+	{
+		return -1;
+	}
+
+	Bin2Reg(message, len, e);
+	Bin2Reg(d, len, dw);
+	Bin2Reg(k, len, kw);
 
+	ret = ecc_sign(crpt, ecc_curve, e, dw, kw, r, sw);
+	if (ret == 0)
+	{
+		Reg2Bin(len, r, R);
+		Reg2Bin(len, sw, S);
+	}
 	return ret;
 }
 
 int  ECC_Write_N(CRPT_T *crpt, E_ECC_CURVE ecc_curve)
 {
-	int   i;
-
 	if (ecc_init_curve(crpt, ecc_curve) != 0)
 	{
 		return -1;
 	}
-	for (i = 0; i < 18; i++)
-	{
-		crpt->ECC_N[i] = 0UL;
-	}
-	Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+	ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 	return 0;
 }
 
@@ -2183,21 +2856,13 @@ int  ECC_GenerateSignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message
 						  CRPT_ECC_KSCTL_RSRCK_Msk | (k_ksnum);
 		}
 
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X2[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_X2);
+		ecc_write_reg(crpt->ECC_X2, ecc_curve_order);
 
 		run_ecc_codec(crpt, ECCOP_POINT_MUL | CRPT_ECC_CTL_ECDSAR_Msk, 1);
 		CRPT->ECC_KSCTL = 0;
 
 		/*  3-(9) Write the curve order to N registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/* 3-(10) Write 0x0 to Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -2234,11 +2899,7 @@ int  ECC_GenerateSignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message
 		/* S/W: GFp_add_mod_order(pCurve->key_len+2, 0, x1, a, R); */
 
 		/*  4-(1) Write the curve order to N registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*  4-(2) Write the random integer k to X1 and d to Y1 */
 
@@ -2306,25 +2967,14 @@ int  ECC_GenerateSignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message
 	return ret;
 }
 
-/**
-  * @brief  ECDSA digital signature verification.
-  * @param[in]  crpt        Reference to Crypto module.
-  * @param[in]  ecc_curve   The pre-defined ECC curve.
-  * @param[in]  message     The hash value of source context.
-  * @param[in]  public_k1   The public key 1.
-  * @param[in]  public_k2   The public key 2.
-  * @param[in]  R           R of the (R,S) pair digital signature
-  * @param[in]  S           S of the (R,S) pair digital signature
-  * @return  0    Success.
-  * @return  -1   "ecc_curve" value is invalid.
-  * @return  -2   Verification failed.
-  */
-int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
-							 char *public_k1, char *public_k2, char *R, char *S)
+/** @cond HIDDEN_SYMBOLS */
+
+static int ecc_verify(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t e[], const uint32_t qx[],
+					  const uint32_t qy[], const uint32_t R[], const uint32_t S[])
 {
 	uint32_t  temp_result1[18], temp_result2[18];
 	uint32_t  temp_x[18], temp_y[18];
-	int   i, ret = 0;
+	int   i, nw, ret = 0;
 
 	/*
 	 *   1. Verify that r and s are integers in the interval [1, n-1]. If not, the signature is invalid
@@ -2352,11 +3002,7 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 	if (ret == 0)
 	{
 		/*  3-(1) Write the curve order to N registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*  3-(2) Write 0x1 to Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -2366,11 +3012,7 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		crpt->ECC_Y1[0] = 0x1UL;
 
 		/*  3-(3) Write s to X1 registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X1[i] = 0UL;
-		}
-		Hex2Reg(S, crpt->ECC_X1);
+		ecc_write_reg(crpt->ECC_X1, S);
 
 		run_ecc_codec(crpt, ECCOP_MODULE | MODOP_DIV, 0);
 
@@ -2381,7 +3023,8 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		}
 
 #if ENABLE_DEBUG
-		CRPT_DBGMSG("e = %s\n", message);
+		Reg2Hex(pCurve->Echar, (uint32_t *)e, temp_hex_str);
+		CRPT_DBGMSG("e = %s\n", temp_hex_str);
 		Reg2Hex(pCurve->Echar, temp_result2, temp_hex_str);
 		CRPT_DBGMSG("w = %s\n", temp_hex_str);
 		CRPT_DBGMSG("o = %s (order)\n", pCurve->Eorder);
@@ -2406,18 +3049,10 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		 */
 
 		/*  4-(1) Write the curve order and curve length to N ,M registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/* 4-(2) Write e, w to X1, Y1 registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X1[i] = 0UL;
-		}
-		Hex2Reg(message, crpt->ECC_X1);
+		ecc_write_reg(crpt->ECC_X1, e);
 
 		for (i = 0; i < 18; i++)
 		{
@@ -2438,18 +3073,10 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 #endif
 
 		/*  4-(8) Write the curve order and curve length to N ,M registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/* 4-(9) Write r, w to X1, Y1 registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X1[i] = 0UL;
-		}
-		Hex2Reg(R, crpt->ECC_X1);
+		ecc_write_reg(crpt->ECC_X1, R);
 
 		for (i = 0; i < 18; i++)
 		{
@@ -2514,11 +3141,7 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 			crpt->ECC_K[i] = temp_result1[i];
 		}
 
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X2[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_X2);
+		ecc_write_reg(crpt->ECC_X2, ecc_curve_order);
 
 		run_ecc_codec(crpt, ECCOP_POINT_MUL, 1);
 
@@ -2540,14 +3163,8 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		ecc_init_curve(crpt, ecc_curve);
 
 		/* (9) Write the public key Q(x,y) to X1, Y1 registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X1[i] = 0UL;
-			crpt->ECC_Y1[i] = 0UL;
-		}
-
-		Hex2Reg(public_k1, crpt->ECC_X1);
-		Hex2Reg(public_k2, crpt->ECC_Y1);
+		ecc_write_reg(crpt->ECC_X1, qx);
+		ecc_write_reg(crpt->ECC_Y1, qy);
 
 		/* (10) Write u2 to K registers */
 		for (i = 0; i < 18; i++)
@@ -2555,11 +3172,7 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 			crpt->ECC_K[i] = temp_result2[i];
 		}
 
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_X2[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_X2);
+		ecc_write_reg(crpt->ECC_X2, ecc_curve_order);
 
 		run_ecc_codec(crpt, ECCOP_POINT_MUL, 1);
 
@@ -2610,11 +3223,7 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 #endif
 
 		/*  (20) Write the curve order and curve length to N ,M registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*
 		 *  (21) Write x1 to X1 registers
@@ -2635,23 +3244,301 @@ int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 
 		run_ecc_codec(crpt, ECCOP_MODULE | MODOP_ADD, 0);
 
-		/*  (27) Read X1 registers to get x1 (mod n) */
+		/*  (27) Read X1 registers to get x1' (mod n) */
+#if ENABLE_DEBUG
 		Reg2Hex(pCurve->Echar, crpt->ECC_X1, temp_hex_str);
 		CRPT_DBGMSG("5-(27) x1' (mod n) = %s\n", temp_hex_str);
+#endif
 
 		/* 6. The signature is valid if x1 = r, otherwise it is invalid */
 
-		/* Compare with test pattern to check if r is correct or not */
-		if (ecc_strcmp(temp_hex_str, R) != 0)
+		/* Compare with r word by word, the register holds key_len bits */
+		nw = (pCurve->key_len + 31) / 32;
+		for (i = 0; i < 18; i++)
 		{
-			CRPT_DBGMSG("x1' (mod n) != R Test filed!!\n");
-			CRPT_DBGMSG("Signature R [%s] is not matched with expected R [%s]!\n", temp_hex_str, R);
-			ret = -2;
+			if (R[i] != ((i < nw) ? crpt->ECC_X1[i] : 0UL))
+			{
+				CRPT_DBGMSG("x1' (mod n) != R Test filed!!\n");
+				ret = -2;
+				break;
+			}
 		}
 	}  /* ret == 0 */
 
 	return ret;
 }
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  ECDSA digital signature verification.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  message     The hash value of source context.
+  * @param[in]  public_k1   The public key 1.
+  * @param[in]  public_k2   The public key 2.
+  * @param[in]  R           R of the (R,S) pair digital signature
+  * @param[in]  S           S of the (R,S) pair digital signature
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @return  -2   Verification failed.
+  */
+int  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
+							 char *public_k1, char *public_k2, char *R, char *S)
+{
+	uint32_t  e[18], qx[18], qy[18], r[18], sw[18];
+
+	ecc_words_from_hex(message, e);
+	ecc_words_from_hex(public_k1, qx);
+	ecc_words_from_hex(public_k2, qy);
+	ecc_words_from_hex(R, r);
+	ecc_words_from_hex(S, sw);
+
+	return ecc_verify(crpt, ecc_curve, e, qx, qy, r, sw);
+}
+
+/**
+  * @brief  ECDSA digital signature verification, binary operands.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  message     The hash value of source context, already truncated to the curve order length.
+  * @param[in]  public_x    The public key X.
+  * @param[in]  public_y    The public key Y.
+  * @param[in]  R           R of the (R,S) pair digital signature
+  * @param[in]  S           S of the (R,S) pair digital signature
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @return  -2   Verification failed.
+  * @note   All operands are big-endian, ECC_CurveBytes() bytes long.
+  */
+int  ECC_VerifySignature_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint8_t message[],
+							 const uint8_t public_x[], const uint8_t public_y[], const uint8_t R[], const uint8_t S[])
+{
+	uint32_t  e[18], qx[18], qy[18], r[18], sw[18];
+	int  len;
+
+	len = ECC_CurveBytes(ecc_curve);
+	if (len < 0)
+	{
+		return -1;
+	}
+
+	Bin2Reg(message, len, e);
+	Bin2Reg(public_x, len, qx);
+	Bin2Reg(public_y, len, qy);
+	Bin2Reg(R, len, r);
+	Bin2Reg(S, len, sw);
+
+	return ecc_verify(crpt, ecc_curve, e, qx, qy, r, sw);
+}
+
+/** @cond HIDDEN_SYMBOLS */
+
+static int sha_digest_len(uint32_t u32OpMode)
+{
+	switch (u32OpMode)
+	{
+	case SHA_MODE_SHA1:
+		return 20;
+	case SHA_MODE_SHA224:
+		return 28;
+	case SHA_MODE_SHA256:
+		return 32;
+	case SHA_MODE_SHA384:
+		return 48;
+	case SHA_MODE_SHA512:
+		return 64;
+	default:
+		return 0;
+	}
+}
+
+/* Digests of the empty message; the SHA engine cannot run a zero byte DMA */
+static const uint8_t sha1_empty[20] =
+{
+	0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d, 0x32, 0x55, 0xbf, 0xef, 0x95, 0x60, 0x18, 0x90,
+	0xaf, 0xd8, 0x07, 0x09
+};
+static const uint8_t sha224_empty[28] =
+{
+	0xd1, 0x4a, 0x02, 0x8c, 0x2a, 0x3a, 0x2b, 0xc9, 0x47, 0x61, 0x02, 0xbb, 0x28, 0x82, 0x34, 0xc4,
+	0x15, 0xa2, 0xb0, 0x1f, 0x82, 0x8e, 0xa6, 0x2a, 0xc5, 0xb3, 0xe4, 0x2f
+};
+static const uint8_t sha256_empty[32] =
+{
+	0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+	0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55
+};
+static const uint8_t sha384_empty[48] =
+{
+	0x38, 0xb0, 0x60, 0xa7, 0x51, 0xac, 0x96, 0x38, 0x4c, 0xd9, 0x32, 0x7e, 0xb1, 0xb1, 0xe3, 0x6a,
+	0x21, 0xfd, 0xb7, 0x11, 0x14, 0xbe, 0x07, 0x43, 0x4c, 0x0c, 0xc7, 0xbf, 0x63, 0xf6, 0xe1, 0xda,
+	0x27, 0x4e, 0xde, 0xbf, 0xe7, 0x6f, 0x65, 0xfb, 0xd5, 0x1a, 0xd2, 0xf1, 0x48, 0x98, 0xb9, 0x5b
+};
+static const uint8_t sha512_empty[64] =
+{
+	0xcf, 0x83, 0xe1, 0x35, 0x7e, 0xef, 0xb8, 0xbd, 0xf1, 0x54, 0x28, 0x50, 0xd6, 0x6d, 0x80, 0x07,
+	0xd6, 0x20, 0xe4, 0x05, 0x0b, 0x57, 0x15, 0xdc, 0x83, 0xf4, 0xa9, 0x21, 0xd3, 0x6c, 0xe9, 0xce,
+	0x47, 0xd0, 0xd1, 0x3c, 0x5d, 0x85, 0xf2, 0xb0, 0xff, 0x83, 0x18, 0xd2, 0x87, 0x7e, 0xec, 0x2f,
+	0x63, 0xb9, 0x31, 0xbd, 0x47, 0x41, 0x7a, 0x81, 0xa5, 0x38, 0x32, 0x7a, 0xf9, 0x27, 0xda, 0x3e
+};
+
+static const uint8_t *sha_empty_digest(uint32_t u32OpMode)
+{
+	switch (u32OpMode)
+	{
+	case SHA_MODE_SHA1:
+		return sha1_empty;
+	case SHA_MODE_SHA224:
+		return sha224_empty;
+	case SHA_MODE_SHA256:
+		return sha256_empty;
+	case SHA_MODE_SHA384:
+		return sha384_empty;
+	default:
+		return sha512_empty;
+	}
+}
+
+/* Take the leftmost len bytes of a dlen bytes digest as e */
+static void ecc_batch_digest_to_e(const uint8_t digest[], int dlen, int len, uint32_t e[])
+{
+	uint8_t   hash[72];
+
+	memset(hash, 0, sizeof(hash));
+	if (dlen > len)
+	{
+		dlen = len;
+	}
+	memcpy(&hash[len - dlen], digest, dlen);
+	Bin2Reg(hash, len, e);
+}
+
+/* Start hashing the message of a batch item. Returns 0 if the item has no message to hash. */
+static int ecc_batch_hash_start(CRPT_T *crpt, uint32_t u32ShaMode, const ECC_VERIFY_ITEM_T *item)
+{
+	if ((item->pu8Msg == NULL) || (item->u32MsgLen == 0UL))
+	{
+		return 0;
+	}
+
+	dcache_clean_by_mva(item->pu8Msg, item->u32MsgLen);
+	SHA_Open(crpt, u32ShaMode, SHA_IN_OUT_SWAP, 0);
+	SHA_SetDMATransfer(crpt, ptr_to_u32(item->pu8Msg), item->u32MsgLen);
+	SHA_Trigger(crpt, CRYPTO_DMA_ONE_SHOT);
+	return 1;
+}
+
+/* Wait for the hash and take its leftmost len bytes as e */
+static int ecc_batch_hash_read(CRPT_T *crpt, int dlen, int len, uint32_t e[])
+{
+	uint32_t  dgst[16];
+	uint8_t   digest[64];
+	int  i;
+
+	if (SHA_Wait(crpt) != 0)
+	{
+		return -1;
+	}
+	SHA_Read(crpt, dgst);
+
+	for (i = 0; i < dlen; i++)
+	{
+		digest[i] = (uint8_t)(dgst[i / 4] >> (24 - (i % 4) * 8));
+	}
+	ecc_batch_digest_to_e(digest, dlen, len, e);
+	return 0;
+}
+
+/** @endcond HIDDEN_SYMBOLS */
+
+/**
+  * @brief  Verify a batch of ECDSA signatures on one curve.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  u32ShaMode  SHA_MODE_SHA1/224/256/384/512, hash of the items with a message.
+  * @param[in,out] items    The signatures. i32Result of each item is set.
+  * @param[in]  count       Number of items.
+  * @return  >= 0 Number of valid signatures.
+  * @return  -1   "ecc_curve", "u32ShaMode" or "count" is invalid.
+  * @details  The curve is looked up and converted to words once for the whole batch; the
+  *           engine registers are still reloaded from that copy at each step of every
+  *           verification, as the engine overwrites them. While the ECC engine checks one
+  *           signature, the SHA engine hashes the message of the next one, so hashing costs
+  *           no time except for the first message. A message with u32MsgLen 0 is the empty
+  *           message and takes its digest from a table. The leftmost ECC_CurveBytes() bytes
+  *           of a digest are used, which is the ECDSA truncation on the NIST prime curves.
+  *           On other curves pass the hash in pu8Hash instead.
+  * @note   Operands are big-endian, ECC_CurveBytes() bytes long. The SHA engine settings
+  *         are changed.
+  */
+int  ECC_VerifyBatch_Bin(CRPT_T *crpt, E_ECC_CURVE ecc_curve, uint32_t u32ShaMode,
+						 ECC_VERIFY_ITEM_T items[], int count)
+{
+	ECC_VERIFY_ITEM_T  *item;
+	uint32_t  e[18], qx[18], qy[18], r[18], sw[18];
+	int  i, len, dlen, hashing, ok, nvalid = 0;
+
+	len = ECC_CurveBytes(ecc_curve);
+	dlen = sha_digest_len(u32ShaMode);
+	if ((len < 0) || (dlen == 0) || (count <= 0))
+	{
+		return -1;
+	}
+
+	if (ecc_init_curve(crpt, ecc_curve) != 0)
+	{
+		return -1;
+	}
+
+	hashing = ecc_batch_hash_start(crpt, u32ShaMode, &items[0]);
+
+	for (i = 0; i < count; i++)
+	{
+		item = &items[i];
+
+		if (hashing)
+		{
+			ok = (ecc_batch_hash_read(crpt, dlen, len, e) == 0);
+		}
+		else if ((item->pu8Msg == NULL) && (item->pu8Hash != NULL))
+		{
+			Bin2Reg(item->pu8Hash, len, e);
+			ok = 1;
+		}
+		else if (item->pu8Msg != NULL)
+		{
+			/* empty message */
+			ecc_batch_digest_to_e(sha_empty_digest(u32ShaMode), dlen, len, e);
+			ok = 1;
+		}
+		else
+		{
+			ok = 0;
+		}
+
+		/* Hash the next message while this signature is checked */
+		hashing = (i + 1 < count) ? ecc_batch_hash_start(crpt, u32ShaMode, &items[i + 1]) : 0;
+
+		if (!ok)
+		{
+			item->i32Result = -1;
+			continue;
+		}
+
+		Bin2Reg(item->pu8PubX, len, qx);
+		Bin2Reg(item->pu8PubY, len, qy);
+		Bin2Reg(item->pu8R, len, r);
+		Bin2Reg(item->pu8S, len, sw);
+
+		item->i32Result = ecc_verify(crpt, ecc_curve, e, qx, qy, r, sw);
+		if (item->i32Result == 0)
+		{
+			nvalid++;
+		}
+	}
+
+	return nvalid;
+}
 
 
 /**
@@ -2707,11 +3594,7 @@ int  ECC_VerifySignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 	if (ret == 0)
 	{
 		/*  3-(1) Write the curve order to N registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*  3-(2) Write 0x1 to Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -2761,11 +3644,7 @@ int  ECC_VerifySignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 		 */
 
 		/*  4-(1) Write the curve order and curve length to N ,M registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/* 4-(2) Write e, w to X1, Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -2793,11 +3672,7 @@ int  ECC_VerifySignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 #endif
 
 		/*  4-(8) Write the curve order and curve length to N ,M registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/* 4-(9) Write r, w to X1, Y1 registers */
 		for (i = 0; i < 18; i++)
@@ -2983,11 +3858,7 @@ int  ECC_VerifySignature_KS(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
 #endif
 
 		/*  (20) Write the curve order and curve length to N ,M registers */
-		for (i = 0; i < 18; i++)
-		{
-			crpt->ECC_N[i] = 0UL;
-		}
-		Hex2Reg(pCurve->Eorder, crpt->ECC_N);
+		ecc_write_reg(crpt->ECC_N, ecc_curve_order);
 
 		/*
 		 *  (21) Write x1 to X1 registers
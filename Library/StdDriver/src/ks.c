@@ -33,6 +33,99 @@ static uint16_t au8OTPCntTbl[7] = {4,6,6,7,8,8,8};
 #define KS_OP_REVOKE    (4 << KS_CTL_OPMODE_Pos)
 #define KS_OP_REMAN     (5 << KS_CTL_OPMODE_Pos)
 
+/* Logical key of the key handle manager */
+typedef struct
+{
+	uint32_t  *pu32Key;     /* Key words, owned by the caller. NULL if the handle is free. */
+	uint32_t  u32Meta;      /* Meta data passed to KS_Write() */
+	int32_t   i32KeyIdx;    /* Key Store SRAM key number, or -1 if not resident */
+	uint32_t  u32LastUse;   /* s_u32KeyClock at the last use */
+	int32_t   i32Pin;       /* Needed by the operation in progress, must not be evicted */
+} KS_KEY_HANDLE_T;
+
+static KS_KEY_HANDLE_T  s_asKeyHandle[KS_HANDLE_CNT];
+static uint32_t  s_u32KeyClock;
+
+/* Key Store SRAM was cleared, no logical key is resident any more */
+static void ks_forget_all(void)
+{
+	int  i;
+
+	for (i = 0; i < KS_HANDLE_CNT; i++)
+		s_asKeyHandle[i].i32KeyIdx = -1;
+}
+
+static KS_KEY_HANDLE_T *ks_handle(int32_t i32Handle)
+{
+	if ((i32Handle < 0) || (i32Handle >= KS_HANDLE_CNT) || (s_asKeyHandle[i32Handle].pu32Key == NULL))
+		return NULL;
+	return &s_asKeyHandle[i32Handle];
+}
+
+/* Erase the least recently used resident key that is not pinned */
+static int ks_evict_lru(void)
+{
+	KS_KEY_HANDLE_T  *psKey, *psLru = NULL;
+	int  i;
+
+	for (i = 0; i < KS_HANDLE_CNT; i++)
+	{
+		psKey = &s_asKeyHandle[i];
+		if ((psKey->pu32Key == NULL) || (psKey->i32KeyIdx < 0) || psKey->i32Pin)
+			continue;
+		/* Difference of the clock values, so the order survives a wrap-around */
+		if ((psLru == NULL) || ((int32_t)(psKey->u32LastUse - psLru->u32LastUse) < 0))
+			psLru = psKey;
+	}
+	if (psLru == NULL)
+		return -1;
+
+	KS_EraseKey(KS_SRAM, psLru->i32KeyIdx);
+	psLru->i32KeyIdx = -1;
+	return 0;
+}
+
+/*
+ * Write the key to Key Store SRAM if it is not there yet. Keys are evicted
+ * only while SRAM is out of space; any other error is returned at once so a
+ * bad request cannot erase the resident keys.
+ */
+static int32_t ks_make_resident(KS_KEY_HANDLE_T *psKey)
+{
+	uint32_t  u32Need, bcnt, kcnt;
+	int32_t   i32KeyIdx;
+
+	psKey->u32LastUse = ++s_u32KeyClock;
+	if (psKey->i32KeyIdx >= 0)
+		return psKey->i32KeyIdx;
+
+	u32Need = au8SRAMCntTbl[(psKey->u32Meta & KS_METADATA_SIZE_Msk) >> KS_METADATA_SIZE_Pos] * 4;
+	if (u32Need == 0)
+		return -1;
+
+	while (1)
+	{
+		if (KS_GetSRAMRemain(&bcnt, &kcnt) != 0)
+			return -1;
+
+		if ((bcnt >= u32Need) && (kcnt > 0))
+		{
+			i32KeyIdx = KS_Write(KS_SRAM, psKey->u32Meta, psKey->pu32Key);
+			if (i32KeyIdx >= 0)
+			{
+				psKey->i32KeyIdx = i32KeyIdx;
+				return i32KeyIdx;
+			}
+			/* Only a write refused for lack of SRAM space is worth an eviction */
+			if ((i32KeyIdx != -3) || ((KS->STS & KS_STS_SRAMFULL_Msk) == 0))
+				return -1;
+		}
+
+		if (ks_evict_lru() != 0)
+			return -1;
+	}
+}
+
 /// @endcond HIDDEN_SYMBOLS
 
 /**
@@ -51,6 +144,8 @@ void KS_Init(void)
 
 	/* Waiting for processing */
 	while(KS->STS & KS_STS_BUSY_Msk);
+
+	ks_forget_all();
 }
 
 
@@ -308,6 +403,8 @@ int32_t KS_EraseAll(void)
 	/* Waiting for processing */
 	while(KS->STS & KS_STS_BUSY_Msk);
 
+	ks_forget_all();
+
 	/* Check error flag */
 	if(KS->STS & KS_STS_EIF_Msk)
 		return -3;
@@ -513,6 +610,219 @@ int32_t KS_TrigReman(void)
 	return 0;
 }
 
+/**
+  * @brief      Add a key to the key handle manager
+  * @param[in]  u32Meta     The metadata of the key, as for KS_Write(). The key number
+  *                         and destination fields are ignored.
+  * @param[in]  au32Key     The key. It is not copied and must stay valid until KS_RemoveKey().
+  * @retval     >= 0        The key handle
+  * @retval     -1          Invalid key size or no free handle
+  * @details    The key handle manager maps up to \ref KS_HANDLE_CNT logical keys to Key Store
+  *             SRAM. A key is written to SRAM on its first use and then stays there, so a key
+  *             used for every record of a session is written only once. When SRAM is full, the
+  *             least recently used key is erased and written again the next time it is used.
+  *             Keys written with KS_Write() directly are never evicted.
+  */
+int32_t KS_AddKey(uint32_t u32Meta, uint32_t au32Key[])
+{
+	uint32_t  sidx;
+	int32_t   i;
+
+	sidx = (u32Meta & KS_METADATA_SIZE_Msk) >> KS_METADATA_SIZE_Pos;
+	if ((au32Key == NULL) || (sidx >= sizeof(au8SRAMCntTbl) / sizeof(au8SRAMCntTbl[0])) ||
+		(au8SRAMCntTbl[sidx] == 0))
+		return -1;
+
+	for (i = 0; i < KS_HANDLE_CNT; i++)
+	{
+		if (s_asKeyHandle[i].pu32Key == NULL)
+		{
+			s_asKeyHandle[i].pu32Key = au32Key;
+			s_asKeyHandle[i].u32Meta = u32Meta & ~(KS_METADATA_NUMBER_Msk | KS_METADATA_DST_Msk);
+			s_asKeyHandle[i].i32KeyIdx = -1;
+			s_asKeyHandle[i].i32Pin = 0;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+  * @brief      Remove a key from the key handle manager
+  * @param[in]  i32Handle   The key handle returned by KS_AddKey()
+  * @retval     0           Successful
+  * @retval     -1          Invalid handle
+  * @details    The key is erased from Key Store SRAM if it is resident, and the handle is freed.
+  */
+int32_t KS_RemoveKey(int32_t i32Handle)
+{
+	KS_KEY_HANDLE_T  *psKey = ks_handle(i32Handle);
+
+	if (psKey == NULL)
+		return -1;
+
+	if (psKey->i32KeyIdx >= 0)
+		KS_EraseKey(KS_SRAM, psKey->i32KeyIdx);
+
+	psKey->pu32Key = NULL;
+	psKey->i32KeyIdx = -1;
+	return 0;
+}
+
+/**
+  * @brief      Get the Key Store SRAM key numbers of a set of keys
+  * @param[in]  ai32Handle  Key handles. -1 means no key and gives key number -1.
+  * @param[out] ai32KeyIdx  The Key Store SRAM key numbers, for the ksnum arguments of the
+  *                         ECC_xxx_KS() functions or the knum argument of AES_Start_KS().
+  * @param[in]  i32Cnt      Number of handles
+  * @retval     0           Successful
+  * @retval     -1          Invalid handle
+  * @retval     -3          The keys do not fit in Key Store SRAM
+  * @details    Writes the keys that are not resident, evicting least recently used keys
+  *             other than the ones in the set. The key numbers are valid until a later
+  *             call of KS_UseKey() or KS_UseKeys() writes another key.
+  */
+int32_t KS_UseKeys(const int32_t ai32Handle[], int32_t ai32KeyIdx[], int32_t i32Cnt)
+{
+	KS_KEY_HANDLE_T  *psKey;
+	int32_t  i, ret = 0;
+
+	for (i = 0; i < i32Cnt; i++)
+	{
+		if ((ai32Handle[i] != -1) && (ks_handle(ai32Handle[i]) == NULL))
+			return -1;
+	}
+
+	/* Pin the whole set first, so writing one key cannot evict another */
+	for (i = 0; i < i32Cnt; i++)
+	{
+		if (ai32Handle[i] != -1)
+			s_asKeyHandle[ai32Handle[i]].i32Pin++;
+	}
+
+	for (i = 0; i < i32Cnt; i++)
+	{
+		ai32KeyIdx[i] = -1;
+		psKey = ks_handle(ai32Handle[i]);
+		if (psKey == NULL)
+			continue;
+
+		ai32KeyIdx[i] = ks_make_resident(psKey);
+		if (ai32KeyIdx[i] < 0)
+		{
+			ret = -3;
+			break;
+		}
+	}
+
+	for (i = 0; i < i32Cnt; i++)
+	{
+		if (ai32Handle[i] != -1)
+			s_asKeyHandle[ai32Handle[i]].i32Pin--;
+	}
+	return ret;
+}
+
+/**
+  * @brief      Get the Key Store SRAM key number of a key
+  * @param[in]  i32Handle   The key handle returned by KS_AddKey()
+  * @retval     >= 0        The Key Store SRAM key number
+  * @retval     -1          Invalid handle
+  * @retval     -3          The key does not fit in Key Store SRAM
+  * @details    See KS_UseKeys().
+  */
+int32_t KS_UseKey(int32_t i32Handle)
+{
+	int32_t  i32KeyIdx, ret;
+
+	ret = KS_UseKeys(&i32Handle, &i32KeyIdx, 1);
+	return (ret == 0) ? i32KeyIdx : ret;
+}
+
+/**
+  * @brief      Start AES encrypt/decrypt with a key of the key handle manager
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  u32DMAMode  AES DMA control, see AES_Start_KS().
+  * @param[in]  i32Handle   The key handle returned by KS_AddKey()
+  * @retval     0           Success.
+  * @retval     -1          Time-out
+  * @retval     -3          Invalid handle or Key Store error
+  */
+int AES_Start_KSH(CRPT_T *crpt, uint32_t u32DMAMode, int32_t i32Handle)
+{
+	int32_t  i32KeyIdx = KS_UseKey(i32Handle);
+
+	if (i32KeyIdx < 0)
+		return -3;
+	return AES_Start_KS(crpt, u32DMAMode, KS_SRAM, i32KeyIdx);
+}
+
+/**
+  * @brief      ECDSA signature generation with keys of the key handle manager
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  message     The hash value of source context.
+  * @param[in]  d_handle    Handle of the private key
+  * @param[in]  k_handle    Handle of the random number
+  * @param[out] R           R of the (R,S) pair digital signature
+  * @param[out] S           S of the (R,S) pair digital signature
+  * @return     See ECC_GenerateSignature_KS(). -3 for an invalid handle or Key Store error.
+  */
+int ECC_GenerateSignature_KSH(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
+							  int32_t d_handle, int32_t k_handle, char *R, char *S)
+{
+	int32_t  ai32Handle[2], ai32KeyIdx[2];
+
+	ai32Handle[0] = d_handle;
+	ai32Handle[1] = k_handle;
+	if (KS_UseKeys(ai32Handle, ai32KeyIdx, 2) != 0)
+		return -3;
+	return ECC_GenerateSignature_KS(crpt, ecc_curve, message, ai32KeyIdx[0], ai32KeyIdx[1], R, S);
+}
+
+/**
+  * @brief      ECDSA signature verification with a public key of the key handle manager
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  message     The hash value of source context.
+  * @param[in]  x_handle    Handle of public key X
+  * @param[in]  y_handle    Handle of public key Y
+  * @param[in]  R           R of the (R,S) pair digital signature
+  * @param[in]  S           S of the (R,S) pair digital signature
+  * @return     See ECC_VerifySignature_KS(). -3 for an invalid handle or Key Store error.
+  */
+int ECC_VerifySignature_KSH(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
+							int32_t x_handle, int32_t y_handle, char *R, char *S)
+{
+	int32_t  ai32Handle[2], ai32KeyIdx[2];
+
+	ai32Handle[0] = x_handle;
+	ai32Handle[1] = y_handle;
+	if (KS_UseKeys(ai32Handle, ai32KeyIdx, 2) != 0)
+		return -3;
+	return ECC_VerifySignature_KS(crpt, ecc_curve, message, ai32KeyIdx[0], ai32KeyIdx[1], R, S);
+}
+
+/**
+  * @brief      ECC CDH secret Z with a private key of the key handle manager
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  k_handle    Handle of one's own private key
+  * @param[in]  public_x    The other party's publick key x.
+  * @param[in]  public_y    The other party's publick key y.
+  * @param[out] secret_z    The ECC CDH secret Z.
+  * @return     See ECC_GenerateSecretZ_KS(). -3 for an invalid handle or Key Store error.
+  */
+int ECC_GenerateSecretZ_KSH(CRPT_T *crpt, E_ECC_CURVE ecc_curve, int32_t k_handle,
+							char public_x[], char public_y[], char secret_z[])
+{
+	int32_t  i32KeyIdx = KS_UseKey(k_handle);
+
+	if (i32KeyIdx < 0)
+		return -3;
+	return ECC_GenerateSecretZ_KS(crpt, ecc_curve, i32KeyIdx, NULL, public_x, public_y, 0, 0, secret_z);
+}
+
 /*@}*/ /* end of group KS_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group KS_Driver */
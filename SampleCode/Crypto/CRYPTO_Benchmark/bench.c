@@ -0,0 +1,503 @@
+/**************************************************************************//**
+ * @file     bench.c
+ * @brief    Crypto benchmark core: mbedTLS software reference cases, timing,
+ *           and the cycles-per-byte and crossover report. The same file
+ *           builds on a host as a software-only reference harness:
+ *
+ *             cd SampleCode/Crypto/CRYPTO_Benchmark/host
+ *             make run MHZ=2400   (host CPU clock in MHz, for cycle counts)
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+#include "mbedtls/md.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+
+#ifdef BENCH_HOST
+#define bench_printf    printf
+#else
+#include "NuMicro.h"
+#define bench_printf    sysprintf
+#endif
+
+/* Each size is repeated for at least 50 ms */
+#define BENCH_MIN_TICKS     (bench_tick_hz / 20)
+
+#define BENCH_NSIZES        9       /* 16 bytes to 1 MB, by 4 */
+
+#define BENCH_ECC_ROUNDS    4
+
+const uint8_t bench_key[16] =
+{
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+	0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+const uint8_t bench_iv[16] =
+{
+	0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad,
+	0xde, 0xca, 0xf8, 0x88, 0x00, 0x00, 0x00, 0x00
+};
+
+const uint8_t bench_hmac_key[32] =
+{
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+};
+
+/*---------------------------------------------------------------------------*/
+/* mbedTLS reference cases; every call sets up its own key and IV, like the  */
+/* hardware cases                                                            */
+/*---------------------------------------------------------------------------*/
+
+int bench_sw_aes_ecb(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	mbedtls_aes_context aes;
+	uint32_t  i;
+	int  ret;
+
+	mbedtls_aes_init(&aes);
+	ret = mbedtls_aes_setkey_enc(&aes, bench_key, 128);
+	for (i = 0; (ret == 0) && (i < len); i += 16)
+		ret = mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, in + i, out + i);
+	mbedtls_aes_free(&aes);
+	return ret;
+}
+
+int bench_sw_aes_cbc(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	mbedtls_aes_context aes;
+	uint8_t  iv[16];
+	int  ret;
+
+	memcpy(iv, bench_iv, sizeof(iv));
+	mbedtls_aes_init(&aes);
+	ret = mbedtls_aes_setkey_enc(&aes, bench_key, 128);
+	if (ret == 0)
+		ret = mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, len, iv, in, out);
+	mbedtls_aes_free(&aes);
+	return ret;
+}
+
+int bench_sw_aes_ctr(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	mbedtls_aes_context aes;
+	uint8_t  ctr[16], block[16];
+	size_t  off = 0;
+	int  ret;
+
+	memcpy(ctr, bench_iv, sizeof(ctr));
+	mbedtls_aes_init(&aes);
+	ret = mbedtls_aes_setkey_enc(&aes, bench_key, 128);
+	if (ret == 0)
+		ret = mbedtls_aes_crypt_ctr(&aes, len, &off, ctr, block, in, out);
+	mbedtls_aes_free(&aes);
+	return ret;
+}
+
+/* 96-bit IV, no additional data, tag written behind the ciphertext */
+int bench_sw_aes_gcm(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	mbedtls_gcm_context gcm;
+	int  ret;
+
+	mbedtls_gcm_init(&gcm);
+	ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, bench_key, 128);
+	if (ret == 0)
+		ret = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, bench_iv, 12,
+										NULL, 0, in, out, 16, out + len);
+	mbedtls_gcm_free(&gcm);
+	return ret;
+}
+
+int bench_sw_sha1(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return mbedtls_sha1(in, len, out);
+}
+
+int bench_sw_sha224(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return mbedtls_sha256(in, len, out, 1);
+}
+
+int bench_sw_sha256(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return mbedtls_sha256(in, len, out, 0);
+}
+
+int bench_sw_sha384(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return mbedtls_sha512(in, len, out, 1);
+}
+
+int bench_sw_sha512(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return mbedtls_sha512(in, len, out, 0);
+}
+
+int bench_sw_hmac_sha256(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+						   bench_hmac_key, sizeof(bench_hmac_key), in, len, out);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Timing and report                                                         */
+/*---------------------------------------------------------------------------*/
+
+/* Not a secure RNG; it only feeds key generation and blinding */
+static int bench_rng(void *p_rng, unsigned char *output, size_t len)
+{
+	static uint32_t  x = 0x2545F491;
+
+	(void)p_rng;
+	while (len--)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		*output++ = (unsigned char)x;
+	}
+	return 0;
+}
+
+/* CPU cycles for ticks spent on n operations, times scale, divided by div */
+static uint32_t bench_cycles(uint64_t ticks, uint32_t n, uint32_t scale, uint32_t div)
+{
+	return (uint32_t)(ticks * bench_cpu_hz / bench_tick_hz * scale / ((uint64_t)n * div));
+}
+
+/* Average cycles per byte x 100 of fn at len */
+static int bench_time(bench_fn_t fn, uint8_t *in, uint8_t *out, uint32_t len, uint32_t *cpb)
+{
+	uint64_t  t0, ticks;
+	uint32_t  n = 0;
+
+	/* Warm up caches and lazily built tables */
+	if (fn(in, out, len) != 0)
+		return -1;
+
+	t0 = bench_ticks();
+	do
+	{
+		if (fn(in, out, len) != 0)
+			return -1;
+		n++;
+		ticks = bench_ticks() - t0;
+	}
+	while (ticks < BENCH_MIN_TICKS);
+
+	*cpb = bench_cycles(ticks, n, 100, len);
+	return 0;
+}
+
+static void bench_print_x100(uint32_t v, int ok)
+{
+	if (ok)
+		bench_printf("  %8d.%02d", v / 100, v % 100);
+	else
+		bench_printf("            -");
+}
+
+/**
+  * @brief  Time every case at each size and print cycles per byte for the
+  *         hardware and software paths, and the size from which hardware
+  *         stays faster.
+  * @param[in]  cases    Cases to run
+  * @param[in]  ncases   Number of cases
+  * @param[in]  in       BENCH_MAX_LEN bytes of input, with BENCH_HEADROOM
+  *                      writable bytes in front of it
+  * @param[out] out_hw   BENCH_OUT_LEN bytes for the hardware output
+  * @param[out] out_sw   BENCH_OUT_LEN bytes for the software output
+  * @return None
+  */
+void bench_run(const bench_case_t cases[], int ncases, uint8_t *in, uint8_t *out_hw, uint8_t *out_sw)
+{
+	const bench_case_t  *c;
+	uint32_t  hw[BENCH_NSIZES], sw[BENCH_NSIZES];
+	uint32_t  len, i, n;
+	int  hw_ok, sw_ok, all_ok, cmp, x;
+
+	for (i = 0; i < BENCH_MAX_LEN; i++)
+		in[i] = (uint8_t)(i * 7 + (i >> 8));
+
+	for (c = cases; c < cases + ncases; c++)
+	{
+		bench_printf("\n%s\n", c->name);
+		bench_printf("       bytes     hw cyc/B     sw cyc/B\n");
+
+		all_ok = (c->hw != NULL) && (c->sw != NULL);
+
+		for (i = 0, len = BENCH_MIN_LEN; len <= BENCH_MAX_LEN; i++, len *= 4)
+		{
+			memset(out_hw, 0, len + 16);
+			memset(out_sw, 0xff, len + 16);
+
+			hw_ok = (c->hw != NULL) && (bench_time(c->hw, in, out_hw, len, &hw[i]) == 0);
+			sw_ok = (c->sw != NULL) && (bench_time(c->sw, in, out_sw, len, &sw[i]) == 0);
+
+			bench_printf("  %10d", len);
+			bench_print_x100(hw[i], hw_ok);
+			bench_print_x100(sw[i], sw_ok);
+
+			cmp = (c->cmp == BENCH_CMP_DATA) ? (int)len :
+				  (c->cmp == BENCH_CMP_TAG) ? (int)len + 16 : c->cmp;
+			if (hw_ok && sw_ok && (cmp > 0) && (memcmp(out_hw, out_sw, cmp) != 0))
+			{
+				bench_printf("  MISMATCH");
+				hw_ok = 0;
+			}
+			bench_printf("\n");
+
+			if ((c->hw != NULL && !hw_ok) || (c->sw != NULL && !sw_ok))
+				all_ok = 0;
+		}
+		n = i;
+
+		if (!all_ok)
+			continue;
+
+		/* First size from which hardware wins at every larger size */
+		for (x = (int)n; (x > 0) && (hw[x - 1] < sw[x - 1]); x--)
+			;
+
+		if (x == 0)
+			bench_printf("  crossover: hardware faster at every size\n");
+		else if (x == (int)n)
+			bench_printf("  crossover: software faster at every size\n");
+		else
+			bench_printf("  crossover: hardware faster from %d bytes\n", BENCH_MIN_LEN << (2 * x));
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/* ECC                                                                       */
+/*---------------------------------------------------------------------------*/
+
+static const struct
+{
+	const char  *name;
+	mbedtls_ecp_group_id  id;
+	int  curve;                             /* E_ECC_CURVE */
+}
+bench_curves[] =
+{
+	{ "P-192", MBEDTLS_ECP_DP_SECP192R1, 0x01 },    /* CURVE_P_192 */
+	{ "P-224", MBEDTLS_ECP_DP_SECP224R1, 0x02 },    /* CURVE_P_224 */
+	{ "P-256", MBEDTLS_ECP_DP_SECP256R1, 0x03 },    /* CURVE_P_256 */
+	{ "P-384", MBEDTLS_ECP_DP_SECP384R1, 0x04 },    /* CURVE_P_384 */
+	{ "P-521", MBEDTLS_ECP_DP_SECP521R1, 0x05 },    /* CURVE_P_521 */
+};
+
+static const char *bench_ecc_ops[] = { "sign", "verify", "ECDH" };
+
+/* One software operation; r, s and z carry results between calls */
+static int bench_sw_ecc(int op, mbedtls_ecp_group *grp, mbedtls_mpi *d, mbedtls_ecp_point *q,
+						const uint8_t hash[32], mbedtls_mpi *r, mbedtls_mpi *s, mbedtls_mpi *z)
+{
+	switch (op)
+	{
+	case BENCH_ECC_SIGN:
+		return mbedtls_ecdsa_sign(grp, r, s, d, hash, 32, bench_rng, NULL);
+	case BENCH_ECC_VERIFY:
+		return mbedtls_ecdsa_verify(grp, hash, 32, q, r, s);
+	default:
+		return mbedtls_ecdh_compute_shared(grp, z, q, d, bench_rng, NULL);
+	}
+}
+
+/* Check the engine results against mbedTLS */
+static int bench_ecc_check(bench_ecc_key_t *key, mbedtls_ecp_group *grp, mbedtls_ecp_point *q,
+						   const uint8_t hash[32], mbedtls_mpi *z)
+{
+	mbedtls_mpi  r, s, hz;
+	int  ret;
+
+	mbedtls_mpi_init(&r);
+	mbedtls_mpi_init(&s);
+	mbedtls_mpi_init(&hz);
+
+	MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(&r, key->r, key->nbytes));
+	MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(&s, key->s, key->nbytes));
+	MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(&hz, key->z, key->nbytes));
+	MBEDTLS_MPI_CHK(mbedtls_ecdsa_verify(grp, hash, 32, q, &r, &s));
+	if (mbedtls_mpi_cmp_mpi(&hz, z) != 0)
+		ret = -1;
+
+cleanup:
+	mbedtls_mpi_free(&r);
+	mbedtls_mpi_free(&s);
+	mbedtls_mpi_free(&hz);
+	return ret;
+}
+
+/**
+  * @brief  Time ECDSA sign and verify and ECDH on each NIST prime curve, in
+  *         thousands of cycles per operation. Engine signatures must pass the
+  *         mbedTLS verify and both sides must agree on the shared secret.
+  * @param[in]  hw   Engine operations, NULL for a software-only run
+  * @return None
+  */
+void bench_run_ecc(bench_ecc_fn_t hw)
+{
+	static bench_ecc_key_t  key;
+	uint8_t  hash[32];
+	mbedtls_ecp_group  grp;
+	mbedtls_ecp_point  q;
+	mbedtls_mpi  d, k, r, s, z;
+	uint64_t  t0, t_hw[3], t_sw[3];
+	uint32_t  c_hw, c_sw;
+	int  i, op, round, hw_ok, ret;
+
+	for (i = 0; i < (int)sizeof(hash); i++)
+		hash[i] = (uint8_t)(0xa5 ^ (i * 29));
+
+	bench_printf("\nECC             op   hw kcyc/op   sw kcyc/op\n");
+
+	for (i = 0; i < (int)(sizeof(bench_curves) / sizeof(bench_curves[0])); i++)
+	{
+		mbedtls_ecp_group_init(&grp);
+		mbedtls_ecp_point_init(&q);
+		mbedtls_mpi_init(&d);
+		mbedtls_mpi_init(&k);
+		mbedtls_mpi_init(&r);
+		mbedtls_mpi_init(&s);
+		mbedtls_mpi_init(&z);
+
+		MBEDTLS_MPI_CHK(mbedtls_ecp_group_load(&grp, bench_curves[i].id));
+		MBEDTLS_MPI_CHK(mbedtls_ecp_gen_keypair(&grp, &d, &q, bench_rng, NULL));
+		MBEDTLS_MPI_CHK(mbedtls_ecp_gen_privkey(&grp, &k, bench_rng, NULL));
+
+		memset(&key, 0, sizeof(key));
+		key.curve = bench_curves[i].curve;
+		key.nbytes = (int)((mbedtls_ecp_curve_info_from_grp_id(bench_curves[i].id)->bit_size + 7) / 8);
+		MBEDTLS_MPI_CHK(mbedtls_mpi_write_binary(&d, key.d, key.nbytes));
+		MBEDTLS_MPI_CHK(mbedtls_mpi_write_binary(&k, key.k, key.nbytes));
+		MBEDTLS_MPI_CHK(mbedtls_mpi_write_binary(&q.X, key.qx, key.nbytes));
+		MBEDTLS_MPI_CHK(mbedtls_mpi_write_binary(&q.Y, key.qy, key.nbytes));
+
+		/* The integer mbedTLS derives from a 32-byte hash for this curve */
+		if (key.nbytes >= (int)sizeof(hash))
+			memcpy(key.hash + key.nbytes - sizeof(hash), hash, sizeof(hash));
+		else
+			memcpy(key.hash, hash, key.nbytes);
+
+		hw_ok = (hw != NULL);
+		for (op = BENCH_ECC_SIGN; op <= BENCH_ECC_ECDH; op++)
+		{
+			t_hw[op] = t_sw[op] = 0;
+			for (round = 0; round < BENCH_ECC_ROUNDS; round++)
+			{
+				t0 = bench_ticks();
+				MBEDTLS_MPI_CHK(bench_sw_ecc(op, &grp, &d, &q, hash, &r, &s, &z));
+				t_sw[op] += bench_ticks() - t0;
+
+				if (hw_ok)
+				{
+					t0 = bench_ticks();
+					if (hw(op, &key) != 0)
+						hw_ok = 0;
+					t_hw[op] += bench_ticks() - t0;
+				}
+			}
+		}
+
+		if (hw_ok && (bench_ecc_check(&key, &grp, &q, hash, &z) != 0))
+		{
+			bench_printf("%-10s engine result MISMATCH\n", bench_curves[i].name);
+			hw_ok = 0;
+		}
+
+		for (op = BENCH_ECC_SIGN; op <= BENCH_ECC_ECDH; op++)
+		{
+			c_hw = bench_cycles(t_hw[op], BENCH_ECC_ROUNDS, 1, 1000);
+			c_sw = bench_cycles(t_sw[op], BENCH_ECC_ROUNDS, 1, 1000);
+
+			bench_printf("%-10s %7s", bench_curves[i].name, bench_ecc_ops[op]);
+			if (hw_ok)
+				bench_printf("  %11d", c_hw);
+			else
+				bench_printf("            -");
+			bench_printf("  %11d", c_sw);
+			if (hw_ok)
+				bench_printf("  %s faster", (c_hw < c_sw) ? "hw" : "sw");
+			bench_printf("\n");
+		}
+
+cleanup:
+		if (ret != 0)
+			bench_printf("%-10s mbedTLS error -0x%x\n", bench_curves[i].name, -ret);
+
+		mbedtls_ecp_group_free(&grp);
+		mbedtls_ecp_point_free(&q);
+		mbedtls_mpi_free(&d);
+		mbedtls_mpi_free(&k);
+		mbedtls_mpi_free(&r);
+		mbedtls_mpi_free(&s);
+		mbedtls_mpi_free(&z);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/* Host reference harness                                                    */
+/*---------------------------------------------------------------------------*/
+
+#ifdef BENCH_HOST
+
+#include <stdlib.h>
+#include <time.h>
+
+uint32_t bench_tick_hz = 1000000000;
+uint32_t bench_cpu_hz = 1000000000;
+
+uint64_t bench_ticks(void)
+{
+	struct timespec  ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static const bench_case_t  host_cases[] =
+{
+	{ "AES-128-ECB",  NULL, bench_sw_aes_ecb,     BENCH_CMP_NONE },
+	{ "AES-128-CBC",  NULL, bench_sw_aes_cbc,     BENCH_CMP_NONE },
+	{ "AES-128-CTR",  NULL, bench_sw_aes_ctr,     BENCH_CMP_NONE },
+	{ "AES-128-GCM",  NULL, bench_sw_aes_gcm,     BENCH_CMP_NONE },
+	{ "SHA-1",        NULL, bench_sw_sha1,        BENCH_CMP_NONE },
+	{ "SHA-224",      NULL, bench_sw_sha224,      BENCH_CMP_NONE },
+	{ "SHA-256",      NULL, bench_sw_sha256,      BENCH_CMP_NONE },
+	{ "SHA-384",      NULL, bench_sw_sha384,      BENCH_CMP_NONE },
+	{ "SHA-512",      NULL, bench_sw_sha512,      BENCH_CMP_NONE },
+	{ "HMAC-SHA-256", NULL, bench_sw_hmac_sha256, BENCH_CMP_NONE },
+};
+
+int main(int argc, char *argv[])
+{
+	static uint8_t  in[BENCH_HEADROOM + BENCH_MAX_LEN];
+	static uint8_t  out_hw[BENCH_OUT_LEN], out_sw[BENCH_OUT_LEN];
+
+	if (argc > 1)
+		bench_cpu_hz = (uint32_t)atoi(argv[1]) * 1000000;
+
+	printf("mbedTLS reference, cycles at %u MHz\n", (unsigned)(bench_cpu_hz / 1000000));
+
+	bench_run(host_cases, sizeof(host_cases) / sizeof(host_cases[0]),
+			  in + BENCH_HEADROOM, out_hw, out_sw);
+	bench_run_ecc(NULL);
+	return 0;
+}
+
+#endif /* BENCH_HOST */
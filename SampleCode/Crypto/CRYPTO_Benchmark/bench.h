@@ -0,0 +1,97 @@
+/**************************************************************************//**
+ * @file     bench.h
+ * @brief    Crypto benchmark core shared by the target sample and the host
+ *           reference harness. Times each case at sizes from 16 bytes to
+ *           1 MB, reports cycles per byte and the hardware/software
+ *           crossover size.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define BENCH_MIN_LEN       16
+#define BENCH_MAX_LEN       (1024 * 1024)
+
+/* Bytes the hardware cases may write in front of the input (IV or HMAC key) */
+#define BENCH_HEADROOM      64
+
+/* Output buffers also hold a GCM tag behind the data */
+#define BENCH_OUT_LEN       (BENCH_MAX_LEN + 64)
+
+#define BENCH_CMP_NONE      (-1)    /* outputs are not compared              */
+#define BENCH_CMP_DATA      0       /* compare len bytes                     */
+#define BENCH_CMP_TAG       (-2)    /* compare len bytes and a 16-byte tag   */
+
+#define BENCH_ECC_SIGN      0
+#define BENCH_ECC_VERIFY    1
+#define BENCH_ECC_ECDH      2
+
+#define BENCH_ECC_MAX_BYTES 66
+
+/* Process len bytes of in into out; return 0 or < 0 on error */
+typedef int (*bench_fn_t)(uint8_t *in, uint8_t *out, uint32_t len);
+
+typedef struct
+{
+	const char  *name;
+	bench_fn_t  hw;         /*!< NULL without an engine, as on the host     */
+	bench_fn_t  sw;         /*!< NULL if mbedTLS has no implementation      */
+	int         cmp;        /*!< BENCH_CMP_xxx, or digest bytes to compare  */
+} bench_case_t;
+
+/* One key pair per curve, shared by the hardware and software runs */
+typedef struct
+{
+	int      curve;                         /*!< E_ECC_CURVE of the engine  */
+	int      nbytes;                        /*!< ECC_CurveBytes()           */
+	uint8_t  d[BENCH_ECC_MAX_BYTES];        /*!< Private key                */
+	uint8_t  k[BENCH_ECC_MAX_BYTES];        /*!< Signing nonce              */
+	uint8_t  qx[BENCH_ECC_MAX_BYTES];       /*!< Public key                 */
+	uint8_t  qy[BENCH_ECC_MAX_BYTES];
+	uint8_t  hash[BENCH_ECC_MAX_BYTES];     /*!< Message, truncated to n    */
+	uint8_t  r[BENCH_ECC_MAX_BYTES];        /*!< Signature from BENCH_ECC_SIGN */
+	uint8_t  s[BENCH_ECC_MAX_BYTES];
+	uint8_t  z[BENCH_ECC_MAX_BYTES];        /*!< Secret from BENCH_ECC_ECDH */
+} bench_ecc_key_t;
+
+/* Run BENCH_ECC_xxx op on key; return 0 or < 0 on error */
+typedef int (*bench_ecc_fn_t)(int op, bench_ecc_key_t *key);
+
+/* Provided by the caller */
+uint64_t bench_ticks(void);
+extern uint32_t bench_tick_hz;          /*!< bench_ticks() rate         */
+extern uint32_t bench_cpu_hz;           /*!< CPU clock for cycle counts */
+
+void bench_run(const bench_case_t cases[], int ncases, uint8_t *in, uint8_t *out_hw, uint8_t *out_sw);
+void bench_run_ecc(bench_ecc_fn_t hw);
+
+/* mbedTLS reference implementations, usable as bench_case_t.sw */
+int  bench_sw_aes_ecb(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_aes_cbc(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_aes_ctr(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_aes_gcm(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_sha1(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_sha224(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_sha256(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_sha384(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_sha512(uint8_t *in, uint8_t *out, uint32_t len);
+int  bench_sw_hmac_sha256(uint8_t *in, uint8_t *out, uint32_t len);
+
+/* Key, IV and HMAC key used by both sides */
+extern const uint8_t bench_key[16];
+extern const uint8_t bench_iv[16];
+extern const uint8_t bench_hmac_key[32];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,7 @@
+/**************************************************************************//**
+ * @file     NuMicro.h
+ * @brief    Empty stand-in for the host build of the benchmark; the mbedTLS
+ *           copy in ThirdParty includes NuMicro.h from platform.h.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
@@ -0,0 +1,278 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    This sample program times the CRYPTO engine against the mbedTLS
+ *           software implementations: AES-128 ECB/CBC/CTR/GCM, SM4, SHA-1/2
+ *           and HMAC-SHA-256 from 16 bytes to 1 MB, and ECDSA and ECDH on the
+ *           NIST prime curves. It reports cycles per byte and the size from
+ *           which the engine is faster, which is where a driver should start
+ *           dispatching to it (see CRYPTO_ALT_AES_DMA_MIN and
+ *           CRYPTO_ALT_SHA_DMA_MIN in the lwIP mbedtls_alt).
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "bench.h"
+
+/*
+ * Buffers are cacheable, like the buffers a driver is handed. The engine
+ * cases include the cache maintenance around each DMA run in their time.
+ */
+uint8_t g_in_pool[BENCH_HEADROOM + BENCH_MAX_LEN] __attribute__((aligned(64)));
+uint8_t g_out_hw[BENCH_OUT_LEN] __attribute__((aligned(64)));
+uint8_t g_out_sw[BENCH_OUT_LEN] __attribute__((aligned(64)));
+
+uint32_t g_key_w[8];
+uint32_t g_iv_w[4];
+
+uint32_t bench_tick_hz = 12000000;
+uint32_t bench_cpu_hz;
+
+uint64_t bench_ticks(void)
+{
+	return EL0_GetCurrentPhysicalValue();
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put_be32(uint32_t v, uint8_t *p)
+{
+	p[0] = (uint8_t)(v >> 24);
+	p[1] = (uint8_t)(v >> 16);
+	p[2] = (uint8_t)(v >> 8);
+	p[3] = (uint8_t)v;
+}
+
+/*---------------------------------------------------------------------------*/
+/* CRYPTO engine cases                                                       */
+/*---------------------------------------------------------------------------*/
+
+static int hw_cipher(uint32_t opmode, int is_sm4, uint8_t *in, uint8_t *out, uint32_t len)
+{
+	dcache_clean_by_mva(in, len);
+	dcache_invalidate_by_mva(out, len);
+
+	AES_Open(CRPT, AES_MODE_ENCRYPT, opmode, AES_KEY_SIZE_128, AES_IN_OUT_SWAP);
+	AES_SetKey(CRPT, g_key_w, AES_KEY_SIZE_128);
+	AES_SetInitVect(CRPT, g_iv_w);
+	AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(in), ptr_to_u32(out), len);
+
+	if (AES_Start(CRPT, is_sm4, CRYPTO_DMA_ONE_SHOT) != 0)
+		return -1;
+
+	dcache_invalidate_by_mva(out, len);
+	return 0;
+}
+
+static int hw_aes_ecb(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_cipher(AES_MODE_ECB, 0, in, out, len);
+}
+
+static int hw_aes_cbc(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_cipher(AES_MODE_CBC, 0, in, out, len);
+}
+
+static int hw_aes_ctr(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_cipher(AES_MODE_CTR, 0, in, out, len);
+}
+
+static int hw_sm4_ecb(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_cipher(AES_MODE_ECB, 1, in, out, len);
+}
+
+static int hw_sm4_cbc(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_cipher(AES_MODE_CBC, 1, in, out, len);
+}
+
+static int hw_sm4_ctr(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_cipher(AES_MODE_CTR, 1, in, out, len);
+}
+
+/*
+ * The engine reads IV | A | P, each padded to a block, and writes C and the
+ * tag. The 96-bit IV block goes into the headroom in front of the input.
+ */
+static int hw_aes_gcm(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	uint8_t  *buf = in - 16;
+
+	memcpy(buf, bench_iv, 12);
+	memset(buf + 12, 0, 4);
+
+	dcache_clean_by_mva(buf, len + 16);
+	dcache_invalidate_by_mva(out, len + 16);
+
+	AES_Open(CRPT, AES_MODE_ENCRYPT, AES_MODE_GCM, AES_KEY_SIZE_128, AES_IN_OUT_SWAP);
+	AES_SetKey(CRPT, g_key_w, AES_KEY_SIZE_128);
+	CRPT->AES_GCM_IVCNT[0] = 12;
+	CRPT->AES_GCM_IVCNT[1] = 0;
+	CRPT->AES_GCM_ACNT[0] = 0;
+	CRPT->AES_GCM_ACNT[1] = 0;
+	CRPT->AES_GCM_PCNT[0] = len;
+	CRPT->AES_GCM_PCNT[1] = 0;
+	AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(buf), ptr_to_u32(out), len + 16);
+
+	if (AES_Start(CRPT, 0, CRYPTO_DMA_ONE_SHOT) != 0)
+		return -1;
+
+	dcache_invalidate_by_mva(out, len + 16);
+	return 0;
+}
+
+/* hmac_key_len bytes of key, if any, are in front of the message */
+static int hw_sha(uint32_t opmode, int dlen, uint32_t hmac_key_len, uint8_t *in, uint8_t *out, uint32_t len)
+{
+	uint32_t  dgst[16];
+	int  i;
+
+	dcache_clean_by_mva(in, len);
+
+	SHA_Open(CRPT, opmode, SHA_IN_OUT_SWAP, hmac_key_len);
+	SHA_SetDMATransfer(CRPT, ptr_to_u32(in), len);
+
+	if (SHA_Start(CRPT, CRYPTO_DMA_ONE_SHOT) != 0)
+		return -1;
+
+	SHA_Read(CRPT, dgst);
+	for (i = 0; i < dlen / 4; i++)
+		put_be32(dgst[i], out + 4 * i);
+	return 0;
+}
+
+static int hw_sha1(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_sha(SHA_MODE_SHA1, 20, 0, in, out, len);
+}
+
+static int hw_sha224(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_sha(SHA_MODE_SHA224, 28, 0, in, out, len);
+}
+
+static int hw_sha256(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_sha(SHA_MODE_SHA256, 32, 0, in, out, len);
+}
+
+static int hw_sha384(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_sha(SHA_MODE_SHA384, 48, 0, in, out, len);
+}
+
+static int hw_sha512(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	return hw_sha(SHA_MODE_SHA512, 64, 0, in, out, len);
+}
+
+static int hw_hmac_sha256(uint8_t *in, uint8_t *out, uint32_t len)
+{
+	uint8_t  *buf = in - sizeof(bench_hmac_key);
+
+	memcpy(buf, bench_hmac_key, sizeof(bench_hmac_key));
+	return hw_sha(SHA_MODE_SHA256, 32, sizeof(bench_hmac_key), buf, out, len + sizeof(bench_hmac_key));
+}
+
+/*
+ * The signing nonce is reused on every round. That is only acceptable
+ * because nothing here is a real signature.
+ */
+static int hw_ecc(int op, bench_ecc_key_t *key)
+{
+	E_ECC_CURVE  curve = (E_ECC_CURVE)key->curve;
+
+	switch (op)
+	{
+	case BENCH_ECC_SIGN:
+		return ECC_GenerateSignature_Bin(CRPT, curve, key->hash, key->d, key->k, key->r, key->s);
+	case BENCH_ECC_VERIFY:
+		return ECC_VerifySignature_Bin(CRPT, curve, key->hash, key->qx, key->qy, key->r, key->s);
+	default:
+		return ECC_GenerateSecretZ_Bin(CRPT, curve, key->d, key->qx, key->qy, key->z);
+	}
+}
+
+static const bench_case_t  g_cases[] =
+{
+	{ "AES-128-ECB",  hw_aes_ecb,     bench_sw_aes_ecb,     BENCH_CMP_DATA },
+	{ "AES-128-CBC",  hw_aes_cbc,     bench_sw_aes_cbc,     BENCH_CMP_DATA },
+	{ "AES-128-CTR",  hw_aes_ctr,     bench_sw_aes_ctr,     BENCH_CMP_DATA },
+	{ "AES-128-GCM",  hw_aes_gcm,     bench_sw_aes_gcm,     BENCH_CMP_TAG  },
+	{ "SM4-ECB",      hw_sm4_ecb,     NULL,                 BENCH_CMP_NONE },
+	{ "SM4-CBC",      hw_sm4_cbc,     NULL,                 BENCH_CMP_NONE },
+	{ "SM4-CTR",      hw_sm4_ctr,     NULL,                 BENCH_CMP_NONE },
+	{ "SHA-1",        hw_sha1,        bench_sw_sha1,        20 },
+	{ "SHA-224",      hw_sha224,      bench_sw_sha224,      28 },
+	{ "SHA-256",      hw_sha256,      bench_sw_sha256,      32 },
+	{ "SHA-384",      hw_sha384,      bench_sw_sha384,      48 },
+	{ "SHA-512",      hw_sha512,      bench_sw_sha512,      64 },
+	{ "HMAC-SHA-256", hw_hmac_sha256, bench_sw_hmac_sha256, 32 },
+};
+
+void SYS_Init(void)
+{
+	/* Waiting LXT ready */
+	CLK_WaitClockReady(CLK_STATUS_LXTSTB_Msk);
+
+	/* Enable UART module clock */
+	CLK_EnableModuleClock(UART0_MODULE);
+
+	/* Select UART module clock source as SYSCLK1 and UART module clock divider as 15 */
+	CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL2_UART0SEL_SYSCLK1_DIV2, CLK_CLKDIV1_UART0(15));
+
+	/* Enable Crypto engine clock */
+	outpw(TSI_CLK_BASE + 0x4, inpw(TSI_CLK_BASE + 0x4) | (1 << 12));
+
+	/* Set GPE multi-function pins for UART0 RXD and TXD */
+	SYS->GPE_MFPH &= ~(SYS_GPE_MFPH_PE14MFP_Msk | SYS_GPE_MFPH_PE15MFP_Msk);
+	SYS->GPE_MFPH |= (SYS_GPE_MFPH_PE14MFP_UART0_TXD | SYS_GPE_MFPH_PE15MFP_UART0_RXD);
+}
+
+int32_t main(void)
+{
+	int  i;
+
+	/* Unlock protected registers */
+	SYS_UnlockReg();
+
+	/* Init System, IP clock and multi-function I/O */
+	SYS_Init();
+
+	/* Init UART to 115200-8n1 for print message */
+	UART_Open(UART0, 115200);
+
+	Crypto_Init();
+
+	/* The Cortex-A35 runs from CA-PLL */
+	bench_cpu_hz = CLK_GetPLLClockFreq(CAPLL);
+
+	for (i = 0; i < 4; i++)
+	{
+		g_key_w[i] = get_be32(bench_key + 4 * i);
+		g_iv_w[i] = get_be32(bench_iv + 4 * i);
+	}
+
+	sysprintf("\n\n");
+	sysprintf("+----------------------------------------+\n");
+	sysprintf("|  Crypto hardware vs software benchmark |\n");
+	sysprintf("+----------------------------------------+\n");
+	sysprintf("CPU clock %d MHz\n", bench_cpu_hz / 1000000);
+
+	bench_run(g_cases, sizeof(g_cases) / sizeof(g_cases[0]),
+			  g_in_pool + BENCH_HEADROOM, g_out_hw, g_out_sw);
+
+	bench_run_ecc(hw_ecc);
+
+	sysprintf("\n\nBenchmark done.\n");
+	while (1);
+}
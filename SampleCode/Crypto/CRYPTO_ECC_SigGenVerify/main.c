@@ -298,6 +298,124 @@ static int ecc_strcmp(char *s1, char *s2)
 	return 0;
 }
 
+/*
+ *  ECC_VerifyBatch_Bin() known answers on P-256 with SHA-256. The "sample" and
+ *  "test" signatures are RFC 6979 A.2.5; the empty message is signed with the
+ *  same key and the k of the P-256 vector above.
+ */
+static const uint8_t _bv_Qx[32] =
+{
+	0x60, 0xfe, 0xd4, 0xba, 0x25, 0x5a, 0x9d, 0x31, 0xc9, 0x61, 0xeb, 0x74, 0xc6, 0x35, 0x6d, 0x68,
+	0xc0, 0x49, 0xb8, 0x92, 0x3b, 0x61, 0xfa, 0x6c, 0xe6, 0x69, 0x62, 0x2e, 0x60, 0xf2, 0x9f, 0xb6
+};
+
+static const uint8_t _bv_Qy[32] =
+{
+	0x79, 0x03, 0xfe, 0x10, 0x08, 0xb8, 0xbc, 0x99, 0xa4, 0x1a, 0xe9, 0xe9, 0x56, 0x28, 0xbc, 0x64,
+	0xf2, 0xf1, 0xb2, 0x0c, 0x2d, 0x7e, 0x9f, 0x51, 0x77, 0xa3, 0xc2, 0x94, 0xd4, 0x46, 0x22, 0x99
+};
+
+static const uint8_t _bv_sample_R[32] =
+{
+	0xef, 0xd4, 0x8b, 0x2a, 0xac, 0xb6, 0xa8, 0xfd, 0x11, 0x40, 0xdd, 0x9c, 0xd4, 0x5e, 0x81, 0xd6,
+	0x9d, 0x2c, 0x87, 0x7b, 0x56, 0xaa, 0xf9, 0x91, 0xc3, 0x4d, 0x0e, 0xa8, 0x4e, 0xaf, 0x37, 0x16
+};
+
+static const uint8_t _bv_sample_S[32] =
+{
+	0xf7, 0xcb, 0x1c, 0x94, 0x2d, 0x65, 0x7c, 0x41, 0xd4, 0x36, 0xc7, 0xa1, 0xb6, 0xe2, 0x9f, 0x65,
+	0xf3, 0xe9, 0x00, 0xdb, 0xb9, 0xaf, 0xf4, 0x06, 0x4d, 0xc4, 0xab, 0x2f, 0x84, 0x3a, 0xcd, 0xa8
+};
+
+static const uint8_t _bv_empty_R[32] =
+{
+	0x2b, 0x82, 0x6f, 0x5d, 0x44, 0xe2, 0xd0, 0xb6, 0xde, 0x53, 0x1a, 0xd9, 0x6b, 0x51, 0xe8, 0xf0,
+	0xc5, 0x6f, 0xdf, 0xea, 0xd3, 0xc2, 0x36, 0x89, 0x2e, 0x4d, 0x84, 0xea, 0xcf, 0xc3, 0xb7, 0x5c
+};
+
+static const uint8_t _bv_empty_S[32] =
+{
+	0x22, 0x8d, 0x52, 0x09, 0x6b, 0xf3, 0xca, 0x41, 0x03, 0xc2, 0xd0, 0x8f, 0xdb, 0x81, 0x2f, 0x87,
+	0x0c, 0x65, 0xd6, 0x95, 0xd3, 0x96, 0x40, 0x4e, 0xf6, 0xa5, 0x44, 0x49, 0x88, 0xfb, 0x83, 0x37
+};
+
+static const uint8_t _bv_test_hash[32] =
+{
+	0x9f, 0x86, 0xd0, 0x81, 0x88, 0x4c, 0x7d, 0x65, 0x9a, 0x2f, 0xea, 0xa0, 0xc5, 0x5a, 0xd0, 0x15,
+	0xa3, 0xbf, 0x4f, 0x1b, 0x2b, 0x0b, 0x82, 0x2c, 0xd1, 0x5d, 0x6c, 0x15, 0xb0, 0xf0, 0x0a, 0x08
+};
+
+static const uint8_t _bv_test_R[32] =
+{
+	0xf1, 0xab, 0xb0, 0x23, 0x51, 0x83, 0x51, 0xcd, 0x71, 0xd8, 0x81, 0x56, 0x7b, 0x1e, 0xa6, 0x63,
+	0xed, 0x3e, 0xfc, 0xf6, 0xc5, 0x13, 0x2b, 0x35, 0x4f, 0x28, 0xd3, 0xb0, 0xb7, 0xd3, 0x83, 0x67
+};
+
+static const uint8_t _bv_test_S[32] =
+{
+	0x01, 0x9f, 0x41, 0x13, 0x74, 0x2a, 0x2b, 0x14, 0xbd, 0x25, 0x92, 0x6b, 0x49, 0xc6, 0x49, 0x15,
+	0x5f, 0x26, 0x7e, 0x60, 0xd3, 0x81, 0x4b, 0x4c, 0x0c, 0xc8, 0x42, 0x50, 0xe4, 0x6f, 0x00, 0x83
+};
+
+static uint8_t _bv_sample[8] __attribute__((aligned(32))) = "sample";
+static uint8_t _bv_tampered[8] __attribute__((aligned(32))) = "sbmple";
+
+static int ECC_BatchVerifyTest(void)
+{
+	ECC_VERIFY_ITEM_T  items[4];
+	static const int32_t  expect[4] = { 0, -2, 0, 0 };
+	int  i, nvalid;
+
+	sysprintf("+---------------------------------------------+\n");
+	sysprintf("|   Crypto ECC Batch Verification Test        |\n");
+	sysprintf("+---------------------------------------------+\n");
+
+	memset(items, 0, sizeof(items));
+	for (i = 0; i < 4; i++)
+	{
+		items[i].pu8PubX = _bv_Qx;
+		items[i].pu8PubY = _bv_Qy;
+		items[i].i32Result = 1;
+	}
+
+	/* [0] valid, hashed on the SHA engine */
+	items[0].pu8Msg = _bv_sample;
+	items[0].u32MsgLen = 6;
+	items[0].pu8R = _bv_sample_R;
+	items[0].pu8S = _bv_sample_S;
+
+	/* [1] the same signature on a tampered message */
+	items[1].pu8Msg = _bv_tampered;
+	items[1].u32MsgLen = 6;
+	items[1].pu8R = _bv_sample_R;
+	items[1].pu8S = _bv_sample_S;
+
+	/* [2] the empty message, digest from the driver table */
+	items[2].pu8Msg = _bv_sample;
+	items[2].u32MsgLen = 0;
+	items[2].pu8R = _bv_empty_R;
+	items[2].pu8S = _bv_empty_S;
+
+	/* [3] hash given by the caller */
+	items[3].pu8Hash = _bv_test_hash;
+	items[3].pu8R = _bv_test_R;
+	items[3].pu8S = _bv_test_S;
+
+	nvalid = ECC_VerifyBatch_Bin(CRPT, CURVE_P_256, SHA_MODE_SHA256, items, 4);
+	for (i = 0; i < 4; i++)
+	{
+		sysprintf("Batch item [%d] result %d, expect %d\n", i, items[i].i32Result, expect[i]);
+		if (items[i].i32Result != expect[i])
+			return -1;
+	}
+	if (nvalid != 3)
+	{
+		sysprintf("ECC_VerifyBatch_Bin returned %d, expect 3\n", nvalid);
+		return -1;
+	}
+	return 0;
+}
+
 void SYS_Init(void)
 {
 	/* Waiting LXT ready */
@@ -395,5 +513,12 @@ int32_t main(void)
 		sysprintf("[PASS]\n");
 	}
 	sysprintf("ECC signature verification test passed.\n");
+
+	if (ECC_BatchVerifyTest() != 0)
+	{
+		sysprintf("ECC batch verification failed!!\n");
+		while (1);
+	}
+	sysprintf("ECC batch verification test passed.\n");
 	while (1);
 }
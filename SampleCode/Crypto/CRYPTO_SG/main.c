@@ -0,0 +1,423 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    This sample program demonstrates Crypto AES/SHA scatter-gather
+ *           lists and streams that share the engine. AES_RunSG()/SHA_RunSG()
+ *           lists of 1 to 7 segments, in one call or chained over three calls,
+ *           and two AES and two SHA streams taking turns with the
+ *           xxx_SaveContext()/xxx_RestoreContext() functions are compared with
+ *           one-shot AES_Start()/SHA_Start() runs.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+
+#define MSG_SIZE        2048
+#define STREAM_CNT      2
+#define SG_MAX          7
+
+/* Cacheable buffers, AES_RunSG() and SHA_RunSG() do the cache maintenance */
+uint8_t  au8Msg[STREAM_CNT][MSG_SIZE] __attribute__((aligned(64)));
+uint8_t  au8RefOut[STREAM_CNT][MSG_SIZE] __attribute__((aligned(64)));
+uint8_t  au8Out[STREAM_CNT][MSG_SIZE] __attribute__((aligned(64)));
+
+static CRYPTO_AES_CTX_T  _aes_ctx[STREAM_CNT];
+static CRYPTO_SHA_CTX_T  _sha_ctx[STREAM_CNT];
+
+static CRYPTO_SG_T  _sg[SG_MAX];
+static uint32_t  _aes_fdbck[CRYPTO_AES_FDBCK_SIZE / 4] __attribute__((aligned(64)));
+static uint32_t  _sha_fdbck[CRYPTO_SHA_FDBCK_SIZE / 4] __attribute__((aligned(64)));
+
+static uint32_t  _aes_key[STREAM_CNT][8] = {
+	{ 0x2b7e1516, 0x28aed2a6, 0xabf71588, 0x09cf4f3c, 0, 0, 0, 0 },
+	{ 0x603deb10, 0x15ca71be, 0x2b73aef0, 0x857d7781, 0x1f352c07, 0x3b6108d7, 0x2d9810a3, 0x0914dff4 }
+};
+
+static uint32_t  _aes_iv[STREAM_CNT][4] = {
+	{ 0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f },
+	{ 0xf0f1f2f3, 0xf4f5f6f7, 0xf8f9fafb, 0xfcfdfeff }
+};
+
+static const uint32_t  _aes_mode[STREAM_CNT] = { AES_MODE_CBC, AES_MODE_CTR };
+static const uint32_t  _aes_keysz[STREAM_CNT] = { AES_KEY_SIZE_128, AES_KEY_SIZE_256 };
+static const uint32_t  _sha_mode[STREAM_CNT] = { SHA_MODE_SHA256, SHA_MODE_SHA512 };
+static const uint32_t  _sha_block[STREAM_CNT] = { 64, 128 };
+
+static const int  _nseg_list[] = { 1, 3, 5, 7 };
+
+/* Segment byte counts, whole SHA-512 blocks except the end of the SHA messages */
+static const uint32_t  _aes_seg[] = { 48, 80, 16, 112, 256 };
+static const uint32_t  _sha_seg[] = { 128, 256, 100 };
+
+#define AES_SEG_CNT     (sizeof(_aes_seg) / sizeof(_aes_seg[0]))
+#define SHA_SEG_CNT     (sizeof(_sha_seg) / sizeof(_sha_seg[0]))
+
+static void  dump_buff_hex(uint8_t *pucBuff, int nBytes)
+{
+	int  i;
+
+	for (i = 0; i < nBytes; i++)
+	{
+		sysprintf("%02x ", pucBuff[i]);
+		if ((i % 16) == 15)
+			sysprintf("\n");
+	}
+	sysprintf("\n");
+}
+
+static uint32_t seg_mode(int i, int nseg)
+{
+	if (i == 0)
+		return CRYPTO_DMA_FIRST;
+	if (i == nseg - 1)
+		return CRYPTO_DMA_LAST;
+	return CRYPTO_DMA_CONTINUE;
+}
+
+/* Byte offset of segment i, the message length for i = segment count */
+static uint32_t seg_offset(const uint32_t seg[], int i)
+{
+	uint32_t  off = 0;
+
+	while (i > 0)
+		off += seg[--i];
+	return off;
+}
+
+static void aes_open(int s)
+{
+	AES_Open(CRPT, AES_MODE_ENCRYPT, _aes_mode[s], _aes_keysz[s], AES_IN_OUT_SWAP);
+	AES_SetKey(CRPT, _aes_key[s], _aes_keysz[s]);
+	AES_SetInitVect(CRPT, _aes_iv[s]);
+}
+
+/* Uninterrupted AES of the whole message with AES_Start() */
+static int aes_one_shot(int s, uint8_t *in, uint8_t *out, uint32_t len)
+{
+	aes_open(s);
+
+	dcache_clean_by_mva(in, len);
+	dcache_clean_invalidate_by_mva(out, len);
+
+	AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(in), ptr_to_u32(out), len);
+	if (AES_Start(CRPT, 0, CRYPTO_DMA_ONE_SHOT) != 0)
+	{
+		sysprintf("AES time-out!\n");
+		return -1;
+	}
+	dcache_invalidate_by_mva(out, len);
+	return 0;
+}
+
+/* Uninterrupted SHA of the whole message with SHA_Start() */
+static int sha_one_shot(int s, uint8_t *in, uint32_t len, uint32_t au32Digest[])
+{
+	SHA_Open(CRPT, _sha_mode[s], SHA_IN_OUT_SWAP, 0);
+
+	dcache_clean_by_mva(in, len);
+
+	SHA_SetDMATransfer(CRPT, ptr_to_u32(in), len);
+	if (SHA_Start(CRPT, CRYPTO_DMA_ONE_SHOT) != 0)
+	{
+		sysprintf("SHA time-out!\n");
+		return -1;
+	}
+	SHA_Read(CRPT, au32Digest);
+	return 0;
+}
+
+/* Split len bytes into nseg segments of 1, 2 or 3 blocks, the rest goes to the last one */
+static void sg_split(int nseg, uint8_t *src, uint8_t *dst, uint32_t len, uint32_t block)
+{
+	uint32_t  off = 0;
+	int  k;
+
+	for (k = 0; k < nseg; k++)
+	{
+		_sg[k].pvSrc = src + off;
+		_sg[k].pvDst = (dst != NULL) ? dst + off : NULL;
+		_sg[k].u32Len = (k == nseg - 1) ? len - off : block * (k % 3 + 1);
+		off += _sg[k].u32Len;
+	}
+}
+
+/* The list in one call, or in three calls chained through the feedback buffer */
+static int aes_run_list(int s, int nseg, int chained)
+{
+	aes_open(s);
+	if (!chained)
+		return AES_RunSG(CRPT, 0, _sg, nseg, CRYPTO_DMA_ONE_SHOT, NULL);
+
+	if ((AES_RunSG(CRPT, 0, &_sg[0], 1, CRYPTO_DMA_FIRST, _aes_fdbck) != 0) ||
+		(AES_RunSG(CRPT, 0, &_sg[1], nseg - 2, CRYPTO_DMA_CONTINUE, _aes_fdbck) != 0))
+		return -1;
+	return AES_RunSG(CRPT, 0, &_sg[nseg - 1], 1, CRYPTO_DMA_LAST, _aes_fdbck);
+}
+
+static int sha_run_list(int s, int nseg, int chained)
+{
+	SHA_Open(CRPT, _sha_mode[s], SHA_IN_OUT_SWAP, 0);
+	if (!chained)
+		return SHA_RunSG(CRPT, _sg, nseg, CRYPTO_DMA_ONE_SHOT, NULL);
+
+	if ((SHA_RunSG(CRPT, &_sg[0], 1, CRYPTO_DMA_FIRST, _sha_fdbck) != 0) ||
+		(SHA_RunSG(CRPT, &_sg[1], nseg - 2, CRYPTO_DMA_CONTINUE, _sha_fdbck) != 0))
+		return -1;
+	return SHA_RunSG(CRPT, &_sg[nseg - 1], 1, CRYPTO_DMA_LAST, _sha_fdbck);
+}
+
+static void test_data_init(void)
+{
+	uint32_t  k32 = 0x1A39175D;
+	int  s, i;
+
+	for (s = 0; s < STREAM_CNT; s++)
+	{
+		for (i = 0; i < MSG_SIZE; i++)
+		{
+			k32 = k32 * 1103515245 + 12345;
+			au8Msg[s][i] = (k32 >> 16) & 0xff;
+		}
+	}
+}
+
+int SG_SegmentTest(void)
+{
+	uint32_t  au32RefDgst[16], au32Dgst[16];
+	uint32_t  sha_len;
+	int  s, n, nseg, chained;
+
+	sysprintf("\n");
+	sysprintf("+---------------------------------------------------+\n");
+	sysprintf("|  AES_RunSG()/SHA_RunSG() segment lists            |\n");
+	sysprintf("+---------------------------------------------------+\n");
+
+	for (s = 0; s < STREAM_CNT; s++)
+	{
+		if (aes_one_shot(s, au8Msg[s], au8RefOut[s], MSG_SIZE) != 0)
+			return -1;
+
+		for (n = 0; n < sizeof(_nseg_list) / sizeof(_nseg_list[0]); n++)
+		{
+			nseg = _nseg_list[n];
+			for (chained = 0; chained <= (nseg >= 3); chained++)
+			{
+				sysprintf("AES mode %d, %d segments in %d call(s)...", _aes_mode[s], nseg, chained ? 3 : 1);
+				memset(au8Out[s], 0, MSG_SIZE);
+				sg_split(nseg, au8Msg[s], au8Out[s], MSG_SIZE, 16);
+				if ((aes_run_list(s, nseg, chained) != 0) || (memcmp(au8Out[s], au8RefOut[s], MSG_SIZE) != 0))
+				{
+					sysprintf("[FAIL]\n");
+					dump_buff_hex(au8Out[s], 64);
+					return -1;
+				}
+				sysprintf("[PASS]\n");
+			}
+		}
+
+		sysprintf("AES mode %d, 5 segments in place...", _aes_mode[s]);
+		memcpy(au8Out[s], au8Msg[s], MSG_SIZE);
+		sg_split(5, au8Out[s], au8Out[s], MSG_SIZE, 16);
+		if ((aes_run_list(s, 5, 1) != 0) || (memcmp(au8Out[s], au8RefOut[s], MSG_SIZE) != 0))
+		{
+			sysprintf("[FAIL]\n");
+			return -1;
+		}
+		sysprintf("[PASS]\n");
+	}
+
+	/* The SHA messages end with a partial block */
+	sha_len = MSG_SIZE - 28;
+	for (s = 0; s < STREAM_CNT; s++)
+	{
+		memset(au32RefDgst, 0, sizeof(au32RefDgst));
+		if (sha_one_shot(s, au8Msg[s], sha_len, au32RefDgst) != 0)
+			return -1;
+
+		for (n = 0; n < sizeof(_nseg_list) / sizeof(_nseg_list[0]); n++)
+		{
+			nseg = _nseg_list[n];
+			for (chained = 0; chained <= (nseg >= 3); chained++)
+			{
+				sysprintf("SHA mode %d, %d segments in %d call(s)...", _sha_mode[s], nseg, chained ? 3 : 1);
+				memset(au32Dgst, 0, sizeof(au32Dgst));
+				sg_split(nseg, au8Msg[s], NULL, sha_len, _sha_block[s]);
+				if (sha_run_list(s, nseg, chained) != 0)
+				{
+					sysprintf("[FAIL]\n");
+					return -1;
+				}
+				SHA_Read(CRPT, au32Dgst);
+				if (memcmp(au32Dgst, au32RefDgst, sizeof(au32Dgst)) != 0)
+				{
+					sysprintf("[FAIL]\n");
+					dump_buff_hex((uint8_t *)au32Dgst, 64);
+					return -1;
+				}
+				sysprintf("[PASS]\n");
+			}
+		}
+	}
+	return 0;
+}
+
+int Stream_InterleaveTest(void)
+{
+	CRYPTO_SG_T  sg;
+	uint32_t  au32RefDgst[STREAM_CNT][16], au32Dgst[STREAM_CNT][16];
+	uint32_t  off, aes_len, sha_len;
+	int  i, s, nseg;
+
+	sysprintf("\n");
+	sysprintf("+---------------------------------------------------+\n");
+	sysprintf("|  Interleaved AES/SHA streams                      |\n");
+	sysprintf("+---------------------------------------------------+\n");
+
+	aes_len = seg_offset(_aes_seg, AES_SEG_CNT);
+	sha_len = seg_offset(_sha_seg, SHA_SEG_CNT);
+	memset(au32RefDgst, 0, sizeof(au32RefDgst));
+
+	for (s = 0; s < STREAM_CNT; s++)
+	{
+		if ((aes_one_shot(s, au8Msg[s], au8RefOut[s], aes_len) != 0) ||
+			(sha_one_shot(s, au8Msg[s], sha_len, au32RefDgst[s]) != 0))
+			return -1;
+	}
+
+	memset(au8Out, 0, sizeof(au8Out));
+	memset(au32Dgst, 0, sizeof(au32Dgst));
+
+	/*
+	 *  One segment of each stream per round. The AES streams differ in mode and
+	 *  key size, the SHA streams in algorithm, so a state left over from the
+	 *  other stream shows up in the result.
+	 */
+	nseg = (AES_SEG_CNT > SHA_SEG_CNT) ? AES_SEG_CNT : SHA_SEG_CNT;
+	for (i = 0; i < nseg; i++)
+	{
+		for (s = 0; (i < AES_SEG_CNT) && (s < STREAM_CNT); s++)
+		{
+			if (i == 0)
+				aes_open(s);
+			else
+				AES_RestoreContext(CRPT, &_aes_ctx[s]);
+
+			off = seg_offset(_aes_seg, i);
+			sg.pvSrc = &au8Msg[s][off];
+			sg.pvDst = &au8Out[s][off];
+			sg.u32Len = _aes_seg[i];
+			if (AES_RunSG(CRPT, 0, &sg, 1, seg_mode(i, AES_SEG_CNT), _aes_ctx[s].au32Fdbck) != 0)
+			{
+				sysprintf("AES_RunSG stream %d segment %d failed!\n", s, i);
+				return -1;
+			}
+			if (AES_SaveContext(CRPT, &_aes_ctx[s]) != 0)
+			{
+				sysprintf("AES_SaveContext stream %d failed!\n", s);
+				return -1;
+			}
+		}
+
+		for (s = 0; (i < SHA_SEG_CNT) && (s < STREAM_CNT); s++)
+		{
+			if (i == 0)
+				SHA_Open(CRPT, _sha_mode[s], SHA_IN_OUT_SWAP, 0);
+			else
+				SHA_RestoreContext(CRPT, &_sha_ctx[s]);
+
+			sg.pvSrc = &au8Msg[s][seg_offset(_sha_seg, i)];
+			sg.pvDst = NULL;
+			sg.u32Len = _sha_seg[i];
+			if (SHA_RunSG(CRPT, &sg, 1, seg_mode(i, SHA_SEG_CNT), _sha_ctx[s].au32Fdbck) != 0)
+			{
+				sysprintf("SHA_RunSG stream %d segment %d failed!\n", s, i);
+				return -1;
+			}
+			if (i == SHA_SEG_CNT - 1)
+				SHA_Read(CRPT, au32Dgst[s]);
+			else
+				SHA_SaveContext(CRPT, &_sha_ctx[s]);
+		}
+	}
+
+	for (s = 0; s < STREAM_CNT; s++)
+	{
+		sysprintf("AES stream %d...", s);
+		if (memcmp(au8Out[s], au8RefOut[s], aes_len) != 0)
+		{
+			sysprintf("[FAIL]\nInterleaved:\n");
+			dump_buff_hex(au8Out[s], 64);
+			sysprintf("Uninterrupted:\n");
+			dump_buff_hex(au8RefOut[s], 64);
+			return -1;
+		}
+		sysprintf("[PASS]\n");
+
+		sysprintf("SHA stream %d...", s);
+		if (memcmp(au32Dgst[s], au32RefDgst[s], sizeof(au32Dgst[s])) != 0)
+		{
+			sysprintf("[FAIL]\nInterleaved:\n");
+			dump_buff_hex((uint8_t *)au32Dgst[s], 64);
+			sysprintf("Uninterrupted:\n");
+			dump_buff_hex((uint8_t *)au32RefDgst[s], 64);
+			return -1;
+		}
+		sysprintf("[PASS]\n");
+	}
+
+	memset(_aes_ctx, 0, sizeof(_aes_ctx));
+	return 0;
+}
+
+void SYS_Init(void)
+{
+	/* Enable LXT */
+	CLK->PWRCTL |= CLK_PWRCTL_LXTEN_Msk; // 32K (LXT) Enabled
+
+	/* Waiting LXT ready */
+	CLK_WaitClockReady(CLK_STATUS_LXTSTB_Msk);
+
+	/* Enable UART module clock */
+	CLK_EnableModuleClock(UART0_MODULE);
+
+	/* Select UART module clock source as SYSCLK1 and UART module clock divider as 15 */
+	CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL2_UART0SEL_SYSCLK1_DIV2, CLK_CLKDIV1_UART0(15));
+
+	/* Enable Crypto engine clock */
+	outpw(TSI_CLK_BASE + 0x4, inpw(TSI_CLK_BASE + 0x4) | (1 << 12));
+
+	/* Set GPE multi-function pins for UART0 RXD and TXD */
+	SYS->GPE_MFPH &= ~(SYS_GPE_MFPH_PE14MFP_Msk | SYS_GPE_MFPH_PE15MFP_Msk);
+	SYS->GPE_MFPH |= (SYS_GPE_MFPH_PE14MFP_UART0_TXD | SYS_GPE_MFPH_PE15MFP_UART0_RXD);
+}
+
+int32_t main(void)
+{
+	int  err;
+
+	/* Unlock protected registers */
+	SYS_UnlockReg();
+
+	/* Init System, IP clock and multi-function I/O */
+	SYS_Init();
+
+	/* Init UART to 115200-8n1 for print message */
+	UART_Open(UART0, 115200);
+
+	Crypto_Init();
+
+	test_data_init();
+
+	err = SG_SegmentTest();
+	if (err == 0)
+		err = Stream_InterleaveTest();
+
+	if (err == 0)
+		sysprintf("\n\nTest passed.\n");
+	else
+		sysprintf("\n\nTest failed!\n");
+
+	while (1);
+}
@@ -0,0 +1,591 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    This sample program demonstrates the Key Store key handle manager.
+ *           It adds more keys than Key Store SRAM can hold, so keys are evicted
+ *           and written again, and checks every key, AES and ECC result.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+
+#define HKEY_CNT        (KS_SRAM_KEY_CNT + 8)   /* more keys than Key Store SRAM holds */
+#define HKEY_META       (KS_META_CPU | KS_META_READABLE | KS_META_256)
+#define KEY_SEED        0x1A39175D
+
+/* Keys of the handle manager are not copied, they must stay valid while added */
+static uint32_t  _hkey[HKEY_CNT][8];
+static int32_t   _hkey_handle[HKEY_CNT];
+static int32_t   _hkey_idx[HKEY_CNT];
+static uint32_t  _direct_key[8];
+
+/* FIPS-197 Appendix C.1, AES-128 */
+static uint32_t  _aes_key[4] = { 0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f };
+
+static uint8_t  _aes_plain[16] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+	0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+static uint8_t  _aes_cipher[16] = {
+	0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+	0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+uint8_t  au8InputData_Pool[64] __attribute__((aligned(32)));
+uint8_t  au8OutputData_Pool[64] __attribute__((aligned(32)));
+
+uint8_t  *au8InputData;
+uint8_t  *au8OutputData;
+
+/* P-256 ECDSA with SHA-1, the same vector as CRYPTO_ECC_SigGenVerify */
+static char  _ecc_msg[] = "a3f91ae21ba6b3039864472f184144c6af62cd0e";
+static char  _ecc_d[]   = "be34baa8d040a3b991f9075b56ba292f755b90e4b6dc10dad36715c33cfdac25";
+static char  _ecc_Qx[]  = "fa2737fb93488d19caef11ae7faf6b7f4bcd67b286e3fc54e8a65c2b74aeccb0";
+static char  _ecc_Qy[]  = "d4ccd6dae698208aa8c3a6f39e45510d03be09b2f124bfc067856c324f9b4d09";
+static char  _ecc_k[]   = "18731ef637fe84872cf89a879567946a50f327f3af3aaeb6074a86f117e332b0";
+static char  _ecc_R[]   = "2b826f5d44e2d0b6de531ad96b51e8f0c56fdfead3c236892e4d84eacfc3b75c";
+static char  _ecc_S[]   = "a2248b62c03db35a7cd63e8a120a3521a89d3d2f61ff99035a2148ae32e3a248";
+
+/* P-256 ECC CDH primitive, NIST CAVS test vector COUNT = 0 */
+static char  _cdh_Qx[]  = "700c48f77f56584c5cc632ca65640db91b6bacce3a4df6b42ce7cc838833d287";
+static char  _cdh_Qy[]  = "db71e509e3fd9b060ddb20ba5c51dcc5948d46fbf640dfe0441782cab85fa4ac";
+static char  _cdh_d[]   = "7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534";
+static char  _cdh_Z[]   = "46fc62106420ff012e54a434fbdd2d25ccc5852060561e68040dd7778997bd7b";
+
+static uint32_t  _ecc_d_key[8], _ecc_k_key[8], _ecc_Qx_key[8], _ecc_Qy_key[8], _cdh_d_key[8];
+
+static char  sig_R[80], sig_S[80], secret_Z[80];
+
+static void ShowRemain(void)
+{
+	uint32_t bcnt, kcnt;
+
+	if (KS_GetSRAMRemain(&bcnt, &kcnt) == 0)
+		sysprintf("Key Store SRAM remaining: %d bytes, %d keys\n", bcnt, kcnt);
+}
+
+static int ecc_strcmp(char *s1, char *s2)
+{
+	char  c1, c2;
+
+	while (*s1 == '0') s1++;
+	while (*s2 == '0') s2++;
+
+	for ( ; *s1 || *s2; s1++, s2++)
+	{
+		if ((*s1 >= 'A') && (*s1 <= 'Z'))
+			c1 = *s1 + 32;
+		else
+			c1 = *s1;
+
+		if ((*s2 >= 'A') && (*s2 <= 'Z'))
+			c2 = *s2 + 32;
+		else
+			c2 = *s2;
+
+		if (c1 != c2)
+			return 1;
+	}
+	return 0;
+}
+
+/* Key words of an ECC key, least significant word first as in the ECC registers */
+static void ecc_key_from_hex(char *hex, uint32_t key[], int wcnt)
+{
+	int   si, ri, i;
+	char  c;
+
+	memset(key, 0, wcnt * 4);
+	si = strlen(hex) - 1;
+	for (ri = 0; (si >= 0) && (ri < wcnt); ri++)
+	{
+		for (i = 0; (i < 8) && (si >= 0); i++, si--)
+		{
+			c = hex[si];
+			if (c >= 'a')
+				c = c - 'a' + 10;
+			else if (c >= 'A')
+				c = c - 'A' + 10;
+			else
+				c = c - '0';
+			key[ri] |= (uint32_t)c << (i * 4);
+		}
+	}
+}
+
+static void test_keys_init(void)
+{
+	int         i, j;
+	uint32_t    k32 = KEY_SEED;
+
+	for (i = 0; i < HKEY_CNT; i++)
+	{
+		for (j = 0; j < 8; j++)
+		{
+			_hkey[i][j] = k32;
+			k32 += KEY_SEED;
+		}
+		_hkey_handle[i] = -1;
+		_hkey_idx[i] = -1;
+	}
+	for (j = 0; j < 8; j++)
+	{
+		_direct_key[j] = k32;
+		k32 += KEY_SEED;
+	}
+}
+
+static int add_handles(void)
+{
+	int  i;
+
+	for (i = 0; i < HKEY_CNT; i++)
+	{
+		_hkey_handle[i] = KS_AddKey(HKEY_META, _hkey[i]);
+		if (_hkey_handle[i] < 0)
+		{
+			sysprintf("KS_AddKey %d failed!\n", i);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void remove_handles(void)
+{
+	int  i;
+
+	for (i = 0; i < HKEY_CNT; i++)
+	{
+		if (_hkey_handle[i] >= 0)
+			KS_RemoveKey(_hkey_handle[i]);
+		_hkey_handle[i] = -1;
+	}
+}
+
+static int read_verify(int32_t i32KeyIdx, uint32_t au32Key[])
+{
+	uint32_t  au32RKey[8];
+
+	memset(au32RKey, 0, sizeof(au32RKey));
+	if (KS_Read(KS_SRAM, i32KeyIdx, au32RKey, 8) != 0)
+	{
+		sysprintf("[FAIL] Read SRAM key %d failed!\n", i32KeyIdx);
+		return -1;
+	}
+	if (memcmp(au32RKey, au32Key, sizeof(au32RKey)) != 0)
+	{
+		sysprintf("[FAIL] SRAM key %d mismatch, 0x%08x, expect 0x%08x\n", i32KeyIdx, au32RKey[0], au32Key[0]);
+		return -1;
+	}
+	return 0;
+}
+
+/* Use key i through its handle and read it back from Key Store SRAM */
+static int use_verify(int i)
+{
+	_hkey_idx[i] = KS_UseKey(_hkey_handle[i]);
+	if (_hkey_idx[i] < 0)
+	{
+		sysprintf("[FAIL] KS_UseKey key %d returned %d!\n", i, _hkey_idx[i]);
+		return -1;
+	}
+	return read_verify(_hkey_idx[i], _hkey[i]);
+}
+
+/* Use all handle keys once, which evicts every other managed key */
+static int use_all(void)
+{
+	int  i;
+
+	for (i = 0; i < HKEY_CNT; i++)
+	{
+		if (use_verify(i) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+int KeyHandle_EvictReloadTest(void)
+{
+	uint32_t    bcnt, kcnt;
+	int32_t     i32DirectIdx, i32KeyIdx;
+	int         i, err = -1;
+
+	sysprintf("\n\n\n");
+	sysprintf("+---------------------------------------------------+\n");
+	sysprintf("|  Key handle eviction and reload test              |\n");
+	sysprintf("+---------------------------------------------------+\n");
+
+	KS_EraseAll();
+
+	sysprintf("Write a key with KS_Write()...");
+	i32DirectIdx = KS_Write(KS_SRAM, HKEY_META, _direct_key);
+	if (i32DirectIdx < 0)
+	{
+		sysprintf("[FAIL]\n");
+		return -1;
+	}
+	sysprintf("number=%d\n", i32DirectIdx);
+
+	if (add_handles() != 0)
+		goto lexit;
+
+	sysprintf("Use %d keys, SRAM holds %d...", HKEY_CNT, KS_SRAM_KEY_CNT);
+	if (use_all() != 0)
+		goto lexit;
+	if ((KS_GetSRAMRemain(&bcnt, &kcnt) != 0) || ((kcnt != 0) && (bcnt >= 32)))
+	{
+		sysprintf("[FAIL] SRAM is not full, no key was evicted!\n");
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+	ShowRemain();
+
+	sysprintf("Use the last key again, it must not be written again...");
+	i32KeyIdx = KS_UseKey(_hkey_handle[HKEY_CNT - 1]);
+	if (i32KeyIdx != _hkey_idx[HKEY_CNT - 1])
+	{
+		sysprintf("[FAIL] number %d, was %d\n", i32KeyIdx, _hkey_idx[HKEY_CNT - 1]);
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	/* In the same order, every key is the least recently used one and was evicted */
+	sysprintf("Reload evicted keys...");
+	for (i = 0; i < 2; i++)
+	{
+		if (use_all() != 0)
+			goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	sysprintf("Verify the KS_Write() key...");
+	if (read_verify(i32DirectIdx, _direct_key) != 0)
+		goto lexit;
+	sysprintf("[PASS]\n");
+	err = 0;
+
+lexit:
+	remove_handles();
+	KS_EraseKey(KS_SRAM, i32DirectIdx);
+	return err;
+}
+
+int KeyHandle_ErrorTest(void)
+{
+	int32_t     i32Handle, ret;
+	int         i, err = -1;
+
+	sysprintf("\n\n\n");
+	sysprintf("+---------------------------------------------------+\n");
+	sysprintf("|  Key handle error test, nothing may be evicted    |\n");
+	sysprintf("+---------------------------------------------------+\n");
+
+	KS_EraseAll();
+
+	if (add_handles() != 0)
+		goto lexit;
+
+	sysprintf("Use 8 keys...");
+	for (i = 0; i < 8; i++)
+	{
+		if (use_verify(i) != 0)
+			goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	sysprintf("Invalid handles...");
+	if ((KS_UseKey(-2) != -1) || (KS_UseKey(KS_HANDLE_CNT) != -1) ||
+		(AES_Start_KSH(CRPT, CRYPTO_DMA_ONE_SHOT, KS_HANDLE_CNT) != -3))
+	{
+		sysprintf("[FAIL]\n");
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	sysprintf("Invalid key size...");
+	if (KS_AddKey(KS_META_CPU | (13ul << KS_METADATA_SIZE_Pos), _direct_key) != -1)
+	{
+		sysprintf("[FAIL]\n");
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	/* A write that fails for any reason but lack of space must not evict keys */
+	sysprintf("Key with reserved owner 7...");
+	i32Handle = KS_AddKey((7ul << KS_METADATA_OWNER_Pos) | KS_META_256, _direct_key);
+	ret = KS_UseKey(i32Handle);
+	sysprintf("KS_UseKey returned %d\n", ret);
+	KS_RemoveKey(i32Handle);
+
+	sysprintf("Verify the resident keys...");
+	for (i = 0; i < 8; i++)
+	{
+		if (read_verify(_hkey_idx[i], _hkey[i]) != 0)
+			goto lexit;
+	}
+	sysprintf("[PASS]\n");
+	err = 0;
+
+lexit:
+	remove_handles();
+	return err;
+}
+
+static int aes_ksh_run(int32_t i32Handle, int encrypt, uint8_t *in)
+{
+	memcpy(au8InputData, in, 16);
+	memset(au8OutputData, 0, 16);
+
+	AES_Open(CRPT, encrypt ? AES_MODE_ENCRYPT : AES_MODE_DECRYPT, AES_MODE_ECB, AES_KEY_SIZE_128, AES_IN_OUT_SWAP);
+	AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(au8InputData), ptr_to_u32(au8OutputData), 16);
+	if (AES_Start_KSH(CRPT, CRYPTO_DMA_ONE_SHOT, i32Handle) != 0)
+	{
+		sysprintf("[FAIL] AES_Start_KSH failed!\n");
+		return -1;
+	}
+	return 0;
+}
+
+int KeyHandle_AESTest(void)
+{
+	int32_t     i32Handle;
+	int         err = -1;
+
+	sysprintf("\n\n\n");
+	sysprintf("+---------------------------------------------------+\n");
+	sysprintf("|  AES_Start_KSH() test                             |\n");
+	sysprintf("+---------------------------------------------------+\n");
+
+	KS_EraseAll();
+
+	i32Handle = KS_AddKey(KS_META_AES | KS_META_128, _aes_key);
+	if ((i32Handle < 0) || (add_handles() != 0))
+		goto lexit;
+
+	sysprintf("FIPS-197 AES-128 encrypt...");
+	if (aes_ksh_run(i32Handle, 1, _aes_plain) != 0)
+		goto lexit;
+	if (memcmp(au8OutputData, _aes_cipher, 16) != 0)
+	{
+		sysprintf("[FAIL]\n");
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	sysprintf("Evict the AES key...");
+	if (use_all() != 0)
+		goto lexit;
+	sysprintf("[PASS]\n");
+
+	sysprintf("Encrypt with the reloaded key...");
+	if (aes_ksh_run(i32Handle, 1, _aes_plain) != 0)
+		goto lexit;
+	if (memcmp(au8OutputData, _aes_cipher, 16) != 0)
+	{
+		sysprintf("[FAIL]\n");
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	sysprintf("Evict and decrypt...");
+	if ((use_all() != 0) || (aes_ksh_run(i32Handle, 0, _aes_cipher) != 0))
+		goto lexit;
+	if (memcmp(au8OutputData, _aes_plain, 16) != 0)
+	{
+		sysprintf("[FAIL]\n");
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+	err = 0;
+
+lexit:
+	remove_handles();
+	if (i32Handle >= 0)
+		KS_RemoveKey(i32Handle);
+	return err;
+}
+
+int KeyHandle_ECCTest(void)
+{
+	int32_t     d_handle, k_handle, x_handle, y_handle, z_handle;
+	int         err = -1;
+
+	sysprintf("\n\n\n");
+	sysprintf("+---------------------------------------------------+\n");
+	sysprintf("|  ECC_xxx_KSH() test                               |\n");
+	sysprintf("+---------------------------------------------------+\n");
+
+	KS_EraseAll();
+
+	ecc_key_from_hex(_ecc_d, _ecc_d_key, 8);
+	ecc_key_from_hex(_ecc_k, _ecc_k_key, 8);
+	ecc_key_from_hex(_ecc_Qx, _ecc_Qx_key, 8);
+	ecc_key_from_hex(_ecc_Qy, _ecc_Qy_key, 8);
+	ecc_key_from_hex(_cdh_d, _cdh_d_key, 8);
+
+	d_handle = KS_AddKey(KS_META_ECC | KS_META_256, _ecc_d_key);
+	k_handle = KS_AddKey(KS_META_ECC | KS_META_256, _ecc_k_key);
+	x_handle = KS_AddKey(KS_META_ECC | KS_META_256, _ecc_Qx_key);
+	y_handle = KS_AddKey(KS_META_ECC | KS_META_256, _ecc_Qy_key);
+	z_handle = KS_AddKey(KS_META_ECC | KS_META_256, _cdh_d_key);
+	if ((d_handle < 0) || (k_handle < 0) || (x_handle < 0) || (y_handle < 0) ||
+		(z_handle < 0) || (add_handles() != 0))
+		goto lexit;
+
+	sysprintf("P-256 signature generation...");
+	if ((ECC_GenerateSignature_KSH(CRPT, CURVE_P_256, _ecc_msg, d_handle, k_handle, sig_R, sig_S) != 0) ||
+		(ecc_strcmp(sig_R, _ecc_R) != 0) || (ecc_strcmp(sig_S, _ecc_S) != 0))
+	{
+		sysprintf("[FAIL]\nR = %s\nS = %s\n", sig_R, sig_S);
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	sysprintf("Evict the ECC keys...");
+	if (use_all() != 0)
+		goto lexit;
+	sysprintf("[PASS]\n");
+
+	sysprintf("P-256 signature verification...");
+	if (ECC_VerifySignature_KSH(CRPT, CURVE_P_256, _ecc_msg, x_handle, y_handle, _ecc_R, _ecc_S) != 0)
+	{
+		sysprintf("[FAIL]\n");
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+
+	sysprintf("Tampered message must fail...");
+	_ecc_msg[0] = 'b';
+	err = ECC_VerifySignature_KSH(CRPT, CURVE_P_256, _ecc_msg, x_handle, y_handle, _ecc_R, _ecc_S);
+	_ecc_msg[0] = 'a';
+	if (err != -2)
+	{
+		sysprintf("[FAIL] returned %d\n", err);
+		err = -1;
+		goto lexit;
+	}
+	err = -1;
+	sysprintf("[PASS]\n");
+
+	sysprintf("Evict the ECC keys...");
+	if (use_all() != 0)
+		goto lexit;
+	sysprintf("[PASS]\n");
+
+	sysprintf("P-256 ECC CDH secret Z...");
+	memset(secret_Z, 0, sizeof(secret_Z));
+	if ((ECC_GenerateSecretZ_KSH(CRPT, CURVE_P_256, z_handle, _cdh_Qx, _cdh_Qy, secret_Z) != 0) ||
+		(ecc_strcmp(secret_Z, _cdh_Z) != 0))
+	{
+		sysprintf("[FAIL]\nZ = %s\n", secret_Z);
+		goto lexit;
+	}
+	sysprintf("[PASS]\n");
+	err = 0;
+
+lexit:
+	remove_handles();
+	KS_RemoveKey(d_handle);
+	KS_RemoveKey(k_handle);
+	KS_RemoveKey(x_handle);
+	KS_RemoveKey(y_handle);
+	KS_RemoveKey(z_handle);
+	return err;
+}
+
+void SYS_Init(void)
+{
+	/* Enable LXT */
+	CLK->PWRCTL |= CLK_PWRCTL_LXTEN_Msk; // 32K (LXT) Enabled
+
+	/* Waiting LXT ready */
+	CLK_WaitClockReady(CLK_STATUS_LXTSTB_Msk);
+
+	/* Enable UART module clock */
+	CLK_EnableModuleClock(UART0_MODULE);
+
+	/* Select UART module clock source as SYSCLK1 and UART module clock divider as 15 */
+	CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL2_UART0SEL_SYSCLK1_DIV2, CLK_CLKDIV1_UART0(15));
+
+	/* Enable Key Store engine clock */
+	outpw(TSI_CLK_BASE + 0x4, inpw(TSI_CLK_BASE + 0x4) | (1 << 14));
+
+	/* Set GPE multi-function pins for UART0 RXD and TXD */
+	SYS->GPE_MFPH &= ~(SYS_GPE_MFPH_PE14MFP_Msk | SYS_GPE_MFPH_PE15MFP_Msk);
+	SYS->GPE_MFPH |= (SYS_GPE_MFPH_PE14MFP_UART0_TXD | SYS_GPE_MFPH_PE15MFP_UART0_RXD);
+}
+
+int32_t main(void)
+{
+	int item, ret;
+
+	/* Unlock protected registers */
+	SYS_UnlockReg();
+
+	/* Init System, IP clock and multi-function I/O */
+	SYS_Init();
+
+	/* Init UART to 115200-8n1 for print message */
+	UART_Open(UART0, 115200);
+
+	au8InputData = nc_ptr(au8InputData_Pool);
+	au8OutputData = nc_ptr(au8OutputData_Pool);
+
+	Crypto_Init();
+	KS_Init();
+
+	test_keys_init();
+
+	while (1)
+	{
+		sysprintf("\n");
+		sysprintf("+---------------------------------------------+\n");
+		sysprintf("|  Key Store Key Handle Test                  |\n");
+		sysprintf("+---------------------------------------------+\n");
+		sysprintf("| [1] Key eviction and reload test            |\n");
+		sysprintf("| [2] Key handle error test                   |\n");
+		sysprintf("| [3] AES_Start_KSH test                      |\n");
+		sysprintf("| [4] ECC_xxx_KSH test                        |\n");
+		sysprintf("+---------------------------------------------+\n");
+
+		item = sysgetchar();
+
+		switch (item)
+		{
+			case '1':
+				ret = KeyHandle_EvictReloadTest();
+				break;
+
+			case '2':
+				ret = KeyHandle_ErrorTest();
+				break;
+
+			case '3':
+				ret = KeyHandle_AESTest();
+				break;
+
+			case '4':
+				ret = KeyHandle_ECCTest();
+				break;
+
+			default:
+				ret = 0;
+				break;
+		}
+
+		ShowRemain();
+
+		if (ret == 0)
+			sysprintf("\n\nTest passed.\n");
+		else
+			sysprintf("\n\nTest failed!\n");
+
+		sysprintf("Press any key to continue...\n");
+		sysgetchar();
+	}
+}
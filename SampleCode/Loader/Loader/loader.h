@@ -25,6 +25,40 @@
 #define SPINAND_PAGE_SIZE		2048
 #define SPINAND_PAGE_PER_BLOCK	64
 
+/* SPI-NAND read mode */
+//#define SPINAND_QUAD_READ			/* read from cache x4 with PDMA, IO2/IO3 on PD4/PD5 */
+#define SPINAND_QE_BIT			0x01	/* QE bit in feature register B0h, 0 if the device has none */
+//#define SPINAND_CACHE_SEQ			/* device supports read cache sequential (31h/3Fh) */
+
+/* SPI-NOR and SD/eMMC read size, each part is hashed while the next one is read */
+#define APP_LOAD_CHUNK		(0x4000)
+
+/* secure boot: the APP_SIZE bytes image is followed by its ECDSA P-256
+   signature over SHA-256, R then S, 32 bytes each, big-endian */
+//#define SECURE_BOOT
+#define APP_SIG_SIZE		(64)
+#define APP_PUBKEY_X		"0000000000000000000000000000000000000000000000000000000000000000"
+#define APP_PUBKEY_Y		"0000000000000000000000000000000000000000000000000000000000000000"
+
+/* compressed image: an LZ4 frame of at most APP_SIZE bytes is stored instead
+   of the image, with the signature right behind the frame for secure boot */
+//#define APP_LZ4
+#define APP_UNPACK_SIZE		(0x1000000)	/* room for the unpacked image */
+#define APP_LZ4_BUF			(APP_EXE_ADDR + APP_UNPACK_SIZE)	/* the frame is read here */
+
+#if defined(APP_LZ4)
+#define APP_LOAD_ADDR		(APP_LZ4_BUF)
+#define APP_LOAD_SIZE		(APP_SIZE)	/* loading stops at the frame end */
+#define APP_SIG_ADDR		(lz4End())
+#elif defined(SECURE_BOOT)
+#define APP_LOAD_ADDR		(APP_EXE_ADDR)
+#define APP_LOAD_SIZE		(APP_SIZE + APP_SIG_SIZE)
+#define APP_SIG_ADDR		(APP_EXE_ADDR + APP_SIZE)
+#else
+#define APP_LOAD_ADDR		(APP_EXE_ADDR)
+#define APP_LOAD_SIZE		(APP_SIZE)
+#endif
+
 /*****************************************************************************/
 /* SPI */
 /* Write commands */
@@ -144,10 +178,21 @@ int  spiNandRead(unsigned int addr, unsigned int len, unsigned int *buf);
 int  spiNandGetStatus(unsigned char offset);
 void spiNandSetStatus(unsigned char offset, unsigned char value);
 int  spiNandIsBlockValid(unsigned int block);
+void spiNandQuadInit(void);
+int  spiNandSeqStart(unsigned int addr);
+int  spiNandSeqRead(int last, unsigned int len, unsigned int *buf);
 int  spiNorReset(void);
 int  spiRead(unsigned int addr, unsigned int len, unsigned int *buf);
 
 int  sdhInit(struct mmc *mmc);
 int  sdhReadBlocks(struct mmc *mmc, void *dst, unsigned int start, unsigned int blkcnt);
 
+void sbHashStart(uint32_t size);
+void sbHashUpdate(uint32_t addr, uint32_t len);
+int  sbVerify(uint32_t sig);
+
+void lz4Init(uint32_t src, uint32_t dst, uint32_t dst_size);
+int  lz4Feed(uint32_t end);
+uint32_t lz4End(void);
+
 #endif /* _MA35H0_LOADER_H */
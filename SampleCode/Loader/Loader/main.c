@@ -191,11 +191,30 @@ void ddr_init(void)
 	CLK->CLKSEL0 = reg_clksel0;
 }
 
+/*
+	Called with each part of the image as soon as it is in memory.
+	Returns non-zero when nothing more needs to be read.
+*/
+int loadChunk(uint32_t addr, uint32_t len)
+{
+#if defined(APP_LZ4)
+	return (lz4Feed(addr + len) != 0);
+#else
+#if defined(SECURE_BOOT)
+	sbHashUpdate(addr, len);
+#endif
+	return 0;
+#endif
+}
+
 void LoadSpiNand(uint32_t offset, uint32_t size, uint32_t load_addr)
 {
 	uint32_t volatile page, addr = load_addr;
 	uint32_t volatile PageToDownload, StartPage, StartBlock;
-	int volatile BlockCount;
+	int volatile BlockCount, ret;
+#ifdef SPINAND_CACHE_SEQ
+	uint32_t volatile seq = 0;
+#endif
 
 	StartPage = offset / SPINAND_PAGE_SIZE;
 	StartBlock = StartPage / SPINAND_PAGE_PER_BLOCK;
@@ -222,20 +241,52 @@ void LoadSpiNand(uint32_t offset, uint32_t size, uint32_t load_addr)
 			return;
 		}
 	}
+#ifdef SPINAND_QUAD_READ
+	spiNandQuadInit();
+#endif
+	BOOTTIME_Mark("storage open");
 
 	while (1)
 	{
 		WDT_RESET_COUNTER(WDT1);
 		if (spiNandIsBlockValid(StartBlock))
 		{
+#ifdef SPINAND_CACHE_SEQ
+			/* the pages wanted from this block are read in one run */
+			seq = SPINAND_PAGE_PER_BLOCK - page;
+			if (seq > PageToDownload)
+				seq = PageToDownload;
+			if (seq < 2)
+				seq = 0;
+			else if (spiNandSeqStart(StartPage))
+			{
+				sysprintf("spi-nand read error!\n");
+				return;
+			}
+#endif
 			while (PageToDownload > 0)
 			{
 				WDT_RESET_COUNTER(WDT1);
-				if (spiNandRead(StartPage, SPINAND_PAGE_SIZE, (unsigned int *)(uint64_t)addr))
+#ifdef SPINAND_CACHE_SEQ
+				if (seq)
+					ret = spiNandSeqRead(--seq == 0, SPINAND_PAGE_SIZE, (unsigned int *)(uint64_t)addr);
+				else
+#endif
+				ret = spiNandRead(StartPage, SPINAND_PAGE_SIZE, (unsigned int *)(uint64_t)addr);
+				if (ret)
 				{
 					sysprintf("spi-nand read error!\n");
 					return;
 				}
+				if (loadChunk(addr, SPINAND_PAGE_SIZE))
+				{
+#ifdef SPINAND_CACHE_SEQ
+					/* end the run, the device is loading the next page */
+					if (seq)
+						spiNandSeqRead(1, 0, 0);
+#endif
+					return;
+				}
 				addr += SPINAND_PAGE_SIZE;
 				page++;
 				PageToDownload--;
@@ -281,6 +332,8 @@ void LoadNand(uint32_t offset, uint32_t size, uint32_t load_addr)
 				WDT_RESET_COUNTER(WDT1);
                 if (nfiPageRead(StartPage, (uint8_t *)(uint64_t)addr))
                 	break;
+				if (loadChunk(addr, tNAND.uPageSize))
+					return;
 				addr += tNAND.uPageSize;
 				page++;
 				PageToDownload--;
@@ -298,6 +351,49 @@ void LoadNand(uint32_t offset, uint32_t size, uint32_t load_addr)
 	}
 }
 
+void LoadSpiNor(uint32_t offset, uint32_t size, uint32_t load_addr)
+{
+	uint32_t len;
+
+	while (size > 0)
+	{
+		WDT_RESET_COUNTER(WDT1);
+		len = (size > APP_LOAD_CHUNK) ? APP_LOAD_CHUNK : size;
+		spiRead(offset, len, (unsigned int *)(uint64_t)load_addr);
+		if (loadChunk(load_addr, len))
+			return;
+		offset += len;
+		load_addr += len;
+		size -= len;
+	}
+}
+
+void LoadSd(uint32_t offset, uint32_t size, uint32_t load_addr)
+{
+	uint32_t start, count, blocks;
+
+	start = offset / 512;
+	count = size / 512;
+	if ((size % 512) != 0)
+		count++;
+
+	while (count > 0)
+	{
+		WDT_RESET_COUNTER(WDT1);
+		blocks = (count > APP_LOAD_CHUNK / 512) ? APP_LOAD_CHUNK / 512 : count;
+		if (sdhReadBlocks(&mmcInfo, (void *)(uint64_t)load_addr, start, blocks))
+		{
+			sysprintf("sd read error!\n");
+			return;
+		}
+		if (loadChunk(load_addr, blocks * 512))
+			return;
+		start += blocks;
+		load_addr += blocks * 512;
+		count -= blocks;
+	}
+}
+
 int main()
 {
 	uint32_t reg_por;
@@ -311,13 +407,23 @@ int main()
     /* Enable timer control */
     EL0_SetControl(3U);			// non-secure timer
 
+    /* boot stage time stamps, read by the application after the jump */
+    BOOTTIME_Start();
+    BOOTTIME_Mark("loader start");
+
     sysprintf("MA35H0 baremetal loader...\n");
 
     /* 1. initial DDR */
     WDT_RESET_COUNTER(WDT1);
 	ddr_init();
+	BOOTTIME_Mark("ddr_init");
 
     /* 2. load application from storage */
+#if defined(APP_LZ4)
+	lz4Init(APP_LZ4_BUF, APP_EXE_ADDR, APP_UNPACK_SIZE);
+#elif defined(SECURE_BOOT)
+	sbHashStart(APP_SIZE);
+#endif
     reg_por = SYS->PWRONOTP;
     if ((reg_por & 0x1) == 0)	/* boot source from pin */
     {
@@ -349,12 +455,13 @@ int main()
     	{
 			sysprintf("SPI-NOR\n");
 			spiNorReset();
-			spiRead((uint32_t)APP_OFFSET_SPINOR, APP_SIZE, (uint32_t *)APP_EXE_ADDR);
+			BOOTTIME_Mark("storage open");
+			LoadSpiNor(APP_OFFSET_SPINOR, APP_LOAD_SIZE, APP_LOAD_ADDR);
     	}
     	else	/* SPI_NAND */
     	{
 			sysprintf("SPI-NAND\n");
-			LoadSpiNand(APP_OFFSET_SPINAND, APP_SIZE, APP_EXE_ADDR);
+			LoadSpiNand(APP_OFFSET_SPINAND, APP_LOAD_SIZE, APP_LOAD_ADDR);
     	}
     	break;
 
@@ -382,16 +489,8 @@ int main()
 		else
 			mmcInfo.bus_width = 0;	/* 4-bit */
 		sdhInit(&mmcInfo);
-		{
-			uint32_t volatile start = APP_OFFSET_EMMC / 512;
-			uint32_t volatile count;
-
-			count = APP_SIZE / 512;
-			if ((APP_SIZE % 512) != 0)
-				count++;
-
-			sdhReadBlocks(&mmcInfo, (void *)(uint64_t)APP_EXE_ADDR, start, count);
-		}
+		BOOTTIME_Mark("storage open");
+		LoadSd(APP_OFFSET_EMMC, APP_LOAD_SIZE, APP_LOAD_ADDR);
     	break;
 
     case 0x800: /* NAND boot */
@@ -402,14 +501,34 @@ int main()
 
 		/* Initial NAND */
         nfiOpen();
+		BOOTTIME_Mark("storage open");
 
-		LoadNand(APP_OFFSET_SPINAND, APP_SIZE, APP_EXE_ADDR);
+		LoadNand(APP_OFFSET_NAND, APP_LOAD_SIZE, APP_LOAD_ADDR);
 		break;
 
     default:
     	sysprintf("Boot interface 0x%x not supported\n", reg_por);
     	while(1);
     }
+	BOOTTIME_Mark("image copy");
+
+#ifdef APP_LZ4
+	if (lz4End() == 0)
+	{
+		sysprintf("compressed image error!\n");
+		while(1);
+	}
+#endif
+
+#ifdef SECURE_BOOT
+    /* 3. check the image signature */
+	if (sbVerify(APP_SIG_ADDR) != 0)
+	{
+		sysprintf("image signature check failed!\n");
+		while(1);
+	}
+	BOOTTIME_Mark("image check");
+#endif
 
     /* branch to application */
 	sysprintf("finish\n\n");
@@ -444,6 +563,8 @@ int main()
 	/* Disable Generic Timer and set load value */
 	EL0_SetControl(0);
 
+	BOOTTIME_Mark("loader exit");
+
 	fBLfunc = (unsigned int (*)())(APP_EXE_ADDR);
 	fBLfunc();
 }
@@ -0,0 +1,289 @@
+/*************************************************************************//**
+ * @file     lz4.c
+ * @version  V1.00
+ * @brief    baremetal loader LZ4 frame decoder for MA35H0 MPU.
+ *           The compressed image is read into a DDR buffer part by part and
+ *           each block is unpacked to the execute address as soon as all
+ *           of it has arrived, so loading stops right after the frame end.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "NuMicro.h"
+#include "../loader.h"
+
+#define LZ4_MAGIC			0x184D2204
+
+/* frame descriptor FLG bits */
+#define LZ4_FLG_VERSION		0xC0
+#define LZ4_FLG_BCHECKSUM	0x10
+#define LZ4_FLG_CSIZE		0x08
+#define LZ4_FLG_CCHECKSUM	0x04
+#define LZ4_FLG_DICTID		0x01
+
+#define LZ4_MIN_MATCH		4
+
+enum { LZ4_HEADER, LZ4_BLOCK, LZ4_DONE, LZ4_ERROR };
+
+static int lz4State;
+static uint8_t lz4Flg;
+static uint32_t lz4Pos;			/* next compressed byte to parse */
+static uint32_t lz4BlockMax;
+static uint32_t lz4Dst, lz4Out, lz4DstEnd;
+static uint64_t lz4ContentSize;
+
+/*
+	All accesses are byte wide, the loader runs with MMU off where DDR is
+	device memory and does not allow unaligned accesses.
+*/
+static uint32_t lz4Read32(uint32_t addr)
+{
+	uint8_t *p = (uint8_t *)(uint64_t)addr;
+
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* unpack one LZ4 block; matches may reach back into earlier blocks */
+static int lz4DecodeBlock(uint32_t src, uint32_t len)
+{
+	uint8_t *ip = (uint8_t *)(uint64_t)src;
+	uint8_t *iend = ip + len;
+	uint8_t *op = (uint8_t *)(uint64_t)lz4Out;
+	uint8_t *oend = (uint8_t *)(uint64_t)lz4DstEnd;
+	uint8_t *ostart = (uint8_t *)(uint64_t)lz4Dst;
+	uint8_t *match;
+	uint32_t token, length, offset, c;
+
+	while (ip < iend)
+	{
+		token = *ip++;
+
+		/* literals */
+		length = token >> 4;
+		if (length == 15)
+		{
+			do
+			{
+				if (ip >= iend)
+					return -1;
+				c = *ip++;
+				length += c;
+			} while (c == 255);
+		}
+		if ((length > (uint32_t)(iend - ip)) || (length > (uint32_t)(oend - op)))
+			return -1;
+		while (length--)
+			*op++ = *ip++;
+
+		/* the last sequence has literals only */
+		if (ip >= iend)
+			break;
+
+		/* match */
+		if ((iend - ip) < 2)
+			return -1;
+		offset = ip[0] | ((uint32_t)ip[1] << 8);
+		ip += 2;
+		if ((offset == 0) || (offset > (uint32_t)(op - ostart)))
+			return -1;
+		match = op - offset;
+
+		length = (token & 0xF) + LZ4_MIN_MATCH;
+		if ((token & 0xF) == 15)
+		{
+			do
+			{
+				if (ip >= iend)
+					return -1;
+				c = *ip++;
+				length += c;
+			} while (c == 255);
+		}
+		if (length > (uint32_t)(oend - op))
+			return -1;
+		/* byte copy, the match may overlap the output */
+		while (length--)
+			*op++ = *match++;
+	}
+
+	lz4Out = (uint32_t)(uint64_t)op;
+	return 0;
+}
+
+/*
+	src: DDR buffer the storage loaders read the compressed image into
+	dst: execute address
+	dst_size: room at dst for the unpacked image
+*/
+void lz4Init(uint32_t src, uint32_t dst, uint32_t dst_size)
+{
+	lz4State = LZ4_HEADER;
+	lz4Pos = src;
+	lz4Dst = dst;
+	lz4Out = dst;
+	lz4DstEnd = dst + dst_size;
+	lz4ContentSize = 0;
+}
+
+static int lz4Header(uint32_t end)
+{
+	uint8_t *p = (uint8_t *)(uint64_t)lz4Pos;
+	uint32_t hlen;
+	int i;
+
+	if ((end - lz4Pos) < 7)
+		return 0;
+
+	if (lz4Read32(lz4Pos) != LZ4_MAGIC)
+	{
+		sysprintf("lz4: not an LZ4 frame!\n");
+		return -1;
+	}
+	lz4Flg = p[4];
+	if (((lz4Flg & LZ4_FLG_VERSION) != 0x40) || (lz4Flg & LZ4_FLG_DICTID))
+	{
+		sysprintf("lz4: frame flags 0x%x not supported!\n", lz4Flg);
+		return -1;
+	}
+	lz4BlockMax = 1UL << (8 + 2 * ((p[5] >> 4) & 0x7));
+	if (lz4BlockMax < 0x10000)
+		return -1;
+
+	hlen = (lz4Flg & LZ4_FLG_CSIZE) ? 15 : 7;
+	if ((end - lz4Pos) < hlen)
+		return 0;
+
+	if (lz4Flg & LZ4_FLG_CSIZE)
+	{
+		for (i = 7; i >= 0; i--)
+			lz4ContentSize = (lz4ContentSize << 8) | p[6 + i];
+		if (lz4ContentSize > (lz4DstEnd - lz4Dst))
+		{
+			sysprintf("lz4: image too large!\n");
+			return -1;
+		}
+	}
+#ifdef SECURE_BOOT
+	/* the unpacked image is hashed, so its size must be known up front */
+	if ((lz4Flg & LZ4_FLG_CSIZE) == 0)
+	{
+		sysprintf("lz4: frame has no content size!\n");
+		return -1;
+	}
+	sbHashStart((uint32_t)lz4ContentSize);
+#endif
+
+	/* the header checksum is not checked, the signature covers the image */
+	lz4Pos += hlen;
+	return 1;
+}
+
+/*
+	end: address just past the compressed data read so far
+	return: 0 if more data is needed, 1 when the frame is complete, -1 on error
+*/
+int lz4Feed(uint32_t end)
+{
+	uint32_t bsize, blen, need, out;
+	int ret;
+
+	while (1)
+	{
+		switch (lz4State)
+		{
+		case LZ4_HEADER:
+			ret = lz4Header(end);
+			if (ret <= 0)
+			{
+				if (ret < 0)
+					lz4State = LZ4_ERROR;
+				return ret;
+			}
+			lz4State = LZ4_BLOCK;
+			break;
+
+		case LZ4_BLOCK:
+			if ((end - lz4Pos) < 4)
+				return 0;
+			bsize = lz4Read32(lz4Pos);
+			if (bsize == 0)
+			{
+				/* end mark, then the content checksum and the signature */
+				blen = (lz4Flg & LZ4_FLG_CCHECKSUM) ? 8 : 4;
+				need = blen;
+#ifdef SECURE_BOOT
+				need += APP_SIG_SIZE;
+#endif
+				if ((end - lz4Pos) < need)
+					return 0;
+				if ((lz4Flg & LZ4_FLG_CSIZE) && (lz4ContentSize != (lz4Out - lz4Dst)))
+				{
+					sysprintf("lz4: size mismatch!\n");
+					lz4State = LZ4_ERROR;
+					return -1;
+				}
+				lz4Pos += blen;
+				lz4State = LZ4_DONE;
+				return 1;
+			}
+
+			blen = bsize & 0x7FFFFFFF;
+			if (blen > lz4BlockMax)
+			{
+				lz4State = LZ4_ERROR;
+				return -1;
+			}
+			need = 4 + blen;
+			if (lz4Flg & LZ4_FLG_BCHECKSUM)
+				need += 4;
+			if ((end - lz4Pos) < need)
+				return 0;
+
+			out = lz4Out;
+			if (bsize & 0x80000000)
+			{
+				/* stored uncompressed */
+				uint8_t *s = (uint8_t *)(uint64_t)(lz4Pos + 4);
+				uint8_t *d = (uint8_t *)(uint64_t)lz4Out;
+
+				if (blen > (lz4DstEnd - lz4Out))
+				{
+					lz4State = LZ4_ERROR;
+					return -1;
+				}
+				lz4Out += blen;
+				while (blen--)
+					*d++ = *s++;
+			}
+			else if (lz4DecodeBlock(lz4Pos + 4, blen) != 0)
+			{
+				sysprintf("lz4: corrupted block!\n");
+				lz4State = LZ4_ERROR;
+				return -1;
+			}
+#ifdef SECURE_BOOT
+			/* the SHA engine hashes this block while the next one is unpacked */
+			sbHashUpdate(out, lz4Out - out);
+#else
+			(void)out;
+#endif
+			lz4Pos += need;
+			break;
+
+		case LZ4_DONE:
+			return 1;
+
+		default:
+			return -1;
+		}
+	}
+}
+
+/*
+	return: address just past the frame, where the signature is, or 0 if the
+	frame is not complete
+*/
+uint32_t lz4End(void)
+{
+	return (lz4State == LZ4_DONE) ? lz4Pos : 0;
+}
@@ -7,7 +7,7 @@
  * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
 #include "NuMicro.h"
-#include "..\loader.h"
+#include "../loader.h"
 
 /*-----------------------------------------------------------------------------
  * Define some constants
@@ -7,7 +7,7 @@
  * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
 #include "NuMicro.h"
-#include "..\loader.h"
+#include "../loader.h"
 
 void spiCmd(unsigned char *cmd, unsigned int cmdlen, unsigned char *data, unsigned int datalen)
 {
@@ -150,16 +150,11 @@ void spiNandSetStatus(unsigned char offset, unsigned char value)
 }
 
 
-int spiNandRead(unsigned int addr, unsigned int len, unsigned int *buf)
+/* wait for the page load into the cache and check its ECC status */
+static int spiNandWaitReady(unsigned int addr)
 {
-	unsigned char cmd[4];
-	int volatile i, status=0;
+	int volatile status=0;
 
-	cmd[0] = 0x13;  /* page read */
-	cmd[1] = (addr >> 16) & 0xFF;
-	cmd[2] = (addr >> 8) & 0xFF;
-	cmd[3] = addr & 0xFF;
-	spiCmd(cmd, 4, 0, 0);
 	gStartTime = raw_read_cntpct_el0();
 	while(spiNandGetStatus(0xc0) & 0x1)		// wait ready
 	{
@@ -179,10 +174,47 @@ int spiNandRead(unsigned int addr, unsigned int len, unsigned int *buf)
 		sysprintf("spiNandRead: ECC error!\n");
 		return 1;
 	}
+	return 0;
+}
+
+#ifdef SPINAND_QUAD_READ
+/*
+	Set QSPI0_MOSI1/MISO1 on PD4/PD5 for IO2/IO3, set the device QE bit
+	and get PDMA0 ready for the data phase of the x4 cache reads.
+*/
+void spiNandQuadInit(void)
+{
+	SYS->GPD_MFPL = (SYS->GPD_MFPL & ~(SYS_GPD_MFPL_PD4MFP_Msk | SYS_GPD_MFPL_PD5MFP_Msk)) |
+					SYS_GPD_MFPL_PD4MFP_QSPI0_MOSI1 | SYS_GPD_MFPL_PD5MFP_QSPI0_MISO1;
+
+	if (SPINAND_QE_BIT)
+		spiNandSetStatus(0xb0, spiNandGetStatus(0xb0) | SPINAND_QE_BIT);
+
+	CLK->SYSCLK1 |= CLK_SYSCLK1_PDMA0EN_Msk;
+	SYS->IPRST0 |= SYS_IPRST0_PDMA0RST_Msk;
+	SYS->IPRST0 &= ~SYS_IPRST0_PDMA0RST_Msk;
+
+	/* channel 1 takes QSPI0 RX */
+	PDMA0->REQSEL0_3 = (PDMA0->REQSEL0_3 & ~PDMA_REQSEL0_3_REQSRC1_Msk) | (PDMA_QSPI0_RX << PDMA_REQSEL0_3_REQSRC1_Pos);
+}
+#endif
+
+/*
+	Read the cache from column 0. With SPINAND_QUAD_READ this is read from
+	cache x4 (6Bh) and PDMA moves the data, otherwise 03h and the FIFO loop.
+	len: multiple of 4
+*/
+static int spiNandReadCache(unsigned int len, unsigned int *buf)
+{
+	int volatile i, ret=0;
 
 	QSPI0->SSCTL = 0x01;   // CS0 low
 
+#ifdef SPINAND_QUAD_READ
+	QSPI0->TX = 0x6b;
+#else
 	QSPI0->TX = 0x03;
+#endif
 	QSPI0->TX = 0;
 	QSPI0->TX = 0;
 	QSPI0->TX = 0;
@@ -194,6 +226,39 @@ int spiNandRead(unsigned int addr, unsigned int len, unsigned int *buf)
 	while(QSPI0->STATUS & 0x800000);
 	WDT_RESET_COUNTER(WDT1);
 
+#ifdef SPINAND_QUAD_READ
+	// quad input, DWIDTH 32 bit and byte reorder
+	QSPI0->CTL = (QSPI0->CTL & ~(QSPI_CTL_DATDIR_Msk | 0x1F00)) | QSPI_CTL_QUADIOEN_Msk | (1<<19);
+
+	PDMA0->CHCTL |= 0x2;
+	PDMA0->DSCT[1].CTL = ((len/4)-1)<<16 |	/* transfer count */
+						 2<<12 |			/* 32-bit width */
+						 0<<10 |			/* increment destination */
+						 3<<8  |			/* fixed source */
+						 1<<7  |			/* table interrupt disabled */
+						 1<<2  |			/* single request */
+						 1;					/* basic mode */
+	PDMA0->DSCT[1].SA = (uint32_t)(uint64_t)&QSPI0->RX;
+	PDMA0->DSCT[1].DA = (uint32_t)(uint64_t)buf;
+	QSPI0->PDMACTL |= QSPI_PDMACTL_RXPDMAEN_Msk;
+
+	gStartTime = raw_read_cntpct_el0();
+	while ((PDMA0->TDSTS & 0x2) == 0)
+	{
+		if ((raw_read_cntpct_el0() - gStartTime) > 120000) /* 10ms */
+		{
+			sysprintf("spiNandRead: pdma timeout!\n");
+			ret = 1;
+			break;
+		}
+	}
+	PDMA0->TDSTS = 0x2;
+	QSPI0->PDMACTL = 0;
+	QSPI0->SSCTL = 0x05;   // CS0 high
+
+	// back to 1-bit, DWIDTH 8 bit and no byte reorder
+	QSPI0->CTL = (QSPI0->CTL & ~(QSPI_CTL_QUADIOEN_Msk | QSPI_CTL_DATDIR_Msk | 0x80000 | 0x1F00)) | (8<<8);
+#else
 	// set DWIDTH to 32 bit and enable byte reorder
 	QSPI0->CTL = (QSPI0->CTL & ~0x1F00) | (1<<19);
 
@@ -207,9 +272,65 @@ int spiNandRead(unsigned int addr, unsigned int len, unsigned int *buf)
 	QSPI0->SSCTL = 0x05;   // CS0 high
 	// set DWIDTH to 8 bit and disable byte reorder
 	QSPI0->CTL = (QSPI0->CTL & ~0x80000) | (8<<8);
+#endif
 
-	return 0;
+	return ret;
+}
+
+int spiNandRead(unsigned int addr, unsigned int len, unsigned int *buf)
+{
+	unsigned char cmd[4];
+
+	cmd[0] = 0x13;  /* page read */
+	cmd[1] = (addr >> 16) & 0xFF;
+	cmd[2] = (addr >> 8) & 0xFF;
+	cmd[3] = addr & 0xFF;
+	spiCmd(cmd, 4, 0, 0);
+	if (spiNandWaitReady(addr))
+		return 1;
+
+	return spiNandReadCache(len, buf);
+}
+
+#ifdef SPINAND_CACHE_SEQ
+/*
+	Cache sequential read: after spiNandSeqStart(), each spiNandSeqRead()
+	moves the next page to the cache and reads it out while the device
+	loads the page after it. The last read of a run must set last, which
+	ends the run with 3Fh instead of 31h.
+*/
+static unsigned int seqPage;
+
+int spiNandSeqStart(unsigned int addr)
+{
+	unsigned char cmd[4];
+
+	cmd[0] = 0x13;  /* page read */
+	cmd[1] = (addr >> 16) & 0xFF;
+	cmd[2] = (addr >> 8) & 0xFF;
+	cmd[3] = addr & 0xFF;
+	spiCmd(cmd, 4, 0, 0);
+	seqPage = addr;
+	return spiNandWaitReady(addr);
+}
+
+/*
+	buf: NULL to just end the run
+*/
+int spiNandSeqRead(int last, unsigned int len, unsigned int *buf)
+{
+	unsigned char cmd[1];
+
+	cmd[0] = last ? 0x3f : 0x31;  /* read cache end / read cache sequential */
+	spiCmd(cmd, 1, 0, 0);
+	if (spiNandWaitReady(++seqPage))
+		return 1;
+	if (buf == 0)
+		return 0;
+
+	return spiNandReadCache(len, buf);
 }
+#endif
 
 
 int spiNandReadSpare(unsigned int addr, unsigned int len, unsigned char *buf)
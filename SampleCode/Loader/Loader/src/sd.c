@@ -8,7 +8,7 @@
 *****************************************************************************/
 #include "NuMicro.h"
 #include "sd.h"
-#include "..\loader.h"
+#include "../loader.h"
 
 /*-----------------------------------------------------------------------------
  * Define some constants
@@ -0,0 +1,360 @@
+/*************************************************************************//**
+ * @file     secure.c
+ * @version  V1.00
+ * @brief    baremetal loader secure boot source for MA35H0 MPU.
+ *           The image is hashed with SHA-256 on the CRYPTO engine a chunk at
+ *           a time, each chunk as soon as it is in DDR, so hashing runs while
+ *           the next chunk is read from storage. The ECDSA P-256 signature
+ *           behind the image is then checked on the ECC engine.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "NuMicro.h"
+#include "../loader.h"
+
+/*
+ * The loader runs with MMU and caches off and without interrupts, so the
+ * engine is driven at register level and polled.
+ */
+#define ECCOP_POINT_MUL     (0x0UL << CRPT_ECC_CTL_ECCOP_Pos)
+#define ECCOP_MODULE        (0x1UL << CRPT_ECC_CTL_ECCOP_Pos)
+#define ECCOP_POINT_ADD     (0x2UL << CRPT_ECC_CTL_ECCOP_Pos)
+
+#define MODOP_DIV           (0x0UL << CRPT_ECC_CTL_MODOP_Pos)
+#define MODOP_MUL           (0x1UL << CRPT_ECC_CTL_MODOP_Pos)
+#define MODOP_ADD           (0x2UL << CRPT_ECC_CTL_MODOP_Pos)
+
+#define SB_WORDS            8           /* P-256 operand words */
+#define SB_TIMEOUT          12000000    /* 1 second */
+
+/* NIST P-256, least significant word first */
+static const uint32_t sbCurveA[SB_WORDS] = {
+	0xFFFFFFFC, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF };
+static const uint32_t sbCurveB[SB_WORDS] = {
+	0x27D2604B, 0x3BCE3C3E, 0xCC53B0F6, 0x651D06B0, 0x769886BC, 0xB3EBBD55, 0xAA3A93E7, 0x5AC635D8 };
+static const uint32_t sbCurveGx[SB_WORDS] = {
+	0xD898C296, 0xF4A13945, 0x2DEB33A0, 0x77037D81, 0x63A440F2, 0xF8BCE6E5, 0xE12C4247, 0x6B17D1F2 };
+static const uint32_t sbCurveGy[SB_WORDS] = {
+	0x37BF51F5, 0xCBB64068, 0x6B315ECE, 0x2BCE3357, 0x7C0F9E16, 0x8EE7EB4A, 0xFE1A7F9B, 0x4FE342E2 };
+static const uint32_t sbCurveP[SB_WORDS] = {
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF };
+static const uint32_t sbCurveN[SB_WORDS] = {
+	0xFC632551, 0xF3B9CAC2, 0xA7179E84, 0xBCE6FAAD, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0xFFFFFFFF };
+
+static uint32_t sbRemain;	/* image bytes not yet given to the SHA engine */
+static int sbFirst, sbBusy, sbError;
+
+/*-----------------------------------------------------------------------------*/
+/* SHA-256 */
+
+static int sbShaWait(void)
+{
+	uint32_t sts;
+
+	if (!sbBusy)
+		return 0;
+
+	gStartTime = raw_read_cntpct_el0();
+	while ((CRPT->INTSTS & (CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk)) == 0)
+	{
+		if ((raw_read_cntpct_el0() - gStartTime) > SB_TIMEOUT)
+		{
+			sysprintf("sha timeout!\n");
+			return -1;
+		}
+	}
+	sts = CRPT->INTSTS & (CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk);
+	CRPT->INTSTS = sts;
+	sbBusy = 0;
+
+	return (sts & CRPT_INTSTS_HMACEIF_Msk) ? -1 : 0;
+}
+
+/*
+	size: image byte count; anything given to sbHashUpdate() past it is not hashed
+*/
+void sbHashStart(uint32_t size)
+{
+	/* enable crypto engine clock */
+	outp32(TSI_CLK_BASE + 0x4, inp32(TSI_CLK_BASE + 0x4) | (1 << 12));
+
+	CRPT->INTSTS = CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk |
+				   CRPT_INTSTS_ECCIF_Msk | CRPT_INTSTS_ECCEIF_Msk;
+	CRPT->HMAC_CTL = (SHA_MODE_SHA256 << CRPT_HMAC_CTL_OPMODE_Pos) |
+					 (SHA_IN_OUT_SWAP << CRPT_HMAC_CTL_OUTSWAP_Pos);
+
+	sbRemain = size;
+	sbFirst = 1;
+	sbBusy = 0;
+	sbError = 0;
+}
+
+/*
+	addr: DDR address of a chunk that has just been loaded
+	len: byte count, a multiple of 64 except for the chunk holding the image end
+
+	Waits for the previous chunk, starts the SHA engine on this one and
+	returns, so the caller can read the next chunk while it runs.
+*/
+void sbHashUpdate(uint32_t addr, uint32_t len)
+{
+	uint32_t mode;
+
+	if (sbError || (sbRemain == 0))
+		return;
+
+	if (sbShaWait() != 0)
+	{
+		sbError = 1;
+		return;
+	}
+
+	if (len > sbRemain)
+		len = sbRemain;
+	sbRemain -= len;
+
+	if (sbFirst)
+		mode = sbRemain ? CRYPTO_DMA_FIRST : CRYPTO_DMA_ONE_SHOT;
+	else
+		mode = sbRemain ? CRYPTO_DMA_CONTINUE : CRYPTO_DMA_LAST;
+	sbFirst = 0;
+
+	CRPT->HMAC_SADDR = addr;
+	CRPT->HMAC_DMACNT = len;
+	CRPT->HMAC_CTL = (CRPT->HMAC_CTL & ~(0x7UL << CRPT_HMAC_CTL_DMALAST_Pos)) |
+					 CRPT_HMAC_CTL_START_Msk | (mode << CRPT_HMAC_CTL_DMALAST_Pos);
+	sbBusy = 1;
+}
+
+/*-----------------------------------------------------------------------------*/
+/* ECDSA P-256 */
+
+static void sbEccWrite(uint32_t volatile reg[], const uint32_t words[])
+{
+	int i;
+
+	for (i = 0; i < 18; i++)
+		reg[i] = (i < SB_WORDS) ? words[i] : 0;
+}
+
+static void sbEccRead(uint32_t words[], uint32_t volatile reg[])
+{
+	int i;
+
+	for (i = 0; i < SB_WORDS; i++)
+		words[i] = reg[i];
+}
+
+/* A, B, N = p, G to X1/Y1, clear X2/Y2 */
+static void sbEccInitCurve(void)
+{
+	int i;
+
+	sbEccWrite(CRPT->ECC_A, sbCurveA);
+	sbEccWrite(CRPT->ECC_B, sbCurveB);
+	sbEccWrite(CRPT->ECC_N, sbCurveP);
+	sbEccWrite(CRPT->ECC_X1, sbCurveGx);
+	sbEccWrite(CRPT->ECC_Y1, sbCurveGy);
+	for (i = 0; i < 18; i++)
+	{
+		CRPT->ECC_X2[i] = 0;
+		CRPT->ECC_Y2[i] = 0;
+	}
+}
+
+/* Verify uses public values only, so side-channel protection is left off */
+static int sbEccRun(uint32_t op)
+{
+	uint32_t sts;
+
+	CRPT->ECC_CTL = CRPT_ECC_CTL_FSEL_Msk | (256UL << CRPT_ECC_CTL_CURVEM_Pos) | op;
+	CRPT->ECC_CTL |= CRPT_ECC_CTL_START_Msk;
+
+	gStartTime = raw_read_cntpct_el0();
+	while ((CRPT->INTSTS & (CRPT_INTSTS_ECCIF_Msk | CRPT_INTSTS_ECCEIF_Msk)) == 0)
+	{
+		if ((raw_read_cntpct_el0() - gStartTime) > SB_TIMEOUT)
+		{
+			sysprintf("ecc timeout!\n");
+			return -1;
+		}
+	}
+	sts = CRPT->INTSTS & (CRPT_INTSTS_ECCIF_Msk | CRPT_INTSTS_ECCEIF_Msk);
+	CRPT->INTSTS = sts;
+	while (CRPT->ECC_STS & CRPT_ECC_STS_BUSY_Msk);
+
+	return (sts & CRPT_INTSTS_ECCEIF_Msk) ? -1 : 0;
+}
+
+/* big-endian bytes to words, least significant word first */
+static void sbBin2Words(const uint8_t *bin, uint32_t words[])
+{
+	int i;
+
+	for (i = 0; i < SB_WORDS; i++)
+		words[SB_WORDS - 1 - i] = ((uint32_t)bin[4*i] << 24) | ((uint32_t)bin[4*i+1] << 16) |
+								  ((uint32_t)bin[4*i+2] << 8) | bin[4*i+3];
+}
+
+static int sbHex2Words(const char *hex, uint32_t words[])
+{
+	int i, c;
+
+	for (i = 0; i < SB_WORDS; i++)
+		words[i] = 0;
+
+	for (i = 0; i < SB_WORDS * 8; i++)
+	{
+		c = hex[i];
+		if ((c >= '0') && (c <= '9'))
+			c -= '0';
+		else if ((c >= 'a') && (c <= 'f'))
+			c -= 'a' - 10;
+		else if ((c >= 'A') && (c <= 'F'))
+			c -= 'A' - 10;
+		else
+			return -1;
+		words[SB_WORDS - 1 - i / 8] |= (uint32_t)c << (28 - (i % 8) * 4);
+	}
+	return 0;
+}
+
+/* -1, 0, 1 for a < b, a == b, a > b */
+static int sbCompare(const uint32_t a[], const uint32_t b[])
+{
+	int i;
+
+	for (i = SB_WORDS - 1; i >= 0; i--)
+	{
+		if (a[i] != b[i])
+			return (a[i] > b[i]) ? 1 : -1;
+	}
+	return 0;
+}
+
+static int sbIsZero(const uint32_t a[])
+{
+	int i;
+
+	for (i = 0; i < SB_WORDS; i++)
+	{
+		if (a[i])
+			return 0;
+	}
+	return 1;
+}
+
+/*
+	e: message hash, r/s: signature, qx/qy: public key
+
+	The step order is that of ecc_verify() in the CRYPTO driver.
+*/
+static int sbEcdsaVerify(const uint32_t e[], const uint32_t r[], const uint32_t s[],
+						 const uint32_t qx[], const uint32_t qy[])
+{
+	uint32_t w[SB_WORDS], u1[SB_WORDS], u2[SB_WORDS];
+	uint32_t x1[SB_WORDS], y1[SB_WORDS], x2[SB_WORDS], y2[SB_WORDS];
+	uint32_t one[SB_WORDS] = { 1 };
+	uint32_t zero[SB_WORDS] = { 0 };
+
+	/* r and s must be in [1, n-1] */
+	if (sbIsZero(r) || sbIsZero(s) || (sbCompare(r, sbCurveN) >= 0) || (sbCompare(s, sbCurveN) >= 0))
+		return -1;
+
+	/* w = s^-1 (mod n) */
+	sbEccWrite(CRPT->ECC_N, sbCurveN);
+	sbEccWrite(CRPT->ECC_X1, s);
+	sbEccWrite(CRPT->ECC_Y1, one);
+	if (sbEccRun(ECCOP_MODULE | MODOP_DIV))
+		return -1;
+	sbEccRead(w, CRPT->ECC_X1);
+
+	/* u1 = e * w (mod n) */
+	sbEccWrite(CRPT->ECC_N, sbCurveN);
+	sbEccWrite(CRPT->ECC_X1, e);
+	sbEccWrite(CRPT->ECC_Y1, w);
+	if (sbEccRun(ECCOP_MODULE | MODOP_MUL))
+		return -1;
+	sbEccRead(u1, CRPT->ECC_X1);
+
+	/* u2 = r * w (mod n) */
+	sbEccWrite(CRPT->ECC_N, sbCurveN);
+	sbEccWrite(CRPT->ECC_X1, r);
+	sbEccWrite(CRPT->ECC_Y1, w);
+	if (sbEccRun(ECCOP_MODULE | MODOP_MUL))
+		return -1;
+	sbEccRead(u2, CRPT->ECC_X1);
+
+	/* u1 * G */
+	sbEccInitCurve();
+	sbEccWrite(CRPT->ECC_K, u1);
+	sbEccWrite(CRPT->ECC_X2, sbCurveN);
+	if (sbEccRun(ECCOP_POINT_MUL))
+		return -1;
+	sbEccRead(x2, CRPT->ECC_X1);
+	sbEccRead(y2, CRPT->ECC_Y1);
+
+	/* u2 * Q */
+	sbEccInitCurve();
+	sbEccWrite(CRPT->ECC_X1, qx);
+	sbEccWrite(CRPT->ECC_Y1, qy);
+	sbEccWrite(CRPT->ECC_K, u2);
+	sbEccWrite(CRPT->ECC_X2, sbCurveN);
+	if (sbEccRun(ECCOP_POINT_MUL))
+		return -1;
+	sbEccRead(x1, CRPT->ECC_X1);
+	sbEccRead(y1, CRPT->ECC_Y1);
+
+	/* (x1', y1') = u1 * G + u2 * Q */
+	sbEccInitCurve();
+	sbEccWrite(CRPT->ECC_X1, x1);
+	sbEccWrite(CRPT->ECC_Y1, y1);
+	sbEccWrite(CRPT->ECC_X2, x2);
+	sbEccWrite(CRPT->ECC_Y2, y2);
+	if (sbEccRun(ECCOP_POINT_ADD))
+		return -1;
+	sbEccRead(x1, CRPT->ECC_X1);
+
+	/* x1' (mod n) */
+	sbEccWrite(CRPT->ECC_N, sbCurveN);
+	sbEccWrite(CRPT->ECC_X1, x1);
+	sbEccWrite(CRPT->ECC_Y1, zero);
+	if (sbEccRun(ECCOP_MODULE | MODOP_ADD))
+		return -1;
+	sbEccRead(x1, CRPT->ECC_X1);
+
+	return (sbCompare(x1, r) == 0) ? 0 : -1;
+}
+
+/*
+	sig: DDR address of the signature, R then S, 32 bytes each, big-endian
+	return: 0 if the whole image was hashed and the signature matches
+*/
+int sbVerify(uint32_t sig)
+{
+	uint32_t e[SB_WORDS], r[SB_WORDS], s[SB_WORDS], qx[SB_WORDS], qy[SB_WORDS];
+	int i;
+
+	if ((sbShaWait() != 0) || sbError || sbFirst || (sbRemain != 0))
+	{
+		sysprintf("image not fully hashed!\n");
+		return -1;
+	}
+
+	/* the digest words are big-endian with output swap on */
+	for (i = 0; i < SB_WORDS; i++)
+		e[SB_WORDS - 1 - i] = CRPT->HMAC_DGST[i];
+
+	if ((sbHex2Words(APP_PUBKEY_X, qx) != 0) || (sbHex2Words(APP_PUBKEY_Y, qy) != 0) ||
+		(sbIsZero(qx) && sbIsZero(qy)))
+	{
+		sysprintf("public key not set!\n");
+		return -1;
+	}
+
+	sbBin2Words((const uint8_t *)(uint64_t)sig, r);
+	sbBin2Words((const uint8_t *)(uint64_t)(sig + 32), s);
+
+	return sbEcdsaVerify(e, r, s, qx, qy);
+}
@@ -0,0 +1,19 @@
+/*************************************************************************//**
+ * @file     NuMicro.h
+ * @version  V1.00
+ * @brief    host stand-in for building src/lz4.c in the decoder test.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#ifndef _HOST_NUMICRO_H
+#define _HOST_NUMICRO_H
+
+#include <stdint.h>
+
+typedef struct { uint32_t uPageSize; } NAND_INFO_T;
+struct mmc;
+
+void sysprintf(const char *pcStr, ...);
+
+#endif /* _HOST_NUMICRO_H */
@@ -0,0 +1,422 @@
+/*************************************************************************//**
+ * @file     lz4_test.c
+ * @version  V1.00
+ * @brief    host test of the loader LZ4 decoder, src/lz4.c, on frames made
+ *           by lz4pack. The frame is fed in storage sized parts as the
+ *           loader does. The decoder takes 32-bit addresses, so the buffers
+ *           are mapped below 4GB, each followed by an inaccessible page: a
+ *           read past the data fed or a write past the unpack room faults.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "NuMicro.h"
+#include "../Loader/loader.h"
+#include "lz4frame.h"
+
+#define PAGE			4096UL
+#define SRC_ROOM		(4UL << 20)
+#define DST_ROOM		(4UL << 20)
+
+#define LZ4_FLG_BCHECKSUM	0x10
+#define LZ4_FLG_CSIZE		0x08
+#define LZ4_FLG_CCHECKSUM	0x04
+
+static uint8_t *srcBuf, *dstBuf;
+static int failCount, checkCount;
+
+#define CHECK(cond, ...)											\
+	do {															\
+		checkCount++;												\
+		if (!(cond)) {												\
+			printf("FAIL %s:%d: ", __FILE__, __LINE__);				\
+			printf(__VA_ARGS__);									\
+			printf("\n");											\
+			failCount++;											\
+		}															\
+	} while (0)
+
+void sysprintf(const char *pcStr, ...)
+{
+	(void)pcStr;
+}
+
+/* room bytes below 4GB, then a guard page */
+static uint8_t *mapLow(size_t room)
+{
+	uint8_t *p = mmap(NULL, room + PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+	if ((p == MAP_FAILED) || (mprotect(p + room, PAGE, PROT_NONE) != 0))
+	{
+		perror("mmap");
+		exit(1);
+	}
+	return p;
+}
+
+static uint32_t addr32(const void *p)
+{
+	return (uint32_t)(uint64_t)p;
+}
+
+static uint32_t rndState = 0x2545F491;
+
+static uint32_t rnd(void)
+{
+	rndState ^= rndState << 13;
+	rndState ^= rndState >> 17;
+	rndState ^= rndState << 5;
+	return rndState;
+}
+
+/*
+	Feed len bytes of frame in parts of chunk bytes, the last byte fed just
+	before the guard page. dstRoom is the unpack room, it ends at the guard
+	page of dstBuf. Return the last lz4Feed() result, *dst the unpacked data.
+*/
+static int feed(const uint8_t *frame, size_t len, size_t chunk, size_t dstRoom, uint8_t **dst)
+{
+	uint8_t *src = srcBuf + SRC_ROOM - len;
+	size_t done, n;
+	int ret = 0;
+
+	*dst = dstBuf + DST_ROOM - dstRoom;
+	memset(*dst, 0x5A, dstRoom);
+	lz4Init(addr32(src), addr32(*dst), (uint32_t)dstRoom);
+
+	for (done = 0; (done < len) && (ret == 0); done += n)
+	{
+		n = (len - done < chunk) ? len - done : chunk;
+		memcpy(src + done, frame + done, n);
+		ret = lz4Feed(addr32(src + done + n));
+	}
+	return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+/* test images                                                               */
+/*---------------------------------------------------------------------------*/
+
+enum { IMG_TEXT, IMG_ZERO, IMG_RANDOM, IMG_MIXED };
+
+static void makeImage(uint8_t *p, size_t len, int kind)
+{
+	static const char *words[] = { "loader ", "image ", "block ", "frame ", "ddr ", "0x80000000 ", "\n" };
+	size_t i, n;
+
+	switch (kind)
+	{
+	case IMG_TEXT:
+		for (i = 0; i < len; i += n)
+		{
+			const char *w = words[rnd() % 7];
+
+			n = strlen(w);
+			if (n > len - i)
+				n = len - i;
+			memcpy(p + i, w, n);
+		}
+		break;
+	case IMG_ZERO:
+		memset(p, 0, len);
+		break;
+	case IMG_RANDOM:
+		for (i = 0; i < len; i++)
+			p[i] = (uint8_t)rnd();
+		break;
+	default:
+		/* code like: short repeats at all distances, some noise */
+		for (i = 0; i < len; i += n)
+		{
+			if ((i >= 64) && (rnd() % 4 != 0))
+			{
+				size_t from = i - 1 - rnd() % ((i < 60000) ? i : 60000);
+
+				n = 4 + rnd() % 36;
+				if (n > len - i)
+					n = len - i;
+				memmove(p + i, p + from, n);
+			}
+			else
+			{
+				p[i] = (uint8_t)rnd();
+				n = 1;
+			}
+		}
+		break;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/* tests                                                                     */
+/*---------------------------------------------------------------------------*/
+
+static void testRoundTrip(void)
+{
+	static const struct { size_t len; int kind; } img[] =
+	{
+		{ 0, IMG_ZERO }, { 1, IMG_RANDOM }, { 12, IMG_TEXT }, { 13, IMG_TEXT },
+		{ 65536, IMG_ZERO }, { 65537, IMG_TEXT }, { 70000, IMG_RANDOM },
+		{ 300000, IMG_MIXED }, { 1000000, IMG_TEXT },
+	};
+	static const size_t chunks[] = { 1, 512, 2048, 0x4000, SRC_ROOM };
+	static const int blockIds[] = { LZ4_BLOCK_64K, 5, LZ4_BLOCK_4M };
+	uint8_t *image, *frame, *dst;
+	size_t i, j, k, flen, room;
+	int ret;
+
+	for (i = 0; i < sizeof(img) / sizeof(img[0]); i++)
+	{
+		image = malloc(img[i].len + 1);
+		makeImage(image, img[i].len, img[i].kind);
+
+		for (k = 0; k < sizeof(blockIds) / sizeof(blockIds[0]); k++)
+		{
+			frame = malloc(lz4PackBound(img[i].len, blockIds[k]));
+			flen = lz4Pack(image, img[i].len, frame, blockIds[k]);
+			CHECK(flen != 0, "pack %zu bytes", img[i].len);
+			if (img[i].kind != IMG_RANDOM)
+				CHECK((img[i].len < 0x1000) || (flen < img[i].len / 2), "%zu bytes packed to %zu", img[i].len, flen);
+
+			for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++)
+			{
+				/* byte at a time only for the small images, it is slow */
+				if ((chunks[j] == 1) && (img[i].len > 70000))
+					continue;
+
+				/* no room to spare, and the output must not go past it */
+				room = img[i].len;
+				ret = feed(frame, flen, chunks[j], room, &dst);
+				CHECK(ret == 1, "%zu bytes, B%d, parts of %zu: lz4Feed() %d", img[i].len, blockIds[k], chunks[j], ret);
+				CHECK(lz4End() == addr32(srcBuf + SRC_ROOM), "frame end");
+				CHECK(memcmp(dst, image, img[i].len) == 0, "%zu bytes, B%d, parts of %zu: data", img[i].len,
+					  blockIds[k], chunks[j]);
+			}
+			free(frame);
+		}
+		free(image);
+	}
+}
+
+/* the loader reads whole pages, the bytes after the frame must be left alone */
+static void testTrailingData(void)
+{
+	uint8_t image[5000], frame[8192], *dst;
+	size_t flen;
+	int ret;
+
+	makeImage(image, sizeof(image), IMG_TEXT);
+	flen = lz4Pack(image, sizeof(image), frame, LZ4_BLOCK_64K);
+	memset(frame + flen, 0xFF, sizeof(frame) - flen);
+
+	ret = feed(frame, sizeof(frame), 2048, DST_ROOM, &dst);
+	CHECK(ret == 1, "frame in pages: lz4Feed() %d", ret);
+	CHECK(lz4End() == addr32(srcBuf + SRC_ROOM - sizeof(frame) + flen), "frame end before the padding");
+	CHECK(memcmp(dst, image, sizeof(image)) == 0, "frame in pages: data");
+	CHECK(dst[sizeof(image)] == 0x5A, "written past the image");
+}
+
+/* every cut of a frame waits for more data, and reads nothing past the cut */
+static void testTruncated(void)
+{
+	uint8_t *image, *frame, *dst;
+	size_t len = 140000, flen, cut;
+	int ret, bad = 0;
+
+	image = malloc(len);
+	makeImage(image, len, IMG_MIXED);
+	frame = malloc(lz4PackBound(len, LZ4_BLOCK_64K));
+	flen = lz4Pack(image, len, frame, LZ4_BLOCK_64K);
+
+	for (cut = 0; cut < flen; cut += (cut < 64 || flen - cut < 64) ? 1 : 97)
+	{
+		ret = feed(frame, cut, 4096, len, &dst);
+		if ((ret != 0) || (lz4End() != 0))
+		{
+			if (bad++ < 5)
+				printf("FAIL cut at %zu of %zu: lz4Feed() %d\n", cut, flen, ret);
+		}
+	}
+	CHECK(bad == 0, "%d truncated frames not waiting for data", bad);
+
+	free(image);
+	free(frame);
+}
+
+/* header with content size, checksum byte not checked by the loader */
+static size_t putHeader(uint8_t *p, uint8_t flg, uint8_t bd, uint64_t csize)
+{
+	size_t n = 6;
+	int i;
+
+	p[0] = 0x04;
+	p[1] = 0x22;
+	p[2] = 0x4D;
+	p[3] = 0x18;
+	p[4] = flg;
+	p[5] = bd;
+	if (flg & LZ4_FLG_CSIZE)
+	{
+		for (i = 0; i < 8; i++)
+			p[n++] = (uint8_t)(csize >> (8 * i));
+	}
+	p[n] = (uint8_t)(lz4Xxh32(p + 4, n - 4, 0) >> 8);
+	return n + 1;
+}
+
+static size_t put32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+	return 4;
+}
+
+/* a frame with one compressed block */
+static size_t oneBlock(uint8_t *p, uint8_t flg, const uint8_t *blk, size_t blen, uint64_t csize)
+{
+	size_t n = putHeader(p, flg, 0x40, csize);
+
+	n += put32(p + n, (uint32_t)blen);
+	memcpy(p + n, blk, blen);
+	n += blen;
+	return n + put32(p + n, 0);
+}
+
+static void testCorrupt(void)
+{
+	/* "abcd" then a 4 byte match of offset 4: "abcdabcd" */
+	static const uint8_t good[] = { 0x40, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x00 };
+	static const uint8_t offZero[] = { 0x40, 'a', 'b', 'c', 'd', 0x00, 0x00, 0x00 };
+	static const uint8_t offFar[] = { 0x40, 'a', 'b', 'c', 'd', 0x05, 0x00, 0x00 };
+	static const uint8_t litLong[] = { 0x90, 'a', 'b', 'c', 'd' };
+	static const uint8_t litExtCut[] = { 0xF0, 0xFF };
+	static const uint8_t offCut[] = { 0x40, 'a', 'b', 'c', 'd', 0x04 };
+	static const uint8_t matchLong[] = { 0x4F, 'a', 'b', 'c', 'd', 0x04, 0x00, 0xFF, 0x10, 0x00 };
+	uint8_t f[256], *dst;
+	size_t n;
+	int ret;
+
+	n = oneBlock(f, 0x40 | LZ4_FLG_CSIZE, good, sizeof(good), 8);
+	CHECK(feed(f, n, n, 8, &dst) == 1, "hand made frame");
+	CHECK(memcmp(dst, "abcdabcd", 8) == 0, "hand made frame data");
+
+	f[0] ^= 1;
+	CHECK(feed(f, n, n, 8, &dst) == -1, "bad magic");
+	CHECK(lz4Feed(addr32(srcBuf + SRC_ROOM)) == -1, "fed after an error");
+
+	n = oneBlock(f, 0x80 | LZ4_FLG_CSIZE, good, sizeof(good), 8);
+	CHECK(feed(f, n, n, 8, &dst) == -1, "frame version 2");
+	n = oneBlock(f, 0x40 | LZ4_FLG_CSIZE | 0x01, good, sizeof(good), 8);
+	CHECK(feed(f, n, n, 8, &dst) == -1, "dictionary id");
+	n = oneBlock(f, 0x40 | LZ4_FLG_CSIZE, good, sizeof(good), 8);
+	f[5] = 0x30;
+	CHECK(feed(f, n, n, 8, &dst) == -1, "16KB blocks");
+
+	n = oneBlock(f, 0x40 | LZ4_FLG_CSIZE, good, sizeof(good), 9);
+	CHECK(feed(f, n, n, 9, &dst) == -1, "content size mismatch");
+	n = oneBlock(f, 0x40 | LZ4_FLG_CSIZE, good, sizeof(good), 8);
+	CHECK(feed(f, n, n, 7, &dst) == -1, "content size over the room");
+
+	/* no content size, so the block checks are reached */
+	n = oneBlock(f, 0x40, offZero, sizeof(offZero), 0);
+	CHECK(feed(f, n, n, 64, &dst) == -1, "match offset 0");
+	n = oneBlock(f, 0x40, offFar, sizeof(offFar), 0);
+	CHECK(feed(f, n, n, 64, &dst) == -1, "match before the image");
+	n = oneBlock(f, 0x40, litLong, sizeof(litLong), 0);
+	CHECK(feed(f, n, n, 64, &dst) == -1, "literals past the block");
+	n = oneBlock(f, 0x40, litExtCut, sizeof(litExtCut), 0);
+	CHECK(feed(f, n, n, 64, &dst) == -1, "literal length past the block");
+	n = oneBlock(f, 0x40, offCut, sizeof(offCut), 0);
+	CHECK(feed(f, n, n, 64, &dst) == -1, "offset past the block");
+	n = oneBlock(f, 0x40, matchLong, sizeof(matchLong), 0);
+	CHECK(feed(f, n, n, 64, &dst) == -1, "match past the room");
+	n = oneBlock(f, 0x40, good, sizeof(good), 0);
+	CHECK(feed(f, n, n, 7, &dst) == -1, "block past the room");
+
+	/* stored block larger than the room, and one over the block size */
+	n = putHeader(f, 0x40, 0x40, 0);
+	n += put32(f + n, 0x80000000 | 16);
+	memset(f + n, 'x', 16);
+	n += 16;
+	n += put32(f + n, 0);
+	CHECK(feed(f, n, n, 15, &dst) == -1, "stored block past the room");
+	n = putHeader(f, 0x40, 0x40, 0);
+	n += put32(f + n, 0x80000000 | 0x10001);
+	ret = feed(f, n, n, 64, &dst);
+	CHECK(ret == -1, "block over the block size: lz4Feed() %d", ret);
+}
+
+/* block and content checksums are skipped, not taken as data */
+static void testChecksums(void)
+{
+	static const char msg[] = "hello, loader";
+	uint8_t f[128], *dst;
+	size_t n, len = sizeof(msg) - 1;
+
+	n = putHeader(f, 0x40 | LZ4_FLG_BCHECKSUM | LZ4_FLG_CCHECKSUM | LZ4_FLG_CSIZE, 0x40, len);
+	n += put32(f + n, 0x80000000 | (uint32_t)len);
+	memcpy(f + n, msg, len);
+	n += len;
+	n += put32(f + n, 0x12345678);		/* block checksum */
+	n += put32(f + n, 0);
+	n += put32(f + n, 0x9ABCDEF0);		/* content checksum */
+
+	CHECK(feed(f, n, 5, len, &dst) == 1, "checksum frame");
+	CHECK(lz4End() == addr32(srcBuf + SRC_ROOM), "checksum frame end");
+	CHECK(memcmp(dst, msg, len) == 0, "checksum frame data");
+}
+
+/* random damage fails cleanly or unpacks in the room, it never faults */
+static void testFuzz(void)
+{
+	uint8_t *image, *frame, *bad, *dst;
+	size_t len = 100000, flen, at;
+	int i, j, ret, result[3] = { 0, 0, 0 };
+
+	image = malloc(len);
+	makeImage(image, len, IMG_MIXED);
+	frame = malloc(lz4PackBound(len, LZ4_BLOCK_64K));
+	bad = malloc(lz4PackBound(len, LZ4_BLOCK_64K));
+	flen = lz4Pack(image, len, frame, LZ4_BLOCK_64K);
+
+	for (i = 0; i < 3000; i++)
+	{
+		memcpy(bad, frame, flen);
+		for (j = 1 + rnd() % 4; j > 0; j--)
+		{
+			at = rnd() % flen;
+			bad[at] ^= (uint8_t)(1 + rnd() % 255);
+		}
+		ret = feed(bad, flen, 2048, len, &dst);
+		CHECK((ret >= -1) && (ret <= 1), "lz4Feed() %d", ret);
+		result[ret + 1]++;
+	}
+	printf("fuzz: %d failed, %d waiting, %d unpacked\n", result[0], result[1], result[2]);
+
+	free(image);
+	free(frame);
+	free(bad);
+}
+
+int main(void)
+{
+	srcBuf = mapLow(SRC_ROOM);
+	dstBuf = mapLow(DST_ROOM);
+
+	testRoundTrip();
+	testTrailingData();
+	testTruncated();
+	testCorrupt();
+	testChecksums();
+	testFuzz();
+
+	printf("lz4: %d checks, %s\n", checkCount, failCount ? "FAILED" : "passed");
+	return failCount ? 1 : 0;
+}
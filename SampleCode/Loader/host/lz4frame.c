@@ -0,0 +1,252 @@
+/*************************************************************************//**
+ * @file     lz4frame.c
+ * @version  V1.00
+ * @brief    host LZ4 frame writer for the loader compressed image.
+ *           Writes the standard frame format with linked blocks and the
+ *           content size, which src/lz4.c in the loader and the lz4 tool
+ *           both read. Blocks that do not shrink are stored.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "lz4frame.h"
+
+#define LZ4_MAGIC			0x184D2204
+#define LZ4_FLG_V01			0x40
+#define LZ4_FLG_CSIZE		0x08
+
+#define LZ4_MIN_MATCH		4
+#define LZ4_LAST_LITERALS	5	/* a block ends with at least this many literals */
+#define LZ4_MF_LIMIT		12	/* no match starts closer than this to the block end */
+#define LZ4_MAX_OFFSET		65535
+
+#define HASH_BITS			16
+#define CHAIN_DEPTH			64	/* match candidates tried per position */
+
+static uint32_t read32(const uint8_t *p)
+{
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t rotl32(uint32_t v, int n)
+{
+	return (v << n) | (v >> (32 - n));
+}
+
+/* xxHash32, for the frame descriptor checksum */
+uint32_t lz4Xxh32(const uint8_t *p, size_t len, uint32_t seed)
+{
+	const uint32_t P1 = 2654435761U, P2 = 2246822519U, P3 = 3266489917U, P4 = 668265263U, P5 = 374761393U;
+	const uint8_t *end = p + len;
+	uint32_t h, v[4];
+	int i;
+
+	if (len >= 16)
+	{
+		v[0] = seed + P1 + P2;
+		v[1] = seed + P2;
+		v[2] = seed;
+		v[3] = seed - P1;
+		do
+		{
+			for (i = 0; i < 4; i++, p += 4)
+				v[i] = rotl32(v[i] + read32(p) * P2, 13) * P1;
+		} while (end - p >= 16);
+		h = rotl32(v[0], 1) + rotl32(v[1], 7) + rotl32(v[2], 12) + rotl32(v[3], 18);
+	}
+	else
+		h = seed + P5;
+
+	h += (uint32_t)len;
+	for (; end - p >= 4; p += 4)
+		h = rotl32(h + read32(p) * P3, 17) * P4;
+	for (; p < end; p++)
+		h = rotl32(h + *p * P5, 11) * P1;
+
+	h ^= h >> 15;
+	h *= P2;
+	h ^= h >> 13;
+	h *= P3;
+	h ^= h >> 16;
+	return h;
+}
+
+static size_t blockSize(int blockId)
+{
+	return (size_t)1 << (8 + 2 * blockId);
+}
+
+/* worst case frame size for len bytes of input */
+size_t lz4PackBound(size_t len, int blockId)
+{
+	size_t blocks = len / blockSize(blockId) + 1;
+
+	return 15 + blocks * 4 + len + 4;
+}
+
+static uint8_t *putLength(uint8_t *op, size_t len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+static uint8_t *putSequence(uint8_t *op, const uint8_t *lit, size_t litLen, size_t offset, size_t matchLen)
+{
+	uint8_t *token = op++;
+
+	*token = (uint8_t)(((litLen < 15) ? litLen : 15) << 4);
+	if (litLen >= 15)
+		op = putLength(op, litLen - 15);
+	memcpy(op, lit, litLen);
+	op += litLen;
+
+	if (matchLen == 0)
+		return op;	/* the last sequence has literals only */
+
+	*op++ = (uint8_t)offset;
+	*op++ = (uint8_t)(offset >> 8);
+	matchLen -= LZ4_MIN_MATCH;
+	*token |= (uint8_t)((matchLen < 15) ? matchLen : 15);
+	if (matchLen >= 15)
+		op = putLength(op, matchLen - 15);
+	return op;
+}
+
+static uint32_t hash4(const uint8_t *p)
+{
+	return (read32(p) * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/*
+	Compress in[start, end) into op, matches may reach back into earlier blocks.
+	head and chain index positions of all of in.
+	Return the block length, or 0 if it did not fit in limit bytes.
+*/
+static size_t packBlock(const uint8_t *in, size_t start, size_t end, int32_t *head, int32_t *chain,
+						uint8_t *op, size_t limit)
+{
+	uint8_t *ostart = op, *oend = op + limit;
+	size_t pos = start, anchor = start, bestLen, bestOff, len;
+	int32_t cand;
+	int depth;
+
+	while (pos + LZ4_MF_LIMIT < end)
+	{
+		uint32_t h = hash4(&in[pos]);
+
+		bestLen = 0;
+		bestOff = 0;
+		for (cand = head[h], depth = 0; (cand >= 0) && (pos - cand <= LZ4_MAX_OFFSET) && (depth < CHAIN_DEPTH);
+			 cand = chain[cand], depth++)
+		{
+			for (len = 0; (pos + len < end - LZ4_LAST_LITERALS) && (in[cand + len] == in[pos + len]); len++)
+				;
+			if (len > bestLen)
+			{
+				bestLen = len;
+				bestOff = pos - cand;
+			}
+		}
+		chain[pos] = head[h];
+		head[h] = (int32_t)pos;
+
+		if (bestLen < LZ4_MIN_MATCH)
+		{
+			pos++;
+			continue;
+		}
+
+		/* token, lengths, literals and offset */
+		if ((size_t)(oend - op) < 1 + (pos - anchor) + (pos - anchor) / 255 + 1 + 2 + bestLen / 255 + 1)
+			return 0;
+		op = putSequence(op, &in[anchor], pos - anchor, bestOff, bestLen);
+
+		/* the matched positions can be matched against later */
+		for (len = 1; (len < bestLen) && (pos + len + LZ4_MIN_MATCH <= end); len++)
+		{
+			h = hash4(&in[pos + len]);
+			chain[pos + len] = head[h];
+			head[h] = (int32_t)(pos + len);
+		}
+		pos += bestLen;
+		anchor = pos;
+	}
+
+	if ((size_t)(oend - op) < 1 + (end - anchor) + (end - anchor) / 255 + 1)
+		return 0;
+	op = putSequence(op, &in[anchor], end - anchor, 0, 0);
+	return op - ostart;
+}
+
+/*
+	in, len: the image
+	out: at least lz4PackBound(len, blockId) bytes
+	blockId: LZ4_BLOCK_64K to LZ4_BLOCK_4M
+	return: frame length, 0 if out of memory
+*/
+size_t lz4Pack(const uint8_t *in, size_t len, uint8_t *out, int blockId)
+{
+	size_t bsize = blockSize(blockId), pos, n, clen;
+	int32_t *head, *chain;
+	uint8_t *op = out;
+	uint64_t csize = len;
+	int i;
+
+	head = malloc(sizeof(int32_t) << HASH_BITS);
+	chain = malloc(sizeof(int32_t) * (len + 1));
+	if ((head == NULL) || (chain == NULL))
+	{
+		free(head);
+		free(chain);
+		return 0;
+	}
+	for (i = 0; i < (1 << HASH_BITS); i++)
+		head[i] = -1;
+
+	/* magic, FLG, BD, content size, header checksum */
+	write32(op, LZ4_MAGIC);
+	op[4] = LZ4_FLG_V01 | LZ4_FLG_CSIZE;
+	op[5] = (uint8_t)(blockId << 4);
+	for (i = 0; i < 8; i++)
+		op[6 + i] = (uint8_t)(csize >> (8 * i));
+	op[14] = (uint8_t)(lz4Xxh32(op + 4, 10, 0) >> 8);
+	op += 15;
+
+	for (pos = 0; pos < len; pos += n)
+	{
+		n = (len - pos < bsize) ? len - pos : bsize;
+		clen = packBlock(in, pos, pos + n, head, chain, op + 4, n - 1);
+		if (clen != 0)
+		{
+			write32(op, (uint32_t)clen);
+		}
+		else
+		{
+			/* stored, the block did not shrink */
+			write32(op, (uint32_t)n | 0x80000000);
+			memcpy(op + 4, &in[pos], n);
+			clen = n;
+		}
+		op += 4 + clen;
+	}
+
+	/* end mark */
+	write32(op, 0);
+	op += 4;
+
+	free(head);
+	free(chain);
+	return op - out;
+}
@@ -0,0 +1,23 @@
+/*************************************************************************//**
+ * @file     lz4frame.h
+ * @version  V1.00
+ * @brief    host LZ4 frame writer for the loader compressed image.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#ifndef _LZ4FRAME_H
+#define _LZ4FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* block size id of the frame descriptor, 4: 64KB ... 7: 4MB */
+#define LZ4_BLOCK_64K		4
+#define LZ4_BLOCK_4M		7
+
+size_t   lz4PackBound(size_t len, int blockId);
+size_t   lz4Pack(const uint8_t *in, size_t len, uint8_t *out, int blockId);
+uint32_t lz4Xxh32(const uint8_t *p, size_t len, uint32_t seed);
+
+#endif /* _LZ4FRAME_H */
@@ -0,0 +1,119 @@
+/*************************************************************************//**
+ * @file     lz4pack.c
+ * @version  V1.00
+ * @brief    host tool packing an application image for the loader APP_LZ4
+ *           mode:
+ *
+ *             lz4pack [-B4..-B7] [-s sig.bin] [-m max] Template.bin Template.bin.lz4
+ *
+ *           -B  block size id, 4: 64KB (default) to 7: 4MB. The loader
+ *               unpacks a block once all of it is read.
+ *           -s  SECURE_BOOT signature of the unpacked image, appended
+ *           -m  room in storage, APP_SIZE; fail if the output is larger
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lz4frame.h"
+
+#define SIG_SIZE	64	/* APP_SIG_SIZE */
+
+static uint8_t *readFile(const char *name, size_t *len)
+{
+	FILE *f = fopen(name, "rb");
+	uint8_t *buf = NULL;
+	long n;
+
+	if (f == NULL)
+		return NULL;
+	if ((fseek(f, 0, SEEK_END) == 0) && ((n = ftell(f)) >= 0) && (fseek(f, 0, SEEK_SET) == 0))
+	{
+		buf = malloc(n + 1);
+		if ((buf != NULL) && (fread(buf, 1, n, f) != (size_t)n))
+		{
+			free(buf);
+			buf = NULL;
+		}
+		*len = n;
+	}
+	fclose(f);
+	return buf;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: lz4pack [-B4..-B7] [-s sig.bin] [-m max] image.bin image.lz4\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *sigName = NULL;
+	uint8_t *in, *out, *sig = NULL;
+	size_t len, olen, slen = 0;
+	unsigned long max = 0;
+	int blockId = LZ4_BLOCK_64K, i;
+	FILE *f;
+
+	for (i = 1; (i < argc) && (argv[i][0] == '-'); i++)
+	{
+		if ((strlen(argv[i]) == 3) && (argv[i][1] == 'B') && (argv[i][2] >= '4') && (argv[i][2] <= '7'))
+			blockId = argv[i][2] - '0';
+		else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+			sigName = argv[++i];
+		else if ((strcmp(argv[i], "-m") == 0) && (i + 1 < argc))
+			max = strtoul(argv[++i], NULL, 0);
+		else
+			usage();
+	}
+	if (argc - i != 2)
+		usage();
+
+	in = readFile(argv[i], &len);
+	if (in == NULL)
+	{
+		fprintf(stderr, "lz4pack: cannot read %s\n", argv[i]);
+		return 1;
+	}
+	if (sigName != NULL)
+	{
+		sig = readFile(sigName, &slen);
+		if ((sig == NULL) || (slen != SIG_SIZE))
+		{
+			fprintf(stderr, "lz4pack: %s is not a %d byte signature\n", sigName, SIG_SIZE);
+			return 1;
+		}
+	}
+
+	out = malloc(lz4PackBound(len, blockId));
+	if ((out == NULL) || ((olen = lz4Pack(in, len, out, blockId)) == 0))
+	{
+		fprintf(stderr, "lz4pack: out of memory\n");
+		return 1;
+	}
+
+	if ((max != 0) && (olen + slen > max))
+	{
+		fprintf(stderr, "lz4pack: %zu bytes do not fit in %lu\n", olen + slen, max);
+		return 1;
+	}
+
+	f = fopen(argv[i + 1], "wb");
+	if ((f == NULL) || (fwrite(out, 1, olen, f) != olen) ||
+		((slen != 0) && (fwrite(sig, 1, slen, f) != slen)) || (fclose(f) != 0))
+	{
+		fprintf(stderr, "lz4pack: cannot write %s\n", argv[i + 1]);
+		return 1;
+	}
+
+	printf("%s: %zu -> %zu bytes (%.1f%%)\n", argv[i + 1], len, olen + slen,
+		   len ? 100.0 * (olen + slen) / len : 0.0);
+
+	free(in);
+	free(out);
+	free(sig);
+	return 0;
+}
@@ -13,6 +13,7 @@
 #include "NuMicro.h"
 #include "diskio.h"     /* FatFs lower layer API */
 #include "ff.h"
+#include "sd_crypt.h"
 
 #define Sector_Size 128 //512byte
 uint32_t Tmp_Buffer[Sector_Size];
@@ -90,6 +91,9 @@ DRESULT disk_read (
 
     //printf("disk_read - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (uint32_t)buff);
 
+    if (SDC_IsEnabled(pdrv))
+        return (SDC_Read((pdrv == 0) ? SDH0 : SDH1, buff, sector, count) == 0) ? RES_OK : RES_ERROR;
+
     if (ptr_to_u32(buff)%4)
     {
         shift_buf_flag = 1;
@@ -159,6 +163,9 @@ DRESULT disk_write (
     uint32_t volatile i;
 
     //printf("disk_write - drv:%d, sec:%d, cnt:%d, buff:0x%x\n", pdrv, sector, count, (uint32_t)buff);
+    if (SDC_IsEnabled(pdrv))
+        return (SDC_Write((pdrv == 0) ? SDH0 : SDH1, buff, sector, count) == 0) ? RES_OK : RES_ERROR;
+
     if (ptr_to_u32(buff)%4)
     {
         shift_buf_flag = 1;
@@ -0,0 +1,164 @@
+/**************************************************************************//**
+ * @file     file_verify.c
+ * @brief    Streaming SHA/HMAC and ECDSA verification of FatFs files. The
+ *           file is read into one of two buffers while the CRYPTO engine
+ *           hashes the other in DMA cascade mode, so a file is hashed at
+ *           storage speed.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <string.h>
+
+#include "file_verify.h"
+
+/*
+ * Ping-pong buffers. Each has FV_HMAC_KEY_MAX bytes in front of the data,
+ * where the HMAC key is put so the first DMA run is key | data.
+ */
+static uint8_t s_au8Buf[2][FV_HMAC_KEY_MAX + FV_CHUNK_SIZE] __attribute__((aligned(64)));
+
+static int fv_digest_len(uint32_t u32ShaMode)
+{
+    switch (u32ShaMode)
+    {
+    case SHA_MODE_SHA1:
+        return 20;
+    case SHA_MODE_SHA224:
+        return 28;
+    case SHA_MODE_SHA256:
+        return 32;
+    case SHA_MODE_SHA384:
+        return 48;
+    case SHA_MODE_SHA512:
+        return 64;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Hash or HMAC a file from its current position to the end. While the
+ * engine hashes one buffer, the next FV_CHUNK_SIZE bytes are read into the
+ * other one.
+ *
+ * @param fp         open file; left at the end of the file
+ * @param u32ShaMode SHA_MODE_SHA1/224/256/384/512
+ * @param au8HmacKey HMAC key, NULL for a plain hash
+ * @param u32KeyLen  HMAC key bytes, at most FV_HMAC_KEY_MAX
+ * @param au8Digest  receives the big-endian digest
+ * @return digest bytes, or FV_ERR_xxx
+ */
+int FV_HashFile(FIL *fp, uint32_t u32ShaMode, const uint8_t au8HmacKey[], uint32_t u32KeyLen,
+                uint8_t au8Digest[])
+{
+    uint32_t au32Dgst[16];
+    uint8_t  *pu8Src;
+    UINT     au32Len[2], u32Len;
+    FRESULT  res = FR_OK;
+    int      i, cur = 0, first = 1, last, dlen;
+
+    dlen = fv_digest_len(u32ShaMode);
+    if (au8HmacKey == NULL)
+        u32KeyLen = 0;
+    if ((dlen == 0) || (u32KeyLen > FV_HMAC_KEY_MAX))
+        return FV_ERR_PARAM;
+
+    if (f_read(fp, s_au8Buf[0] + FV_HMAC_KEY_MAX, FV_CHUNK_SIZE, &au32Len[0]) != FR_OK)
+        return FV_ERR_READ;
+    if (au32Len[0] == 0)
+        return FV_ERR_PARAM;
+
+    SHA_Open(CRPT, u32ShaMode, SHA_IN_OUT_SWAP, u32KeyLen);
+
+    for (;;)
+    {
+        last = (f_tell(fp) >= f_size(fp));
+
+        pu8Src = s_au8Buf[cur] + FV_HMAC_KEY_MAX;
+        u32Len = au32Len[cur];
+        if (first && (u32KeyLen != 0))
+        {
+            /* The engine pads the key into its own block, so only the data
+               part of a cascade run has to be a multiple of the block size */
+            pu8Src -= u32KeyLen;
+            memcpy(pu8Src, au8HmacKey, u32KeyLen);
+            u32Len += u32KeyLen;
+        }
+
+        dcache_clean_by_mva(pu8Src, u32Len);
+        SHA_SetDMATransfer(CRPT, ptr_to_u32(pu8Src), u32Len);
+        SHA_Trigger(CRPT, first ? (last ? CRYPTO_DMA_ONE_SHOT : CRYPTO_DMA_FIRST) :
+                    (last ? CRYPTO_DMA_LAST : CRYPTO_DMA_CONTINUE));
+
+        /* Read ahead while the engine works */
+        if (!last)
+            res = f_read(fp, s_au8Buf[!cur] + FV_HMAC_KEY_MAX, FV_CHUNK_SIZE, &au32Len[!cur]);
+
+        if (SHA_Wait(CRPT) != 0)
+            return FV_ERR_ENGINE;
+
+        if (last)
+            break;
+
+        /* f_read() only comes back short at the end of the file */
+        if ((res != FR_OK) || (au32Len[!cur] == 0))
+            return FV_ERR_READ;
+
+        first = 0;
+        cur = !cur;
+    }
+
+    SHA_Read(CRPT, au32Dgst);
+    for (i = 0; i < dlen / 4; i++)
+    {
+        au8Digest[4 * i]     = (uint8_t)(au32Dgst[i] >> 24);
+        au8Digest[4 * i + 1] = (uint8_t)(au32Dgst[i] >> 16);
+        au8Digest[4 * i + 2] = (uint8_t)(au32Dgst[i] >> 8);
+        au8Digest[4 * i + 3] = (uint8_t)au32Dgst[i];
+    }
+    return dlen;
+}
+
+/**
+ * Check an ECDSA signature over a file, from its current position to the
+ * end. The file is hashed with SHA-256 for curves up to P-256, SHA-384 for
+ * P-384 and SHA-512 for P-521.
+ *
+ * @param fp      open file; left at the end of the file
+ * @param eCurve  CURVE_P_192 to CURVE_P_521
+ * @param au8PubX public key, ECC_CurveBytes() bytes each, big-endian
+ * @param au8PubY
+ * @param au8R    signature, ECC_CurveBytes() bytes each, big-endian
+ * @param au8S
+ * @return 0 if the signature matches, or FV_ERR_xxx
+ */
+int FV_VerifyFile(FIL *fp, E_ECC_CURVE eCurve, const uint8_t au8PubX[], const uint8_t au8PubY[],
+                  const uint8_t au8R[], const uint8_t au8S[])
+{
+    uint8_t  au8Digest[64], au8Msg[66];
+    uint32_t u32ShaMode;
+    int      nbytes, dlen, ret;
+
+    if ((eCurve < CURVE_P_192) || (eCurve > CURVE_P_521))
+        return FV_ERR_PARAM;
+
+    nbytes = ECC_CurveBytes(eCurve);
+    u32ShaMode = (eCurve == CURVE_P_521) ? SHA_MODE_SHA512 :
+                 (eCurve == CURVE_P_384) ? SHA_MODE_SHA384 : SHA_MODE_SHA256;
+
+    dlen = FV_HashFile(fp, u32ShaMode, NULL, 0, au8Digest);
+    if (dlen < 0)
+        return dlen;
+
+    /* ECDSA uses the leftmost bits of the hash, up to the order length */
+    memset(au8Msg, 0, sizeof(au8Msg));
+    if (dlen >= nbytes)
+        memcpy(au8Msg, au8Digest, nbytes);
+    else
+        memcpy(au8Msg + nbytes - dlen, au8Digest, dlen);
+
+    ret = ECC_VerifySignature_Bin(CRPT, eCurve, au8Msg, au8PubX, au8PubY, au8R, au8S);
+    if (ret == -2)
+        return FV_ERR_SIGNATURE;
+    return (ret == 0) ? 0 : FV_ERR_ENGINE;
+}
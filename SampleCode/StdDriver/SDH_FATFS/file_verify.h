@@ -0,0 +1,41 @@
+/**************************************************************************//**
+ * @file     file_verify.h
+ * @brief    Streaming SHA/HMAC and ECDSA verification of FatFs files. The
+ *           file is read into one of two buffers while the CRYPTO engine
+ *           hashes the other, so a file is hashed at storage speed.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#ifndef __FILE_VERIFY_H__
+#define __FILE_VERIFY_H__
+
+#include "NuMicro.h"
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Bytes read per buffer; a multiple of the sector and SHA block sizes */
+#ifndef FV_CHUNK_SIZE
+#define FV_CHUNK_SIZE       (32 * 1024)
+#endif
+
+#define FV_HMAC_KEY_MAX     128     /* Longer HMAC keys must be hashed first */
+
+#define FV_ERR_PARAM        (-1)    /* Bad argument or empty file           */
+#define FV_ERR_READ         (-2)    /* f_read() failed                      */
+#define FV_ERR_ENGINE       (-3)    /* SHA or ECC engine time-out or error  */
+#define FV_ERR_SIGNATURE    (-4)    /* Signature does not match             */
+
+int FV_HashFile(FIL *fp, uint32_t u32ShaMode, const uint8_t au8HmacKey[], uint32_t u32KeyLen,
+                uint8_t au8Digest[]);
+int FV_VerifyFile(FIL *fp, E_ECC_CURVE eCurve, const uint8_t au8PubX[], const uint8_t au8PubY[],
+                  const uint8_t au8R[], const uint8_t au8S[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FILE_VERIFY_H__ */
@@ -0,0 +1,27 @@
+/**************************************************************************//**
+ * @file     NuMicro.h
+ * @brief    Host stand-in for the sd_crypt.c test: the SD card is a RAM
+ *           array, the AES runs in mbedTLS (SDC_SW_AES).
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __NUMICRO_H__
+#define __NUMICRO_H__
+
+#include <stdint.h>
+
+#define AES_KEY_SIZE_128        0UL
+#define AES_KEY_SIZE_192        1UL
+#define AES_KEY_SIZE_256        2UL
+
+typedef struct
+{
+    uint8_t  *pu8Card;          /* SDC_SECTOR_SIZE * u32Sectors bytes */
+    uint32_t u32Sectors;
+    uint32_t u32FailSector;     /* a transfer touching this sector fails, ~0 for none */
+} SDH_T;
+
+int SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount);
+uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount);
+
+#endif /* __NUMICRO_H__ */
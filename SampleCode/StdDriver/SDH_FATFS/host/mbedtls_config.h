@@ -0,0 +1,8 @@
+/**************************************************************************//**
+ * @file     mbedtls_config.h
+ * @brief    mbedTLS configuration of the sd_crypt.c host test, AES-CBC only
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#define MBEDTLS_AES_C
+#define MBEDTLS_CIPHER_MODE_CBC
@@ -0,0 +1,232 @@
+/**************************************************************************//**
+ * @file     sd_crypt_test.c
+ * @brief    Host test of the sector encryption layer with the software AES
+ *           backend. The card is a RAM array; the expected ciphertext was
+ *           made with OpenSSL, for sector s:
+ *
+ *             IV = AES-256-ECB(IV key, s as a 16-byte big-endian number)
+ *             C  = AES-256-CBC(data key, IV, sector)
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "sd_crypt.h"
+
+#define CARD_SECTORS    64
+#define NO_FAIL         0xFFFFFFFFUL
+
+typedef struct
+{
+    uint32_t u32Sector;
+    uint8_t  au8First[16];      /* first and last cipher block of the sector */
+    uint8_t  au8Last[16];
+} kat_t;
+
+static const uint8_t s_au8DataKey[32] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+};
+
+static const uint8_t s_au8IvKey[32] =
+{
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+};
+
+/* Sector 17 is in the second chunk of a write from sector 0 */
+static const kat_t s_asKat[] =
+{
+    {
+        0,
+        { 0x2f, 0xcb, 0x22, 0xb0, 0x5a, 0xf8, 0xbf, 0x04, 0xf1, 0x56, 0xf5, 0x95, 0xba, 0xbf, 0xa7, 0xd2 },
+        { 0x82, 0xd5, 0x76, 0x36, 0x25, 0xf2, 0x28, 0x1a, 0x1b, 0xd7, 0x1a, 0x9c, 0x61, 0x67, 0x44, 0xc7 },
+    },
+    {
+        1,
+        { 0x4a, 0xee, 0x8b, 0x1e, 0x4f, 0x45, 0xee, 0xcc, 0x93, 0x0b, 0xa2, 0xe6, 0x66, 0xd4, 0x85, 0xbb },
+        { 0x43, 0x67, 0xe7, 0x77, 0x23, 0xcf, 0xe6, 0xd2, 0x97, 0x7b, 0x55, 0x5d, 0x87, 0x47, 0x74, 0x3d },
+    },
+    {
+        17,
+        { 0x31, 0xf6, 0x05, 0x09, 0xfa, 0x4c, 0x26, 0x4b, 0xb0, 0xff, 0x32, 0x1d, 0xbd, 0xd0, 0x7c, 0x02 },
+        { 0x2a, 0x35, 0x88, 0x2f, 0xd1, 0x5c, 0x39, 0x1a, 0xc2, 0xc7, 0xba, 0x38, 0xe3, 0x30, 0xc2, 0x00 },
+    },
+};
+
+/* All four bytes of the sector number reach the IV */
+static const kat_t s_sKatHigh =
+{
+    0x01020304,
+    { 0x48, 0x4e, 0x59, 0xc2, 0x22, 0xcd, 0x8a, 0xdf, 0x5f, 0x6e, 0x95, 0x26, 0x2a, 0xee, 0x51, 0x36 },
+    { 0x48, 0xf6, 0x9f, 0x94, 0x12, 0x90, 0xcd, 0x6d, 0xbd, 0x5a, 0x0f, 0x1e, 0x4c, 0x88, 0x71, 0x45 },
+};
+
+static uint8_t s_au8Card[CARD_SECTORS * SDC_SECTOR_SIZE];
+static uint8_t s_au8Plain[CARD_SECTORS * SDC_SECTOR_SIZE];
+static uint8_t s_au8Buf[CARD_SECTORS * SDC_SECTOR_SIZE];
+
+static int s_i32Fail;
+
+/*---------------------------------------------------------------------------*/
+/* Simulated SD host, sector u32Base of the card is at pu8Card[0]            */
+/*---------------------------------------------------------------------------*/
+
+static uint32_t s_u32Base;
+
+static int sdh_range(SDH_T *sdh, uint32_t u32StartSec, uint32_t u32SecCount)
+{
+    if ((u32StartSec < s_u32Base) || (u32StartSec - s_u32Base + u32SecCount > sdh->u32Sectors))
+        return -1;
+    if ((sdh->u32FailSector >= u32StartSec) && (sdh->u32FailSector < u32StartSec + u32SecCount))
+        return -1;
+    return 0;
+}
+
+int SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
+{
+    if (sdh_range(sdh, u32StartSec, u32SecCount) != 0)
+        return -1;
+    memcpy(pu8BufAddr, sdh->pu8Card + (u32StartSec - s_u32Base) * SDC_SECTOR_SIZE, u32SecCount * SDC_SECTOR_SIZE);
+    return 0;
+}
+
+uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount)
+{
+    if (sdh_range(sdh, u32StartSec, u32SecCount) != 0)
+        return 1;
+    memcpy(sdh->pu8Card + (u32StartSec - s_u32Base) * SDC_SECTOR_SIZE, pu8BufAddr, u32SecCount * SDC_SECTOR_SIZE);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Tests                                                                     */
+/*---------------------------------------------------------------------------*/
+
+#define CHECK(cond, ...)                                    \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);     \
+            printf(__VA_ARGS__);                            \
+            printf("\n");                                   \
+            s_i32Fail++;                                    \
+        }                                                   \
+    } while (0)
+
+/* Byte j of sector s, the plaintext the vectors were made with */
+static void fill_sector(uint8_t *pu8Sec, uint32_t u32Sector)
+{
+    uint32_t j;
+
+    for (j = 0; j < SDC_SECTOR_SIZE; j++)
+        pu8Sec[j] = (uint8_t)(u32Sector * 7 + j);
+}
+
+static void check_kat(const uint8_t *pu8Sec, const kat_t *psKat)
+{
+    CHECK(memcmp(pu8Sec, psKat->au8First, 16) == 0, "sector %u first block", psKat->u32Sector);
+    CHECK(memcmp(pu8Sec + SDC_SECTOR_SIZE - 16, psKat->au8Last, 16) == 0, "sector %u last block", psKat->u32Sector);
+}
+
+static void test_known_answer(SDH_T *sdh)
+{
+    uint32_t i;
+
+    for (i = 0; i < 20; i++)
+        fill_sector(&s_au8Plain[i * SDC_SECTOR_SIZE], i);
+    memcpy(s_au8Buf, s_au8Plain, 20 * SDC_SECTOR_SIZE);
+
+    CHECK(SDC_Write(sdh, s_au8Buf, 0, 20) == 0, "write sectors 0-19");
+    CHECK(memcmp(s_au8Buf, s_au8Plain, 20 * SDC_SECTOR_SIZE) == 0, "write changed the caller buffer");
+
+    for (i = 0; i < sizeof(s_asKat) / sizeof(s_asKat[0]); i++)
+        check_kat(&s_au8Card[s_asKat[i].u32Sector * SDC_SECTOR_SIZE], &s_asKat[i]);
+
+    /* Read back across the chunk boundary */
+    memset(s_au8Buf, 0, sizeof(s_au8Buf));
+    CHECK(SDC_Read(sdh, s_au8Buf, 0, 20) == 0, "read sectors 0-19");
+    CHECK(memcmp(s_au8Buf, s_au8Plain, 20 * SDC_SECTOR_SIZE) == 0, "read back sectors 0-19");
+}
+
+static void test_high_sector(SDH_T *sdh)
+{
+    uint8_t au8Sec[SDC_SECTOR_SIZE];
+
+    s_u32Base = s_sKatHigh.u32Sector;
+    fill_sector(au8Sec, s_sKatHigh.u32Sector);
+
+    CHECK(SDC_Write(sdh, au8Sec, s_sKatHigh.u32Sector, 1) == 0, "write sector 0x%x", s_sKatHigh.u32Sector);
+    check_kat(s_au8Card, &s_sKatHigh);
+
+    memset(au8Sec, 0, sizeof(au8Sec));
+    CHECK(SDC_Read(sdh, au8Sec, s_sKatHigh.u32Sector, 1) == 0, "read sector 0x%x", s_sKatHigh.u32Sector);
+    fill_sector(s_au8Buf, s_sKatHigh.u32Sector);
+    CHECK(memcmp(au8Sec, s_au8Buf, SDC_SECTOR_SIZE) == 0, "read back sector 0x%x", s_sKatHigh.u32Sector);
+
+    s_u32Base = 0;
+}
+
+/* Every sector decrypts on its own, whatever chunk it was written in */
+static void test_round_trip(SDH_T *sdh)
+{
+    uint32_t i;
+
+    for (i = 0; i < sizeof(s_au8Plain); i++)
+        s_au8Plain[i] = (uint8_t)(i * 131 + (i >> 9));
+
+    CHECK(SDC_Write(sdh, s_au8Plain, 5, 40) == 0, "write sectors 5-44");
+    CHECK(memcmp(&s_au8Card[5 * SDC_SECTOR_SIZE], s_au8Plain, SDC_SECTOR_SIZE) != 0, "sector 5 stored in plain");
+
+    for (i = 0; i < 40; i += 3)
+    {
+        uint32_t u32N = (40 - i < 3) ? 40 - i : 3;
+
+        memset(s_au8Buf, 0, u32N * SDC_SECTOR_SIZE);
+        CHECK(SDC_Read(sdh, s_au8Buf, 5 + i, u32N) == 0, "read sectors %u-%u", 5 + i, 5 + i + u32N - 1);
+        CHECK(memcmp(s_au8Buf, &s_au8Plain[i * SDC_SECTOR_SIZE], u32N * SDC_SECTOR_SIZE) == 0,
+              "read back sectors %u-%u", 5 + i, 5 + i + u32N - 1);
+    }
+
+    /* Same data at another sector gives other ciphertext */
+    CHECK(SDC_Write(sdh, s_au8Plain, 50, 1) == 0, "write sector 50");
+    CHECK(memcmp(&s_au8Card[5 * SDC_SECTOR_SIZE], &s_au8Card[50 * SDC_SECTOR_SIZE], SDC_SECTOR_SIZE) != 0,
+          "sectors 5 and 50 have the same ciphertext");
+}
+
+static void test_errors(SDH_T *sdh)
+{
+    CHECK(SDC_Read(sdh, s_au8Buf, 0, 0) == 0, "read of no sectors");
+    CHECK(SDC_Write(sdh, s_au8Buf, 0, 0) == 0, "write of no sectors");
+
+    /* In the first chunk and in a later one */
+    sdh->u32FailSector = 3;
+    CHECK(SDC_Read(sdh, s_au8Buf, 0, 40) == SDC_ERR_IO, "read error in chunk 0");
+    CHECK(SDC_Write(sdh, s_au8Buf, 0, 40) == SDC_ERR_IO, "write error in chunk 0");
+    sdh->u32FailSector = 35;
+    CHECK(SDC_Read(sdh, s_au8Buf, 0, 40) == SDC_ERR_IO, "read error in chunk 2");
+    CHECK(SDC_Write(sdh, s_au8Buf, 0, 40) == SDC_ERR_IO, "write error in chunk 2");
+    sdh->u32FailSector = NO_FAIL;
+
+    CHECK(SDC_Init(s_au8DataKey, s_au8IvKey, AES_KEY_SIZE_256 + 1) == SDC_ERR_PARAM, "bad key size accepted");
+}
+
+int main(void)
+{
+    SDH_T sSdh = { s_au8Card, CARD_SECTORS, NO_FAIL };
+
+    if (SDC_Init(s_au8DataKey, s_au8IvKey, AES_KEY_SIZE_256) != 0)
+    {
+        printf("FAIL SDC_Init\n");
+        return 1;
+    }
+
+    test_known_answer(&sSdh);
+    test_high_sector(&sSdh);
+    test_round_trip(&sSdh);
+    test_errors(&sSdh);
+
+    printf("sd_crypt: %s\n", s_i32Fail ? "FAILED" : "passed");
+    return s_i32Fail ? 1 : 0;
+}
@@ -10,9 +10,25 @@
 #include "NuMicro.h"
 #include "diskio.h"
 #include "ff.h"
+#include "file_verify.h"
+#include "sd_crypt.h"
 
 #define BUFF_SIZE       (8*1024)
 
+/*
+ * Build with SD_ENCRYPT to keep the card encrypted at rest. The AES keys
+ * must already be in Key Store OTP; format the card with "fm" after the
+ * first boot, since plain FAT sectors do not decrypt.
+ */
+#ifdef SD_ENCRYPT
+#ifndef SD_ENCRYPT_DATA_KEY
+#define SD_ENCRYPT_DATA_KEY     1       /* Key Store OTP key number of the sector key */
+#endif
+#ifndef SD_ENCRYPT_IV_KEY
+#define SD_ENCRYPT_IV_KEY       2       /* Key Store OTP key number of the IV key     */
+#endif
+#endif
+
 static UINT blen = BUFF_SIZE;
 DWORD acc_size;                         /* Work register for fs command */
 WORD acc_files, acc_dirs;
@@ -369,6 +385,134 @@ unsigned long get_fattime (void)
 
 static FIL file1, file2;        /* File objects */
 
+/*--------------------------------------------------------------------------*/
+/* Streaming hash and signature check                                       */
+/*--------------------------------------------------------------------------*/
+
+/* Read a small file, such as a key or a signature, into buf */
+static FRESULT read_small_file(const char *name, BYTE *buf, UINT max, UINT *len)
+{
+    FRESULT res;
+
+    res = f_open(&file2, name, FA_OPEN_EXISTING | FA_READ);
+    if (res == FR_OK)
+    {
+        res = f_read(&file2, buf, max, len);
+        f_close(&file2);
+    }
+    return res;
+}
+
+/* fh <1|224|256|384|512> <file> - Hash a file */
+static void cmd_hash(char *ptr)
+{
+    long     bits;
+    uint32_t mode;
+    uint64_t t0;
+    int      i, size, ret;
+    FRESULT  res;
+
+    if (!xatoi(&ptr, &bits)) return;
+    while (*ptr == ' ') ptr++;
+
+    switch (bits)
+    {
+    case 1:   mode = SHA_MODE_SHA1;   break;
+    case 224: mode = SHA_MODE_SHA224; break;
+    case 256: mode = SHA_MODE_SHA256; break;
+    case 384: mode = SHA_MODE_SHA384; break;
+    case 512: mode = SHA_MODE_SHA512; break;
+    default:
+        sysprintf("Unknown SHA size %d\n", (int)bits);
+        return;
+    }
+
+    res = f_open(&file2, ptr, FA_OPEN_EXISTING | FA_READ);
+    if (res)
+    {
+        put_rc(res);
+        return;
+    }
+
+    size = (int)f_size(&file2);
+    t0 = EL0_GetCurrentPhysicalValue();
+    ret = FV_HashFile(&file2, mode, NULL, 0, Buff);
+    t0 = EL0_GetCurrentPhysicalValue() - t0;
+    f_close(&file2);
+
+    if (ret < 0)
+    {
+        sysprintf("Hash failed %d\n", ret);
+        return;
+    }
+
+    for (i = 0; i < ret; i++)
+        sysprintf("%02x", Buff[i]);
+    sysprintf("\n%d bytes in %d ms\n", size, (int)(t0 / 12000));
+}
+
+/* fy <file> <signature file> <public key file> - Check an ECDSA signature */
+static void cmd_verify(char *ptr)
+{
+    static const E_ECC_CURVE curves[] = { CURVE_P_192, CURVE_P_224, CURVE_P_256, CURVE_P_384, CURVE_P_521 };
+    char     *sig_name, *key_name;
+    BYTE     *sig = Buff, *key = Buff + 256;
+    UINT     sig_len, key_len;
+    uint64_t t0;
+    int      i, n, size, ret;
+    FRESULT  res;
+
+    while (*ptr == ' ') ptr++;
+    sig_name = strchr(ptr, ' ');
+    if (!sig_name) return;
+    *sig_name++ = 0;
+    while (*sig_name == ' ') sig_name++;
+    key_name = strchr(sig_name, ' ');
+    if (!key_name) return;
+    *key_name++ = 0;
+    while (*key_name == ' ') key_name++;
+
+    /* Raw big-endian R | S and X | Y; the key size gives the curve */
+    if ((res = read_small_file(sig_name, sig, 256, &sig_len)) != FR_OK ||
+            (res = read_small_file(key_name, key, 256, &key_len)) != FR_OK)
+    {
+        put_rc(res);
+        return;
+    }
+
+    for (i = 0; i < (int)(sizeof(curves) / sizeof(curves[0])); i++)
+    {
+        if (key_len == 2 * (UINT)ECC_CurveBytes(curves[i]))
+            break;
+    }
+    if ((i == (int)(sizeof(curves) / sizeof(curves[0]))) || (sig_len != key_len))
+    {
+        sysprintf("Key or signature size does not match P-192/224/256/384/521\n");
+        return;
+    }
+    n = ECC_CurveBytes(curves[i]);
+
+    res = f_open(&file2, ptr, FA_OPEN_EXISTING | FA_READ);
+    if (res)
+    {
+        put_rc(res);
+        return;
+    }
+
+    size = (int)f_size(&file2);
+    t0 = EL0_GetCurrentPhysicalValue();
+    ret = FV_VerifyFile(&file2, curves[i], key, key + n, sig, sig + n);
+    t0 = EL0_GetCurrentPhysicalValue() - t0;
+    f_close(&file2);
+
+    if (ret == 0)
+        sysprintf("Signature OK, %d bytes in %d ms\n", size, (int)(t0 / 12000));
+    else if (ret == FV_ERR_SIGNATURE)
+        sysprintf("Signature does NOT match\n");
+    else
+        sysprintf("Verify failed %d\n", ret);
+}
+
 #if 0
 void access_test(SDH_T * sdh) {
 	char ram0[1024],ram1[1024];
@@ -406,6 +550,13 @@ int32_t main(void)
     SYS_Init();
     UART0_Init();
     global_timer_init();
+    Crypto_Init();
+
+#ifdef SD_ENCRYPT
+    KS_Init();
+    SDC_Init(KS_OTP, SD_ENCRYPT_DATA_KEY, SD_ENCRYPT_IV_KEY, AES_KEY_SIZE_256);
+    SDC_Enable((SDH == SDH0) ? 0 : 1, 1);
+#endif
 
     sysprintf("\n");
     sysprintf("====================================\n");
@@ -820,6 +971,14 @@ int32_t main(void)
                     put_rc(f_mkfs(0, (BYTE)p2, (WORD)p3));
                 break;
 #endif
+            case 'h' :  /* fh <1|224|256|384|512> <file> - Hash a file */
+                cmd_hash(ptr);
+                break;
+
+            case 'y' :  /* fy <file> <signature file> <public key file> - Check an ECDSA signature */
+                cmd_verify(ptr);
+                break;
+
             case 'z' :  /* fz [<rw size>] - Change R/W length for fr/fw/fx command */
                 if (xatoi(&ptr, &p1) && p1 >= 1 && (size_t)p1 <= BUFF_SIZE)
                     blen = p1;
@@ -855,6 +1014,8 @@ int32_t main(void)
                 _T("fa <atrr> <mask> <object name> - Change object attribute\n")
                 _T("ft <year> <month> <day> <hour> <min> <sec> <object name> - Change timestamp of an object\n")
                 _T("fx <src file> <dst file> - Copy a file\n")
+                _T("fh <1|224|256|384|512> <file> - SHA hash a file\n")
+                _T("fy <file> <sig file> <pubkey file> - Check ECDSA signature (raw R|S, X|Y)\n")
                 _T("fg <path> - Change current directory\n")
                 _T("fj <ld#> - Change current drive. For example: <fj 4:>\n")
                 _T("fm <ld#> <rule> <cluster size> - Create file system\n")
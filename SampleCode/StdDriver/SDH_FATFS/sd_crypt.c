@@ -0,0 +1,319 @@
+/**************************************************************************//**
+ * @file     sd_crypt.c
+ * @brief    Sector encryption layer between FatFs diskio and the SD host.
+ *           A read decrypts one chunk on the AES engine while the SD host
+ *           DMA fetches the next one; a write encrypts the next chunk while
+ *           the current one is written. The AES runs of a chunk are chained
+ *           from the CRYPTO interrupt, so the CPU only waits for the card.
+ *
+ *           Build with SDC_SW_AES to use mbedTLS instead of the engine;
+ *           host/ tests that backend against a RAM card (make test).
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <string.h>
+
+#include "sd_crypt.h"
+#ifdef SDC_SW_AES
+#include "mbedtls/aes.h"
+#endif
+
+#define SDC_CHUNK_SIZE      (SDC_CHUNK_SECTORS * SDC_SECTOR_SIZE)
+
+/* Ciphertext side of the transfers, one chunk on the bus and one on the engine */
+static uint8_t s_au8Chunk[2][SDC_CHUNK_SIZE] __attribute__((aligned(64)));
+
+/* Sector numbers in, IVs out */
+static uint8_t s_au8IvTbl[SDC_CHUNK_SECTORS * 16] __attribute__((aligned(64)));
+
+static uint32_t s_u32DriveMask;
+
+static void sdc_sector_blocks(uint32_t u32Sector, uint32_t u32Count)
+{
+    uint32_t i;
+
+    memset(s_au8IvTbl, 0, u32Count * 16);
+    for (i = 0; i < u32Count; i++)
+    {
+        s_au8IvTbl[i * 16 + 12] = (uint8_t)((u32Sector + i) >> 24);
+        s_au8IvTbl[i * 16 + 13] = (uint8_t)((u32Sector + i) >> 16);
+        s_au8IvTbl[i * 16 + 14] = (uint8_t)((u32Sector + i) >> 8);
+        s_au8IvTbl[i * 16 + 15] = (uint8_t)(u32Sector + i);
+    }
+}
+
+#ifdef SDC_SW_AES
+
+static mbedtls_aes_context s_sEnc, s_sDec, s_sIv;
+
+int SDC_Init(const uint8_t au8DataKey[], const uint8_t au8IvKey[], uint32_t u32KeySize)
+{
+    unsigned int bits = 128 + 64 * u32KeySize;
+
+    if (u32KeySize > AES_KEY_SIZE_256)
+        return SDC_ERR_PARAM;
+
+    mbedtls_aes_init(&s_sEnc);
+    mbedtls_aes_init(&s_sDec);
+    mbedtls_aes_init(&s_sIv);
+    if ((mbedtls_aes_setkey_enc(&s_sEnc, au8DataKey, bits) != 0) ||
+            (mbedtls_aes_setkey_dec(&s_sDec, au8DataKey, bits) != 0) ||
+            (mbedtls_aes_setkey_enc(&s_sIv, au8IvKey, bits) != 0))
+        return SDC_ERR_PARAM;
+    return 0;
+}
+
+static void sdc_start(uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count, int bEncrypt)
+{
+    uint32_t i;
+
+    sdc_sector_blocks(u32Sector, u32Count);
+    for (i = 0; i < u32Count; i++)
+    {
+        mbedtls_aes_crypt_ecb(&s_sIv, MBEDTLS_AES_ENCRYPT, &s_au8IvTbl[i * 16], &s_au8IvTbl[i * 16]);
+        mbedtls_aes_crypt_cbc(bEncrypt ? &s_sEnc : &s_sDec,
+                              bEncrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT,
+                              SDC_SECTOR_SIZE, &s_au8IvTbl[i * 16],
+                              pu8Buf + i * SDC_SECTOR_SIZE, pu8Buf + i * SDC_SECTOR_SIZE);
+    }
+}
+
+static int sdc_wait(void)
+{
+    return 0;
+}
+
+#else
+
+/* The chunk the engine is working on */
+static struct
+{
+    uint8_t  *pu8Buf;
+    uint32_t u32Count;
+    int      i32Run;        /* -1: IV run, then the sector index */
+    int      bEncrypt;
+    volatile int bBusy;
+    volatile int bError;
+} s_sJob;
+
+/* Whoever had the CRYPTO callback before SDC_Init(), it still gets every event */
+static CRYPTO_CALLBACK_T s_pfnPrevCallback;
+static int s_bCallback;
+
+static KS_MEM_Type s_eKeyMem;
+static int s_i32DataKey, s_i32IvKey;
+static uint32_t s_u32KeySize;
+
+static uint32_t sdc_get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* CBC run over sector i of the job, in place */
+static void sdc_run_sector(int i)
+{
+    uint32_t au32IV[4], j;
+    uint8_t *pu8Sec = s_sJob.pu8Buf + i * SDC_SECTOR_SIZE;
+
+    for (j = 0; j < 4; j++)
+        au32IV[j] = sdc_get_be32(&s_au8IvTbl[i * 16 + j * 4]);
+
+    AES_Open(CRPT, s_sJob.bEncrypt ? AES_MODE_ENCRYPT : AES_MODE_DECRYPT, AES_MODE_CBC,
+             s_u32KeySize, AES_IN_OUT_SWAP);
+    AES_SetInitVect(CRPT, au32IV);
+    AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(pu8Sec), ptr_to_u32(pu8Sec), SDC_SECTOR_SIZE);
+    AES_Trigger_KS(CRPT, CRYPTO_DMA_ONE_SHOT, s_eKeyMem, s_i32DataKey);
+}
+
+/* Runs in CRYPTO_IRQHandler(): start the next AES run of the chain */
+static void sdc_callback(uint32_t u32Events)
+{
+    if (s_pfnPrevCallback != NULL)
+        s_pfnPrevCallback(u32Events);
+
+    if (!s_sJob.bBusy || !(u32Events & (CRYPTO_EVT_AES | CRYPTO_EVT_AES_ERR)))
+        return;
+
+    if (u32Events & CRYPTO_EVT_AES_ERR)
+    {
+        s_sJob.bError = 1;
+        s_sJob.bBusy = 0;
+        return;
+    }
+
+    if (s_sJob.i32Run < 0)
+        dcache_invalidate_by_mva(s_au8IvTbl, s_sJob.u32Count * 16);
+
+    if (++s_sJob.i32Run < (int)s_sJob.u32Count)
+        sdc_run_sector(s_sJob.i32Run);
+    else
+        s_sJob.bBusy = 0;
+}
+
+int SDC_Init(KS_MEM_Type eType, int i32DataKey, int i32IvKey, uint32_t u32KeySize)
+{
+    if ((u32KeySize > AES_KEY_SIZE_256) || (i32DataKey < 0) || (i32IvKey < 0))
+        return SDC_ERR_PARAM;
+
+    s_eKeyMem = eType;
+    s_i32DataKey = i32DataKey;
+    s_i32IvKey = i32IvKey;
+    s_u32KeySize = u32KeySize;
+
+    /* Install once, a second SDC_Init() must not chain sdc_callback to itself */
+    if (!s_bCallback)
+    {
+        s_pfnPrevCallback = CRYPTO_SetCallback(sdc_callback);
+        s_bCallback = 1;
+    }
+    return 0;
+}
+
+/*
+ * One ECB run turns the sector numbers of the chunk into IVs, then one CBC
+ * run per sector follows. Only the first run is started here.
+ */
+static void sdc_start(uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count, int bEncrypt)
+{
+    sdc_sector_blocks(u32Sector, u32Count);
+    dcache_clean_by_mva(s_au8IvTbl, u32Count * 16);
+    dcache_clean_by_mva(pu8Buf, u32Count * SDC_SECTOR_SIZE);
+
+    s_sJob.pu8Buf = pu8Buf;
+    s_sJob.u32Count = u32Count;
+    s_sJob.i32Run = -1;
+    s_sJob.bEncrypt = bEncrypt;
+    s_sJob.bError = 0;
+    s_sJob.bBusy = 1;
+
+    AES_Open(CRPT, AES_MODE_ENCRYPT, AES_MODE_ECB, s_u32KeySize, AES_IN_OUT_SWAP);
+    AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(s_au8IvTbl), ptr_to_u32(s_au8IvTbl), u32Count * 16);
+    AES_Trigger_KS(CRPT, CRYPTO_DMA_ONE_SHOT, s_eKeyMem, s_i32IvKey);
+}
+
+static int sdc_wait(void)
+{
+    uint64_t t0 = EL0_GetCurrentPhysicalValue();
+
+    while (s_sJob.bBusy)
+    {
+        if (EL0_GetCurrentPhysicalValue() - t0 > 12000000)  /* 1 second timeout */
+        {
+            s_sJob.bBusy = 0;
+            return SDC_ERR_CRYPTO;
+        }
+    }
+    dcache_invalidate_by_mva(s_sJob.pu8Buf, s_sJob.u32Count * SDC_SECTOR_SIZE);
+    return s_sJob.bError ? SDC_ERR_CRYPTO : 0;
+}
+
+#endif  /* SDC_SW_AES */
+
+/**
+ * Route a FatFs physical drive through the encryption layer.
+ *
+ * @param u32Drive physical drive number, 0 or 1
+ * @param bEnable  1 to encrypt, 0 for plain sectors
+ */
+void SDC_Enable(uint32_t u32Drive, int bEnable)
+{
+    if (bEnable)
+        s_u32DriveMask |= (1UL << u32Drive);
+    else
+        s_u32DriveMask &= ~(1UL << u32Drive);
+}
+
+int SDC_IsEnabled(uint32_t u32Drive)
+{
+    return (s_u32DriveMask >> u32Drive) & 1;
+}
+
+/**
+ * Read and decrypt sectors. Chunk n + 1 is read from the card while
+ * chunk n is decrypted.
+ *
+ * @return 0, or SDC_ERR_xxx
+ */
+int SDC_Read(SDH_T *sdh, uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count)
+{
+    uint32_t u32N, u32Next;
+    int cur = 0, io, ret;
+
+    u32N = (u32Count > SDC_CHUNK_SECTORS) ? SDC_CHUNK_SECTORS : u32Count;
+    if (u32N == 0)
+        return 0;
+    if (SDH_Read(sdh, s_au8Chunk[0], u32Sector, u32N) != 0)
+        return SDC_ERR_IO;
+
+    while (u32N != 0)
+    {
+        sdc_start(s_au8Chunk[cur], u32Sector, u32N, 0);
+
+        u32Next = u32Count - u32N;
+        if (u32Next > SDC_CHUNK_SECTORS)
+            u32Next = SDC_CHUNK_SECTORS;
+        io = (u32Next != 0) ? SDH_Read(sdh, s_au8Chunk[!cur], u32Sector + u32N, u32Next) : 0;
+
+        ret = sdc_wait();
+        if (ret != 0)
+            return ret;
+        if (io != 0)
+            return SDC_ERR_IO;
+
+        memcpy(pu8Buf, s_au8Chunk[cur], u32N * SDC_SECTOR_SIZE);
+        pu8Buf += u32N * SDC_SECTOR_SIZE;
+        u32Sector += u32N;
+        u32Count -= u32N;
+        u32N = u32Next;
+        cur = !cur;
+    }
+    return 0;
+}
+
+/**
+ * Encrypt and write sectors. Chunk n + 1 is encrypted while chunk n is
+ * written to the card. The caller's buffer is not changed.
+ *
+ * @return 0, or SDC_ERR_xxx
+ */
+int SDC_Write(SDH_T *sdh, const uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count)
+{
+    uint32_t u32N, u32Next;
+    int cur = 0, ret;
+
+    u32N = (u32Count > SDC_CHUNK_SECTORS) ? SDC_CHUNK_SECTORS : u32Count;
+    if (u32N == 0)
+        return 0;
+    memcpy(s_au8Chunk[0], pu8Buf, u32N * SDC_SECTOR_SIZE);
+    sdc_start(s_au8Chunk[0], u32Sector, u32N, 1);
+
+    while (u32N != 0)
+    {
+        ret = sdc_wait();
+        if (ret != 0)
+            return ret;
+
+        pu8Buf += u32N * SDC_SECTOR_SIZE;
+        u32Next = u32Count - u32N;
+        if (u32Next > SDC_CHUNK_SECTORS)
+            u32Next = SDC_CHUNK_SECTORS;
+        if (u32Next != 0)
+        {
+            memcpy(s_au8Chunk[!cur], pu8Buf, u32Next * SDC_SECTOR_SIZE);
+            sdc_start(s_au8Chunk[!cur], u32Sector + u32N, u32Next, 1);
+        }
+
+        if (SDH_Write(sdh, s_au8Chunk[cur], u32Sector, u32N) != 0)
+        {
+            if (u32Next != 0)
+                sdc_wait();
+            return SDC_ERR_IO;
+        }
+
+        u32Sector += u32N;
+        u32Count -= u32N;
+        u32N = u32Next;
+        cur = !cur;
+    }
+    return 0;
+}
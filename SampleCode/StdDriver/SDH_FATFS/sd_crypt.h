@@ -0,0 +1,46 @@
+/**************************************************************************//**
+ * @file     sd_crypt.h
+ * @brief    Sector encryption layer between FatFs diskio and the SD host.
+ *           Each sector is AES-CBC encrypted with its own IV, the sector
+ *           number encrypted with a second key (ESSIV).
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#ifndef __SD_CRYPT_H__
+#define __SD_CRYPT_H__
+
+#include "NuMicro.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SDC_SECTOR_SIZE     512
+
+/* Sectors per AES chain; one chain runs while the next chunk is on the bus */
+#ifndef SDC_CHUNK_SECTORS
+#define SDC_CHUNK_SECTORS   16
+#endif
+
+#define SDC_ERR_IO          (-1)    /* SDH_Read() or SDH_Write() failed     */
+#define SDC_ERR_CRYPTO      (-2)    /* AES engine time-out or error         */
+#define SDC_ERR_PARAM       (-3)    /* Bad key or drive                     */
+
+#ifdef SDC_SW_AES
+/* Software AES backend: raw keys, no CRYPTO engine needed */
+int  SDC_Init(const uint8_t au8DataKey[], const uint8_t au8IvKey[], uint32_t u32KeySize);
+#else
+/* Keys from Key Store; eType KS_SRAM or KS_OTP */
+int  SDC_Init(KS_MEM_Type eType, int i32DataKey, int i32IvKey, uint32_t u32KeySize);
+#endif
+void SDC_Enable(uint32_t u32Drive, int bEnable);
+int  SDC_IsEnabled(uint32_t u32Drive);
+int  SDC_Read(SDH_T *sdh, uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count);
+int  SDC_Write(SDH_T *sdh, const uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SD_CRYPT_H__ */
@@ -67,6 +67,11 @@ int main()
     /* Initialize System, IP clock and multi-function I/O */
     SYS_Init();
 
+    /* Add to the boot time log left by the Loader, and show it */
+    BOOTTIME_Mark("app SYS_Init");
+    if (BOOTTIME_IsValid())
+        BOOTTIME_Print();
+
     /* Connect UART to PC, and open a terminal tool to receive following message */
     sysprintf("Hello World\n");
 
@@ -0,0 +1,26 @@
+/**************************************************************************//**
+ * @file     FreeRTOS.h
+ * @brief    Stand-in for the host build of the lwIP port. Only the kernel
+ *           types and constants ethernetif.c uses are defined.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  pdTRUE
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define portPRIORITY_SHIFT      4
+
+#define configMINIMAL_STACK_SIZE                    256
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 18
+
+#endif /* INC_FREERTOS_H */
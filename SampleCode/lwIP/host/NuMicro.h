@@ -0,0 +1,78 @@
+/**************************************************************************//**
+ * @file     NuMicro.h
+ * @brief    Stand-in for the host build of the lwIP port. The EMAC, CLK and
+ *           SYS register layouts come from the device headers; EMAC register
+ *           accesses go to the simulated GMAC in gmac_sim.c.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __NUMICRO_H__
+#define __NUMICRO_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include "types.h"
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+
+#include "emac_reg.h"
+#include "clk_reg.h"
+#include "sys_reg.h"
+
+/* Plain host memory, no separate non-cacheable alias */
+#define NON_CACHE           0
+
+extern EMAC_T gmac_sim_regs[2];
+extern CLK_T  gmac_sim_clk;
+extern SYS_T  gmac_sim_sys;
+
+#define EMAC0               (&gmac_sim_regs[0])
+#define EMAC1               (&gmac_sim_regs[1])
+#define CLK                 (&gmac_sim_clk)
+#define SYS                 (&gmac_sim_sys)
+
+uint32_t gmac_sim_read32(const void *addr);
+void gmac_sim_write32(void *addr, uint32_t val);
+
+static inline uint32_t read32(const void *addr)
+{
+    return gmac_sim_read32(addr);
+}
+
+static inline void write32(void *addr, uint32_t val)
+{
+    gmac_sim_write32(addr, val);
+}
+
+/* GIC, CPU and generic timer */
+typedef int32_t IRQn_ID_t;
+typedef void (*IRQHandler_t)(void);
+
+enum
+{
+    EMAC0_IRQn = 55,
+    EMAC1_IRQn = 56,
+};
+
+int32_t IRQ_SetHandler(IRQn_ID_t irqn, IRQHandler_t handler);
+int32_t IRQ_SetPriority(IRQn_ID_t irqn, uint32_t priority);
+int32_t IRQ_SetTarget(IRQn_ID_t irqn, uint32_t cpu_mask);
+int32_t IRQ_Enable(IRQn_ID_t irqn);
+int32_t IRQ_Disable(IRQn_ID_t irqn);
+
+uint32_t host_msticks(void);
+uint64_t EL0_GetCurrentPhysicalValue(void);
+
+/* plat_delay() spins on these, every read moves them on by one */
+#define msTicks0            host_msticks()
+#define msTicks1            host_msticks()
+
+#define cpuid()             0
+#define __DSB()             __sync_synchronize()
+#define sysprintf           printf
+
+#include "emac.h"
+
+#endif  /* __NUMICRO_H__ */
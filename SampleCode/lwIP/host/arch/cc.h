@@ -0,0 +1,26 @@
+/**************************************************************************//**
+ * @file     cc.h
+ * @brief    lwIP compiler and platform definitions for the host build.
+ *           Replaces port/include/arch/cc.h; NO_SYS builds do not include
+ *           sys_arch.h, so the kernel stand-ins ethernetif.c needs are
+ *           pulled in here.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __CC_H__
+#define __CC_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define LWIP_PLATFORM_ASSERT(x) \
+    do \
+    {   printf("Assertion \"%s\" failed at line %d in %s\n", x, __LINE__, __FILE__); \
+        abort(); \
+    } while(0)
+
+#define LWIP_PLATFORM_DIAG(x) do {printf x;} while(0)
+
+#endif /* __CC_H__ */
@@ -0,0 +1,532 @@
+/**************************************************************************//**
+ * @file     gmac_sim.c
+ * @brief    Simulated EMAC (Synopsys GMAC) for the host build of the lwIP
+ *           port.
+ *
+ *           Model, as far as emac.c and ma35h0_mac.c rely on it:
+ *           - Enhanced (ATDS) descriptors in ring mode, one buffer per frame.
+ *           - Tx DMA fetches owned descriptors on poll demand into a 2 KB
+ *             Tx FIFO, inserts the IPv4 header and TCP/UDP/ICMP checksums
+ *             as selected by CIC, and closes each descriptor (OWN cleared,
+ *             TI) once the frame has left at the link rate.
+ *           - The wire is a datagram socket. Its send buffer acts as the
+ *             queue of a switch between the boards: a frame that finds it
+ *             full is dropped.
+ *           - Rx DMA writes a frame with its FCS into the next owned
+ *             descriptor and raises RI; without one the frame waits in the
+ *             queue and RU is raised. At most RX_BURST frames are received
+ *             per gmac_sim_poll() so the Rx task (32 rxskbuf) keeps up.
+ *           - The interrupt is delivered as soon as a status bit it enables
+ *             is set, also from within a register access, like a real
+ *             interrupt preempting the caller.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include "NuMicro.h"
+#include "gmac_sim.h"
+
+#define TX_FIFO_SIZE    2048
+#define TX_FIFO_FRAMES  8
+#define RX_BURST        16
+#define MAX_FRAME       1536
+
+/* Preamble, SFD, FCS and inter-frame gap on the wire */
+#define WIRE_OVERHEAD   (8 + 4 + 12)
+
+#define DMA_NORMAL      (EMAC_DmaStatus_TI_Msk | EMAC_DmaStatus_TU_Msk | EMAC_DmaStatus_RI_Msk | \
+                         EMAC_DmaStatus_ERI_Msk)
+#define DMA_ABNORMAL    (EMAC_DmaStatus_TPS_Msk | EMAC_DmaStatus_TJT_Msk | EMAC_DmaStatus_OVF_Msk | \
+                         EMAC_DmaStatus_UNF_Msk | EMAC_DmaStatus_RU_Msk | EMAC_DmaStatus_RPS_Msk | \
+                         EMAC_DmaStatus_RWT_Msk | EMAC_DmaStatus_ETI_Msk | EMAC_DmaStatus_FBI_Msk)
+
+struct tx_frame
+{
+    DmaDesc *desc;
+    uint64_t done;      /* time the last bit leaves */
+    uint32_t len;
+    uint8_t data[MAX_FRAME];
+};
+
+struct gmac_sim
+{
+    EMAC_T *regs;
+    IRQn_ID_t irqn;
+    int fd;
+    uint32_t mbps;
+    uint16_t phy[32];
+
+    DmaDesc *tx_desc;   /* next descriptor the Tx DMA fetches */
+    DmaDesc *rx_desc;   /* next descriptor the Rx DMA fills */
+    int rx_suspended;
+
+    struct tx_frame fifo[TX_FIFO_FRAMES];
+    int fifo_head;
+    int fifo_count;
+    uint32_t fifo_bytes;
+    uint64_t wire_free; /* time the wire is idle again */
+
+    uint8_t rx_frame[MAX_FRAME + 4];
+    int rx_len;         /* frame read from the wire, waiting for a descriptor */
+
+    int in_isr;
+    struct gmac_sim_stats st;
+};
+
+EMAC_T gmac_sim_regs[2];
+CLK_T  gmac_sim_clk;
+SYS_T  gmac_sim_sys;
+
+static struct gmac_sim sim[2] =
+{
+    { .regs = &gmac_sim_regs[0], .irqn = EMAC0_IRQn, .fd = -1 },
+    { .regs = &gmac_sim_regs[1], .irqn = EMAC1_IRQn, .fd = -1 },
+};
+
+void host_irq(IRQn_ID_t irqn);
+
+uint64_t gmac_sim_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static struct gmac_sim *find_sim(const void *addr, uint32_t *off)
+{
+    int i;
+
+    for(i = 0; i < 2; i++)
+    {
+        if(((const uint8_t *)addr >= (const uint8_t *)sim[i].regs) &&
+                ((const uint8_t *)addr < (const uint8_t *)(sim[i].regs + 1)))
+        {
+            *off = (uint32_t)((const uint8_t *)addr - (const uint8_t *)sim[i].regs);
+            return &sim[i];
+        }
+    }
+    return NULL;
+}
+
+static DmaDesc *desc_ptr(uint32_t addr)
+{
+    return (DmaDesc *)(uintptr_t)addr;
+}
+
+/* ---------------------------------------------------------------------------
+ * Interrupt
+ */
+static void update_summary(struct gmac_sim *g)
+{
+    uint32_t s = g->regs->DmaStatus & ~(EMAC_DmaStatus_NIS_Msk | EMAC_DmaStatus_AIS_Msk);
+
+    if(s & DMA_NORMAL)
+        s |= EMAC_DmaStatus_NIS_Msk;
+    if(s & DMA_ABNORMAL)
+        s |= EMAC_DmaStatus_AIS_Msk;
+    g->regs->DmaStatus = s;
+}
+
+static int irq_line(struct gmac_sim *g)
+{
+    uint32_t s = g->regs->DmaStatus, e = g->regs->DmaInt;
+
+    /* DmaInt enable bits line up with the DmaStatus bits they enable */
+    if((e & EMAC_DmaInt_NIE_Msk) && (s & e & DMA_NORMAL))
+        return 1;
+    if((e & EMAC_DmaInt_AIE_Msk) && (s & e & DMA_ABNORMAL))
+        return 1;
+    return 0;
+}
+
+static void raise_status(struct gmac_sim *g, uint32_t bits)
+{
+    g->regs->DmaStatus |= bits;
+    update_summary(g);
+}
+
+static void deliver_irq(struct gmac_sim *g)
+{
+    int n;
+
+    if(g->in_isr)
+        return;
+
+    g->in_isr = 1;
+    for(n = 0; irq_line(g) && (n < 8); n++)
+        host_irq(g->irqn);
+    g->in_isr = 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Checksum insertion and FCS
+ */
+static uint32_t csum_add(uint32_t sum, const uint8_t *p, uint32_t len)
+{
+    for(; len > 1; len -= 2, p += 2)
+        sum += (p[0] << 8) | p[1];
+    if(len)
+        sum += p[0] << 8;
+    return sum;
+}
+
+static uint16_t csum_fold(uint32_t sum)
+{
+    while(sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+static void insert_checksums(uint8_t *f, uint32_t len, uint32_t cic)
+{
+    uint32_t l3 = 14, ihl, tot, l4len, sum, csoff;
+    uint8_t *ip, *l4;
+    uint16_t c;
+
+    if((len >= 18) && (f[12] == 0x81) && (f[13] == 0x00))
+        l3 = 18;
+    if((cic == 0) || (len < l3 + 20) || (f[l3 - 2] != 0x08) || (f[l3 - 1] != 0x00))
+        return;
+
+    ip = &f[l3];
+    ihl = (ip[0] & 0x0F) * 4;
+    tot = (ip[2] << 8) | ip[3];
+    if(((ip[0] >> 4) != 4) || (ihl < 20) || (tot < ihl) || (l3 + tot > len))
+        return;
+
+    ip[10] = ip[11] = 0;
+    c = csum_fold(csum_add(0, ip, ihl));
+    ip[10] = c >> 8;
+    ip[11] = c & 0xFF;
+
+    /* payload checksum for unfragmented TCP, UDP and ICMP only */
+    if((cic == eDescTxCisIpv4HdrCs) || (((ip[6] & 0x3F) | ip[7]) != 0))
+        return;
+
+    l4 = ip + ihl;
+    l4len = tot - ihl;
+    switch(ip[9])
+    {
+    case 6:
+        csoff = 16;
+        break;
+    case 17:
+        csoff = 6;
+        break;
+    case 1:
+        csoff = 2;
+        break;
+    default:
+        return;
+    }
+    if(l4len < csoff + 2)
+        return;
+
+    l4[csoff] = l4[csoff + 1] = 0;
+    sum = csum_add(0, l4, l4len);
+    if(ip[9] != 1)
+    {
+        /* pseudo header */
+        sum = csum_add(sum, &ip[12], 8);
+        sum += ip[9] + l4len;
+    }
+    c = csum_fold(sum);
+    if((ip[9] == 17) && (c == 0))
+        c = 0xFFFF;
+    l4[csoff] = c >> 8;
+    l4[csoff + 1] = c & 0xFF;
+}
+
+static uint32_t crc32(const uint8_t *p, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    int i;
+
+    while(len--)
+    {
+        crc ^= *p++;
+        for(i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+/* ---------------------------------------------------------------------------
+ * Tx
+ */
+static int tx_running(struct gmac_sim *g)
+{
+    return (g->regs->DmaOpMode & EMAC_DmaOpMode_ST_Msk) && (g->regs->Config & EMAC_Config_TE_Msk) &&
+           (g->tx_desc != NULL);
+}
+
+/* Fetch owned descriptors while the Tx FIFO has room */
+static void tx_fetch(struct gmac_sim *g, uint64_t now)
+{
+    struct tx_frame *t;
+    DmaDesc *d;
+    uint32_t len, bits;
+
+    while(tx_running(g) && (g->fifo_count < TX_FIFO_FRAMES))
+    {
+        d = g->tx_desc;
+        if(!(d->status & DescOwnByDma))
+            break;
+
+        len = d->length & eDescSize1Mask;
+        if(len > MAX_FRAME)
+            len = MAX_FRAME;
+        if((g->fifo_count != 0) && (g->fifo_bytes + len > TX_FIFO_SIZE))
+            break;
+
+        t = &g->fifo[(g->fifo_head + g->fifo_count) % TX_FIFO_FRAMES];
+        memcpy(t->data, (const void *)(uintptr_t)d->buffer1, len);
+        insert_checksums(t->data, len, d->status & eDescTxCisMask);
+        if(len < 60)
+        {
+            memset(&t->data[len], 0, 60 - len);
+            len = 60;
+        }
+        t->len = len;
+        t->desc = d;
+
+        /* serialise behind the frames already queued */
+        if(g->wire_free < now)
+            g->wire_free = now;
+        if(g->mbps != 0)
+        {
+            bits = (len + WIRE_OVERHEAD) * 8;
+            g->wire_free += (uint64_t)bits * 1000 / g->mbps;
+        }
+        t->done = g->wire_free;
+
+        g->fifo_count++;
+        g->fifo_bytes += len;
+        g->tx_desc = (d->status & eDescTxEndOfRing) ? desc_ptr(g->regs->DmaTxDesc) : d + 1;
+    }
+}
+
+/* Put frames whose time has come on the wire and close their descriptors */
+static int tx_complete(struct gmac_sim *g, uint64_t now)
+{
+    struct tx_frame *t;
+    int moved = 0;
+
+    while(g->fifo_count != 0)
+    {
+        t = &g->fifo[g->fifo_head];
+        if(t->done > now)
+            break;
+
+        if(send(g->fd, t->data, t->len, MSG_DONTWAIT) < 0)
+            g->st.wire_drops++;
+        else
+            g->st.tx_frames++;
+
+        t->desc->status &= ~(DescOwnByDma | DescError);
+        if(t->desc->status & eDescTxIntOnCompl)
+            raise_status(g, EMAC_DmaStatus_TI_Msk);
+
+        g->fifo_head = (g->fifo_head + 1) % TX_FIFO_FRAMES;
+        g->fifo_count--;
+        g->fifo_bytes -= t->len;
+        moved = 1;
+    }
+    return moved;
+}
+
+static int tx_process(struct gmac_sim *g)
+{
+    uint64_t now = gmac_sim_now_ns();
+    int moved;
+
+    tx_fetch(g, now);
+    moved = tx_complete(g, now);
+    if(moved)
+        tx_fetch(g, now);
+    return moved;
+}
+
+/* ---------------------------------------------------------------------------
+ * Rx
+ */
+static int rx_process(struct gmac_sim *g)
+{
+    DmaDesc *d;
+    ssize_t n;
+    uint32_t fcs, st;
+    int count;
+
+    if(!(g->regs->DmaOpMode & EMAC_DmaOpMode_SR_Msk) || !(g->regs->Config & EMAC_Config_RE_Msk) ||
+            (g->rx_desc == NULL))
+        return 0;
+
+    for(count = 0; count < RX_BURST; count++)
+    {
+        if(g->rx_len == 0)
+        {
+            n = recv(g->fd, g->rx_frame, MAX_FRAME, MSG_DONTWAIT);
+            if(n <= 0)
+                break;
+            fcs = crc32(g->rx_frame, (uint32_t)n);
+            memcpy(&g->rx_frame[n], &fcs, 4);
+            g->rx_len = (int)n + 4;
+        }
+
+        d = g->rx_desc;
+        if(!(d->status & DescOwnByDma) || g->rx_suspended)
+        {
+            if(!g->rx_suspended)
+            {
+                g->rx_suspended = 1;
+                g->st.rx_stalls++;
+                raise_status(g, EMAC_DmaStatus_RU_Msk);
+            }
+            break;
+        }
+
+        memcpy((void *)(uintptr_t)d->buffer1, g->rx_frame, g->rx_len);
+        st = DescRxFirst | DescRxLast | ((g->rx_len << DescRxFrameLengthShift) & DescRxFrameLengthMask);
+        if(((g->rx_frame[12] << 8) | g->rx_frame[13]) >= 0x0600)
+            st |= DescRxChkBit5;
+        d->extstatus = 0;
+        d->status = st;
+        g->rx_len = 0;
+        g->st.rx_frames++;
+
+        if(!(d->length & DescRxDisIntCompl))
+            raise_status(g, EMAC_DmaStatus_RI_Msk);
+        g->rx_desc = (d->length & eDescRxEndOfRing) ? desc_ptr(g->regs->DmaRxDesc) : d + 1;
+    }
+    return count != 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Registers
+ */
+static void mac_reset(struct gmac_sim *g)
+{
+    EMAC_T *r = g->regs;
+
+    memset(r, 0, sizeof(*r));
+    r->Version = 0x1037;
+    r->DmaBusMode = 0x00020100;  /* PBL 1, SWR self-cleared */
+    g->tx_desc = g->rx_desc = NULL;
+    g->rx_suspended = 0;
+    g->fifo_head = g->fifo_count = 0;
+    g->fifo_bytes = 0;
+}
+
+static void mdio_access(struct gmac_sim *g, uint32_t val)
+{
+    uint32_t reg = (val & EMAC_GmiiAddr_GR_Msk) >> EMAC_GmiiAddr_GR_Pos;
+
+    if(val & EMAC_GmiiAddr_GW_Msk)
+        g->phy[reg] = (uint16_t)g->regs->GmiiData & ~Mii_reset;
+    else
+        g->regs->GmiiData = g->phy[reg];
+    g->regs->GmiiAddr = val & ~EMAC_GmiiAddr_GB_Msk;
+}
+
+uint32_t gmac_sim_read32(const void *addr)
+{
+    /* registers with side effects on read are not used by the driver */
+    return *(const volatile uint32_t *)addr;
+}
+
+void gmac_sim_write32(void *addr, uint32_t val)
+{
+    struct gmac_sim *g;
+    uint32_t off;
+    EMAC_T *r;
+
+    g = find_sim(addr, &off);
+    if(g == NULL)
+    {
+        /* CLK and SYS */
+        *(volatile uint32_t *)addr = val;
+        return;
+    }
+    r = g->regs;
+
+    switch(off)
+    {
+    case offsetof(EMAC_T, DmaBusMode):
+        if(val & EMAC_DmaBusMode_SWR_Msk)
+            mac_reset(g);
+        else
+            r->DmaBusMode = val;
+        break;
+    case offsetof(EMAC_T, GmiiAddr):
+        if(val & EMAC_GmiiAddr_GB_Msk)
+            mdio_access(g, val);
+        else
+            r->GmiiAddr = val;
+        break;
+    case offsetof(EMAC_T, IntStatus):
+        break;
+    case offsetof(EMAC_T, DmaStatus):
+        r->DmaStatus &= ~(val & (DMA_NORMAL | DMA_ABNORMAL));
+        update_summary(g);
+        break;
+    case offsetof(EMAC_T, DmaTxDesc):
+        r->DmaTxDesc = val;
+        g->tx_desc = desc_ptr(val);
+        break;
+    case offsetof(EMAC_T, DmaRxDesc):
+        r->DmaRxDesc = val;
+        g->rx_desc = desc_ptr(val);
+        break;
+    case offsetof(EMAC_T, DmaTxPollDemand):
+        tx_process(g);
+        break;
+    case offsetof(EMAC_T, DmaRxPollDemand):
+        g->rx_suspended = 0;
+        break;
+    default:
+        *(volatile uint32_t *)addr = val;
+        break;
+    }
+
+    deliver_irq(g);
+}
+
+/* ---------------------------------------------------------------------------
+ * Main loop interface
+ */
+void gmac_sim_attach(int intf, int fd, uint32_t mbps)
+{
+    struct gmac_sim *g = &sim[intf];
+
+    g->fd = fd;
+    g->mbps = mbps;
+    mac_reset(g);
+    /* RMII PHY with the link up and auto-negotiation done */
+    g->phy[PHY_STATUS_REG] = Mii_Link | Mii_AutoNegCmplt;
+}
+
+int gmac_sim_poll(void)
+{
+    struct gmac_sim *g;
+    int i, moved = 0;
+
+    for(i = 0; i < 2; i++)
+    {
+        g = &sim[i];
+        if(g->fd < 0)
+            continue;
+        moved |= tx_process(g);
+        moved |= rx_process(g);
+        deliver_irq(g);
+    }
+    return moved;
+}
+
+void gmac_sim_get_stats(int intf, struct gmac_sim_stats *st)
+{
+    *st = sim[intf].st;
+}
@@ -0,0 +1,43 @@
+/**************************************************************************//**
+ * @file     gmac_sim.h
+ * @brief    Simulated EMAC (Synopsys GMAC) for the host build of the lwIP
+ *           port. Registers and the DMA descriptor engine are modelled to
+ *           the extent emac.c and ma35h0_mac.c use them; the wire is a
+ *           datagram socket to the other simulated board.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __GMAC_SIM_H__
+#define __GMAC_SIM_H__
+
+#include <stdint.h>
+
+struct gmac_sim_stats
+{
+    uint32_t tx_frames;
+    uint32_t rx_frames;
+    uint32_t wire_drops;    /* the link queue to the peer was full */
+    uint32_t rx_stalls;     /* a frame waited for a free Rx descriptor */
+};
+
+/**
+ * Connect an EMAC to the wire.
+ * @param intf EMACINTF0 or EMACINTF1
+ * @param fd non-blocking SOCK_SEQPACKET socket, one frame per datagram
+ * @param mbps link rate, 0 for no limit
+ */
+void gmac_sim_attach(int intf, int fd, uint32_t mbps);
+
+/**
+ * Move frames between the wire and the DMA rings and raise the EMAC
+ * interrupt if it is pending. Call from the main loop.
+ * @return 1 if a frame was sent or received
+ */
+int gmac_sim_poll(void);
+
+void gmac_sim_get_stats(int intf, struct gmac_sim_stats *st);
+
+/* Monotonic time, shared with the rest of the host build */
+uint64_t gmac_sim_now_ns(void);
+
+#endif /* __GMAC_SIM_H__ */
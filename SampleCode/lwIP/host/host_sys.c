@@ -0,0 +1,151 @@
+/**************************************************************************//**
+ * @file     host_sys.c
+ * @brief    GIC, timer and task stand-ins for the host build of the lwIP
+ *           port, and the lwIP NO_SYS time base.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <setjmp.h>
+#include "NuMicro.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "gmac_sim.h"
+#include "lwip/sys.h"
+
+#define MAX_IRQ     64
+#define MAX_TASKS   4
+
+struct host_task
+{
+    TaskFunction_t func;
+    void *arg;
+    uint32_t notified;
+};
+
+static IRQHandler_t irq_handler[MAX_IRQ];
+static uint8_t irq_enabled[MAX_IRQ];
+
+static struct host_task tasks[MAX_TASKS];
+static int task_count;
+static struct host_task *current;
+static jmp_buf task_wait;
+
+/* ---------------------------------------------------------------------------
+ * GIC
+ */
+int32_t IRQ_SetHandler(IRQn_ID_t irqn, IRQHandler_t handler)
+{
+    irq_handler[irqn] = handler;
+    return 0;
+}
+
+int32_t IRQ_SetPriority(IRQn_ID_t irqn, uint32_t priority)
+{
+    return 0;
+}
+
+int32_t IRQ_SetTarget(IRQn_ID_t irqn, uint32_t cpu_mask)
+{
+    return 0;
+}
+
+int32_t IRQ_Enable(IRQn_ID_t irqn)
+{
+    irq_enabled[irqn] = 1;
+    return 0;
+}
+
+int32_t IRQ_Disable(IRQn_ID_t irqn)
+{
+    irq_enabled[irqn] = 0;
+    return 0;
+}
+
+/* Called by the simulated peripheral while its interrupt line is high */
+void host_irq(IRQn_ID_t irqn)
+{
+    if(irq_enabled[irqn] && (irq_handler[irqn] != NULL))
+        irq_handler[irqn]();
+}
+
+/* ---------------------------------------------------------------------------
+ * Time
+ */
+uint32_t host_msticks(void)
+{
+    static uint32_t ticks;
+
+    return ticks++;
+}
+
+uint64_t EL0_GetCurrentPhysicalValue(void)
+{
+    /* 12 MHz, as the generic timer on the board */
+    return gmac_sim_now_ns() * 12 / 1000;
+}
+
+u32_t sys_now(void)
+{
+    return (u32_t)(gmac_sim_now_ns() / 1000000);
+}
+
+/* ---------------------------------------------------------------------------
+ * Tasks
+ */
+BaseType_t xTaskCreate(TaskFunction_t func, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle)
+{
+    struct host_task *t;
+
+    if(task_count == MAX_TASKS)
+        return pdFALSE;
+
+    t = &tasks[task_count++];
+    t->func = func;
+    t->arg = arg;
+    t->notified = 0;
+    if(handle != NULL)
+        *handle = t;
+    return pdPASS;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    task->notified++;
+    if(woken != NULL)
+        *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    uint32_t n = current->notified;
+
+    if(n == 0)
+        longjmp(task_wait, 1);   /* back to host_run_tasks() */
+
+    current->notified = clear ? 0 : n - 1;
+    return n;
+}
+
+int host_run_tasks(void)
+{
+    int i, ran = 0;
+
+    for(i = 0; i < task_count; i++)
+    {
+        if(tasks[i].notified == 0)
+            continue;
+
+        current = &tasks[i];
+        if(setjmp(task_wait) == 0)
+            current->func(current->arg);
+        current = NULL;
+        ran++;
+    }
+    return ran;
+}
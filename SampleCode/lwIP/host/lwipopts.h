@@ -0,0 +1,74 @@
+/**************************************************************************//**
+ * @file     lwipopts.h
+ * @brief    lwIP options of the host benchmark. Mirrors the
+ *           lwIP_iperf_Server sample, without the OS: the same demo and
+ *           throughput profiles are selected by LWIP_THROUGHPUT_PROFILE,
+ *           and single values can be overridden from the make command
+ *           line, e.g. make BENCH_OPTS="-DBENCH_TCP_WND=8192".
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __LWIPOPTS_H__
+#define __LWIPOPTS_H__
+
+#include "netif/ma35h0_mac.h"
+
+#define NO_SYS                          1
+#define SYS_LIGHTWEIGHT_PROT            0
+#define MEM_ALIGNMENT                   4
+#define LWIP_STATS                      0
+#define LWIP_NETCONN                    0
+#define LWIP_SOCKET                     0
+#define LWIP_RAND()                     ((u32_t)rand())
+
+#ifndef LWIP_PERF
+#define LWIP_PERF                       0
+#endif
+
+/* TCP Maximum segment size. */
+#define TCP_MSS                         1460
+
+#ifndef LWIP_THROUGHPUT_PROFILE
+#define LWIP_THROUGHPUT_PROFILE         0
+#endif
+
+#if (LWIP_THROUGHPUT_PROFILE == 1)
+#include "lwipopts_throughput.h"
+#else
+#define MEMP_NUM_NETCONN                8
+#define MEM_SIZE                        1600
+#define MEMP_NUM_PBUF                   32
+#define PBUF_POOL_SIZE                  64
+#define TCP_WND                         16384 //Max: 65535
+#define TCP_SND_BUF                     8192
+#define TCP_SND_QUEUELEN                (4 * TCP_SND_BUF/TCP_MSS)
+#define MEMP_NUM_TCP_SEG                64
+#endif
+
+#ifdef BENCH_TCP_WND
+#undef TCP_WND
+#define TCP_WND                         BENCH_TCP_WND
+#endif
+#ifdef BENCH_TCP_SND_BUF
+#undef TCP_SND_BUF
+#define TCP_SND_BUF                     BENCH_TCP_SND_BUF
+#endif
+#ifdef BENCH_PBUF_POOL_SIZE
+#undef PBUF_POOL_SIZE
+#define PBUF_POOL_SIZE                  BENCH_PBUF_POOL_SIZE
+#endif
+
+#define LWIP_USING_HW_CHECKSUM          1
+/* ---------- Checksum options ---------- */
+#if (LWIP_USING_HW_CHECKSUM == 1)
+#define CHECKSUM_GEN_IP                 0
+#define CHECKSUM_GEN_UDP                0
+#define CHECKSUM_GEN_TCP                0
+#define CHECKSUM_GEN_ICMP               0
+#define CHECKSUM_CHECK_IP               0
+#define CHECKSUM_CHECK_UDP              0
+#define CHECKSUM_CHECK_TCP              0
+#define CHECKSUM_CHECK_ICMP             0
+#endif
+
+#endif /* __LWIPOPTS_H__ */
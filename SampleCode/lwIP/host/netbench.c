@@ -0,0 +1,583 @@
+/**************************************************************************//**
+ * @file     netbench.c
+ * @brief    Two simulated boards back to back, each running lwIP with the
+ *           MA35H0 port (ethernetif.c, ma35h0_mac.c, emac.c) on a simulated
+ *           EMAC0:
+ *
+ *             netbench [-r mbps] [-t kbytes] [-u datagrams] [-l rounds]
+ *
+ *           -r  link rate, default 100 (RMII_100M), 0 for no limit
+ *           -t  TCP bulk transfer from B to A, default 8192 KB
+ *           -u  UDP datagrams of 1472 bytes from B to A at the link rate,
+ *               default 10000
+ *           -l  UDP echo round trips for the latency, default 2000
+ *
+ *           Board A (192.168.1.1) is the board under test, built with the
+ *           lwipopts profile being measured; it receives, as the
+ *           lwIP_iperf_Server sample does, and prints the TCP and UDP
+ *           results. Board B (192.168.1.2) stands in for the iperf client
+ *           PC: it is netbench-peer, always built with the throughput
+ *           profile, and prints the latency. All payloads are checked.
+ *           The exit status is 1 if data was corrupted, a transfer did
+ *           not complete or a board timed out.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "lwip/sys.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+#include "netif/ethernetif.h"
+#include "netif/ma35h0_mac.h"
+#include "gmac_sim.h"
+
+#define TCP_PORT        5001
+#define UDP_PORT        5002
+#define CTRL_PORT       5003
+#define ECHO_PORT       7
+
+#define UDP_SIZE        1472
+#define ECHO_SIZE       64
+#define TIMEOUT_MS      60000
+
+#if (LWIP_THROUGHPUT_PROFILE == 1)
+#define PROFILE_NAME    "throughput"
+#else
+#define PROFILE_NAME    "demo"
+#endif
+
+static struct netif netif;
+static const char *board_name = "A";
+static int failed;
+
+static uint32_t link_mbps = 100;
+static uint32_t tcp_total = 8192 * 1024;
+static uint32_t udp_count = 10000;
+static uint32_t echo_rounds = 2000;
+
+/* Payload byte at stream offset i; 251 is prime so shifted data shows */
+static uint8_t pattern(uint32_t i)
+{
+    return (uint8_t)(i % 251);
+}
+
+static void fail(const char *msg)
+{
+    printf("%s: %s\n", board_name, msg);
+    failed = 1;
+}
+
+static void poll_once(void)
+{
+    int busy;
+
+    busy = gmac_sim_poll();
+    busy |= host_run_tasks();
+    sys_check_timeouts();
+    if(!busy)
+        sched_yield();  /* let the other board run on a single CPU */
+}
+
+static int wait_for(volatile int *flag)
+{
+    u32_t start = sys_now();
+
+    while(!*flag)
+    {
+        poll_once();
+        if(sys_now() - start > TIMEOUT_MS)
+        {
+            fail("timed out");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void send_udp(struct udp_pcb *pcb, const ip_addr_t *addr, u16_t port, const void *data, u16_t len)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+
+    if(p == NULL)
+    {
+        fail("out of pbufs");
+        return;
+    }
+    memcpy(p->payload, data, len);
+    /* Block like a PC socket while the Tx ring is full; the port drops the frame */
+    while(EMAC_get_tx_skb(EMACINTF0) == NULL)
+        poll_once();
+    if(udp_sendto(pcb, p, addr, port) != ERR_OK)
+        fail("udp_sendto failed");
+    pbuf_free(p);
+}
+
+static double mbps(uint64_t bytes, uint64_t ns)
+{
+    return ns ? (double)bytes * 8 * 1000 / ns : 0.0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Board A: TCP sink, UDP sink, echo and control
+ */
+static struct
+{
+    uint64_t bytes, start, end;
+    uint32_t errors;
+    int done;
+} tcp_rx;
+
+static struct
+{
+    uint64_t bytes, start, end;
+    uint32_t count, dups, errors;
+    uint8_t *seen;
+} udp_rx;
+
+static int quit;
+
+static err_t sink_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    struct pbuf *q;
+    uint8_t *d;
+    u16_t i;
+
+    if(p == NULL)
+    {
+        tcp_rx.done = 1;
+        tcp_close(pcb);
+        return ERR_OK;
+    }
+
+    if(tcp_rx.bytes == 0)
+        tcp_rx.start = gmac_sim_now_ns();
+    for(q = p; q != NULL; q = q->next)
+    {
+        d = q->payload;
+        for(i = 0; i < q->len; i++)
+            if(d[i] != pattern((uint32_t)tcp_rx.bytes + i))
+                tcp_rx.errors++;
+        tcp_rx.bytes += q->len;
+    }
+    /* Up to the last byte: the FIN waits for our delayed ACK of it */
+    tcp_rx.end = gmac_sim_now_ns();
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static err_t sink_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    if(err != ERR_OK)
+        return ERR_VAL;
+    tcp_recv(pcb, sink_recv);
+    return ERR_OK;
+}
+
+static void udp_sink_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    uint8_t buf[UDP_SIZE];
+    uint32_t seq, i;
+
+    if((p->tot_len != UDP_SIZE) || (pbuf_copy_partial(p, buf, UDP_SIZE, 0) != UDP_SIZE))
+    {
+        udp_rx.errors++;
+        pbuf_free(p);
+        return;
+    }
+    pbuf_free(p);
+
+    memcpy(&seq, buf, 4);
+    for(i = 4; i < UDP_SIZE; i++)
+        if(buf[i] != pattern(seq + i))
+            break;
+    if((i != UDP_SIZE) || (seq >= udp_count))
+    {
+        udp_rx.errors++;
+        return;
+    }
+    if(udp_rx.seen[seq])
+    {
+        udp_rx.dups++;
+        return;
+    }
+    udp_rx.seen[seq] = 1;
+
+    if(udp_rx.count == 0)
+        udp_rx.start = gmac_sim_now_ns();
+    udp_rx.end = gmac_sim_now_ns();
+    udp_rx.count++;
+    udp_rx.bytes += UDP_SIZE;
+}
+
+static void echo_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    udp_sendto(pcb, p, addr, port);
+    pbuf_free(p);
+}
+
+static void report(uint32_t tcp_sent, uint32_t udp_sent)
+{
+    printf("TCP  %8u KB  %6u ms  %6.1f Mbit/s", (unsigned)(tcp_rx.bytes / 1024),
+           (unsigned)((tcp_rx.end - tcp_rx.start) / 1000000), mbps(tcp_rx.bytes, tcp_rx.end - tcp_rx.start));
+    if(!tcp_rx.done || (tcp_rx.bytes != tcp_sent) || tcp_rx.errors)
+    {
+        printf("  FAILED: %u of %u bytes, %u corrupted\n", (unsigned)tcp_rx.bytes, tcp_sent, tcp_rx.errors);
+        failed = 1;
+    }
+    else
+        printf("\n");
+
+    printf("UDP  %8u/%u datagrams  %6.1f Mbit/s  %.2f%% lost", udp_rx.count, udp_sent,
+           mbps(udp_rx.bytes, udp_rx.end - udp_rx.start),
+           udp_sent ? 100.0 * (udp_sent - udp_rx.count) / udp_sent : 0.0);
+    if(udp_rx.dups || udp_rx.errors)
+    {
+        printf("  FAILED: %u duplicated, %u corrupted\n", udp_rx.dups, udp_rx.errors);
+        failed = 1;
+    }
+    else
+        printf("\n");
+    fflush(stdout);
+}
+
+static void ctrl_recv_a(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    char cmd[64];
+    unsigned tcp_sent, udp_sent;
+    u16_t n;
+
+    n = pbuf_copy_partial(p, cmd, sizeof(cmd) - 1, 0);
+    cmd[n] = 0;
+    pbuf_free(p);
+
+    if(sscanf(cmd, "END %u %u", &tcp_sent, &udp_sent) == 2)
+        report(tcp_sent, udp_sent);
+    else if(strcmp(cmd, "QUIT") == 0)
+        quit = 1;
+    else
+        return;
+    send_udp(pcb, addr, port, "OK", 2);
+}
+
+static void run_a(void)
+{
+    struct tcp_pcb *lpcb = tcp_new();
+    struct udp_pcb *sink = udp_new(), *echo = udp_new(), *ctrl = udp_new();
+
+    udp_rx.seen = calloc(udp_count ? udp_count : 1, 1);
+
+    tcp_bind(lpcb, IP_ADDR_ANY, TCP_PORT);
+    lpcb = tcp_listen(lpcb);
+    tcp_accept(lpcb, sink_accept);
+
+    udp_bind(sink, IP_ADDR_ANY, UDP_PORT);
+    udp_recv(sink, udp_sink_recv, NULL);
+    udp_bind(echo, IP_ADDR_ANY, ECHO_PORT);
+    udp_recv(echo, echo_recv, NULL);
+    udp_bind(ctrl, IP_ADDR_ANY, CTRL_PORT);
+    udp_recv(ctrl, ctrl_recv_a, NULL);
+
+    wait_for(&quit);
+
+    /* let the reply to QUIT leave */
+    while(EMACdev[EMACINTF0].BusyTxDesc != 0)
+        poll_once();
+}
+
+/* ---------------------------------------------------------------------------
+ * Board B: TCP source, UDP source, echo client
+ */
+static struct
+{
+    uint32_t written, acked;
+    int connected, done;
+} tcp_tx;
+
+/* One segment per write: the demo profile heap (MEM_SIZE) holds little more */
+static void source_send(struct tcp_pcb *pcb)
+{
+    static uint8_t buf[TCP_MSS];
+    uint32_t n, i;
+
+    while(tcp_tx.written < tcp_total)
+    {
+        n = LWIP_MIN(tcp_sndbuf(pcb), tcp_total - tcp_tx.written);
+        n = LWIP_MIN(n, sizeof(buf));
+        if(n == 0)
+            break;
+        for(i = 0; i < n; i++)
+            buf[i] = pattern(tcp_tx.written + i);
+        if(tcp_write(pcb, buf, (u16_t)n, TCP_WRITE_FLAG_COPY) != ERR_OK)
+            break;
+        tcp_tx.written += n;
+    }
+    tcp_output(pcb);
+}
+
+static err_t source_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    tcp_tx.acked += len;
+    if(tcp_tx.acked == tcp_total)
+    {
+        tcp_close(pcb);
+        tcp_tx.done = 1;
+    }
+    else
+        source_send(pcb);
+    return ERR_OK;
+}
+
+/* Retry writes that failed for lack of memory */
+static err_t source_poll(void *arg, struct tcp_pcb *pcb)
+{
+    if(!tcp_tx.done)
+        source_send(pcb);
+    return ERR_OK;
+}
+
+static err_t source_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    tcp_tx.connected = 1;
+    /* Do not hold the short last segment for the delayed ACK of board A */
+    tcp_nagle_disable(pcb);
+    tcp_sent(pcb, source_sent);
+    tcp_poll(pcb, source_poll, 1);
+    source_send(pcb);
+    return ERR_OK;
+}
+
+static void source_err(void *arg, err_t err)
+{
+    fail("TCP connection aborted");
+    tcp_tx.done = 1;
+}
+
+static volatile int reply;
+static uint64_t echo_sent_at;
+static uint64_t rtt_sum, rtt_min = ~0ull, rtt_max;
+
+static void ctrl_recv_b(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    pbuf_free(p);
+    reply = 1;
+}
+
+static void echo_reply(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    uint64_t rtt = gmac_sim_now_ns() - echo_sent_at;
+
+    pbuf_free(p);
+    rtt_sum += rtt;
+    if(rtt < rtt_min)
+        rtt_min = rtt;
+    if(rtt > rtt_max)
+        rtt_max = rtt;
+    reply = 1;
+}
+
+static int request(struct udp_pcb *pcb, const ip_addr_t *peer, const char *cmd)
+{
+    reply = 0;
+    send_udp(pcb, peer, CTRL_PORT, cmd, (u16_t)strlen(cmd));
+    return wait_for(&reply);
+}
+
+static void run_b(void)
+{
+    struct tcp_pcb *pcb;
+    struct udp_pcb *udp = udp_new(), *ctrl = udp_new();
+    uint8_t buf[UDP_SIZE];
+    uint64_t start, gap;
+    uint32_t seq, i;
+    ip_addr_t peer;
+    char cmd[64];
+
+    IP_ADDR4(&peer, 192, 168, 1, 1);
+    udp_bind(ctrl, IP_ADDR_ANY, CTRL_PORT);
+    udp_recv(ctrl, ctrl_recv_b, NULL);
+
+    /* TCP bulk transfer */
+    if(tcp_total != 0)
+    {
+        pcb = tcp_new();
+        tcp_err(pcb, source_err);
+        tcp_connect(pcb, &peer, TCP_PORT, source_connected);
+        if(wait_for(&tcp_tx.done) != 0)
+            return;
+    }
+
+    /* UDP at the link rate, paced like iperf -u -b */
+    gap = link_mbps ? (uint64_t)(UDP_SIZE + 42 + 24) * 8 * 1000 / link_mbps : 0;
+    start = gmac_sim_now_ns();
+    for(seq = 0; seq < udp_count; seq++)
+    {
+        while(gmac_sim_now_ns() < start + seq * gap)
+            poll_once();
+
+        memcpy(buf, &seq, 4);
+        for(i = 4; i < UDP_SIZE; i++)
+            buf[i] = pattern(seq + i);
+        send_udp(udp, &peer, UDP_PORT, buf, UDP_SIZE);
+        poll_once();
+    }
+
+    snprintf(cmd, sizeof(cmd), "END %u %u", tcp_total, udp_count);
+    if(request(ctrl, &peer, cmd) != 0)
+        return;
+
+    /* UDP echo round trips */
+    udp_recv(udp, echo_reply, NULL);
+    memset(buf, 0x5A, ECHO_SIZE);
+    for(i = 0; i < echo_rounds; i++)
+    {
+        reply = 0;
+        echo_sent_at = gmac_sim_now_ns();
+        send_udp(udp, &peer, ECHO_PORT, buf, ECHO_SIZE);
+        if(wait_for(&reply) != 0)
+            return;
+    }
+    if(echo_rounds != 0)
+        printf("RTT  %8u x %u bytes  avg %.1f us  min %.1f us  max %.1f us\n", echo_rounds, ECHO_SIZE,
+               rtt_sum / 1000.0 / echo_rounds, rtt_min / 1000.0, rtt_max / 1000.0);
+    fflush(stdout);
+
+    request(ctrl, &peer, "QUIT");
+}
+
+/* ---------------------------------------------------------------------------
+ */
+static void board_init(int fd, int b)
+{
+    ip4_addr_t ip, mask, gw;
+
+    board_name = b ? "B" : "A";
+    if(b)
+        mac_addr0[5] = 0x56;
+
+    gmac_sim_attach(EMACINTF0, fd, link_mbps);
+    lwip_init();
+
+    IP4_ADDR(&ip, 192, 168, 1, 1 + b);
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 254);
+    netif_add(&netif, &ip, &mask, &gw, NULL, ethernetif_init0, ethernet_input);
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+}
+
+static void print_stats(void)
+{
+    struct gmac_sim_stats st;
+
+    gmac_sim_get_stats(EMACINTF0, &st);
+    printf("%s: %u frames sent, %u received, %u dropped on the link, %u waited for an Rx descriptor\n",
+           board_name, st.tx_frames, st.rx_frames, st.wire_drops, st.rx_stalls);
+    fflush(stdout);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: netbench [-r mbps] [-t kbytes] [-u datagrams] [-l rounds]\n");
+    exit(2);
+}
+
+/* Board B runs in netbench-peer, next to this binary */
+static void exec_peer(const char *self, int fd)
+{
+    char path[4096], arg[5][16];
+    const char *slash = strrchr(self, '/');
+
+    snprintf(path, sizeof(path), "%.*snetbench-peer", slash ? (int)(slash - self + 1) : 0, self);
+    snprintf(arg[0], sizeof(arg[0]), "%d", fd);
+    snprintf(arg[1], sizeof(arg[1]), "%u", link_mbps);
+    snprintf(arg[2], sizeof(arg[2]), "%u", tcp_total / 1024);
+    snprintf(arg[3], sizeof(arg[3]), "%u", udp_count);
+    snprintf(arg[4], sizeof(arg[4]), "%u", echo_rounds);
+    execl(path, path, "-w", arg[0], "-r", arg[1], "-t", arg[2], "-u", arg[3], "-l", arg[4], (char *)NULL);
+    perror(path);
+    _exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    int sv[2], status, opt, wire = -1;
+    pid_t pid;
+
+    while((opt = getopt(argc, argv, "r:t:u:l:w:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'r':
+            link_mbps = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            tcp_total = strtoul(optarg, NULL, 0) * 1024;
+            break;
+        case 'u':
+            udp_count = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            echo_rounds = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            wire = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if(wire >= 0)
+    {
+        /* board B, started by board A */
+        board_init(wire, 1);
+        run_b();
+        print_stats();
+        return failed;
+    }
+
+    printf("netbench: %s profile, TCP_WND %u, TCP_SND_BUF %u, PBUF_POOL_SIZE %u, link %u Mbit/s\n",
+           PROFILE_NAME, (unsigned)TCP_WND, (unsigned)TCP_SND_BUF, (unsigned)PBUF_POOL_SIZE, link_mbps);
+    fflush(stdout);
+
+    if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0)
+    {
+        perror("socketpair");
+        return 1;
+    }
+    fcntl(sv[0], F_SETFL, O_NONBLOCK);
+    fcntl(sv[1], F_SETFL, O_NONBLOCK);
+
+    pid = fork();
+    if(pid < 0)
+    {
+        perror("fork");
+        return 1;
+    }
+    if(pid == 0)
+    {
+        close(sv[0]);
+        exec_peer(argv[0], sv[1]);
+    }
+    close(sv[1]);
+
+    board_init(sv[0], 0);
+    run_a();
+    print_stats();
+    if((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        failed = 1;
+    return failed;
+}
@@ -0,0 +1,32 @@
+/**************************************************************************//**
+ * @file     task.h
+ * @brief    Task notification stand-in for the host build of the lwIP port.
+ *
+ *           A task is a function that loops on ulTaskNotifyTake(). The host
+ *           main loop calls host_run_tasks(), which runs every notified
+ *           task until it waits again; the wait then returns to the main
+ *           loop instead of blocking.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define tskIDLE_PRIORITY        ((UBaseType_t)0)
+#define taskSCHEDULER_RUNNING   ((BaseType_t)2)
+
+BaseType_t xTaskCreate(TaskFunction_t func, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle);
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+
+/* Run every task with a pending notification, return how many ran */
+int host_run_tasks(void);
+
+#endif /* INC_TASK_H */
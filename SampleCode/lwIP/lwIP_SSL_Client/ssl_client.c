@@ -53,9 +53,10 @@
 #include "test/certs.h"
 #include "mbedtls/x509.h"
 #include "mbedtls/ssl.h"
-#include "mbedtls/net_sockets.h"
+#include "net_netconn.h"
 #include "mbedtls/error.h"
 #include "mbedtls/debug.h"
+#include "crypto_alt.h"
 
 #if defined(MBEDTLS_SSL_CACHE_C)
 #include "mbedtls/ssl_cache.h"
@@ -66,11 +67,17 @@
 #define HOST_NAME "localhost"
 #define GET_REQUEST "GET / HTTP/1.0\r\n\r\n"
 
+/* Give up on a silent server after this long */
+#define READ_TIMEOUT_MS 10000
+
 //#define DEBUG_LEVEL 4
 
 #define SSLCLIENT_THREAD_PRIO    ( tskIDLE_PRIORITY + 2UL )
 #define SSLCLIENT_THREAD_STACKSIZE  2048
 
+/* Reconnections made with the saved session, 0 to skip the benchmark */
+#define RESUME_BENCH_COUNT    10
+
 #if defined(MBEDTLS_CHECK_PARAMS)
 #include "mbedtls/platform_util.h"
 void mbedtls_param_failed( const char *failure_condition,
@@ -93,6 +100,7 @@ static void my_debug( void *ctx, int level,
     fflush(  (FILE *) ctx  );
 }
 
+mbedtls_entropy_context entropy;
 mbedtls_ctr_drbg_context ctr_drbg;
 mbedtls_ssl_context ssl;
 mbedtls_ssl_config conf;
@@ -112,33 +120,122 @@ static void *mbedtls_calloc_wrapper( size_t n, size_t size )
     return ptr;
 }
 
-static int custom_entropy_poll( void *data, unsigned char *output, size_t len )
+#if RESUME_BENCH_COUNT > 0
+/*
+ * One dashboard style connection: connect, handshake, GET and read the reply.
+ * The session is resumed from the server's cache or from a session ticket,
+ * so no certificate or key exchange public key operation is made.
+ */
+static int ssl_resume_once( net_netconn_context *server_fd,
+                            const mbedtls_ssl_session *saved )
+{
+    int ret;
+
+    mbedtls_ssl_session_reset( &ssl );
+
+    if( ( ret = mbedtls_ssl_set_session( &ssl, saved ) ) != 0 )
+        return( ret );
+
+    if( ( ret = net_netconn_connect( server_fd, SERVER_NAME,
+                                     SERVER_PORT ) ) != 0 )
+        return( ret );
+
+    while( ( ret = mbedtls_ssl_handshake( &ssl ) ) != 0 )
+    {
+        if( ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE )
+            goto close;
+    }
+
+    while( ( ret = mbedtls_ssl_write( &ssl, (const unsigned char *) GET_REQUEST,
+                                      strlen( GET_REQUEST ) ) ) <= 0 )
+    {
+        if( ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE )
+            goto close;
+    }
+
+    do
+    {
+        ret = mbedtls_ssl_read( &ssl, buf, sizeof( buf ) );
+    }
+    while( ret > 0 || ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE );
+
+    ret = ( ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY ) ? 0 : ret;
+
+    mbedtls_ssl_close_notify( &ssl );
+
+close:
+    net_netconn_free( server_fd );
+
+    return( ret );
+}
+
+/*
+ * Reconnect RESUME_BENCH_COUNT times with the session of the first
+ * connection and report the connection rate.
+ */
+static void ssl_resume_bench( net_netconn_context *server_fd )
 {
-    size_t i;
-    uint32_t seed;
-    (void) data;
+    mbedtls_ssl_session saved;
+    TickType_t start;
+    int i, ret, ms;
+
+    mbedtls_ssl_session_init( &saved );
 
-    for( i = 0; i < len; i++ )
+    mbedtls_printf( "  . Resuming the session %d times...", RESUME_BENCH_COUNT );
+    fflush( stdout );
+
+    if( ( ret = mbedtls_ssl_get_session( &ssl, &saved ) ) != 0 )
     {
-        seed = xTaskGetTickCount();
-        seed ^= (uint32_t)( (uintptr_t) &seed >> 16 );
-        output[i] = (unsigned char)( seed >> ( ( i % 8 ) * 4 ) ) & 0xFF;
+        mbedtls_printf( " failed\n  ! mbedtls_ssl_get_session returned -0x%x\n\n", -ret );
+        goto exit;
     }
 
-    return( 0 );
+    start = xTaskGetTickCount();
+    for( i = 0; i < RESUME_BENCH_COUNT; i++ )
+    {
+        if( ( ret = ssl_resume_once( server_fd, &saved ) ) != 0 )
+        {
+            mbedtls_printf( " failed\n  ! connection %d returned -0x%x\n\n", i, -ret );
+            goto exit;
+        }
+    }
+    ms = (int)( ( xTaskGetTickCount() - start ) * portTICK_PERIOD_MS );
+    if( ms == 0 )
+        ms = 1;
+
+    /* Compare with the full handshake time printed above */
+    mbedtls_printf( " ok (%d ms, %d.%02d conn/s)\n", ms,
+                    RESUME_BENCH_COUNT * 1000 / ms, ( RESUME_BENCH_COUNT * 100000 / ms ) % 100 );
+
+exit:
+    mbedtls_ssl_session_free( &saved );
 }
+#endif /* RESUME_BENCH_COUNT > 0 */
 
 static void ssl_main(void *arg)
 {
     int ret = 1, len;
     int exit_code = MBEDTLS_EXIT_FAILURE;
-    mbedtls_net_context server_fd;
+    net_netconn_context server_fd;
     uint32_t flags;
+    TickType_t handshake_start;
 
     const char *pers = "ssl_client1";
 
     mbedtls_platform_set_calloc_free( mbedtls_calloc_wrapper, vPortFree );
 
+#if defined(CRYPTO_ALT_SELF_TEST)
+    /* Check the CRYPTO engine against the mbedTLS test vectors */
+    if( crypto_alt_self_test( 1 ) != 0 )
+    {
+        mbedtls_printf( "  ! CRYPTO self test failed\n\n" );
+        vTaskDelete( NULL );
+    }
+#endif
+#if defined(CRYPTO_ALT_BENCHMARK)
+    crypto_alt_benchmark();
+#endif
+
 
 #if defined(MBEDTLS_DEBUG_C)
     mbedtls_debug_set_threshold( DEBUG_LEVEL );
@@ -147,13 +244,14 @@ static void ssl_main(void *arg)
     /*
      * 0. Initialize the RNG and the session data
      */
-    mbedtls_net_init( &server_fd );
+    net_netconn_init( &server_fd );
     mbedtls_ssl_init( &ssl );
     mbedtls_ssl_config_init( &conf );
     mbedtls_x509_crt_init( &cacert );
+    mbedtls_entropy_init( &entropy );
     mbedtls_ctr_drbg_init( &ctr_drbg );
 
-    ret = mbedtls_ctr_drbg_seed( &ctr_drbg, custom_entropy_poll, NULL,
+    ret = mbedtls_ctr_drbg_seed( &ctr_drbg, mbedtls_entropy_func, &entropy,
                                (const unsigned char *) pers, strlen( pers ) );
     if( ret != 0 )
     {
@@ -185,10 +283,10 @@ static void ssl_main(void *arg)
     mbedtls_printf( "  . Connecting to tcp/%s/%s...", SERVER_NAME, SERVER_PORT );
     fflush( stdout );
 
-    if( ( ret = mbedtls_net_connect( &server_fd, SERVER_NAME,
-                                     SERVER_PORT, MBEDTLS_NET_PROTO_TCP ) ) != 0 )
+    if( ( ret = net_netconn_connect( &server_fd, SERVER_NAME,
+                                     SERVER_PORT ) ) != 0 )
     {
-        mbedtls_printf( " failed\n  ! mbedtls_net_connect returned %d\n\n", ret );
+        mbedtls_printf( " failed\n  ! net_netconn_connect returned %d\n\n", ret );
         goto exit;
     }
 
@@ -217,6 +315,7 @@ static void ssl_main(void *arg)
     mbedtls_ssl_conf_ca_chain( &conf, &cacert, NULL );
     mbedtls_ssl_conf_rng( &conf, mbedtls_ctr_drbg_random, &ctr_drbg );
     mbedtls_ssl_conf_dbg( &conf, my_debug, stdout );
+    mbedtls_ssl_conf_read_timeout( &conf, READ_TIMEOUT_MS );
 
     if( ( ret = mbedtls_ssl_setup( &ssl, &conf ) ) != 0 )
     {
@@ -230,7 +329,7 @@ static void ssl_main(void *arg)
         goto exit;
     }
 
-    mbedtls_ssl_set_bio( &ssl, &server_fd, mbedtls_net_send, mbedtls_net_recv, NULL );
+    mbedtls_ssl_set_bio( &ssl, &server_fd, net_netconn_send, NULL, net_netconn_recv_timeout );
 
     /*
      * 3. Handshake
@@ -238,6 +337,7 @@ static void ssl_main(void *arg)
     mbedtls_printf( "  . Performing the SSL/TLS handshake..." );
     fflush( stdout );
 
+    handshake_start = xTaskGetTickCount();
     while( ( ret = mbedtls_ssl_handshake( &ssl ) ) != 0 )
     {
         if( ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE )
@@ -247,7 +347,8 @@ static void ssl_main(void *arg)
         }
     }
 
-    mbedtls_printf( " ok\n" );
+    mbedtls_printf( " ok (%d ms)\n",
+                    (int)( ( xTaskGetTickCount() - handshake_start ) * portTICK_PERIOD_MS ) );
 
     /*
      * 4. Verify the server certificate
@@ -329,6 +430,11 @@ static void ssl_main(void *arg)
 
     mbedtls_ssl_close_notify( &ssl );
 
+#if RESUME_BENCH_COUNT > 0
+    net_netconn_free( &server_fd );
+    ssl_resume_bench( &server_fd );
+#endif
+
     exit_code = MBEDTLS_EXIT_SUCCESS;
 
 exit:
@@ -342,12 +448,13 @@ exit:
     }
 #endif
 
-    mbedtls_net_free( &server_fd );
+    net_netconn_free( &server_fd );
 
     mbedtls_x509_crt_free( &cacert );
     mbedtls_ssl_free( &ssl );
     mbedtls_ssl_config_free( &conf );
     mbedtls_ctr_drbg_free( &ctr_drbg );
+    mbedtls_entropy_free( &entropy );
 
 #if defined(_WIN32)
     mbedtls_printf( "  + Press Enter to exit this program.\n" );
@@ -50,7 +50,8 @@
 #define LWIP_STATS                      0
 #define LWIP_SOCKET_SET_ERRNO           0
 #define LWIP_NETCONN                    1
-#define LWIP_SOCKET                     1
+#define LWIP_SOCKET                     0
+#define LWIP_SO_RCVTIMEO                1   /* mbedTLS read timeout */
 #define LWIP_PROVIDE_ERRNO              1
 #if defined ( __GNUC__ ) && !(__CC_ARM) && !(__ICCARM__)
 #define LWIP_TIMEVAL_PRIVATE            0
@@ -53,14 +53,19 @@
 #include "test/certs.h"
 #include "mbedtls/x509.h"
 #include "mbedtls/ssl.h"
-#include "mbedtls/net_sockets.h"
+#include "net_netconn.h"
 #include "mbedtls/error.h"
 #include "mbedtls/debug.h"
+#include "crypto_alt.h"
 
 #if defined(MBEDTLS_SSL_CACHE_C)
 #include "mbedtls/ssl_cache.h"
 #endif
 
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+#include "ssl_ticket_ks.h"
+#endif
+
 #define HTTP_RESPONSE \
     "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\n\r\n" \
     "<h2>mbed TLS Test Server</h2>\r\n" \
@@ -71,6 +76,15 @@
 #define SSLSERVER_THREAD_PRIO    ( tskIDLE_PRIORITY + 2UL )
 #define SSLSERVER_THREAD_STACKSIZE  2048
 
+/* Drop a client that stalls, the server handles one connection at a time */
+#define READ_TIMEOUT_MS          10000
+
+/* One cache entry per dashboard expected to reconnect */
+#define SSL_CACHE_MAX_ENTRIES    8
+
+/* Ticket lifetime and ticket key rotation period, in seconds */
+#define SSL_TICKET_LIFETIME      3600
+
 #if defined(MBEDTLS_CHECK_PARAMS)
 #include "mbedtls/platform_util.h"
 void mbedtls_param_failed( const char *failure_condition,
@@ -94,6 +108,7 @@ static void my_debug( void *ctx, int level,
 }
 
 unsigned char buf[1024];
+mbedtls_entropy_context entropy;
 mbedtls_ctr_drbg_context ctr_drbg;
 mbedtls_ssl_context ssl;
 mbedtls_ssl_config conf;
@@ -102,6 +117,9 @@ mbedtls_pk_context pkey;
 #if defined(MBEDTLS_SSL_CACHE_C)
 mbedtls_ssl_cache_context cache;
 #endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+ssl_ticket_ks_context ticket;
+#endif
 
 static void *mbedtls_calloc_wrapper( size_t n, size_t size )
 {
@@ -113,42 +131,43 @@ static void *mbedtls_calloc_wrapper( size_t n, size_t size )
     return ptr;
 }
 
-static int custom_entropy_poll( void *data, unsigned char *output, size_t len )
-{
-    size_t i;
-    uint32_t seed;
-    (void) data;
-
-    for( i = 0; i < len; i++ )
-    {
-        seed = xTaskGetTickCount();
-        seed ^= (uint32_t)( (uintptr_t) &seed >> 16 );
-        output[i] = (unsigned char)( seed >> ( ( i % 8 ) * 4 ) ) & 0xFF;
-    }
-
-    return( 0 );
-}
-
 static void ssl_main(void *arg)
 {
     int ret, len;
-    mbedtls_net_context listen_fd, client_fd;
+    net_netconn_context listen_fd, client_fd;
+    TickType_t handshake_start;
     const char *pers = "ssl_server";
 
     mbedtls_platform_set_calloc_free( mbedtls_calloc_wrapper, vPortFree );
 
-    mbedtls_net_init( &listen_fd );
-    mbedtls_net_init( &client_fd );
+#if defined(CRYPTO_ALT_SELF_TEST)
+    /* Check the CRYPTO engine against the mbedTLS test vectors */
+    if( crypto_alt_self_test( 1 ) != 0 )
+    {
+        mbedtls_printf( "  ! CRYPTO self test failed\n\n" );
+        vTaskDelete( NULL );
+    }
+#endif
+#if defined(CRYPTO_ALT_BENCHMARK)
+    crypto_alt_benchmark();
+#endif
+
+    net_netconn_init( &listen_fd );
+    net_netconn_init( &client_fd );
     mbedtls_ssl_init( &ssl );
     mbedtls_ssl_config_init( &conf );
 #if defined(MBEDTLS_SSL_CACHE_C)
     mbedtls_ssl_cache_init( &cache );
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    ssl_ticket_ks_init( &ticket );
 #endif
     mbedtls_x509_crt_init( &srvcert );
     mbedtls_pk_init( &pkey );
+    mbedtls_entropy_init( &entropy );
     mbedtls_ctr_drbg_init( &ctr_drbg );
 
-    ret = mbedtls_ctr_drbg_seed( &ctr_drbg, custom_entropy_poll, NULL,
+    ret = mbedtls_ctr_drbg_seed( &ctr_drbg, mbedtls_entropy_func, &entropy,
                                (const unsigned char *) pers, strlen( pers ) );
     if( ret != 0 )
     {
@@ -204,9 +223,9 @@ static void ssl_main(void *arg)
     mbedtls_printf( "  . Bind on https://localhost:443/ ..." );
     fflush( stdout );
 
-    if( ( ret = mbedtls_net_bind( &listen_fd, NULL, "443", MBEDTLS_NET_PROTO_TCP ) ) != 0 )
+    if( ( ret = net_netconn_bind( &listen_fd, NULL, "443" ) ) != 0 )
     {
-        mbedtls_printf( " failed\n  ! mbedtls_net_bind returned %d\n\n", ret );
+        mbedtls_printf( " failed\n  ! net_netconn_bind returned %d\n\n", ret );
         goto exit;
     }
 
@@ -229,13 +248,31 @@ static void ssl_main(void *arg)
 
     mbedtls_ssl_conf_rng( &conf, mbedtls_ctr_drbg_random, &ctr_drbg );
     mbedtls_ssl_conf_dbg( &conf, my_debug, stdout );
+    mbedtls_ssl_conf_read_timeout( &conf, READ_TIMEOUT_MS );
 
 #if defined(MBEDTLS_SSL_CACHE_C)
+    /* MBEDTLS_HAVE_TIME is off, entries only leave the cache when it is full */
+    mbedtls_ssl_cache_set_max_entries( &cache, SSL_CACHE_MAX_ENTRIES );
     mbedtls_ssl_conf_session_cache( &conf, &cache,
                                     mbedtls_ssl_cache_get,
                                     mbedtls_ssl_cache_set );
 #endif
 
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    /* Ticket keys are generated into and used from Key Store SRAM */
+    if( ( ret = ssl_ticket_ks_setup( &ticket, mbedtls_ctr_drbg_random, &ctr_drbg,
+                                     SSL_TICKET_LIFETIME ) ) != 0 )
+    {
+        mbedtls_printf( " failed\n  ! ssl_ticket_ks_setup returned %d\n\n", ret );
+        goto exit;
+    }
+
+    mbedtls_ssl_conf_session_tickets_cb( &conf,
+                                         ssl_ticket_ks_write,
+                                         ssl_ticket_ks_parse,
+                                         &ticket );
+#endif
+
     mbedtls_ssl_conf_ca_chain( &conf, srvcert.next, NULL );
     if( ( ret = mbedtls_ssl_conf_own_cert( &conf, &srvcert, &pkey ) ) != 0 )
     {
@@ -261,7 +298,7 @@ reset:
     }
 #endif
 
-    mbedtls_net_free( &client_fd );
+    net_netconn_free( &client_fd );
 
     mbedtls_ssl_session_reset( &ssl );
 
@@ -271,14 +308,14 @@ reset:
     mbedtls_printf( "  . Waiting for a remote connection ..." );
     fflush( stdout );
 
-    if( ( ret = mbedtls_net_accept( &listen_fd, &client_fd,
+    if( ( ret = net_netconn_accept( &listen_fd, &client_fd,
                                     NULL, 0, NULL ) ) != 0 )
     {
-        mbedtls_printf( " failed\n  ! mbedtls_net_accept returned %d\n\n", ret );
+        mbedtls_printf( " failed\n  ! net_netconn_accept returned %d\n\n", ret );
         goto exit;
     }
 
-    mbedtls_ssl_set_bio( &ssl, &client_fd, mbedtls_net_send, mbedtls_net_recv, NULL );
+    mbedtls_ssl_set_bio( &ssl, &client_fd, net_netconn_send, NULL, net_netconn_recv_timeout );
 
     mbedtls_printf( " ok\n" );
 
@@ -288,6 +325,7 @@ reset:
     mbedtls_printf( "  . Performing the SSL/TLS handshake..." );
     fflush( stdout );
 
+    handshake_start = xTaskGetTickCount();
     while( ( ret = mbedtls_ssl_handshake( &ssl ) ) != 0 )
     {
         if( ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE )
@@ -297,7 +335,8 @@ reset:
         }
     }
 
-    mbedtls_printf( " ok\n" );
+    mbedtls_printf( " ok (%d ms)\n",
+                    (int)( ( xTaskGetTickCount() - handshake_start ) * portTICK_PERIOD_MS ) );
 
     /*
      * 6. Read the HTTP Request
@@ -326,6 +365,10 @@ reset:
                     mbedtls_printf( " connection was reset by peer\n" );
                     break;
 
+                case MBEDTLS_ERR_SSL_TIMEOUT:
+                    mbedtls_printf( " timed out\n" );
+                    goto reset;
+
                 default:
                     mbedtls_printf( " mbedtls_ssl_read returned -0x%x\n", (unsigned int) -ret );
                     break;
@@ -397,8 +440,8 @@ exit:
     }
 #endif
 
-    mbedtls_net_free( &client_fd );
-    mbedtls_net_free( &listen_fd );
+    net_netconn_free( &client_fd );
+    net_netconn_free( &listen_fd );
 
     mbedtls_x509_crt_free( &srvcert );
     mbedtls_pk_free( &pkey );
@@ -406,8 +449,12 @@ exit:
     mbedtls_ssl_config_free( &conf );
 #if defined(MBEDTLS_SSL_CACHE_C)
     mbedtls_ssl_cache_free( &cache );
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    ssl_ticket_ks_free( &ticket );
 #endif
     mbedtls_ctr_drbg_free( &ctr_drbg );
+    mbedtls_entropy_free( &entropy );
 
 
     return;
@@ -62,7 +62,7 @@
 #define SSIZE_MAX                       65535
 
 #define MEMP_NUM_NETCONN                8
-#define MEM_SIZE                        1600
+#define MEM_SIZE                        8192
 #define MEMP_NUM_PBUF                   32
 #define PBUF_POOL_SIZE                  64
 #define TCP_WND                         16384 //Max: 65535
@@ -76,7 +76,7 @@
 #define TCPIP_MBOX_SIZE                 10
 #define DEFAULT_TCP_RECVMBOX_SIZE       5
 #define DEFAULT_ACCEPTMBOX_SIZE         5
-#define DEFAULT_UDP_RECVMBOX_SIZE       5
+#define DEFAULT_UDP_RECVMBOX_SIZE       16  // > TFTP_MAX_WINDOWSIZE
 #define DEFAULT_RAW_RECVMBOX_SIZE       5
 #define LWIP_SO_RCVTIMEO                1
 
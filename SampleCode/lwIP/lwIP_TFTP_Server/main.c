@@ -1,7 +1,8 @@
 /**************************************************************************//**
  * @file     main.c
  *
- * @brief    A TFTP server
+ * @brief    A TFTP server storing files on the SD card (FatFs, SDH1).
+ *           Supports the blksize, timeout, tsize and windowsize options.
  *
  * @note     TIMER11 has been assigned to FreeRTOS kernel.
  *
@@ -22,6 +23,7 @@
 #include "lwip/tcpip.h"
 #include "netif/ethernetif.h"
 #include "tftp.h"
+#include "ff.h"
 #if (LWIP_DHCP == 1)
 #include "lwip/dhcp.h"
 #endif
@@ -182,6 +184,35 @@ void SYS_Init()
     CLK->PLL[EPLL].CTL1 = 2 << CLK_PLLnCTL1_OUTDIV_Pos; // EPLL divide by 2 and enable
     CLK_WaitClockReady(CLK_STATUS_STABLE_EPLL);
 
+    /* Enable SD1 and its pins */
+    CLK_EnableModuleClock(SD1_MODULE);
+    CLK_EnableModuleClock(GPJ_MODULE);
+
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ0MFP_Msk)) | SYS_GPJ_MFPL_PJ0MFP_eMMC1_DAT4;
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ1MFP_Msk)) | SYS_GPJ_MFPL_PJ1MFP_eMMC1_DAT5;
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ2MFP_Msk)) | SYS_GPJ_MFPL_PJ2MFP_eMMC1_DAT6;
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ3MFP_Msk)) | SYS_GPJ_MFPL_PJ3MFP_eMMC1_DAT7;
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ4MFP_Msk)) | SYS_GPJ_MFPL_PJ4MFP_SD1_WP;
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ5MFP_Msk)) | SYS_GPJ_MFPL_PJ5MFP_SD1_nCD;
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ6MFP_Msk)) | SYS_GPJ_MFPL_PJ6MFP_eMMC1_CMD;
+    SYS->GPJ_MFPL = (SYS->GPJ_MFPL & (~SYS_GPJ_MFPL_PJ7MFP_Msk)) | SYS_GPJ_MFPL_PJ7MFP_eMMC1_CLK;
+    SYS->GPJ_MFPH = (SYS->GPJ_MFPH & (~SYS_GPJ_MFPH_PJ8MFP_Msk)) | SYS_GPJ_MFPH_PJ8MFP_eMMC1_DAT0;
+    SYS->GPJ_MFPH = (SYS->GPJ_MFPH & (~SYS_GPJ_MFPH_PJ9MFP_Msk)) | SYS_GPJ_MFPH_PJ9MFP_eMMC1_DAT1;
+    SYS->GPJ_MFPH = (SYS->GPJ_MFPH & (~SYS_GPJ_MFPH_PJ10MFP_Msk)) | SYS_GPJ_MFPH_PJ10MFP_eMMC1_DAT2;
+    SYS->GPJ_MFPH = (SYS->GPJ_MFPH & (~SYS_GPJ_MFPH_PJ11MFP_Msk)) | SYS_GPJ_MFPH_PJ11MFP_eMMC1_DAT3;
+
+    /* PJ Driver Strength */
+    GPIO_SetDriveStrength(PJ,  0, 1);
+    GPIO_SetDriveStrength(PJ,  1, 1);
+    GPIO_SetDriveStrength(PJ,  2, 1);
+    GPIO_SetDriveStrength(PJ,  3, 1);
+    GPIO_SetDriveStrength(PJ,  6, 4);
+    GPIO_SetDriveStrength(PJ,  7, 7);
+    GPIO_SetDriveStrength(PJ,  8, 1);
+    GPIO_SetDriveStrength(PJ,  9, 1);
+    GPIO_SetDriveStrength(PJ, 10, 1);
+    GPIO_SetDriveStrength(PJ, 11, 1);
+
     /* DDR Init */
     outp32(UMCTL2_BASE + 0x6a0, 0x01);
 
@@ -196,6 +227,14 @@ void SYS_Init()
     SYS_LockReg();
 }
 
+/*---------------------------------------------------------*/
+/* User Provided RTC Function for FatFs module             */
+/*---------------------------------------------------------*/
+unsigned long get_fattime (void)
+{
+    return 0x00000;
+}
+
 static netif_init_fn ethernetif_init(int intf)
 {
     netif_init_fn ethernetif_init;
@@ -235,6 +274,10 @@ static void vNetTask( void *pvParameters )
     sysprintf("Subnet mask:     %s\n", ip4addr_ntoa(&netif.netmask));
     sysprintf("Default gateway: %s\n", ip4addr_ntoa(&netif.gw));
 
+    /* Mount the card, files are read from and written to drive 1: */
+    SDH_Open_Disk(SDH);
+    f_chdrive("1:");
+
     tftp_server_init();
 
     vTaskSuspend( NULL );
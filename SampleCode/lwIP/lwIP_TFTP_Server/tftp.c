@@ -1,31 +1,57 @@
 /*************************************************************************//**
  * @file     tftp.c
  * @version  V1.00
- * @brief    A simple TFTP source file.
+ * @brief    A simple TFTP source file. Files are read from and written to
+ *           FatFs. Supports the blksize (RFC 2348), timeout and tsize
+ *           (RFC 2349) and windowsize (RFC 7440) options.
  *
  * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
 *****************************************************************************/
 #include "lwip/opt.h"
 #include "lwip/arch.h"
+#include "lwip/def.h"
 #include "lwip/api.h"
 #include "string.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "ff.h"
 #include "tftp.h"
 
 
 #define TFTP_THREAD_PRIO       ( tskIDLE_PRIORITY + 2UL )
-#define TFTP_THREAD_STACKSIZE  ( 200UL )
+#define TFTP_THREAD_STACKSIZE  ( 400UL )
 
 #ifndef MIN
-#define MIN(a, b)   (a) < (b) ? (a) : (b)
+#define MIN(a, b)   ((a) < (b) ? (a) : (b))
 #endif
 
 static struct netconn *conn;
 static unsigned short client_port;
 static ip_addr_t client_addr;
 
-#define FILE_LEN        2048
-static uint32_t flen = FILE_LEN;
-static uint8_t file[FILE_LEN];
+/* Transfer state */
+static FIL fil;
+static FSIZE_t fsize;
+static uint16_t blksize;
+static uint16_t windowsize;
+static uint32_t timeout;
+static uint32_t blk;            // RRQ: first block not acked yet, WRQ: last block received in order
+static uint32_t blk_sent;       // RRQ: last block sent
+static uint32_t blk_last;       // RRQ: final (short) block of the file
+static uint16_t win_cnt;        // WRQ: blocks received since the last ACK
+static uint8_t nak_sent;        // WRQ: out of order block already answered
+static uint8_t oack_pending;    // OACK sent, waiting for ACK 0 or DATA 1
+static uint32_t start_time;
+
+/* FatFs I/O buffer: RRQ read cache at file offset io_off, WRQ staging buffer */
+static uint8_t io_buf[TFTP_IO_BUF_SIZE] __attribute__((aligned(64)));
+static FSIZE_t io_off;
+static uint32_t io_len;
+
+static uint8_t rx_buf[TFTP_MAX_BLKSIZE + 4 + 1];
+static char path[TFTP_MAX_PATH];
+static char oack[128];
+static uint16_t oack_len;
 
 
 void send_ack(uint16_t blk)
@@ -98,6 +124,216 @@ void send_err(ip_addr_t *addr, unsigned short port, uint16_t err)
     netbuf_delete(nbuf);
 }
 
+void send_oack(void)
+{
+    struct netbuf *nbuf;
+    char *data;
+    /* Prepare data */
+    if((nbuf = netbuf_new()) == NULL)
+        return;
+    if((data = netbuf_alloc(nbuf, oack_len)) == NULL)
+    {
+        netbuf_delete(nbuf);
+        return;
+    }
+    memcpy(data, oack, oack_len);
+    /* Send the packet */
+    netconn_sendto(conn, nbuf, &client_addr, client_port);
+
+    /* Free the buffer */
+    netbuf_delete(nbuf);
+}
+
+static void oack_add(const char *name, unsigned long val)
+{
+    int n;
+
+    n = snprintf(&oack[oack_len], sizeof(oack) - oack_len, "%s%c%lu", name, 0, val);
+    if((n > 0) && (oack_len + n + 1 <= sizeof(oack)))
+        oack_len += n + 1;
+}
+
+/**
+  * @brief Map a requested file name into TFTP_ROOT_DIR
+  * @param name file name from the request
+  * @retval 0 and the FatFs path in path[], -1 if the name may not be served.
+  *         Drive prefixes, absolute paths, "." and ".." components and empty
+  *         components are rejected so the request cannot leave the directory.
+  */
+static int map_filename(const char *name)
+{
+    const char *p = name;
+    size_t n;
+
+    if((*name == '\0') || (*name == '/'))
+        return -1;
+
+    while(*p != '\0')
+    {
+        /* one path component */
+        for(n = 0; (p[n] != '\0') && (p[n] != '/'); n++)
+        {
+            if((p[n] == ':') || (p[n] == '\\'))
+                return -1;
+        }
+        if((n == 0) || ((n == 1) && (p[0] == '.')) || ((n == 2) && (p[0] == '.') && (p[1] == '.')))
+            return -1;
+        p += n;
+        if(*p == '/')
+        {
+            p++;
+            if(*p == '\0')
+                return -1;
+        }
+    }
+
+    if(strlen(TFTP_ROOT_DIR) + strlen(name) >= sizeof(path))
+        return -1;
+    strcpy(path, TFTP_ROOT_DIR);
+    strcat(path, name);
+
+    return 0;
+}
+
+/**
+  * @brief Parse the options following the mode string and build the OACK
+  * @param opt first option name
+  * @param end end of the request
+  * @param rrq 1 for a read request, 0 for a write request
+  * @retval None
+  */
+static void parse_options(char *opt, char *end, int rrq)
+{
+    char *val;
+    unsigned long v;
+
+    blksize = TFTP_BLOCK_LENGTH;
+    windowsize = 1;
+    timeout = TFTP_TIMEOUT;
+
+    *(uint16_t *)oack = lwip_htons(TFTP_OPCODE_OACK);
+    oack_len = 2;
+
+    while(opt < end)
+    {
+        val = opt + strlen(opt) + 1;
+        if(val >= end)
+            break;
+        v = strtoul(val, NULL, 10);
+
+        if((lwip_stricmp(opt, "blksize") == 0) && (v >= 8))
+        {
+            blksize = MIN(v, TFTP_MAX_BLKSIZE);
+            oack_add("blksize", blksize);
+        }
+        else if((lwip_stricmp(opt, "windowsize") == 0) && (v >= 1))
+        {
+            windowsize = MIN(v, TFTP_MAX_WINDOWSIZE);
+            oack_add("windowsize", windowsize);
+        }
+        else if((lwip_stricmp(opt, "timeout") == 0) && (v >= 1) && (v <= 255))
+        {
+            timeout = v * 1000;
+            oack_add("timeout", v);
+        }
+        else if(lwip_stricmp(opt, "tsize") == 0)
+        {
+            if(!rrq)
+                fsize = v;
+            oack_add("tsize", fsize);
+        }
+        /* Unknown options are ignored */
+
+        opt = val + strlen(val) + 1;
+    }
+}
+
+/**
+  * @brief Get block n (1-based) of the file being read
+  * @param n block number
+  * @param len returns the block length, less than blksize for the last block
+  * @retval Pointer into the read cache, NULL on a FatFs error
+  */
+static uint8_t *read_block(uint32_t n, uint16_t *len)
+{
+    FSIZE_t off = (FSIZE_t)(n - 1) * blksize;
+    UINT br;
+
+    *len = (off >= fsize) ? 0 : (uint16_t)MIN(fsize - off, blksize);
+
+    if((off < io_off) || (off + *len > io_off + io_len))
+    {
+        /* Refill from a sector boundary so FatFs reads straight into io_buf */
+        io_off = off & ~(FSIZE_t)511;
+        if((f_lseek(&fil, io_off) != FR_OK) || (f_read(&fil, io_buf, TFTP_IO_BUF_SIZE, &br) != FR_OK))
+            return NULL;
+        io_len = br;
+    }
+
+    return &io_buf[off - io_off];
+}
+
+/* Send the window starting at the first unacknowledged block */
+static int send_window(void)
+{
+    uint32_t n;
+    uint16_t len;
+    uint8_t *p;
+
+    for(n = blk; (n < blk + windowsize) && (n <= blk_last); n++)
+    {
+        if((p = read_block(n, &len)) == NULL)
+            return -1;
+        send_data((uint16_t)n, p, len);
+        blk_sent = n;
+    }
+
+    return 0;
+}
+
+static int write_flush(void)
+{
+    UINT bw;
+
+    if(io_len == 0)
+        return 0;
+    if((f_write(&fil, io_buf, io_len, &bw) != FR_OK) || (bw != io_len))
+        return -1;
+    io_len = 0;
+
+    return 0;
+}
+
+/* Stage received data and write it out in whole buffers */
+static int write_block(uint8_t *p, uint16_t len)
+{
+    uint32_t n;
+
+    while(len)
+    {
+        n = MIN(len, TFTP_IO_BUF_SIZE - io_len);
+        memcpy(&io_buf[io_len], p, n);
+        io_len += n;
+        p += n;
+        len -= n;
+        if((io_len == TFTP_IO_BUF_SIZE) && write_flush())
+            return -1;
+    }
+
+    return 0;
+}
+
+static void end_transfer(uint16_t *state, int ok)
+{
+    uint32_t ms = sys_now() - start_time;
+
+    f_close(&fil);
+    if(ok)
+        sysprintf("Done, %lu bytes in %u ms\n", (unsigned long)fsize, ms);
+    *state = TFTP_STATE_IDLE;
+    netconn_set_recvtimeout(conn, TFTP_TIMEOUT);
+}
+
 /**
   * @brief TFTP server thread
   * @param arg pointer on argument(not used here)
@@ -108,14 +344,14 @@ static void tftp_thread(void *arg)
 
     err_t err;
     struct netbuf *nbuf;
-    uint8_t *data, *payload;
+    uint8_t *payload;
     ip_addr_t *get_addr;
     unsigned short get_port;
     uint16_t payload_len;
 
     uint16_t state = TFTP_STATE_IDLE;
-    uint16_t op, blk;
-    int retry, remain;
+    uint16_t op;
+    int retry = 0;
 
 
     /* Create a new UDP connection handle */
@@ -150,22 +386,27 @@ static void tftp_thread(void *arg)
             {
                 sysprintf("Exceed retry count, reset to idle state\n");
                 retry = 0;
-                state = TFTP_STATE_IDLE;
+                end_transfer(&state, 0);
                 continue;
             }
             /* Packet was likely lost */
-            if(state == TFTP_STATE_RRQ)
+            if(oack_pending)
+            {
+                sysprintf("Timeout, resend oack %d\n", retry);
+                send_oack();
+            }
+            else if(state == TFTP_STATE_RRQ)
             {
                 sysprintf("Timeout, resend data %d\n", retry);
-                send_data(blk, (void *)data, MIN(remain, TFTP_BLOCK_LENGTH));
-                continue;
+                send_window();
             }
             else
             {
                 sysprintf("Timeout, resend ack %d\n", retry);
-                send_ack(blk);
-                continue;
+                send_ack((uint16_t)blk);
+                win_cnt = 0;
             }
+            continue;
         }
         else if(err != ERR_OK)
         {
@@ -177,8 +418,20 @@ static void tftp_thread(void *arg)
         /* Get destination IP address and port*/
         get_addr = netbuf_fromaddr(nbuf);
         get_port = netbuf_fromport(nbuf);
-        /* Get the payload and length */
-        netbuf_data(nbuf, (void**)&payload, &payload_len);
+        /* Get the payload and length, DATA of a large block may be chained */
+        if(nbuf->p->next != NULL)
+        {
+            payload_len = netbuf_copy(nbuf, rx_buf, sizeof(rx_buf) - 1);
+            payload = rx_buf;
+        }
+        else
+            netbuf_data(nbuf, (void**)&payload, &payload_len);
+
+        if(payload_len < 4)
+        {
+            netbuf_delete(nbuf);
+            continue;
+        }
 
         op = lwip_ntohs(*(uint16_t *)payload);
 
@@ -188,33 +441,87 @@ static void tftp_thread(void *arg)
             case TFTP_OPCODE_WRQ:
                 if(state == TFTP_STATE_IDLE)
                 {
+                    char *filename, *mode, *end;
+
+                    /* Work on a NUL terminated copy of the request */
+                    if(payload != rx_buf)
+                    {
+                        payload_len = MIN(payload_len, sizeof(rx_buf) - 1);
+                        memcpy(rx_buf, payload, payload_len);
+                    }
+                    rx_buf[payload_len] = 0;
+                    end = (char *)&rx_buf[payload_len];
+                    filename = (char *)&rx_buf[2];
+                    mode = filename + strlen(filename) + 1;
+                    if(mode >= end)
+                    {
+                        send_err(get_addr, get_port, TFTP_ERROR_ILLEGAL_OPERATION);
+                        break;
+                    }
+                    if(map_filename(filename) != 0)
+                    {
+                        sysprintf("Rejected request for %s\n", filename);
+                        send_err(get_addr, get_port, TFTP_ERROR_ACCESS_VIOLATION);
+                        break;
+                    }
+
                     /* New request comes in, save client's address and port number */
                     memcpy((void *)&client_addr, get_addr, sizeof(ip_addr_t));
                     client_port = get_port;
-                    /* This sample does not check file name and mode */
+                    io_off = 0;
+                    io_len = 0;
+                    start_time = sys_now();
+
+                    /* Only octet transfers are supported, the mode is not checked */
                     if(op == TFTP_OPCODE_RRQ)
                     {
-                        sysprintf("Received RRQ\n");
+                        if(f_open(&fil, path, FA_READ) != FR_OK)
+                        {
+                            send_err(get_addr, get_port, TFTP_ERROR_FILE_NOT_FOUND);
+                            break;
+                        }
+                        fsize = f_size(&fil);
+                        parse_options(mode + strlen(mode) + 1, end, 1);
+                        sysprintf("Received RRQ %s, blksize %d, windowsize %d\n", filename, blksize, windowsize);
+
+                        /* The last block is shorter than blksize, possibly empty */
+                        blk_last = fsize / blksize + 1;
                         blk = 1;
-                        data = file;
-                        remain = flen;
+                        blk_sent = 0;
                         state = TFTP_STATE_RRQ;
-                        send_data(blk, data, MIN(remain, TFTP_BLOCK_LENGTH));
                     }
                     else
                     {
-                        sysprintf("Received WRQ\n");
-                        /* ACK for WRQ must be 0 */
+                        if(f_open(&fil, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+                        {
+                            send_err(get_addr, get_port, TFTP_ERROR_ACCESS_VIOLATION);
+                            break;
+                        }
+                        fsize = 0;
+                        parse_options(mode + strlen(mode) + 1, end, 0);
+                        sysprintf("Received WRQ %s, blksize %d, windowsize %d\n", filename, blksize, windowsize);
+
                         blk = 0;
+                        win_cnt = 0;
+                        nak_sent = 0;
                         state = TFTP_STATE_WRQ;
-                        send_ack(blk);
                     }
+                    netconn_set_recvtimeout(conn, timeout);
+
+                    oack_pending = (oack_len > 2);
+                    if(oack_pending)
+                        send_oack();
+                    else if(state == TFTP_STATE_RRQ)
+                        send_window();
+                    else
+                        send_ack(0);    /* ACK for WRQ must be 0 */
                 }
-                else
+                else if((get_port != client_port) || memcmp(get_addr, &client_addr, sizeof(ip_addr_t)))
                 {
                     /* Be patient, one client at a time.  */
                     send_err(get_addr, get_port, TFTP_ERROR_ACCESS_VIOLATION);
                 }
+                /* else a retransmitted request, the timeout resends our reply */
                 break;
 
             case TFTP_OPCODE_DATA:
@@ -225,39 +532,47 @@ static void tftp_thread(void *arg)
                 else
                 {
                     uint16_t new_blk = lwip_ntohs(*(uint16_t *)(payload + 2));
+                    uint16_t len = payload_len - 4;
 
-                    if(new_blk == blk)
-                    {
-                        /* Last ACK lost */
-                        send_ack(blk);
-                    }
-                    if(new_blk == blk + 1)
+                    if(new_blk == (uint16_t)(blk + 1))
                     {
-                        int i;
-                        uint8_t *c = payload + 4;
-                        // Dump received data */
-                        for(i = 0; i < payload_len - 4; i++)
+                        if(write_block(payload + 4, len) != 0)
                         {
-                            if((i & 0xF) == 0)
-                                sysprintf("\n");
-                            sysprintf("%02x ", *c++);
+                            sysprintf("Write failed\n");
+                            send_err(get_addr, get_port, TFTP_ERROR_DISK_FULL);
+                            end_transfer(&state, 0);
+                            break;
                         }
+                        blk++;
+                        win_cnt++;
+                        nak_sent = 0;
+                        oack_pending = 0;
 
-                        blk = new_blk;
-                        send_ack(blk);
-                        if(payload_len < TFTP_BLOCK_LENGTH + 4)
+                        if(len < blksize)
                         {
                             /* This is the last data packet, all done */
-                            sysprintf("Done\n");
-                            state = TFTP_STATE_IDLE;
+                            if(write_flush() != 0)
+                            {
+                                send_err(get_addr, get_port, TFTP_ERROR_DISK_FULL);
+                                end_transfer(&state, 0);
+                                break;
+                            }
+                            fsize = f_tell(&fil);
+                            send_ack((uint16_t)blk);
+                            end_transfer(&state, 1);
+                        }
+                        else if(win_cnt >= windowsize)
+                        {
+                            send_ack((uint16_t)blk);
+                            win_cnt = 0;
                         }
                     }
-                    else
+                    else if(!nak_sent)
                     {
-                        /* Wrong ack # */
-                        sysprintf("Unknown ID number\n");
-                        send_err(get_addr, get_port, TFTP_ERROR_UNKNOWN_ID);
-                        state = TFTP_STATE_IDLE;
+                        /* Duplicate or out of order block, ack the last one received in order */
+                        send_ack((uint16_t)blk);
+                        win_cnt = 0;
+                        nak_sent = 1;
                     }
                 }
                 break;
@@ -270,53 +585,59 @@ static void tftp_thread(void *arg)
                 else
                 {
                     uint16_t new_blk = lwip_ntohs(*(uint16_t *)(payload + 2));
+                    uint32_t acked;
 
-                    if(new_blk == (blk - 1))
+                    if(oack_pending)
                     {
-                        /* Last packet was lost */
-                        send_data(blk, data, MIN(remain, TFTP_BLOCK_LENGTH));
-                    }
-                    else if(new_blk == blk)
-                    {
-                        remain -= TFTP_BLOCK_LENGTH;
-                        if(remain < 0)  /* Still need to send a 0 data packet if remain is 0 */
-                        {
-                            /* All done */
-                            sysprintf("\nDone\n");
-                            state = TFTP_STATE_IDLE;
-                        }
-                        else
+                        /* ACK 0 accepts the options */
+                        if(new_blk == 0)
                         {
-                            blk++;
-                            data += TFTP_BLOCK_LENGTH;
-                            sysprintf(".");
-                            send_data(blk, data, MIN(remain, TFTP_BLOCK_LENGTH));
+                            oack_pending = 0;
+                            send_window();
                         }
+                        break;
+                    }
+
+                    /* Extend the 16-bit block number, it rolls over on large files */
+                    acked = (blk - 1) + (uint16_t)(new_blk - (uint16_t)(blk - 1));
+                    if(acked > blk_sent)
+                    {
+                        /* Stale ACK from before a rollback */
+                        break;
+                    }
+
+                    if(acked == blk_last)
+                    {
+                        /* All done */
+                        end_transfer(&state, 1);
                     }
                     else
                     {
-                        /* Wrong ack # */
-                        sysprintf("Unknown ID number\n");
-                        send_err(get_addr, get_port, TFTP_ERROR_UNKNOWN_ID);
-                        state = TFTP_STATE_IDLE;
+                        /* Continue after the acked block; the peer may have lost part of the window */
+                        blk = acked + 1;
+                        if(send_window() != 0)
+                        {
+                            send_err(get_addr, get_port, TFTP_ERROR_NOT_DEFINED);
+                            end_transfer(&state, 0);
+                        }
                     }
                 }
                 break;
             case TFTP_OPCODE_ERROR:
                 /* Reset to idle state iff this packet is from our client */
-                if((get_port == client_port) || !memcmp(get_addr, &client_addr, sizeof(ip_addr_t)))
+                if((state != TFTP_STATE_IDLE) && (get_port == client_port) && !memcmp(get_addr, &client_addr, sizeof(ip_addr_t)))
                 {
-                    state = TFTP_STATE_IDLE;
                     sysprintf("Received ERR: %d\n", lwip_ntohs(*(uint16_t *)(payload + 2)));
+                    end_transfer(&state, 0);
                 }
                 break;
             default:
                 /* Reset to idle state iff this packet is from our client */
-                if((get_port == client_port) || !memcmp(get_addr, &client_addr, sizeof(ip_addr_t)))
+                if((state != TFTP_STATE_IDLE) && (get_port == client_port) && !memcmp(get_addr, &client_addr, sizeof(ip_addr_t)))
                 {
                     sysprintf("Received unknown op code\n");
                     send_err(get_addr, get_port, TFTP_ERROR_ILLEGAL_OPERATION);
-                    state = TFTP_STATE_IDLE;
+                    end_transfer(&state, 0);
                 }
                 break;
         }
@@ -332,9 +653,5 @@ static void tftp_thread(void *arg)
   */
 void tftp_server_init(void)
 {
-    int i;
-
-    for(i = 0; i < FILE_LEN; i++)
-        file[i] = i & 0xFF;
     sys_thread_new("TFTP", tftp_thread, NULL, TFTP_THREAD_STACKSIZE, TFTP_THREAD_PRIO);
 }
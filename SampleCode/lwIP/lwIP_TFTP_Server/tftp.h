@@ -14,11 +14,23 @@
 #define TFTP_OPCODE_DATA        3
 #define TFTP_OPCODE_ACK         4
 #define TFTP_OPCODE_ERROR       5
+#define TFTP_OPCODE_OACK        6       // RFC 2347
 
 #define TFTP_PORT               69
 #define TFTP_TIMEOUT            500    //msec
 #define TFTP_MAX_RETRIES        5
-#define TFTP_BLOCK_LENGTH       512
+#define TFTP_BLOCK_LENGTH       512     // Default block size
+
+/* Negotiated options: blksize (RFC 2348), timeout/tsize (RFC 2349), windowsize (RFC 7440) */
+#define TFTP_MAX_BLKSIZE        1468    // Largest block fitting a 1500 byte MTU
+#define TFTP_MAX_WINDOWSIZE     8       // Keep below DEFAULT_UDP_RECVMBOX_SIZE
+
+/* File I/O buffer, a multiple of the sector size so FatFs transfers go directly to the card */
+#define TFTP_IO_BUF_SIZE        (32 * 1024)
+
+/* Served directory; request file names are relative to it and may not leave it */
+#define TFTP_ROOT_DIR           "1:/"
+#define TFTP_MAX_PATH           128
 
 enum tftp_error
 {
@@ -29,7 +41,8 @@ enum tftp_error
     TFTP_ERROR_ILLEGAL_OPERATION,   // 4
     TFTP_ERROR_UNKNOWN_ID,          // 5
     TFTP_ERROR_FILE_EXISTS,         // 6
-    TFTP_ERROR_NO_SUCH_USER         // 7
+    TFTP_ERROR_NO_SUCH_USER,        // 7
+    TFTP_ERROR_OPTION               // 8
 };
 
 enum tftp_state
@@ -0,0 +1,296 @@
+/**************************************************************************//**
+ * @file     main.c
+ *
+ * @brief    Demonstrate 802.1Q VLAN netifs with LwIP under FreeRTOS.
+ *           Besides the untagged interface 192.168.1.2, two VLAN interfaces
+ *           are added on the same EMAC: VLAN 10 (192.168.10.2) for control
+ *           traffic with priority 6 and VLAN 20 (192.168.20.2) for bulk
+ *           traffic with priority 0. The EMAC inserts the tags on transmit.
+ *           A UDP echo server listens to port 80 on all three interfaces.
+ *
+ * @note     TIMER11 has been assigned to FreeRTOS kernel.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+/* Nuvoton includes */
+#include "NuMicro.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+#include "semphr.h"
+
+/* lwIP includes */
+#include "lwipopts.h"
+#include "lwip/tcpip.h"
+#include "netif/ethernetif.h"
+#include "netif/vlanif.h"
+#include "udp_echoserver-netconn.h"
+#if (LWIP_DHCP == 1)
+#include "lwip/dhcp.h"
+#endif
+
+#define UDP_TASK_PRIORITY        ( tskIDLE_PRIORITY + 3UL )
+#define UDP_THREAD_STACKSIZE     ( 400 )
+
+/* Prototypes for the standard FreeRTOS callback/hook functions implemented
+within this file. */
+void vApplicationMallocFailedHook( void );
+void vApplicationIdleHook( void );
+void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName );
+void vApplicationTickHook( void );
+
+void vApplicationMallocFailedHook( void )
+{
+    /* Called if a call to pvPortMalloc() fails because there is insufficient
+    free memory available in the FreeRTOS heap.  pvPortMalloc() is called
+    internally by FreeRTOS API functions that create tasks, queues, software
+    timers, and semaphores.  The size of the FreeRTOS heap is set by the
+    configTOTAL_HEAP_SIZE configuration constant in FreeRTOSConfig.h. */
+    taskDISABLE_INTERRUPTS();
+    sysprintf( "ASSERT!  MallocFailed\r\n");
+    for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
+{
+    ( void ) pcTaskName;
+    ( void ) pxTask;
+
+    /* Run time stack overflow checking is performed if
+    configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2.  This hook
+    function is called if a stack overflow is detected. */
+    taskDISABLE_INTERRUPTS();
+    sysprintf( "ASSERT!  StackOverflow\r\n");
+    for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+    volatile size_t xFreeHeapSpace;
+
+    /* This is just a trivial example of an idle hook.  It is called on each
+    cycle of the idle task.  It must *NOT* attempt to block.  In this case the
+    idle task just queries the amount of FreeRTOS heap that remains.  See the
+    memory management section on the http://www.FreeRTOS.org web site for memory
+    management options.  If there is a lot of heap memory free then the
+    configTOTAL_HEAP_SIZE value in FreeRTOSConfig.h can be reduced to free up
+    RAM. */
+    xFreeHeapSpace = xPortGetFreeHeapSize();
+
+    /* Remove compiler warning about xFreeHeapSpace being set but never used. */
+    ( void ) xFreeHeapSpace;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+#if( mainSELECTED_APPLICATION == 1 )
+    {
+        /* Only the comprehensive demo actually uses the tick hook. */
+        extern void vFullDemoTickHook( void );
+        vFullDemoTickHook();
+    }
+#endif
+}
+/*-----------------------------------------------------------*/
+
+/* configUSE_STATIC_ALLOCATION is set to 1, so the application must provide an
+implementation of vApplicationGetIdleTaskMemory() to provide the memory that is
+used by the Idle task. */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize )
+{
+    /* If the buffers to be provided to the Idle task are declared inside this
+    function then they must be declared static - otherwise they will be allocated on
+    the stack and so not exists after this function exits. */
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t uxIdleTaskStack[ configMINIMAL_STACK_SIZE ];
+
+    /* Pass out a pointer to the StaticTask_t structure in which the Idle task's
+    state will be stored. */
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+
+    /* Pass out the array that will be used as the Idle task's stack. */
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+
+    /* Pass out the size of the array pointed to by *ppxIdleTaskStackBuffer.
+    Note that, as the array is necessarily of type StackType_t,
+    configMINIMAL_STACK_SIZE is specified in words, not bytes. */
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+/*-----------------------------------------------------------*/
+
+/* configUSE_STATIC_ALLOCATION and configUSE_TIMERS are both set to 1, so the
+application must provide an implementation of vApplicationGetTimerTaskMemory()
+to provide the memory that is used by the Timer service task. */
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize )
+{
+    /* If the buffers to be provided to the Timer task are declared inside this
+    function then they must be declared static - otherwise they will be allocated on
+    the stack and so not exists after this function exits. */
+    static StaticTask_t xTimerTaskTCB;
+    static StackType_t uxTimerTaskStack[ configTIMER_TASK_STACK_DEPTH ];
+
+    /* Pass out a pointer to the StaticTask_t structure in which the Timer
+    task's state will be stored. */
+    *ppxTimerTaskTCBBuffer = &xTimerTaskTCB;
+
+    /* Pass out the array that will be used as the Timer task's stack. */
+    *ppxTimerTaskStackBuffer = uxTimerTaskStack;
+
+    /* Pass out the size of the array pointed to by *ppxTimerTaskStackBuffer.
+    Note that, as the array is necessarily of type StackType_t,
+    configMINIMAL_STACK_SIZE is specified in words, not bytes. */
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vMainAssertCalled( const char *pcFileName, uint32_t ulLineNumber )
+{
+    sysprintf( "ASSERT!  Line %lu of file %s\r\n", ulLineNumber, pcFileName );
+    taskENTER_CRITICAL();
+    for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+void UART0_Init()
+{
+    /* Enable UART0 clock */
+    CLK_EnableModuleClock(UART0_MODULE);
+    CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL2_UART0SEL_HXT, CLK_CLKDIV1_UART0(1));
+
+    /* Set multi-function pins */
+    SYS->GPE_MFPH &= ~(SYS_GPE_MFPH_PE14MFP_Msk | SYS_GPE_MFPH_PE15MFP_Msk);
+    SYS->GPE_MFPH |= (SYS_GPE_MFPH_PE14MFP_UART0_TXD | SYS_GPE_MFPH_PE15MFP_UART0_RXD);
+
+    /* Init UART to 115200-8n1 for print message */
+    UART_Open(UART0, 115200);
+}
+
+void SYS_Init()
+{
+    /* Unlock protected registers */
+    SYS_UnlockReg();
+
+    /* Update System Core Clock */
+    /* User can use SystemCoreClockUpdate() to calculate SystemCoreClock. */
+    SystemCoreClockUpdate();
+
+    /* Init UART for sysprintf */
+    UART0_Init();
+
+    /* Configure EPLL = 500MHz */
+    CLK->PLL[EPLL].CTL0 = (6 << CLK_PLLnCTL0_INDIV_Pos) | (250 << CLK_PLLnCTL0_FBDIV_Pos); // M=6, N=250
+    CLK->PLL[EPLL].CTL1 = 2 << CLK_PLLnCTL1_OUTDIV_Pos; // EPLL divide by 2 and enable
+    CLK_WaitClockReady(CLK_STATUS_STABLE_EPLL);
+
+    /* DDR Init */
+    outp32(UMCTL2_BASE + 0x6a0, 0x01);
+
+    // Enable HWSEM clock
+    CLK_EnableModuleClock(HWS_MODULE);
+
+    // Reset HWSEM
+    SYS->IPRST0 = SYS_IPRST0_HWSEMRST_Msk;
+    SYS->IPRST0 = 0;
+
+    /* Lock protected registers */
+    SYS_LockReg();
+}
+
+static netif_init_fn ethernetif_init(int intf)
+{
+    netif_init_fn ethernetif_init;
+
+    if(intf == EMACINTF0)
+        ethernetif_init = ethernetif_init0;
+    else
+        ethernetif_init = ethernetif_init1;
+
+    return ethernetif_init;
+}
+
+struct netif netif;
+struct netif netif_ctrl;
+struct netif netif_bulk;
+
+static struct vlanif vlan_ctrl = { &netif, 10, 6, 0 };
+static struct vlanif vlan_bulk = { &netif, 20, 0, 0 };
+
+static void print_netif(const char *title, struct netif *nif)
+{
+    sysprintf("[ %s ] %c%c\n", title, nif->name[0], nif->name[1]);
+    sysprintf("IP address:      %s\n", ip4addr_ntoa(&nif->ip_addr));
+    sysprintf("Subnet mask:     %s\n", ip4addr_ntoa(&nif->netmask));
+    sysprintf("Default gateway: %s\n", ip4addr_ntoa(&nif->gw));
+}
+
+static void vUdpTask( void *pvParameters )
+{
+    ip_addr_t ipaddr;
+    ip_addr_t netmask;
+    ip_addr_t gw;
+
+    /* Remove compiler warning about unused parameter. */
+    ( void ) pvParameters;
+
+    IP4_ADDR(&gw, 192,168,1,1);
+    IP4_ADDR(&ipaddr, 192,168,1,2);
+    IP4_ADDR(&netmask, 255,255,255,0);
+
+    tcpip_init(NULL, NULL);
+
+    netif_add(&netif, &ipaddr, &netmask, &gw, NULL, ethernetif_init(EMAC_INTF), tcpip_input);
+
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+
+    /* VLAN netifs must be added after their parent */
+    IP4_ADDR(&gw, 192,168,10,1);
+    IP4_ADDR(&ipaddr, 192,168,10,2);
+    netif_add(&netif_ctrl, &ipaddr, &netmask, &gw, &vlan_ctrl, vlanif_init, tcpip_input);
+    netif_set_up(&netif_ctrl);
+
+    IP4_ADDR(&gw, 192,168,20,1);
+    IP4_ADDR(&ipaddr, 192,168,20,2);
+    netif_add(&netif_bulk, &ipaddr, &netmask, &gw, &vlan_bulk, vlanif_init, tcpip_input);
+    netif_set_up(&netif_bulk);
+
+    print_netif("Untagged", &netif);
+    print_netif("VLAN 10", &netif_ctrl);
+    print_netif("VLAN 20", &netif_bulk);
+
+    udp_echoserver_netconn_init();
+
+    vTaskSuspend( NULL );
+}
+
+/* main function */
+int main(void)
+{
+    SYS_Init();
+
+    global_timer_init();
+
+    sysprintf("\n\nCPU @ %d Hz\n", SystemCoreClock);
+    sysprintf("FreeRTOS is starting ...\n");
+
+    xTaskCreate( vUdpTask, "UdpTask", UDP_THREAD_STACKSIZE, NULL, UDP_TASK_PRIORITY, NULL );
+
+    /* Start the tasks and timer running. */
+    vTaskStartScheduler();
+
+    /* If all is well, the scheduler will now be running, and the following
+    line will never be reached.  If the following line does execute, then
+    there was either insufficient FreeRTOS heap memory available for the idle
+    and/or timer tasks to be created, or vTaskStartScheduler() was called from
+    User mode.  See the memory management section on the FreeRTOS web site for
+    more details on the FreeRTOS heap http://www.freertos.org/a00111.html.  The
+    mode from which main() is called is set in the C start up code and must be
+    a privileged mode (not user mode). */
+    for( ;; );
+}
@@ -0,0 +1,6 @@
+#ifndef __UDP_ECHOSERVER_NETCONN_H__
+#define __UDP_ECHOSERVER_NETCONN_H__
+
+void udp_echoserver_netconn_init(void);
+
+#endif /* __UDP_ECHOSERVER_NETCONN_H__ */
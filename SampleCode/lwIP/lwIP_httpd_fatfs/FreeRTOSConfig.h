@@ -0,0 +1,198 @@
+/*
+ * FreeRTOS V202212.01
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include "NuMicro.h"
+#include "netif/ma35h0_mac.h"
+
+/*-----------------------------------------------------------
+ * Application specific definitions.
+ *
+ * These definitions should be adjusted for your particular hardware and
+ * application requirements.
+ *
+ * THESE PARAMETERS ARE DESCRIBED WITHIN THE 'CONFIGURATION' SECTION OF THE
+ * FreeRTOS API DOCUMENTATION AVAILABLE ON THE FreeRTOS.org WEB SITE.
+ *
+ * See http://www.freertos.org/a00110.html.
+ *----------------------------------------------------------*/
+
+/*
+ * The FreeRTOS Cortex-A port implements a full interrupt nesting model.
+ *
+ * Interrupts that are assigned a priority at or below
+ * configMAX_API_CALL_INTERRUPT_PRIORITY (which counter-intuitively in the ARM
+ * generic interrupt controller [GIC] means a priority that has a numerical
+ * value above configMAX_API_CALL_INTERRUPT_PRIORITY) can call FreeRTOS safe API
+ * functions and will nest.
+ *
+ * Interrupts that are assigned a priority above
+ * configMAX_API_CALL_INTERRUPT_PRIORITY (which in the GIC means a numerical
+ * value below configMAX_API_CALL_INTERRUPT_PRIORITY) cannot call any FreeRTOS
+ * API functions, will nest, and will not be masked by FreeRTOS critical
+ * sections (although it is necessary for interrupts to be globally disabled
+ * extremely briefly as the interrupt mask is updated in the GIC).
+ *
+ * FreeRTOS functions that can be called from an interrupt are those that end in
+ * "FromISR".  FreeRTOS maintains a separate interrupt safe API to enable
+ * interrupt entry to be shorter, faster, simpler and smaller.
+ *
+ * For the purpose of setting configMAX_API_CALL_INTERRUPT_PRIORITY 255
+ * represents the lowest priority.
+ */
+extern uint32_t SystemCoreClock;
+
+#define FIXED_TO(x)                             x
+
+#define configMAX_API_CALL_INTERRUPT_PRIORITY	18
+
+#define configCPU_CLOCK_HZ                      ( SystemCoreClock )
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	1
+#define configUSE_TICKLESS_IDLE					0
+#define configTICK_RATE_HZ                      ( ( TickType_t ) 1000 )
+#define configUSE_PREEMPTION                    1
+#define configUSE_IDLE_HOOK                     1
+#define configUSE_TICK_HOOK                     1
+#define configMAX_PRIORITIES                    ( 8 )
+#define configMINIMAL_STACK_SIZE                ( ( unsigned short ) 200)
+#define configTOTAL_HEAP_SIZE                   ( ( size_t ) ( 128 * 1024 ) )
+#define configMAX_TASK_NAME_LEN                 ( 16 )
+
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_16_BIT_TICKS                  FIXED_TO(0)
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_MUTEXES                       FIXED_TO(1)
+#define configQUEUE_REGISTRY_SIZE               8
+
+#define configCHECK_FOR_STACK_OVERFLOW          2
+
+#define configUSE_RECURSIVE_MUTEXES             FIXED_TO(1)
+#define configUSE_MALLOC_FAILED_HOOK            1
+#define configUSE_APPLICATION_TASK_TAG          0
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configUSE_QUEUE_SETS                    1
+
+#define configSUPPORT_STATIC_ALLOCATION			1
+#define configSUPPORT_DYNAMIC_ALLOCATION		FIXED_TO(1)
+
+/* Set the following definitions to 1 if you would like to place a critical
+section in interrupt. This will use HWSEM channel 0 to implement a spinlock. */
+#define configCritical_Section_In_Int           0
+
+/* Software timer definitions. */
+#define configUSE_TIMERS                        FIXED_TO(1)
+#define configTIMER_TASK_PRIORITY               ( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH                5
+#define configTIMER_TASK_STACK_DEPTH            ( configMINIMAL_STACK_SIZE * 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet				1
+#define INCLUDE_uxTaskPriorityGet				1
+#define INCLUDE_vTaskDelete						1
+#define INCLUDE_vTaskCleanUpResources			1
+#define INCLUDE_vTaskSuspend					1
+#define INCLUDE_vTaskDelayUntil					1
+#define INCLUDE_vTaskDelay						1
+#define INCLUDE_xTimerPendFunctionCall			1
+#define INCLUDE_eTaskGetState					1
+#define INCLUDE_xTaskAbortDelay					1
+#define INCLUDE_xTaskGetHandle					1
+#define INCLUDE_xSemaphoreGetMutexHolder		1
+
+/* This demo makes use of one or more example stats formatting functions.  These
+format the raw data provided by the uxTaskGetSystemState() function in to human
+readable ASCII form.  See the notes in the implementation of vTaskList() within
+FreeRTOS/Source/tasks.c for limitations. */
+#define configUSE_STATS_FORMATTING_FUNCTIONS	0
+
+/* Run time stats are not generated.  portCONFIGURE_TIMER_FOR_RUN_TIME_STATS and
+portGET_RUN_TIME_COUNTER_VALUE must be defined if configGENERATE_RUN_TIME_STATS
+is set to 1. */
+#define configGENERATE_RUN_TIME_STATS           0
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()
+
+/* The size of the global output buffer that is available for use when there
+are multiple command interpreters running at once (for example, one on a UART
+and one on TCP/IP).  This is done to prevent an output buffer being defined by
+each implementation - which would waste RAM.  In this case, there is only one
+command interpreter running. */
+#define configCOMMAND_INT_MAX_OUTPUT_SIZE       2096
+
+/* Normal assert() semantics without relying on the provision of an assert.h
+header file. */
+void vMainAssertCalled( const char *pcFileName, uint32_t ulLineNumber );
+#ifndef GLOBAL_NOASSERT
+    #define configASSERT( x ) if( ( x ) == 0 ) { vMainAssertCalled( __FILE__, __LINE__ ); }
+#else
+    #define configASSERT( x ) x
+#endif
+
+/* If configTASK_RETURN_ADDRESS is not defined then a task that attempts to
+return from its implementing function will end up in a "task exit error"
+function - which contains a call to configASSERT().  However this can give GCC
+some problems when it tries to unwind the stack, as the exit error function has
+nothing to return to.  To avoid this define configTASK_RETURN_ADDRESS to 0.  */
+#define configTASK_RETURN_ADDRESS	NULL
+
+/* Bump up the priority of recmuCONTROLLING_TASK_PRIORITY to prevent false
+positive errors being reported considering the priority of other tasks in the
+system. */
+#define recmuCONTROLLING_TASK_PRIORITY ( configMAX_PRIORITIES - 2 )
+
+/* The highest interrupt priority that can be used by any interrupt service
+routine that makes calls to interrupt safe FreeRTOS API functions.  DO NOT CALL
+INTERRUPT SAFE FREERTOS API FUNCTIONS FROM ANY INTERRUPT THAT HAS A HIGHER
+PRIORITY THAN THIS! (higher priorities are lower numeric values. */
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY    configMAX_API_CALL_INTERRUPT_PRIORITY
+
+/****** Hardware specific settings. *******************************************/
+
+/*
+ * The application must provide a function that configures a peripheral to
+ * create the FreeRTOS tick interrupt, then define configSETUP_TICK_INTERRUPT()
+ * in FreeRTOSConfig.h to call the function.  This file contains a function
+ * that is suitable for use on the Zynq MPU.  FreeRTOS_Tick_Handler() must
+ * be installed as the peripheral's interrupt handler.
+ */
+void vConfigureTickInterrupt( void );
+#define configSETUP_TICK_INTERRUPT() vConfigureTickInterrupt()
+
+void vClearTickInterrupt( void );
+#define configCLEAR_TICK_INTERRUPT() vClearTickInterrupt()
+
+/* The following constant describe the hardware, and are correct for the
+Nuvoton MA35H0 MPU. */
+#define configINTERRUPT_CONTROLLER_BASE_ADDRESS 		( GIC_DISTRIBUTOR_BASE )
+#define configINTERRUPT_CONTROLLER_CPU_INTERFACE_OFFSET ( GIC_INTERFACE_BASE - GIC_DISTRIBUTOR_BASE )
+#define configUNIQUE_INTERRUPT_PRIORITIES				32
+
+
+#endif /* FREERTOS_CONFIG_H */
+
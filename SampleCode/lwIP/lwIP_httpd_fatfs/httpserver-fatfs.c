@@ -0,0 +1,677 @@
+/**************************************************************************//**
+ * @file     httpserver-fatfs.c
+ * @brief    Netconn HTTP/1.1 server streaming files from FatFs.
+ *
+ *           File data is read into a pool of cache line aligned buffers
+ *           and handed to TCP with NETCONN_NOCOPY, so each byte is copied
+ *           only once on its way out (by the EMAC port into the DMA
+ *           buffer). A buffer returns to the pool from the netconn event
+ *           callback once the peer has acknowledged all of its data.
+ *           Byte ranges and persistent connections are supported.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lwip/opt.h"
+#include "lwip/arch.h"
+#include "lwip/api.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+#include "lwip/sys.h"
+#include "ff.h"
+#include "httpserver-fatfs.h"
+
+/* Private typedef -----------------------------------------------------------*/
+struct http_buf
+{
+    struct http_buf *next;
+    struct netconn *owner;      /* Connection whose TCP queue references data */
+    u32_t end_seq;              /* Sequence number following the last byte   */
+    u8_t *data;
+};
+
+struct http_worker
+{
+    struct netconn *conn;
+    u32_t seq;                  /* Next sequence number we will write        */
+    u16_t req_len;
+    char req[1024];
+    char hdr[320];
+    char path[128];
+    FIL fil;
+};
+
+/* Private define ------------------------------------------------------------*/
+#define WEBSERVER_THREAD_PRIO       ( tskIDLE_PRIORITY + 2UL )
+#define WEBSERVER_THREAD_STACKSIZE  400
+#define WEBWORKER_THREAD_STACKSIZE  800
+
+#define HTTP_SEQ_GEQ(a, b)          ((s32_t)((u32_t)(a) - (u32_t)(b)) >= 0)
+
+/* Private variables ---------------------------------------------------------*/
+static u8_t http_buf_pool[HTTPD_BUF_NUM][HTTPD_BUF_SIZE] __attribute__((aligned(64)));
+static struct http_buf http_bufs[HTTPD_BUF_NUM];
+static struct http_buf *http_free;
+static struct http_buf *http_inflight;
+static sys_sem_t http_buf_sem;
+
+static sys_mutex_t http_fs_mutex;   /* FatFs is built without FF_FS_REENTRANT */
+static sys_mbox_t http_conn_mbox;
+static struct http_worker http_workers[HTTPD_MAX_CONN];
+
+static const struct
+{
+    const char *ext;
+    const char *type;
+} http_mime[] =
+{
+    { "htm",  "text/html" },
+    { "html", "text/html" },
+    { "css",  "text/css" },
+    { "js",   "application/javascript" },
+    { "json", "application/json" },
+    { "txt",  "text/plain" },
+    { "xml",  "text/xml" },
+    { "jpg",  "image/jpeg" },
+    { "png",  "image/png" },
+    { "gif",  "image/gif" },
+    { "ico",  "image/x-icon" },
+    { "svg",  "image/svg+xml" },
+    { "wav",  "audio/wav" },
+    { "mp3",  "audio/mpeg" },
+    { "mp4",  "video/mp4" },
+    { "264",  "video/h264" },
+    { "pdf",  "application/pdf" },
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Return buffers whose data has been acknowledged to the pool
+  * @param  conn: connection the buffers belong to
+  * @param  all: 1 to return every buffer of conn regardless of the ack state
+  * @retval Number of buffers returned
+  */
+static int http_buf_reclaim(struct netconn *conn, int all)
+{
+    struct http_buf **pp, *hb;
+    int n = 0;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    for(pp = &http_inflight; (hb = *pp) != NULL;)
+    {
+        if((hb->owner == conn) &&
+           (all || HTTP_SEQ_GEQ(conn->pcb.tcp->lastack, hb->end_seq)))
+        {
+            *pp = hb->next;
+            hb->owner = NULL;
+            hb->next = http_free;
+            http_free = hb;
+            n++;
+        }
+        else
+            pp = &hb->next;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+
+    if(n)
+        sys_sem_signal(&http_buf_sem);
+
+    return n;
+}
+
+/**
+  * @brief  Netconn event callback, runs in the tcpip thread
+  * @note   SENDPLUS is raised when acked data frees send buffer space, and
+  *         with a NULL pcb when the connection is reset or aborted; in both
+  *         cases TCP no longer references the released buffers.
+  */
+static void http_netconn_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
+{
+    LWIP_UNUSED_ARG(len);
+
+    if(evt != NETCONN_EVT_SENDPLUS)
+        return;
+
+    http_buf_reclaim(conn, conn->pcb.tcp == NULL);
+}
+
+static struct http_buf *http_buf_alloc(void)
+{
+    struct http_buf *hb;
+    u32_t start = sys_now();
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    for(;;)
+    {
+        SYS_ARCH_PROTECT(lev);
+        hb = http_free;
+        if(hb != NULL)
+            http_free = hb->next;
+        SYS_ARCH_UNPROTECT(lev);
+
+        if(hb != NULL)
+            return hb;
+
+        if((sys_now() - start) > HTTPD_TX_TIMEOUT)
+            return NULL;
+
+        /* Binary semaphore, so re-check the free list periodically */
+        sys_arch_sem_wait(&http_buf_sem, 100);
+    }
+}
+
+/* Queue a buffer as referenced by TCP up to end_seq */
+static void http_buf_queue(struct http_buf *hb, struct netconn *conn, u32_t end_seq)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    hb->owner = conn;
+    hb->end_seq = end_seq;
+
+    SYS_ARCH_PROTECT(lev);
+    hb->next = http_inflight;
+    http_inflight = hb;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+static void http_buf_free(struct http_buf *hb)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    hb->next = http_free;
+    http_free = hb;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+static int http_buf_busy(struct netconn *conn)
+{
+    struct http_buf *hb;
+    int n = 0;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    for(hb = http_inflight; hb != NULL; hb = hb->next)
+        if(hb->owner == conn)
+            n++;
+    SYS_ARCH_UNPROTECT(lev);
+
+    return n;
+}
+
+/* Drop the connection at once so TCP frees every segment referencing our buffers */
+static void http_conn_abort(struct netconn *conn)
+{
+    LOCK_TCPIP_CORE();
+    if(conn->pcb.tcp != NULL)
+        tcp_abort(conn->pcb.tcp);
+    UNLOCK_TCPIP_CORE();
+
+    http_buf_reclaim(conn, 1);
+}
+
+/**
+  * @brief  Write through the copying path and account the sequence space
+  */
+static err_t http_write_copy(struct http_worker *w, const void *data, size_t len, u8_t more)
+{
+    err_t err;
+
+    err = netconn_write(w->conn, data, len, NETCONN_COPY | (more ? NETCONN_MORE : 0));
+    if(err == ERR_OK)
+        w->seq += len;
+
+    return err;
+}
+
+/* Value of request header 'name' (e.g. "Range:"), NULL if absent */
+static const char *http_header(const char *req, const char *name)
+{
+    size_t n = strlen(name);
+    const char *p = strstr(req, "\r\n");
+
+    while((p != NULL) && (p[2] != '\r'))
+    {
+        p += 2;
+        if(lwip_strnicmp(p, name, n) == 0)
+        {
+            p += n;
+            while(*p == ' ')
+                p++;
+            return p;
+        }
+        p = strstr(p, "\r\n");
+    }
+
+    return NULL;
+}
+
+/**
+  * @brief  Parse a single "bytes=" range
+  * @retval 1 range set, 0 serve the whole file, -1 unsatisfiable
+  */
+static int http_parse_range(const char *v, FSIZE_t size, FSIZE_t *start, FSIZE_t *end)
+{
+    const char *eol = strstr(v, "\r\n");
+    char *p;
+    unsigned long a, b;
+
+    if(strncmp(v, "bytes=", 6) != 0)
+        return 0;
+    v += 6;
+
+    /* Multiple ranges are not supported; RFC 7233 allows a full response */
+    p = strchr(v, ',');
+    if((p != NULL) && (p < eol))
+        return 0;
+
+    if(*v == '-')
+    {
+        b = strtoul(v + 1, &p, 10);
+        if((p == v + 1) || (b == 0) || (size == 0))
+            return -1;
+        *start = (b < size) ? (size - b) : 0;
+        *end = size - 1;
+        return 1;
+    }
+
+    a = strtoul(v, &p, 10);
+    if((p == v) || (*p != '-'))
+        return 0;
+    v = p + 1;
+    b = strtoul(v, &p, 10);
+    if((p == v) || (b >= size))
+        b = size - 1;
+
+    if((size == 0) || (a >= size) || (a > b))
+        return -1;
+
+    *start = a;
+    *end = b;
+    return 1;
+}
+
+static const char *http_mime_type(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    size_t i;
+
+    if(ext != NULL)
+    {
+        ext++;
+        for(i = 0; i < sizeof(http_mime) / sizeof(http_mime[0]); i++)
+            if(lwip_stricmp(ext, http_mime[i].ext) == 0)
+                return http_mime[i].type;
+    }
+
+    return "application/octet-stream";
+}
+
+static err_t http_send_error(struct http_worker *w, const char *status, u8_t keep)
+{
+    int n;
+
+    n = snprintf(w->hdr, sizeof(w->hdr),
+                 "HTTP/1.1 %s\r\n"
+                 "Server: lwIP/MA35H0\r\n"
+                 "Content-Type: text/html\r\n"
+                 "Content-Length: %u\r\n"
+                 "Connection: %s\r\n"
+                 "\r\n"
+                 "<html><body><h1>%s</h1></body></html>",
+                 status, (unsigned)(strlen(status) + 35), keep ? "keep-alive" : "close", status);
+
+    return http_write_copy(w, w->hdr, n, 0);
+}
+
+/**
+  * @brief  Stream bytes [start, end] of the open file with NETCONN_NOCOPY
+  */
+static err_t http_send_body(struct http_worker *w, FSIZE_t start, FSIZE_t end)
+{
+    struct http_buf *hb;
+    FSIZE_t remain = end - start + 1;
+    UINT chunk, br;
+    FRESULT res;
+    err_t err;
+
+    sys_mutex_lock(&http_fs_mutex);
+    res = f_lseek(&w->fil, start);
+    sys_mutex_unlock(&http_fs_mutex);
+    if(res != FR_OK)
+        return ERR_VAL;
+
+    /* A short first read brings the file pointer to a sector boundary, so
+       the following reads go from the card straight into the buffers */
+    chunk = HTTPD_BUF_SIZE - (UINT)(start % 512);
+
+    while(remain > 0)
+    {
+        if(chunk > remain)
+            chunk = (UINT)remain;
+
+        hb = http_buf_alloc();
+        if(hb == NULL)
+            return ERR_TIMEOUT;
+
+        sys_mutex_lock(&http_fs_mutex);
+        res = f_read(&w->fil, hb->data, chunk, &br);
+        sys_mutex_unlock(&http_fs_mutex);
+        if((res != FR_OK) || (br == 0))
+        {
+            http_buf_free(hb);
+            return ERR_VAL;
+        }
+
+        remain -= br;
+
+        /* Queue before writing: the ack may arrive before netconn_write returns */
+        http_buf_queue(hb, w->conn, w->seq + br);
+        err = netconn_write(w->conn, hb->data, br, NETCONN_NOCOPY | (remain ? NETCONN_MORE : 0));
+        if(err != ERR_OK)
+            return err;
+        w->seq += br;
+
+        chunk = HTTPD_BUF_SIZE;
+    }
+
+    return ERR_OK;
+}
+
+/**
+  * @brief  Read one request header block into w->req
+  * @retval Length of the header block including the empty line, 0 on error
+  */
+static u16_t http_recv_request(struct http_worker *w)
+{
+    struct netbuf *inbuf;
+    char *eoh;
+    u16_t n;
+
+    for(;;)
+    {
+        w->req[w->req_len] = '\0';
+        eoh = strstr(w->req, "\r\n\r\n");
+        if(eoh != NULL)
+            return (u16_t)(eoh + 4 - w->req);
+
+        if(w->req_len >= sizeof(w->req) - 1)
+            return 0;
+
+        if(netconn_recv(w->conn, &inbuf) != ERR_OK)
+            return 0;
+
+        n = netbuf_copy(inbuf, &w->req[w->req_len], sizeof(w->req) - 1 - w->req_len);
+        w->req_len += n;
+        netbuf_delete(inbuf);
+    }
+}
+
+/**
+  * @brief  Serve one request
+  * @retval 1 keep the connection, 0 close it, -1 abort it
+  */
+static int http_serve_request(struct http_worker *w)
+{
+    char *method, *uri, *version, *p;
+    const char *v;
+    u16_t len;
+    u8_t keep, head;
+    FSIZE_t size, start, end;
+    FRESULT res;
+    int range, n;
+    err_t err;
+
+    len = http_recv_request(w);
+    if(len == 0)
+        return 0;
+
+    /* Request line: METHOD URI VERSION */
+    method = w->req;
+    uri = strchr(method, ' ');
+    version = (uri != NULL) ? strchr(uri + 1, ' ') : NULL;
+    if(version == NULL)
+    {
+        err = http_send_error(w, "400 Bad Request", 0);
+        return (err == ERR_OK) ? 0 : -1;
+    }
+    *uri++ = '\0';
+    *version++ = '\0';
+
+    if(strncmp(version, "HTTP/1.0", 8) == 0)
+        keep = 0;
+    else
+        keep = 1;
+    v = http_header(version, "Connection:");
+    if(v != NULL)
+    {
+        if(lwip_strnicmp(v, "close", 5) == 0)
+            keep = 0;
+        else if(lwip_strnicmp(v, "keep-alive", 10) == 0)
+            keep = 1;
+    }
+
+    head = (strcmp(method, "HEAD") == 0);
+    if(!head && (strcmp(method, "GET") != 0))
+    {
+        err = http_send_error(w, "501 Not Implemented", 0);
+        return (err == ERR_OK) ? 0 : -1;
+    }
+
+    p = strchr(uri, '?');
+    if(p != NULL)
+        *p = '\0';
+    if(strcmp(uri, "/") == 0)
+        uri = "/index.html";
+
+    if((uri[0] != '/') || (strstr(uri, "..") != NULL) ||
+       (strlen(HTTPD_ROOT) + strlen(uri) >= sizeof(w->path)))
+    {
+        err = http_send_error(w, "400 Bad Request", 0);
+        return (err == ERR_OK) ? 0 : -1;
+    }
+    strcpy(w->path, HTTPD_ROOT);
+    strcat(w->path, uri);
+
+    sys_mutex_lock(&http_fs_mutex);
+    res = f_open(&w->fil, w->path, FA_READ);
+    sys_mutex_unlock(&http_fs_mutex);
+    if(res != FR_OK)
+    {
+        err = http_send_error(w, "404 Not Found", keep);
+        goto done;
+    }
+
+    size = f_size(&w->fil);
+    start = 0;
+    end = size - 1;
+    range = 0;
+    v = http_header(version, "Range:");
+    if(v != NULL)
+        range = http_parse_range(v, size, &start, &end);
+
+    if(range < 0)
+    {
+        n = snprintf(w->hdr, sizeof(w->hdr),
+                     "HTTP/1.1 416 Range Not Satisfiable\r\n"
+                     "Server: lwIP/MA35H0\r\n"
+                     "Content-Range: bytes */%lu\r\n"
+                     "Content-Length: 0\r\n"
+                     "Connection: %s\r\n"
+                     "\r\n",
+                     (unsigned long)size, keep ? "keep-alive" : "close");
+        err = http_write_copy(w, w->hdr, n, 0);
+    }
+    else
+    {
+        n = snprintf(w->hdr, sizeof(w->hdr),
+                     "HTTP/1.1 %s\r\n"
+                     "Server: lwIP/MA35H0\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Length: %lu\r\n"
+                     "Accept-Ranges: bytes\r\n",
+                     range ? "206 Partial Content" : "200 OK",
+                     http_mime_type(w->path), (unsigned long)(size ? (end - start + 1) : 0));
+        if(range)
+            n += snprintf(&w->hdr[n], sizeof(w->hdr) - n, "Content-Range: bytes %lu-%lu/%lu\r\n",
+                          (unsigned long)start, (unsigned long)end, (unsigned long)size);
+        n += snprintf(&w->hdr[n], sizeof(w->hdr) - n, "Connection: %s\r\n\r\n",
+                      keep ? "keep-alive" : "close");
+
+        err = http_write_copy(w, w->hdr, n, (!head && size));
+        if((err == ERR_OK) && !head && size)
+            err = http_send_body(w, start, end);
+    }
+
+    sys_mutex_lock(&http_fs_mutex);
+    f_close(&w->fil);
+    sys_mutex_unlock(&http_fs_mutex);
+
+done:
+    /* Keep any pipelined bytes that followed this request */
+    w->req_len -= len;
+    memmove(w->req, &w->req[len], w->req_len);
+
+    if(err != ERR_OK)
+        return -1;
+
+    return keep;
+}
+
+/**
+  * @brief  Worker thread, serves connections posted by the listener
+  * @param  arg: pointer to the worker context
+  * @retval None
+  */
+static void http_worker_thread(void *arg)
+{
+    struct http_worker *w = (struct http_worker *)arg;
+    void *msg;
+    u32_t start;
+    int ret;
+
+    for(;;)
+    {
+        sys_arch_mbox_fetch(&http_conn_mbox, &msg, 0);
+        w->conn = (struct netconn *)msg;
+        w->req_len = 0;
+
+        netconn_set_recvtimeout(w->conn, HTTPD_KEEPALIVE_TIMEOUT);
+
+        LOCK_TCPIP_CORE();
+        ret = (w->conn->pcb.tcp != NULL) ? 1 : -1;
+        if(ret > 0)
+            w->seq = w->conn->pcb.tcp->snd_lbb;
+        UNLOCK_TCPIP_CORE();
+
+        while(ret > 0)
+            ret = http_serve_request(w);
+
+        if(ret == 0)
+        {
+            /* TCP may still hold references to our buffers: wait for the
+               peer to ack everything before closing, else drop the link */
+            start = sys_now();
+            while(http_buf_busy(w->conn))
+            {
+                if((sys_now() - start) > HTTPD_TX_TIMEOUT)
+                {
+                    ret = -1;
+                    break;
+                }
+                sys_msleep(10);
+            }
+        }
+
+        if(ret < 0)
+            http_conn_abort(w->conn);
+        else
+            netconn_close(w->conn);
+
+        netconn_delete(w->conn);
+        w->conn = NULL;
+    }
+}
+
+/**
+  * @brief  http server thread, accepts connections for the workers
+  * @param arg: pointer on argument(not used here)
+  * @retval None
+  */
+static void http_server_fatfs_thread(void *arg)
+{
+    struct netconn *conn, *newconn;
+    err_t err;
+
+    /* Accepted connections inherit the callback that releases our buffers */
+    conn = netconn_new_with_callback(NETCONN_TCP, http_netconn_callback);
+
+    if (conn!= NULL)
+    {
+        /* Bind to port 80 (HTTP) with default IP address */
+        err = netconn_bind(conn, NULL, 80);
+
+        if (err == ERR_OK)
+        {
+            /* Put the connection into LISTEN state */
+            netconn_listen(conn);
+
+            while(1)
+            {
+                /* accept any incoming connection */
+                if(netconn_accept(conn, &newconn) != ERR_OK)
+                    continue;
+
+                if(sys_mbox_trypost(&http_conn_mbox, newconn) != ERR_OK)
+                {
+                    /* All workers busy and the backlog is full */
+                    netconn_close(newconn);
+                    netconn_delete(newconn);
+                }
+            }
+        }
+        else
+        {
+            sysprintf("can not bind netconn");
+        }
+    }
+    else
+    {
+        sysprintf("can not create netconn");
+    }
+}
+
+/**
+  * @brief  Initialize the HTTP server (start its threads)
+  * @param  none
+  * @retval None
+  */
+void http_server_fatfs_init()
+{
+    int i;
+
+    for(i = 0; i < HTTPD_BUF_NUM; i++)
+    {
+        http_bufs[i].data = http_buf_pool[i];
+        http_buf_free(&http_bufs[i]);
+    }
+
+    if((sys_sem_new(&http_buf_sem, 0) != ERR_OK) ||
+       (sys_mutex_new(&http_fs_mutex) != ERR_OK) ||
+       (sys_mbox_new(&http_conn_mbox, HTTPD_MAX_CONN * 2) != ERR_OK))
+    {
+        sysprintf("httpd: out of memory\n");
+        return;
+    }
+
+    for(i = 0; i < HTTPD_MAX_CONN; i++)
+        sys_thread_new("HTTPW", http_worker_thread, &http_workers[i], WEBWORKER_THREAD_STACKSIZE, WEBSERVER_THREAD_PRIO);
+
+    sys_thread_new("HTTP", http_server_fatfs_thread, NULL, WEBSERVER_THREAD_STACKSIZE, WEBSERVER_THREAD_PRIO);
+}
@@ -0,0 +1,31 @@
+/**************************************************************************//**
+ * @file     httpserver-fatfs.h
+ * @brief    Netconn HTTP server streaming files from FatFs
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __HTTPSERVER_FATFS_H__
+#define __HTTPSERVER_FATFS_H__
+
+/* Directory served as the document root, e.g. "1:/www" */
+#ifndef HTTPD_ROOT
+#define HTTPD_ROOT                  "/www"
+#endif
+
+/* Read buffers handed to TCP with NETCONN_NOCOPY, size is a multiple of 512 */
+#ifndef HTTPD_BUF_NUM
+#define HTTPD_BUF_NUM               8
+#endif
+#ifndef HTTPD_BUF_SIZE
+#define HTTPD_BUF_SIZE              (16 * 1024)
+#endif
+
+#ifndef HTTPD_MAX_CONN
+#define HTTPD_MAX_CONN              2       /* Connections served concurrently */
+#endif
+#define HTTPD_KEEPALIVE_TIMEOUT     5000    /* ms an idle keep-alive connection is held */
+#define HTTPD_TX_TIMEOUT            10000   /* ms to wait for the peer to ack our buffers */
+
+void http_server_fatfs_init(void);
+
+#endif /* __HTTPSERVER_FATFS_H__ */
@@ -68,6 +68,12 @@
 #define TCP_MSS                         1460
 #define SSIZE_MAX                       65535
 
+/* 0: small demo footprint, 1: high-throughput profile (port/include/lwipopts_throughput.h) */
+#define LWIP_THROUGHPUT_PROFILE         0
+
+#if (LWIP_THROUGHPUT_PROFILE == 1)
+#include "lwipopts_throughput.h"
+#else
 #define MEMP_NUM_NETCONN                8
 #define MEM_SIZE                        10240
 #define MEMP_NUM_PBUF                   32
@@ -76,15 +82,16 @@
 #define TCP_SND_BUF                     8192
 #define TCP_SND_QUEUELEN                (4 * TCP_SND_BUF/TCP_MSS)
 #define MEMP_NUM_TCP_SEG                64
-
-/* Application */
-#define TCPIP_THREAD_STACKSIZE          400
-#define TCPIP_THREAD_PRIO               2
 #define TCPIP_MBOX_SIZE                 10
 #define DEFAULT_TCP_RECVMBOX_SIZE       5
 #define DEFAULT_ACCEPTMBOX_SIZE         5
 #define DEFAULT_UDP_RECVMBOX_SIZE       5
 #define DEFAULT_RAW_RECVMBOX_SIZE       5
+#endif
+
+/* Application */
+#define TCPIP_THREAD_STACKSIZE          400
+#define TCPIP_THREAD_PRIO               2
 
 #define LWIP_USING_HW_CHECKSUM          0
 /* ---------- Checksum options ---------- */
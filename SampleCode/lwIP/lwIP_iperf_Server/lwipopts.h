@@ -53,6 +53,9 @@
 #define LWIP_SOCKET                     0
 #define LWIP_PROVIDE_ERRNO              1
 
+/* Set to 1 to time the packet path (see port/include/arch/perf.h) */
+#define LWIP_PERF                       0
+
 #ifdef GLOBAL_NOASSERT
     #define LWIP_NOASSERT
 #endif
@@ -61,6 +64,12 @@
 #define TCP_MSS                         1460
 #define SSIZE_MAX                       65535
 
+/* 0: small demo footprint, 1: high-throughput profile (port/include/lwipopts_throughput.h) */
+#define LWIP_THROUGHPUT_PROFILE         0
+
+#if (LWIP_THROUGHPUT_PROFILE == 1)
+#include "lwipopts_throughput.h"
+#else
 #define MEMP_NUM_NETCONN                8
 #define MEM_SIZE                        1600
 #define MEMP_NUM_PBUF                   32
@@ -69,15 +78,16 @@
 #define TCP_SND_BUF                     8192
 #define TCP_SND_QUEUELEN                (4 * TCP_SND_BUF/TCP_MSS)
 #define MEMP_NUM_TCP_SEG                64
-
-/* Application */
-#define TCPIP_THREAD_STACKSIZE          400
-#define TCPIP_THREAD_PRIO               2
 #define TCPIP_MBOX_SIZE                 10
 #define DEFAULT_TCP_RECVMBOX_SIZE       5
 #define DEFAULT_ACCEPTMBOX_SIZE         5
 #define DEFAULT_UDP_RECVMBOX_SIZE       5
 #define DEFAULT_RAW_RECVMBOX_SIZE       5
+#endif
+
+/* Application */
+#define TCPIP_THREAD_STACKSIZE          400
+#define TCPIP_THREAD_PRIO               2
 #define LWIP_SO_RCVTIMEO                1
 
 #define LWIP_USING_HW_CHECKSUM          1
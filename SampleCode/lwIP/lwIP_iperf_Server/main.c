@@ -215,6 +215,24 @@ static netif_init_fn ethernetif_init(int intf)
     return ethernetif_init;
 }
 
+static void lwiperf_report(void *arg, enum lwiperf_report_type report_type,
+                           const ip_addr_t *local_addr, u16_t local_port,
+                           const ip_addr_t *remote_addr, u16_t remote_port,
+                           u32_t bytes_transferred, u32_t ms_duration, u32_t bandwidth_kbitpsec)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(local_addr);
+    LWIP_UNUSED_ARG(local_port);
+
+    sysprintf("iperf report: type=%d, remote %s:%d\n", report_type, ipaddr_ntoa(remote_addr), remote_port);
+    sysprintf("  %u bytes in %u ms, %u kbits/s\n", bytes_transferred, ms_duration, bandwidth_kbitpsec);
+#if LWIP_PERF
+    /* Per-packet cost of the EMAC port and lwIP core during this run */
+    perf_dump();
+    perf_reset();
+#endif
+}
+
 static void vTcpTask( void *pvParameters )
 {
     ip_addr_t ipaddr;
@@ -235,9 +253,9 @@ static void vTcpTask( void *pvParameters )
     netif_set_default(&netif);
     netif_set_up(&netif);
 #ifdef IWIPERF_CLIENT_MODE
-    lwiperf_start_tcp_client_default(&server_ip, NULL, NULL);
+    lwiperf_start_tcp_client_default(&server_ip, lwiperf_report, NULL);
 #else
-    lwiperf_start_tcp_server_default(NULL, NULL);
+    lwiperf_start_tcp_server_default(lwiperf_report, NULL);
 #endif
 
     vTaskSuspend( NULL );
@@ -0,0 +1,842 @@
+/**************************************************************************//**
+ * @file     aes_alt.c
+ * @brief    mbedTLS MBEDTLS_AES_ALT on the CRYPTO AES engine. Requests of
+ *           CRYPTO_ALT_AES_DMA_MIN bytes and up are run by the engine through
+ *           DMA; single blocks and short requests use the software AES below.
+ *           Cache line aligned requests are queued on crypto_job.c, the
+ *           others are copied through the shared bounce buffers.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "common.h"
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_AES_ALT)
+
+#include "mbedtls/aes.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include "NuMicro.h"
+#include "crypto_alt.h"
+#if CRYPTO_ALT_AES_JOB
+#include "crypto_job.h"
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Software AES, tables are generated on first use                           */
+/*---------------------------------------------------------------------------*/
+
+static uint8_t FSb[256];
+static uint8_t RSb[256];
+static uint32_t FT0[256];
+static uint32_t RT0[256];
+static uint32_t RCON[10];
+static volatile int aes_init_done;
+
+#define ROTL8(x)    (((x) << 8) | ((x) >> 24))
+#define ROTL16(x)   (((x) << 16) | ((x) >> 16))
+#define ROTL24(x)   (((x) << 24) | ((x) >> 8))
+
+#define FT1(i)      ROTL8(FT0[i])
+#define FT2(i)      ROTL16(FT0[i])
+#define FT3(i)      ROTL24(FT0[i])
+#define RT1(i)      ROTL8(RT0[i])
+#define RT2(i)      ROTL16(RT0[i])
+#define RT3(i)      ROTL24(RT0[i])
+
+#define XTIME(x)    ((((x) << 1) ^ (((x) & 0x80) ? 0x1B : 0x00)) & 0xFF)
+#define MUL(x, y)   (((x) && (y)) ? pow[(log[(x)] + log[(y)]) % 255] : 0)
+
+static void aes_gen_tables(void)
+{
+    int i, x, y, z;
+    int pow[256];
+    int log[256];
+
+    /* Power and log tables over GF(2^8) */
+    for(i = 0, x = 1; i < 256; i++)
+    {
+        pow[i] = x;
+        log[x] = i;
+        x = (x ^ XTIME(x)) & 0xFF;
+    }
+
+    for(i = 0, x = 1; i < 10; i++)
+    {
+        RCON[i] = (uint32_t)x;
+        x = XTIME(x);
+    }
+
+    /* Forward and reverse S-boxes */
+    FSb[0x00] = 0x63;
+    RSb[0x63] = 0x00;
+    for(i = 1; i < 256; i++)
+    {
+        x = pow[255 - log[i]];
+        y = x;
+        y = ((y << 1) | (y >> 7)) & 0xFF;
+        x ^= y;
+        y = ((y << 1) | (y >> 7)) & 0xFF;
+        x ^= y;
+        y = ((y << 1) | (y >> 7)) & 0xFF;
+        x ^= y;
+        y = ((y << 1) | (y >> 7)) & 0xFF;
+        x ^= y ^ 0x63;
+
+        FSb[i] = (uint8_t)x;
+        RSb[x] = (uint8_t)i;
+    }
+
+    /* Forward and reverse round tables, the other three are rotations */
+    for(i = 0; i < 256; i++)
+    {
+        x = FSb[i];
+        y = XTIME(x);
+        z = (y ^ x) & 0xFF;
+        FT0[i] = ((uint32_t)y) ^ ((uint32_t)x << 8) ^ ((uint32_t)x << 16) ^ ((uint32_t)z << 24);
+
+        x = RSb[i];
+        RT0[i] = ((uint32_t)MUL(0x0E, x)) ^ ((uint32_t)MUL(0x09, x) << 8) ^
+                 ((uint32_t)MUL(0x0D, x) << 16) ^ ((uint32_t)MUL(0x0B, x) << 24);
+    }
+}
+
+#define AES_FROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3)                                  \
+    do {                                                                            \
+        (X0) = *RK++ ^ FT0[(Y0) & 0xFF] ^ FT1(((Y1) >> 8) & 0xFF) ^                 \
+               FT2(((Y2) >> 16) & 0xFF) ^ FT3(((Y3) >> 24) & 0xFF);                 \
+        (X1) = *RK++ ^ FT0[(Y1) & 0xFF] ^ FT1(((Y2) >> 8) & 0xFF) ^                 \
+               FT2(((Y3) >> 16) & 0xFF) ^ FT3(((Y0) >> 24) & 0xFF);                 \
+        (X2) = *RK++ ^ FT0[(Y2) & 0xFF] ^ FT1(((Y3) >> 8) & 0xFF) ^                 \
+               FT2(((Y0) >> 16) & 0xFF) ^ FT3(((Y1) >> 24) & 0xFF);                 \
+        (X3) = *RK++ ^ FT0[(Y3) & 0xFF] ^ FT1(((Y0) >> 8) & 0xFF) ^                 \
+               FT2(((Y1) >> 16) & 0xFF) ^ FT3(((Y2) >> 24) & 0xFF);                 \
+    } while(0)
+
+#define AES_RROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3)                                  \
+    do {                                                                            \
+        (X0) = *RK++ ^ RT0[(Y0) & 0xFF] ^ RT1(((Y3) >> 8) & 0xFF) ^                 \
+               RT2(((Y2) >> 16) & 0xFF) ^ RT3(((Y1) >> 24) & 0xFF);                 \
+        (X1) = *RK++ ^ RT0[(Y1) & 0xFF] ^ RT1(((Y0) >> 8) & 0xFF) ^                 \
+               RT2(((Y3) >> 16) & 0xFF) ^ RT3(((Y2) >> 24) & 0xFF);                 \
+        (X2) = *RK++ ^ RT0[(Y2) & 0xFF] ^ RT1(((Y1) >> 8) & 0xFF) ^                 \
+               RT2(((Y0) >> 16) & 0xFF) ^ RT3(((Y3) >> 24) & 0xFF);                 \
+        (X3) = *RK++ ^ RT0[(Y3) & 0xFF] ^ RT1(((Y2) >> 8) & 0xFF) ^                 \
+               RT2(((Y1) >> 16) & 0xFF) ^ RT3(((Y0) >> 24) & 0xFF);                 \
+    } while(0)
+
+#define SUBWORD(x)  (((uint32_t)FSb[(x) & 0xFF]) ^ ((uint32_t)FSb[((x) >> 8) & 0xFF] << 8) ^ \
+                     ((uint32_t)FSb[((x) >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[((x) >> 24) & 0xFF] << 24))
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_aes_context));
+}
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+    if(ctx == NULL)
+        return;
+
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_aes_context));
+}
+
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits)
+{
+    unsigned int i;
+    uint32_t *RK;
+
+    switch(keybits)
+    {
+        case 128:
+            ctx->nr = 10;
+            ctx->keysz = AES_KEY_SIZE_128;
+            break;
+        case 192:
+            ctx->nr = 12;
+            ctx->keysz = AES_KEY_SIZE_192;
+            break;
+        case 256:
+            ctx->nr = 14;
+            ctx->keysz = AES_KEY_SIZE_256;
+            break;
+        default:
+            return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+    }
+
+    ctx->ks = 0;
+
+    if(!aes_init_done)
+    {
+        crypto_alt_lock();
+        if(!aes_init_done)
+        {
+            aes_gen_tables();
+            aes_init_done = 1;
+        }
+        crypto_alt_unlock();
+    }
+
+    memset(ctx->keys, 0, sizeof(ctx->keys));
+    for(i = 0; i < (keybits >> 5); i++)
+    {
+        ctx->keys[i] = MBEDTLS_GET_UINT32_BE(key, i << 2);
+        ctx->rk[i] = MBEDTLS_GET_UINT32_LE(key, i << 2);
+    }
+
+    RK = ctx->rk;
+    switch(ctx->nr)
+    {
+        case 10:
+            for(i = 0; i < 10; i++, RK += 4)
+            {
+                RK[4] = RK[0] ^ RCON[i] ^ SUBWORD(ROTL24(RK[3]));
+                RK[5] = RK[1] ^ RK[4];
+                RK[6] = RK[2] ^ RK[5];
+                RK[7] = RK[3] ^ RK[6];
+            }
+            break;
+
+        case 12:
+            for(i = 0; i < 8; i++, RK += 6)
+            {
+                RK[6] = RK[0] ^ RCON[i] ^ SUBWORD(ROTL24(RK[5]));
+                RK[7] = RK[1] ^ RK[6];
+                RK[8] = RK[2] ^ RK[7];
+                RK[9] = RK[3] ^ RK[8];
+                RK[10] = RK[4] ^ RK[9];
+                RK[11] = RK[5] ^ RK[10];
+            }
+            break;
+
+        case 14:
+            for(i = 0; i < 7; i++, RK += 8)
+            {
+                RK[8] = RK[0] ^ RCON[i] ^ SUBWORD(ROTL24(RK[7]));
+                RK[9] = RK[1] ^ RK[8];
+                RK[10] = RK[2] ^ RK[9];
+                RK[11] = RK[3] ^ RK[10];
+
+                RK[12] = RK[4] ^ SUBWORD(RK[11]);
+                RK[13] = RK[5] ^ RK[12];
+                RK[14] = RK[6] ^ RK[13];
+                RK[15] = RK[7] ^ RK[14];
+            }
+            break;
+    }
+
+    return 0;
+}
+
+int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits)
+{
+    mbedtls_aes_context cty;
+    uint32_t *RK, *SK;
+    int i, j, ret;
+
+    mbedtls_aes_init(&cty);
+
+    /* The engine derives the decryption key itself, only rk is inverted */
+    if((ret = mbedtls_aes_setkey_enc(&cty, key, keybits)) != 0)
+        goto exit;
+
+    ctx->nr = cty.nr;
+    ctx->keysz = cty.keysz;
+    ctx->ks = 0;
+    memcpy(ctx->keys, cty.keys, sizeof(ctx->keys));
+
+    RK = ctx->rk;
+    SK = cty.rk + cty.nr * 4;
+
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+
+    for(i = ctx->nr - 1, SK -= 8; i > 0; i--, SK -= 8)
+    {
+        for(j = 0; j < 4; j++, SK++)
+        {
+            *RK++ = RT0[FSb[(*SK) & 0xFF]] ^ RT1(FSb[(*SK >> 8) & 0xFF]) ^
+                    RT2(FSb[(*SK >> 16) & 0xFF]) ^ RT3(FSb[(*SK >> 24) & 0xFF]);
+        }
+    }
+
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+
+exit:
+    mbedtls_aes_free(&cty);
+
+    return ret;
+}
+
+/**
+ * Use an AES key held in Key Store SRAM. The key never leaves the Key Store,
+ * so every block, single ones included, is run by the engine. The context
+ * works for both directions.
+ *
+ * @param ctx AES context
+ * @param ksnum Key Store SRAM key number
+ * @param keybits 128, 192 or 256
+ * @return 0 or MBEDTLS_ERR_AES_INVALID_KEY_LENGTH
+ */
+int mbedtls_aes_setkey_ks(mbedtls_aes_context *ctx, int ksnum, unsigned int keybits)
+{
+    switch(keybits)
+    {
+        case 128:
+            ctx->keysz = AES_KEY_SIZE_128;
+            break;
+        case 192:
+            ctx->keysz = AES_KEY_SIZE_192;
+            break;
+        case 256:
+            ctx->keysz = AES_KEY_SIZE_256;
+            break;
+        default:
+            return MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+    }
+
+    mbedtls_platform_zeroize(ctx->rk, sizeof(ctx->rk));
+    mbedtls_platform_zeroize(ctx->keys, sizeof(ctx->keys));
+    ctx->nr = 0;
+    ctx->ks = 1;
+    ctx->ksnum = ksnum;
+
+    return 0;
+}
+
+int mbedtls_internal_aes_encrypt(mbedtls_aes_context *ctx,
+                                 const unsigned char input[16],
+                                 unsigned char output[16])
+{
+    int i;
+    uint32_t *RK = ctx->rk;
+    uint32_t X0, X1, X2, X3, Y0, Y1, Y2, Y3;
+
+    if(ctx->ks)
+        return mbedtls_aes_alt_hw_crypt(ctx, AES_ALT_ECB, 1, NULL, 16, input, output);
+
+    X0 = MBEDTLS_GET_UINT32_LE(input,  0) ^ *RK++;
+    X1 = MBEDTLS_GET_UINT32_LE(input,  4) ^ *RK++;
+    X2 = MBEDTLS_GET_UINT32_LE(input,  8) ^ *RK++;
+    X3 = MBEDTLS_GET_UINT32_LE(input, 12) ^ *RK++;
+
+    for(i = (ctx->nr >> 1) - 1; i > 0; i--)
+    {
+        AES_FROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+        AES_FROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3);
+    }
+
+    AES_FROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+
+    X0 = *RK++ ^ ((uint32_t)FSb[Y0 & 0xFF]) ^ ((uint32_t)FSb[(Y1 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y2 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y3 >> 24) & 0xFF] << 24);
+    X1 = *RK++ ^ ((uint32_t)FSb[Y1 & 0xFF]) ^ ((uint32_t)FSb[(Y2 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y3 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y0 >> 24) & 0xFF] << 24);
+    X2 = *RK++ ^ ((uint32_t)FSb[Y2 & 0xFF]) ^ ((uint32_t)FSb[(Y3 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y0 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y1 >> 24) & 0xFF] << 24);
+    X3 = *RK++ ^ ((uint32_t)FSb[Y3 & 0xFF]) ^ ((uint32_t)FSb[(Y0 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y1 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y2 >> 24) & 0xFF] << 24);
+
+    MBEDTLS_PUT_UINT32_LE(X0, output,  0);
+    MBEDTLS_PUT_UINT32_LE(X1, output,  4);
+    MBEDTLS_PUT_UINT32_LE(X2, output,  8);
+    MBEDTLS_PUT_UINT32_LE(X3, output, 12);
+
+    return 0;
+}
+
+int mbedtls_internal_aes_decrypt(mbedtls_aes_context *ctx,
+                                 const unsigned char input[16],
+                                 unsigned char output[16])
+{
+    int i;
+    uint32_t *RK = ctx->rk;
+    uint32_t X0, X1, X2, X3, Y0, Y1, Y2, Y3;
+
+    if(ctx->ks)
+        return mbedtls_aes_alt_hw_crypt(ctx, AES_ALT_ECB, 0, NULL, 16, input, output);
+
+    X0 = MBEDTLS_GET_UINT32_LE(input,  0) ^ *RK++;
+    X1 = MBEDTLS_GET_UINT32_LE(input,  4) ^ *RK++;
+    X2 = MBEDTLS_GET_UINT32_LE(input,  8) ^ *RK++;
+    X3 = MBEDTLS_GET_UINT32_LE(input, 12) ^ *RK++;
+
+    for(i = (ctx->nr >> 1) - 1; i > 0; i--)
+    {
+        AES_RROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+        AES_RROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3);
+    }
+
+    AES_RROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+
+    X0 = *RK++ ^ ((uint32_t)RSb[Y0 & 0xFF]) ^ ((uint32_t)RSb[(Y3 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y2 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y1 >> 24) & 0xFF] << 24);
+    X1 = *RK++ ^ ((uint32_t)RSb[Y1 & 0xFF]) ^ ((uint32_t)RSb[(Y0 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y3 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y2 >> 24) & 0xFF] << 24);
+    X2 = *RK++ ^ ((uint32_t)RSb[Y2 & 0xFF]) ^ ((uint32_t)RSb[(Y1 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y0 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y3 >> 24) & 0xFF] << 24);
+    X3 = *RK++ ^ ((uint32_t)RSb[Y3 & 0xFF]) ^ ((uint32_t)RSb[(Y2 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y1 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y0 >> 24) & 0xFF] << 24);
+
+    MBEDTLS_PUT_UINT32_LE(X0, output,  0);
+    MBEDTLS_PUT_UINT32_LE(X1, output,  4);
+    MBEDTLS_PUT_UINT32_LE(X2, output,  8);
+    MBEDTLS_PUT_UINT32_LE(X3, output, 12);
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* CRYPTO engine                                                             */
+/*---------------------------------------------------------------------------*/
+
+/* Add n to a 128-bit big-endian counter */
+static void aes_ctr_add(unsigned char ctr[16], uint32_t n)
+{
+    int i;
+    uint32_t sum;
+
+    for(i = 15; (i >= 0) && (n != 0); i--)
+    {
+        sum = ctr[i] + (n & 0xFF);
+        ctr[i] = (unsigned char)sum;
+        n = (n >> 8) + (sum >> 8);
+    }
+}
+
+/* Update iv as the software modes expect after the last block, last_in is
+   the last input block as it was before the run */
+static void aes_next_iv(int mode, int encrypt, unsigned char iv[16], size_t n,
+                        const unsigned char last_in[16], const unsigned char *out)
+{
+    size_t i;
+
+    switch(mode)
+    {
+        case AES_ALT_CBC:
+        case AES_ALT_CFB:
+            memcpy(iv, encrypt ? &out[n - 16] : last_in, 16);
+            break;
+        case AES_ALT_OFB:
+            for(i = 0; i < 16; i++)
+                iv[i] = last_in[i] ^ out[n - 16 + i];
+            break;
+        case AES_ALT_CTR:
+            aes_ctr_add(iv, (uint32_t)(n / 16));
+            break;
+    }
+}
+
+#if CRYPTO_ALT_AES_JOB
+
+/*
+ * The job queue moves the data straight between the caller buffers, so they
+ * must cover whole cache lines. A CTR counter that would wrap its low word
+ * needs the request split, which the bounce buffer loop does.
+ */
+static int aes_job_fits(int mode, const unsigned char iv[16], size_t length,
+                        const unsigned char *input, const unsigned char *output)
+{
+    uint32_t left;
+
+    if(xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+        return 0;
+
+    if((length % 64) || (length > 0xFFFFFFC0) || (ptr_to_u32(input) & 0x3F) || (ptr_to_u32(output) & 0x3F))
+        return 0;
+
+    if(mode == AES_ALT_CTR)
+    {
+        left = 0 - MBEDTLS_GET_UINT32_BE(iv, 12);
+        if((left != 0) && (length / 16 > left))
+            return 0;
+    }
+    return 1;
+}
+
+/* Run the whole request as one queued job and sleep until it completes */
+static int aes_hw_job(mbedtls_aes_context *ctx, uint32_t opmode, int mode, int encrypt,
+                      unsigned char iv[16], size_t length,
+                      const unsigned char *input, unsigned char *output)
+{
+    crypto_job_t job;
+    unsigned char last_in[16];
+    size_t i;
+    int ret;
+
+    memset(&job, 0, sizeof(job));
+    job.type = CRYPTO_JOB_AES;
+    job.u.aes.opmode = opmode;
+    job.u.aes.encrypt = encrypt ? AES_MODE_ENCRYPT : AES_MODE_DECRYPT;
+    job.u.aes.keysz = ctx->keysz;
+    job.u.aes.ksnum = ctx->ks ? ctx->ksnum : -1;
+    if(!ctx->ks)
+        memcpy(job.u.aes.key, ctx->keys, sizeof(job.u.aes.key));
+    for(i = 0; i < 4; i++)
+        job.u.aes.iv[i] = (mode == AES_ALT_ECB) ? 0 : MBEDTLS_GET_UINT32_BE(iv, i * 4);
+    job.u.aes.in = input;
+    job.u.aes.out = output;
+    job.u.aes.len = (uint32_t)length;
+
+    /* In place, the engine overwrites the block the next IV comes from */
+    memcpy(last_in, &input[length - 16], 16);
+
+    ret = crypto_job_run(&job);
+    if(ret == 0)
+        aes_next_iv(mode, encrypt, iv, length, last_in, output);
+
+    mbedtls_platform_zeroize(&job, sizeof(job));
+    mbedtls_platform_zeroize(last_in, sizeof(last_in));
+    return ret;
+}
+
+#endif /* CRYPTO_ALT_AES_JOB */
+
+/**
+ * Run whole blocks through the engine. iv is updated to the chaining value
+ * the software modes expect after the last block: the last ciphertext block
+ * for CBC and CFB, the last key stream block for OFB and the next counter
+ * for CTR.
+ *
+ * @param ctx AES context set up with mbedtls_aes_setkey_enc/dec()
+ * @param mode AES_ALT_ECB, AES_ALT_CBC, AES_ALT_CFB, AES_ALT_OFB or AES_ALT_CTR
+ * @param encrypt 1 to encrypt, 0 to decrypt
+ * @param iv IV or counter block, unused for ECB
+ * @param length byte count, a multiple of 16
+ * @return 0, MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH or
+ *         MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED on an engine time-out
+ */
+int mbedtls_aes_alt_hw_crypt(mbedtls_aes_context *ctx, int mode, int encrypt,
+                             unsigned char iv[16], size_t length,
+                             const unsigned char *input, unsigned char *output)
+{
+    static const uint32_t opmode[] = { AES_MODE_ECB, AES_MODE_CBC, AES_MODE_CFB, AES_MODE_OFB, AES_MODE_CTR };
+    uint32_t ivw[4], left;
+    size_t i, n;
+    int ret = 0;
+
+    if(length % 16)
+        return MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH;
+
+    /* OFB and CTR only ever run the cipher forward */
+    if((mode == AES_ALT_OFB) || (mode == AES_ALT_CTR))
+        encrypt = 1;
+
+#if CRYPTO_ALT_AES_JOB
+    if((length > 0) && aes_job_fits(mode, iv, length, input, output))
+        return aes_hw_job(ctx, opmode[mode], mode, encrypt, iv, length, input, output);
+#endif
+
+    crypto_alt_lock();
+
+    while(length > 0)
+    {
+        n = (length < CRYPTO_ALT_DMA_BUF_SIZE) ? length : CRYPTO_ALT_DMA_BUF_SIZE;
+
+        if(mode == AES_ALT_CTR)
+        {
+            /* Never let the low counter word wrap inside a job, so it does not
+               matter how far the engine carries */
+            left = 0 - MBEDTLS_GET_UINT32_BE(iv, 12);
+            if((left != 0) && (n / 16 > left))
+                n = (size_t)left * 16;
+        }
+
+        memcpy(crypto_alt_dma_in, input, n);
+        dcache_clean_by_mva(crypto_alt_dma_in, n);
+        dcache_invalidate_by_mva(crypto_alt_dma_out, n);
+
+        for(i = 0; i < 4; i++)
+            ivw[i] = (mode == AES_ALT_ECB) ? 0 : MBEDTLS_GET_UINT32_BE(iv, i * 4);
+
+        AES_Open(CRPT, encrypt ? AES_MODE_ENCRYPT : AES_MODE_DECRYPT, opmode[mode], ctx->keysz, AES_IN_OUT_SWAP);
+        if(!ctx->ks)
+            AES_SetKey(CRPT, ctx->keys, ctx->keysz);
+        AES_SetInitVect(CRPT, ivw);
+        AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(crypto_alt_dma_in), ptr_to_u32(crypto_alt_dma_out), n);
+
+        if((ctx->ks ? AES_Start_KS(CRPT, CRYPTO_DMA_ONE_SHOT, 0, ctx->ksnum) :
+                AES_Start(CRPT, 0, CRYPTO_DMA_ONE_SHOT)) != 0)
+        {
+            ret = MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+            break;
+        }
+        dcache_invalidate_by_mva(crypto_alt_dma_out, n);
+
+        aes_next_iv(mode, encrypt, iv, n, &crypto_alt_dma_in[n - 16], crypto_alt_dma_out);
+
+        memcpy(output, crypto_alt_dma_out, n);
+
+        input += n;
+        output += n;
+        length -= n;
+    }
+
+    crypto_alt_unlock();
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Block cipher modes                                                        */
+/*---------------------------------------------------------------------------*/
+
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx,
+                          int mode,
+                          const unsigned char input[16],
+                          unsigned char output[16])
+{
+    if((mode != MBEDTLS_AES_ENCRYPT) && (mode != MBEDTLS_AES_DECRYPT))
+        return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+    /* A single block, never worth a DMA job */
+    if(mode == MBEDTLS_AES_ENCRYPT)
+        return mbedtls_internal_aes_encrypt(ctx, input, output);
+    else
+        return mbedtls_internal_aes_decrypt(ctx, input, output);
+}
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
+                          int mode,
+                          size_t length,
+                          unsigned char iv[16],
+                          const unsigned char *input,
+                          unsigned char *output)
+{
+    unsigned char temp[16];
+    int i, ret;
+
+    if((mode != MBEDTLS_AES_ENCRYPT) && (mode != MBEDTLS_AES_DECRYPT))
+        return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+    if(length % 16)
+        return MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH;
+
+    if(length >= CRYPTO_ALT_AES_DMA_MIN)
+        return mbedtls_aes_alt_hw_crypt(ctx, AES_ALT_CBC, mode == MBEDTLS_AES_ENCRYPT, iv, length, input, output);
+
+    while(length > 0)
+    {
+        if(mode == MBEDTLS_AES_DECRYPT)
+        {
+            memcpy(temp, input, 16);
+            if((ret = mbedtls_internal_aes_decrypt(ctx, input, output)) != 0)
+                return ret;
+            for(i = 0; i < 16; i++)
+                output[i] ^= iv[i];
+            memcpy(iv, temp, 16);
+        }
+        else
+        {
+            for(i = 0; i < 16; i++)
+                output[i] = input[i] ^ iv[i];
+            if((ret = mbedtls_internal_aes_encrypt(ctx, output, output)) != 0)
+                return ret;
+            memcpy(iv, output, 16);
+        }
+
+        input += 16;
+        output += 16;
+        length -= 16;
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_CIPHER_MODE_CBC */
+
+#if defined(MBEDTLS_CIPHER_MODE_CFB)
+int mbedtls_aes_crypt_cfb128(mbedtls_aes_context *ctx,
+                             int mode,
+                             size_t length,
+                             size_t *iv_off,
+                             unsigned char iv[16],
+                             const unsigned char *input,
+                             unsigned char *output)
+{
+    size_t n = *iv_off, blk;
+    unsigned char c;
+    int ret;
+
+    if((mode != MBEDTLS_AES_ENCRYPT) && (mode != MBEDTLS_AES_DECRYPT))
+        return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+    if(n > 15)
+        return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+    while(length > 0)
+    {
+        /* Whole blocks on a block boundary go to the engine */
+        if((n == 0) && (length >= CRYPTO_ALT_AES_DMA_MIN))
+        {
+            blk = length & ~(size_t)15;
+            if((ret = mbedtls_aes_alt_hw_crypt(ctx, AES_ALT_CFB, mode == MBEDTLS_AES_ENCRYPT, iv, blk, input, output)) != 0)
+                return ret;
+            input += blk;
+            output += blk;
+            length -= blk;
+            continue;
+        }
+
+        if(n == 0)
+        {
+            if((ret = mbedtls_internal_aes_encrypt(ctx, iv, iv)) != 0)
+                return ret;
+        }
+
+        c = *input++;
+        if(mode == MBEDTLS_AES_DECRYPT)
+        {
+            *output++ = c ^ iv[n];
+            iv[n] = c;
+        }
+        else
+        {
+            iv[n] = *output++ = c ^ iv[n];
+        }
+
+        n = (n + 1) & 0x0F;
+        length--;
+    }
+
+    *iv_off = n;
+
+    return 0;
+}
+
+int mbedtls_aes_crypt_cfb8(mbedtls_aes_context *ctx,
+                           int mode,
+                           size_t length,
+                           unsigned char iv[16],
+                           const unsigned char *input,
+                           unsigned char *output)
+{
+    unsigned char c;
+    unsigned char ov[17];
+    int ret;
+
+    if((mode != MBEDTLS_AES_ENCRYPT) && (mode != MBEDTLS_AES_DECRYPT))
+        return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+    /* One cipher block per byte, software only */
+    while(length--)
+    {
+        memcpy(ov, iv, 16);
+        if((ret = mbedtls_internal_aes_encrypt(ctx, iv, iv)) != 0)
+            return ret;
+
+        if(mode == MBEDTLS_AES_DECRYPT)
+            ov[16] = *input;
+
+        c = *output++ = (unsigned char)(iv[0] ^ *input++);
+
+        if(mode == MBEDTLS_AES_ENCRYPT)
+            ov[16] = c;
+
+        memcpy(iv, ov + 1, 16);
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_CIPHER_MODE_CFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_OFB)
+int mbedtls_aes_crypt_ofb(mbedtls_aes_context *ctx,
+                          size_t length,
+                          size_t *iv_off,
+                          unsigned char iv[16],
+                          const unsigned char *input,
+                          unsigned char *output)
+{
+    size_t n = *iv_off, blk;
+    int ret;
+
+    if(n > 15)
+        return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+    while(length > 0)
+    {
+        if((n == 0) && (length >= CRYPTO_ALT_AES_DMA_MIN))
+        {
+            blk = length & ~(size_t)15;
+            if((ret = mbedtls_aes_alt_hw_crypt(ctx, AES_ALT_OFB, 1, iv, blk, input, output)) != 0)
+                return ret;
+            input += blk;
+            output += blk;
+            length -= blk;
+            continue;
+        }
+
+        if(n == 0)
+        {
+            if((ret = mbedtls_internal_aes_encrypt(ctx, iv, iv)) != 0)
+                return ret;
+        }
+        *output++ = *input++ ^ iv[n];
+
+        n = (n + 1) & 0x0F;
+        length--;
+    }
+
+    *iv_off = n;
+
+    return 0;
+}
+#endif /* MBEDTLS_CIPHER_MODE_OFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+int mbedtls_aes_crypt_ctr(mbedtls_aes_context *ctx,
+                          size_t length,
+                          size_t *nc_off,
+                          unsigned char nonce_counter[16],
+                          unsigned char stream_block[16],
+                          const unsigned char *input,
+                          unsigned char *output)
+{
+    size_t n = *nc_off, blk;
+    int ret;
+
+    if(n > 15)
+        return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+
+    while(length > 0)
+    {
+        if((n == 0) && (length >= CRYPTO_ALT_AES_DMA_MIN))
+        {
+            blk = length & ~(size_t)15;
+            if((ret = mbedtls_aes_alt_hw_crypt(ctx, AES_ALT_CTR, 1, nonce_counter, blk, input, output)) != 0)
+                return ret;
+            input += blk;
+            output += blk;
+            length -= blk;
+            continue;
+        }
+
+        if(n == 0)
+        {
+            if((ret = mbedtls_internal_aes_encrypt(ctx, nonce_counter, stream_block)) != 0)
+                return ret;
+            aes_ctr_add(nonce_counter, 1);
+        }
+        *output++ = *input++ ^ stream_block[n];
+
+        n = (n + 1) & 0x0F;
+        length--;
+    }
+
+    *nc_off = n;
+
+    return 0;
+}
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+
+#endif /* MBEDTLS_AES_C && MBEDTLS_AES_ALT */
@@ -0,0 +1,61 @@
+/**************************************************************************//**
+ * @file     aes_alt.h
+ * @brief    mbedTLS MBEDTLS_AES_ALT context for the CRYPTO AES engine
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __AES_ALT_H__
+#define __AES_ALT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(MBEDTLS_AES_ALT)
+
+#if defined(MBEDTLS_CIPHER_MODE_XTS)
+#error "MBEDTLS_CIPHER_MODE_XTS is not supported by MBEDTLS_AES_ALT"
+#endif
+
+/**
+ * The AES context. Blocks and short requests are done in software with
+ * the round keys in rk; longer requests go through the CRYPTO engine
+ * with the original key, which derives its own decryption key. A key set
+ * with mbedtls_aes_setkey_ks() stays in Key Store SRAM and all requests
+ * go through the engine.
+ */
+typedef struct mbedtls_aes_context
+{
+    int nr;                 /*!< Number of rounds */
+    uint32_t rk[68];        /*!< Software round keys, encrypt or decrypt schedule */
+    uint32_t keys[8];       /*!< Key as big-endian words for AES_SetKey() */
+    uint32_t keysz;         /*!< AES_KEY_SIZE_128/192/256 */
+    int ks;                 /*!< 1 when the key is in Key Store SRAM */
+    int ksnum;              /*!< Key Store SRAM key number */
+}
+mbedtls_aes_context;
+
+/* Modes run on the engine by the AES and GCM alternate implementations */
+#define AES_ALT_ECB         0
+#define AES_ALT_CBC         1
+#define AES_ALT_CFB         2
+#define AES_ALT_OFB         3
+#define AES_ALT_CTR         4
+
+int mbedtls_aes_setkey_ks(mbedtls_aes_context *ctx, int ksnum, unsigned int keybits);
+
+int mbedtls_aes_alt_hw_crypt(mbedtls_aes_context *ctx, int mode, int encrypt,
+                             unsigned char iv[16], size_t length,
+                             const unsigned char *input, unsigned char *output);
+
+#endif /* MBEDTLS_AES_ALT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AES_ALT_H__ */
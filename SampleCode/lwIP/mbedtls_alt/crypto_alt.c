@@ -0,0 +1,802 @@
+/**************************************************************************//**
+ * @file     crypto_alt.c
+ * @brief    CRYPTO engine access shared by the mbedTLS alternate implementations
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "NuMicro.h"
+#include "crypto_alt.h"
+#include "crypto_job.h"
+
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/platform.h"
+
+uint8_t crypto_alt_dma_in[CRYPTO_ALT_DMA_BUF_SIZE] __attribute__((aligned(64)));
+uint8_t crypto_alt_dma_out[CRYPTO_ALT_DMA_BUF_SIZE] __attribute__((aligned(64)));
+
+static SemaphoreHandle_t crypto_mutex;
+static const void *sha_owner;
+
+/**
+ * Enable the CRYPTO engine and create the lock serializing it. Called on
+ * first use; may also be called from main() before the scheduler starts.
+ */
+void crypto_alt_init(void)
+{
+    vTaskSuspendAll();
+    if(crypto_mutex == NULL)
+    {
+        Crypto_Init();
+        crypto_mutex = xSemaphoreCreateMutex();
+        configASSERT(crypto_mutex != NULL);
+    }
+    xTaskResumeAll();
+}
+
+/* The engine, its registers and the DMA buffers belong to the lock holder */
+void crypto_alt_lock(void)
+{
+    if(crypto_mutex == NULL)
+        crypto_alt_init();
+
+    xSemaphoreTake(crypto_mutex, portMAX_DELAY);
+}
+
+void crypto_alt_unlock(void)
+{
+    xSemaphoreGive(crypto_mutex);
+}
+
+/**
+ * Claim the SHA engine digest state for a hash context. Never blocks, a
+ * context that cannot get the engine hashes in software instead.
+ *
+ * @param owner the hash context
+ * @return 0 if owner now holds the engine, -1 if another context does
+ */
+int crypto_alt_sha_acquire(const void *owner)
+{
+    int ret;
+
+    vTaskSuspendAll();
+    if(sha_owner == NULL)
+        sha_owner = owner;
+    ret = (sha_owner == owner) ? 0 : -1;
+    xTaskResumeAll();
+
+    return ret;
+}
+
+void crypto_alt_sha_release(const void *owner)
+{
+    vTaskSuspendAll();
+    if(sha_owner == owner)
+        sha_owner = NULL;
+    xTaskResumeAll();
+}
+
+#if defined(MBEDTLS_SELF_TEST)
+
+#if (defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA256_ALT)) || \
+    (defined(MBEDTLS_SHA512_C) && defined(MBEDTLS_SHA512_ALT))
+#define CLONE_TEST
+#endif
+
+#if defined(CLONE_TEST)
+
+#define CLONE_MSG_SIZE      1000            /* Byte i is i * 7 + 3 */
+
+/*
+ * Where the clone tests copy a running digest: the first two move it to
+ * the engine first, keeping back a partial and a full block, the last is
+ * still hashed in software.
+ */
+static const size_t clone_cut[] = { 600, 640, 100 };
+
+#if defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA256_ALT)
+
+static const unsigned char clone_sha256[32] =
+{
+    0x1E, 0x9B, 0xC3, 0x8C, 0xBF, 0x86, 0x0B, 0x9E, 0xC3, 0x19, 0x18, 0xB0, 0x65, 0xF9, 0xB5, 0x24,
+    0x76, 0xC5, 0x49, 0xA7, 0x82, 0xE0, 0xE7, 0x99, 0x0B, 0xED, 0x8C, 0xE3, 0x86, 0x8D, 0x23, 0x71,
+};
+
+/*
+ * Clone a SHA-256 context part way through the message, finish the rest
+ * in both copies and check both digests. The engine keeps the digest of
+ * the original while the copy goes on in software.
+ */
+static int sha256_clone_test(const unsigned char *msg, int verbose)
+{
+    mbedtls_sha256_context a, b;
+    unsigned char out[2][32];
+    size_t i, cut;
+    int ret = 0;
+
+    for(i = 0; (ret == 0) && (i < sizeof(clone_cut) / sizeof(clone_cut[0])); i++)
+    {
+        cut = clone_cut[i];
+        mbedtls_sha256_init(&a);
+        mbedtls_sha256_init(&b);
+
+        if(verbose != 0)
+            mbedtls_printf("  SHA-256 clone at %d: ", (int)cut);
+
+        if(((ret = mbedtls_sha256_starts(&a, 0)) != 0) ||
+                ((ret = mbedtls_sha256_update(&a, msg, cut)) != 0))
+            goto next;
+
+        /* Nothing else uses the engine during the self test */
+        if(a.hw != (cut >= CRYPTO_ALT_SHA_DMA_MIN))
+        {
+            ret = 1;
+            goto next;
+        }
+
+        mbedtls_sha256_clone(&b, &a);
+
+        if(((ret = mbedtls_sha256_update(&a, msg + cut, 1)) != 0) ||
+                ((ret = mbedtls_sha256_update(&b, msg + cut, CLONE_MSG_SIZE - cut)) != 0) ||
+                ((ret = mbedtls_sha256_update(&a, msg + cut + 1, CLONE_MSG_SIZE - cut - 1)) != 0) ||
+                ((ret = mbedtls_sha256_finish(&b, out[1])) != 0) ||
+                ((ret = mbedtls_sha256_finish(&a, out[0])) != 0))
+            goto next;
+
+        if((memcmp(out[0], clone_sha256, 32) != 0) || (memcmp(out[1], clone_sha256, 32) != 0))
+            ret = 1;
+
+next:
+        if(verbose != 0)
+            mbedtls_printf("%s\n", (ret == 0) ? "passed" : "failed");
+
+        mbedtls_sha256_free(&a);
+        mbedtls_sha256_free(&b);
+    }
+
+    return ret;
+}
+
+#endif /* MBEDTLS_SHA256_C && MBEDTLS_SHA256_ALT */
+
+#if defined(MBEDTLS_SHA512_C) && defined(MBEDTLS_SHA512_ALT)
+
+static const unsigned char clone_sha512[64] =
+{
+    0x00, 0xE3, 0x6F, 0xCC, 0xF1, 0x93, 0xE5, 0x96, 0x97, 0xA9, 0x2B, 0x5A, 0xB2, 0x46, 0x66, 0xCE,
+    0x63, 0x26, 0xD7, 0xFA, 0x16, 0xBF, 0x10, 0x83, 0x2D, 0x09, 0x91, 0xDD, 0xC5, 0x91, 0x11, 0x2E,
+    0x9D, 0xFA, 0x6A, 0x63, 0x69, 0x50, 0xED, 0x9C, 0x4D, 0x67, 0x34, 0x4A, 0x76, 0x06, 0x54, 0xC2,
+    0xFF, 0x77, 0x85, 0xE1, 0xD6, 0x00, 0x94, 0xD6, 0x51, 0x03, 0x87, 0x35, 0xB5, 0xDC, 0xCA, 0xBD,
+};
+
+/* As sha256_clone_test(), with 128-byte blocks */
+static int sha512_clone_test(const unsigned char *msg, int verbose)
+{
+    mbedtls_sha512_context a, b;
+    unsigned char out[2][64];
+    size_t i, cut;
+    int ret = 0;
+
+    for(i = 0; (ret == 0) && (i < sizeof(clone_cut) / sizeof(clone_cut[0])); i++)
+    {
+        cut = clone_cut[i];
+        mbedtls_sha512_init(&a);
+        mbedtls_sha512_init(&b);
+
+        if(verbose != 0)
+            mbedtls_printf("  SHA-512 clone at %d: ", (int)cut);
+
+        if(((ret = mbedtls_sha512_starts(&a, 0)) != 0) ||
+                ((ret = mbedtls_sha512_update(&a, msg, cut)) != 0))
+            goto next;
+
+        if(a.hw != (cut >= CRYPTO_ALT_SHA_DMA_MIN))
+        {
+            ret = 1;
+            goto next;
+        }
+
+        mbedtls_sha512_clone(&b, &a);
+
+        if(((ret = mbedtls_sha512_update(&a, msg + cut, 1)) != 0) ||
+                ((ret = mbedtls_sha512_update(&b, msg + cut, CLONE_MSG_SIZE - cut)) != 0) ||
+                ((ret = mbedtls_sha512_update(&a, msg + cut + 1, CLONE_MSG_SIZE - cut - 1)) != 0) ||
+                ((ret = mbedtls_sha512_finish(&b, out[1])) != 0) ||
+                ((ret = mbedtls_sha512_finish(&a, out[0])) != 0))
+            goto next;
+
+        if((memcmp(out[0], clone_sha512, 64) != 0) || (memcmp(out[1], clone_sha512, 64) != 0))
+            ret = 1;
+
+next:
+        if(verbose != 0)
+            mbedtls_printf("%s\n", (ret == 0) ? "passed" : "failed");
+
+        mbedtls_sha512_free(&a);
+        mbedtls_sha512_free(&b);
+    }
+
+    return ret;
+}
+
+#endif /* MBEDTLS_SHA512_C && MBEDTLS_SHA512_ALT */
+
+/* Clone known answer tests of the SHA alternate implementations */
+static int sha_clone_test(int verbose)
+{
+    unsigned char *msg;
+    int i, ret = 0;
+
+    if((msg = mbedtls_calloc(1, CLONE_MSG_SIZE)) == NULL)
+        return 1;
+
+    for(i = 0; i < CLONE_MSG_SIZE; i++)
+        msg[i] = (unsigned char)(i * 7 + 3);
+
+#if defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA256_ALT)
+    ret = sha256_clone_test(msg, verbose);
+#endif
+#if defined(MBEDTLS_SHA512_C) && defined(MBEDTLS_SHA512_ALT)
+    if(ret == 0)
+        ret = sha512_clone_test(msg, verbose);
+#endif
+
+    mbedtls_free(msg);
+    return ret;
+}
+
+#endif /* CLONE_TEST */
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_AES_ALT) && defined(MBEDTLS_SHA256_C) && CRYPTO_ALT_AES_JOB
+#define JOB_TEST
+#endif
+
+#if defined(JOB_TEST)
+
+#define JOB_TEST_SIZE       1024            /* Byte i is i * 13 + 5 */
+#define JOB_TEST_JOBS       4               /* Of each type, JOB_TEST_SIZE / 4 bytes each */
+
+static unsigned char job_in[JOB_TEST_SIZE] __attribute__((aligned(64)));
+static unsigned char job_out[JOB_TEST_SIZE] __attribute__((aligned(64)));
+static unsigned char job_tmp[JOB_TEST_SIZE + 64] __attribute__((aligned(64)));
+static crypto_job_t job_list[2 * JOB_TEST_JOBS];
+
+static const unsigned char job_key[16] =
+{
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C,
+};
+
+/*
+ * Queue AES-128 ECB and SHA-256 jobs together so both engines run at once,
+ * then check each against a software AES block and a software digest.
+ */
+static int job_queue_test(mbedtls_aes_context *aes, int verbose)
+{
+    unsigned char blk[16], dgst[32];
+    size_t part = JOB_TEST_SIZE / JOB_TEST_JOBS, i;
+    crypto_job_t *job;
+    int j, n, ret = 0;
+
+    if(verbose != 0)
+        mbedtls_printf("  CRYPTO job queue AES/SHA: ");
+
+    memset(job_list, 0, sizeof(job_list));
+    memset(job_out, 0, sizeof(job_out));
+    for(j = 0; (ret == 0) && (j < JOB_TEST_JOBS); j++)
+    {
+        job = &job_list[2 * j];
+        job->type = CRYPTO_JOB_AES;
+        job->u.aes.opmode = AES_MODE_ECB;
+        job->u.aes.encrypt = AES_MODE_ENCRYPT;
+        job->u.aes.keysz = aes->keysz;
+        job->u.aes.ksnum = -1;
+        memcpy(job->u.aes.key, aes->keys, sizeof(job->u.aes.key));
+        job->u.aes.in = job_in + j * part;
+        job->u.aes.out = job_out + j * part;
+        job->u.aes.len = part;
+        ret = crypto_job_submit(job);
+
+        job = &job_list[2 * j + 1];
+        job->type = CRYPTO_JOB_SHA;
+        job->u.sha.opmode = SHA_MODE_SHA256;
+        job->u.sha.in = job_in + j * part;
+        job->u.sha.len = part;
+        if(ret == 0)
+            ret = crypto_job_submit(job);
+    }
+
+    /* Jobs still pending after the queue time-out have been lost */
+    for(n = 0; (ret == 0) && (n < 2 * CRYPTO_JOB_TIMEOUT_MS); n++)
+    {
+        for(j = 0; j < 2 * JOB_TEST_JOBS; j++)
+        {
+            if(job_list[j].status == CRYPTO_JOB_PENDING)
+                break;
+        }
+        if(j == 2 * JOB_TEST_JOBS)
+            break;
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    for(j = 0; (ret == 0) && (j < JOB_TEST_JOBS); j++)
+    {
+        if((job_list[2 * j].status != 0) || (job_list[2 * j + 1].status != 0))
+        {
+            ret = 1;
+            break;
+        }
+
+        /* Single blocks are encrypted in software */
+        for(i = 0; (ret == 0) && (i < part); i += 16)
+        {
+            if(((ret = mbedtls_aes_crypt_ecb(aes, MBEDTLS_AES_ENCRYPT, job_in + j * part + i, blk)) == 0) &&
+                    (memcmp(blk, job_out + j * part + i, 16) != 0))
+                ret = 1;
+        }
+
+        /* Shorter than CRYPTO_ALT_SHA_DMA_MIN, hashed in software */
+        if((ret == 0) && ((ret = mbedtls_sha256(job_in + j * part, part, dgst, 0)) == 0) &&
+                (memcmp(dgst, job_list[2 * j + 1].u.sha.digest, 32) != 0))
+            ret = 1;
+    }
+
+    if(verbose != 0)
+        mbedtls_printf("%s\n", (ret == 0) ? "passed" : "failed");
+
+    return ret;
+}
+
+/*
+ * Run AES-CBC through the engine on aligned buffers, which go through the
+ * job queue, and on a misaligned copy, which goes through the bounce
+ * buffers. Both must give the same ciphertext and next IV, and an in-place
+ * decryption through the queue must give back the plaintext. The engine
+ * path is called directly, MBEDTLS_CIPHER_MODE_CBC may be off.
+ */
+static int job_aes_path_test(mbedtls_aes_context *aes, int verbose)
+{
+    static const unsigned char iv0[16] =
+    {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    };
+    unsigned char iv[2][16];
+    unsigned char *copy = job_tmp + 16;
+    int ret;
+
+    if(verbose != 0)
+        mbedtls_printf("  AES-CBC queued and bounced: ");
+
+    memcpy(iv[0], iv0, 16);
+    memcpy(iv[1], iv0, 16);
+    memcpy(copy, job_in, JOB_TEST_SIZE);
+
+    if(((ret = mbedtls_aes_alt_hw_crypt(aes, AES_ALT_CBC, 1, iv[0], JOB_TEST_SIZE, job_in, job_out)) != 0) ||
+            ((ret = mbedtls_aes_alt_hw_crypt(aes, AES_ALT_CBC, 1, iv[1], JOB_TEST_SIZE, copy, copy)) != 0))
+        goto exit;
+
+    if((memcmp(job_out, copy, JOB_TEST_SIZE) != 0) || (memcmp(iv[0], iv[1], 16) != 0))
+    {
+        ret = 1;
+        goto exit;
+    }
+
+    /* The engine derives the decryption key itself */
+    memcpy(iv[0], iv0, 16);
+    if((ret = mbedtls_aes_alt_hw_crypt(aes, AES_ALT_CBC, 0, iv[0], JOB_TEST_SIZE, job_out, job_out)) != 0)
+        goto exit;
+
+    if((memcmp(job_out, job_in, JOB_TEST_SIZE) != 0) || (memcmp(iv[0], iv[1], 16) != 0))
+        ret = 1;
+
+exit:
+    if(verbose != 0)
+        mbedtls_printf("%s\n", (ret == 0) ? "passed" : "failed");
+
+    return ret;
+}
+
+/* Job queue and AES job path tests against the software implementations */
+static int job_test(int verbose)
+{
+    mbedtls_aes_context aes;
+    int i, ret;
+
+    for(i = 0; i < JOB_TEST_SIZE; i++)
+        job_in[i] = (unsigned char)(i * 13 + 5);
+
+    mbedtls_aes_init(&aes);
+
+    if(((ret = mbedtls_aes_setkey_enc(&aes, job_key, 128)) == 0) &&
+            ((ret = job_queue_test(&aes, verbose)) == 0))
+        ret = job_aes_path_test(&aes, verbose);
+
+    mbedtls_aes_free(&aes);
+    return ret;
+}
+
+#endif /* JOB_TEST */
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECDSA_C)
+
+#if defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+
+/* RFC 5903 8.1, P-256 ECDH */
+#define KAT_ECDH_I      "C88F01F510D9AC3F70A292DAA2316DE544E9AAB8AFE84049C62A9C57862D1433"
+#define KAT_ECDH_GIX    "DAD0B65394221CF9B051E1FECA5787D098DFE637FC90B9EF945D0C3772581180"
+#define KAT_ECDH_GIY    "5271A0461CDB8252D61F1C456FA3E59AB1F45B33ACCF5F58389E0577B8990BB3"
+#define KAT_ECDH_GRX    "D12DFB5289C8D4F81208B70270398C342296970A0BCCB74C736FC7554494BF63"
+#define KAT_ECDH_GRY    "56FBF3CA366CC23E8157854C13C58D6AAC23F046ADA30F8353E74F33039872AB"
+#define KAT_ECDH_Z      "D6840F6B42F6EDAFD13116E0E12565202FEF8E9ECE7DCE03812464D04B9442DE"
+
+/* RFC 6979 A.2.5, P-256 ECDSA of "sample" with SHA-256 */
+#define KAT_ECDSA_X     "C9AFA9D845BA75166B5C215767B1D6934E50C3DB36E89B127B8A622B120F6721"
+#define KAT_ECDSA_UX    "60FED4BA255A9D31C961EB74C6356D68C049B8923B61FA6CE669622E60F29FB6"
+#define KAT_ECDSA_UY    "7903FE1008B8BC99A41AE9E95628BC64F2F1B20C2D7E9F5177A3C294D4462299"
+#define KAT_ECDSA_K     "A6E3C57DD01ABE90086538398355DD4C3B17AA873382B0F24D6129493D8AAD60"
+#define KAT_ECDSA_R     "EFD48B2AACB6A8FD1140DD9CD45E81D69D2C877B56AAF991C34D0EA84EAF3716"
+#define KAT_ECDSA_S     "F7CB1C942D657C41D436C7A1B6E29F65F3E900DBB9AFF4064DC4AB2F843ACDA8"
+
+static const unsigned char kat_sample_sha256[32] =
+{
+    0xAF, 0x2B, 0xDB, 0xE1, 0xAA, 0x9B, 0x6E, 0xC1, 0xE2, 0xAD, 0xE1, 0xD6, 0x94, 0xF4, 0x1F, 0xC7,
+    0x1A, 0x83, 0x1D, 0x02, 0x68, 0xE9, 0x89, 0x15, 0x62, 0x11, 0x3D, 0x8A, 0x62, 0xAD, 0xD1, 0xBF
+};
+
+/*
+ * Hands out the scalar in p_rng every time. One P-256 draw takes it whole,
+ * so the private key and the ECDSA nonce come out as the vectors give them.
+ */
+static int kat_rng(void *p_rng, unsigned char *out, size_t len)
+{
+    return mbedtls_mpi_write_binary((const mbedtls_mpi *)p_rng, out, len);
+}
+
+/*
+ * P-256 ECDH and ECDSA against published vectors, so a result that is wrong
+ * in the same way on both ends of a round trip is still caught.
+ */
+static int ecc_kat_test(int verbose)
+{
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point q, peer;
+    mbedtls_mpi k, d, z, r, s, want;
+    int ret;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&q);
+    mbedtls_ecp_point_init(&peer);
+    mbedtls_mpi_init(&k);
+    mbedtls_mpi_init(&d);
+    mbedtls_mpi_init(&z);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    mbedtls_mpi_init(&want);
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1));
+
+    /* ECDH: our public value and the shared secret */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_string(&k, 16, KAT_ECDH_I));
+    MBEDTLS_MPI_CHK(mbedtls_ecdh_gen_public(&grp, &d, &q, kat_rng, &k));
+    MBEDTLS_MPI_CHK(mbedtls_ecp_point_read_string(&peer, 16, KAT_ECDH_GIX, KAT_ECDH_GIY));
+    if(mbedtls_ecp_point_cmp(&q, &peer) != 0)
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_point_read_string(&peer, 16, KAT_ECDH_GRX, KAT_ECDH_GRY));
+    MBEDTLS_MPI_CHK(mbedtls_ecdh_compute_shared(&grp, &z, &peer, &d, kat_rng, &k));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_string(&want, 16, KAT_ECDH_Z));
+    if(mbedtls_mpi_cmp_mpi(&z, &want) != 0)
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
+    if(verbose != 0)
+        mbedtls_printf("  P-256 ECDH (RFC 5903): passed\n");
+
+    /* ECDSA: the signature with the vector nonce, and its verification */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_string(&d, 16, KAT_ECDSA_X));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_string(&k, 16, KAT_ECDSA_K));
+    MBEDTLS_MPI_CHK(mbedtls_ecdsa_sign(&grp, &r, &s, &d, kat_sample_sha256, sizeof(kat_sample_sha256),
+                                       kat_rng, &k));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_string(&want, 16, KAT_ECDSA_R));
+    if(mbedtls_mpi_cmp_mpi(&r, &want) != 0)
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_string(&want, 16, KAT_ECDSA_S));
+    if(mbedtls_mpi_cmp_mpi(&s, &want) != 0)
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_point_read_string(&q, 16, KAT_ECDSA_UX, KAT_ECDSA_UY));
+    MBEDTLS_MPI_CHK(mbedtls_ecdsa_verify(&grp, kat_sample_sha256, sizeof(kat_sample_sha256), &q, &r, &s));
+
+    /* The same signature with one bit of s flipped must be rejected */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_set_bit(&s, 0, !mbedtls_mpi_get_bit(&s, 0)));
+    ret = mbedtls_ecdsa_verify(&grp, kat_sample_sha256, sizeof(kat_sample_sha256), &q, &r, &s);
+    if(ret != MBEDTLS_ERR_ECP_VERIFY_FAILED)
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+    ret = 0;
+
+    if(verbose != 0)
+        mbedtls_printf("  P-256 ECDSA (RFC 6979): passed\n");
+
+cleanup:
+    if(ret != 0)
+        mbedtls_printf("  P-256 ECDH/ECDSA known answer test failed (-0x%04x)\n", (unsigned int) - ret);
+
+    mbedtls_ecp_group_free(&grp);
+    mbedtls_ecp_point_free(&q);
+    mbedtls_ecp_point_free(&peer);
+    mbedtls_mpi_free(&k);
+    mbedtls_mpi_free(&d);
+    mbedtls_mpi_free(&z);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&want);
+    return ret;
+}
+
+#endif /* MBEDTLS_ECP_DP_SECP256R1_ENABLED */
+
+#endif /* MBEDTLS_ECDH_C && MBEDTLS_ECDSA_C */
+
+/**
+ * Run the mbedTLS known answer tests of the accelerated modules, the SHA
+ * context clone tests and the job queue tests, then check ECDH and ECDSA
+ * against the P-256 vectors of RFC 5903 and RFC 6979.
+ *
+ * @param verbose print each test as it runs
+ * @return 0 if all tests passed
+ */
+int crypto_alt_self_test(int verbose)
+{
+    int ret = 0;
+
+#if defined(MBEDTLS_AES_C)
+    if((ret = mbedtls_aes_self_test(verbose)) != 0)
+        return ret;
+#endif
+#if defined(MBEDTLS_SHA256_C)
+    if((ret = mbedtls_sha256_self_test(verbose)) != 0)
+        return ret;
+#endif
+#if defined(MBEDTLS_SHA512_C)
+    if((ret = mbedtls_sha512_self_test(verbose)) != 0)
+        return ret;
+#endif
+#if defined(CLONE_TEST)
+    if((ret = sha_clone_test(verbose)) != 0)
+        return ret;
+#endif
+#if defined(JOB_TEST)
+    if((ret = job_test(verbose)) != 0)
+        return ret;
+#endif
+#if defined(MBEDTLS_GCM_C)
+    if((ret = mbedtls_gcm_self_test(verbose)) != 0)
+        return ret;
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+    if((ret = ecc_kat_test(verbose)) != 0)
+        return ret;
+#endif
+
+    return ret;
+}
+
+#endif /* MBEDTLS_SELF_TEST */
+
+#if defined(CRYPTO_ALT_BENCHMARK)
+
+#define BENCH_RECORD_SIZE   (16 * 1024)     /* Largest TLS record */
+#define BENCH_RECORDS       64
+#define BENCH_ECC_ROUNDS    8
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECDSA_C)
+
+static uint32_t bench_seed = 0x2545F491;
+
+/* Not a real RNG, key material for timing only */
+static int bench_rng(void *p_rng, unsigned char *out, size_t len)
+{
+    (void)p_rng;
+
+    while(len--)
+    {
+        bench_seed ^= bench_seed << 13;
+        bench_seed ^= bench_seed >> 17;
+        bench_seed ^= bench_seed << 5;
+        *out++ = (unsigned char)bench_seed;
+    }
+    return 0;
+}
+
+static int ticks_to_us(uint64_t ticks)
+{
+    return (int)(ticks / 12 / BENCH_ECC_ROUNDS);    /* 12 MHz */
+}
+
+/*
+ * ECDH key agreement and ECDSA sign/verify round trip on one curve, timed
+ * per operation. Both sides of the exchange must agree and every signature
+ * must verify.
+ */
+static int bench_ecc(mbedtls_ecp_group_id id, const char *name)
+{
+    unsigned char hash[32] = { 0 };
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point qa, qb;
+    mbedtls_mpi da, db, za, zb, r, s;
+    uint64_t t0, t_gen = 0, t_shared = 0, t_sign = 0, t_verify = 0;
+    int i, ret;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&qa);
+    mbedtls_ecp_point_init(&qb);
+    mbedtls_mpi_init(&da);
+    mbedtls_mpi_init(&db);
+    mbedtls_mpi_init(&za);
+    mbedtls_mpi_init(&zb);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_group_load(&grp, id));
+
+    for(i = 0; i < BENCH_ECC_ROUNDS; i++)
+    {
+        t0 = EL0_GetCurrentPhysicalValue();
+        MBEDTLS_MPI_CHK(mbedtls_ecdh_gen_public(&grp, &da, &qa, bench_rng, NULL));
+        t_gen += EL0_GetCurrentPhysicalValue() - t0;
+        MBEDTLS_MPI_CHK(mbedtls_ecdh_gen_public(&grp, &db, &qb, bench_rng, NULL));
+
+        t0 = EL0_GetCurrentPhysicalValue();
+        MBEDTLS_MPI_CHK(mbedtls_ecdh_compute_shared(&grp, &za, &qb, &da, bench_rng, NULL));
+        t_shared += EL0_GetCurrentPhysicalValue() - t0;
+        MBEDTLS_MPI_CHK(mbedtls_ecdh_compute_shared(&grp, &zb, &qa, &db, bench_rng, NULL));
+
+        if(mbedtls_mpi_cmp_mpi(&za, &zb) != 0)
+        {
+            ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+            goto cleanup;
+        }
+
+        hash[i % sizeof(hash)] ^= (unsigned char)(i + 1);
+
+        t0 = EL0_GetCurrentPhysicalValue();
+        MBEDTLS_MPI_CHK(mbedtls_ecdsa_sign(&grp, &r, &s, &da, hash, sizeof(hash), bench_rng, NULL));
+        t_sign += EL0_GetCurrentPhysicalValue() - t0;
+
+        t0 = EL0_GetCurrentPhysicalValue();
+        MBEDTLS_MPI_CHK(mbedtls_ecdsa_verify(&grp, hash, sizeof(hash), &qa, &r, &s));
+        t_verify += EL0_GetCurrentPhysicalValue() - t0;
+
+        /* A signature over another hash must be rejected */
+        hash[0] ^= 0x80;
+        ret = mbedtls_ecdsa_verify(&grp, hash, sizeof(hash), &qa, &r, &s);
+        hash[0] ^= 0x80;
+        if(ret != MBEDTLS_ERR_ECP_VERIFY_FAILED)
+        {
+            ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+            goto cleanup;
+        }
+        ret = 0;
+    }
+
+    mbedtls_printf("  %s ECDH keygen %d us, shared %d us, ECDSA sign %d us, verify %d us\n", name,
+                   ticks_to_us(t_gen), ticks_to_us(t_shared), ticks_to_us(t_sign), ticks_to_us(t_verify));
+
+cleanup:
+    if(ret != 0)
+        mbedtls_printf("  %s ECDH/ECDSA test failed (-0x%04x)\n", name, (unsigned int) - ret);
+
+    mbedtls_ecp_group_free(&grp);
+    mbedtls_ecp_point_free(&qa);
+    mbedtls_ecp_point_free(&qb);
+    mbedtls_mpi_free(&da);
+    mbedtls_mpi_free(&db);
+    mbedtls_mpi_free(&za);
+    mbedtls_mpi_free(&zb);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&s);
+    return ret;
+}
+
+#endif /* MBEDTLS_ECDH_C && MBEDTLS_ECDSA_C */
+
+/**
+ * Time AES-GCM encryption and SHA-256 hashing of full size TLS records, then
+ * the ECDH and ECDSA operations of a handshake on the engine and software
+ * curves. Each curve also checks that both ends agree and that every
+ * signature verifies.
+ *
+ * @return 0 if all operations succeeded
+ */
+int crypto_alt_benchmark(void)
+{
+    static const unsigned char key[32] = { 0 };
+    unsigned char iv[12] = { 0 };
+    unsigned char tag[16];
+    unsigned char digest[32];
+    mbedtls_gcm_context gcm;
+    unsigned char *buf;
+    uint64_t t0, ticks;
+    int i, ret = 0;
+
+#if defined(MBEDTLS_GCM_C)
+    if((buf = mbedtls_calloc(1, BENCH_RECORD_SIZE)) == NULL)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    mbedtls_gcm_init(&gcm);
+    mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, 128);
+
+    t0 = EL0_GetCurrentPhysicalValue();
+    for(i = 0; i < BENCH_RECORDS; i++)
+    {
+        iv[11] = (unsigned char)i;
+        if((ret = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, BENCH_RECORD_SIZE, iv, sizeof(iv),
+                                            NULL, 0, buf, buf, sizeof(tag), tag)) != 0)
+            break;
+    }
+    ticks = EL0_GetCurrentPhysicalValue() - t0;     /* 12 MHz */
+
+    mbedtls_gcm_free(&gcm);
+
+    if(ret == 0)
+        mbedtls_printf("  AES-128-GCM %d byte records: %d KB/s\n", BENCH_RECORD_SIZE,
+                       (int)((uint64_t)BENCH_RECORDS * BENCH_RECORD_SIZE * 12000000 / 1024 / (ticks ? ticks : 1)));
+
+#if defined(MBEDTLS_SHA256_C)
+    t0 = EL0_GetCurrentPhysicalValue();
+    for(i = 0; (ret == 0) && (i < BENCH_RECORDS); i++)
+        ret = mbedtls_sha256(buf, BENCH_RECORD_SIZE, digest, 0);
+    ticks = EL0_GetCurrentPhysicalValue() - t0;
+
+    if(ret == 0)
+        mbedtls_printf("  SHA-256 %d byte records: %d KB/s\n", BENCH_RECORD_SIZE,
+                       (int)((uint64_t)BENCH_RECORDS * BENCH_RECORD_SIZE * 12000000 / 1024 / (ticks ? ticks : 1)));
+#endif
+
+    mbedtls_free(buf);
+    if(ret != 0)
+        return ret;
+#endif
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECDSA_C)
+#if defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+    if((ret = bench_ecc(MBEDTLS_ECP_DP_SECP256R1, "P-256")) != 0)
+        return ret;
+#endif
+#if defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
+    if((ret = bench_ecc(MBEDTLS_ECP_DP_SECP384R1, "P-384")) != 0)
+        return ret;
+#endif
+#if defined(MBEDTLS_ECP_DP_BP256R1_ENABLED)
+    if((ret = bench_ecc(MBEDTLS_ECP_DP_BP256R1, "BP-256")) != 0)
+        return ret;
+#endif
+#endif
+
+    return ret;
+}
+
+#endif /* CRYPTO_ALT_BENCHMARK */
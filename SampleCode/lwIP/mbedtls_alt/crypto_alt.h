@@ -0,0 +1,64 @@
+/**************************************************************************//**
+ * @file     crypto_alt.h
+ * @brief    CRYPTO engine access shared by the mbedTLS alternate implementations
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __CRYPTO_ALT_H__
+#define __CRYPTO_ALT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* DMA bounce buffer size per direction, a multiple of the 64-byte cache line */
+#ifndef CRYPTO_ALT_DMA_BUF_SIZE
+#define CRYPTO_ALT_DMA_BUF_SIZE     4096
+#endif
+
+/* AES requests shorter than this are done in software, DMA setup costs more */
+#ifndef CRYPTO_ALT_AES_DMA_MIN
+#define CRYPTO_ALT_AES_DMA_MIN      64
+#endif
+
+/* AES requests in whole cache lines of 64-byte aligned buffers go through
+   the job queue (crypto_job.c) without a copy, and the calling task sleeps
+   until the engine interrupt instead of polling. 0 keeps them on the
+   bounce buffers. */
+#ifndef CRYPTO_ALT_AES_JOB
+#define CRYPTO_ALT_AES_JOB          1
+#endif
+
+/* Digests are started in software and move to the engine once this much
+   data has been queued before the first block is compressed */
+#ifndef CRYPTO_ALT_SHA_DMA_MIN
+#define CRYPTO_ALT_SHA_DMA_MIN      512
+#endif
+
+/* Cache line aligned bounce buffers, only valid while the engine is locked */
+extern uint8_t crypto_alt_dma_in[CRYPTO_ALT_DMA_BUF_SIZE];
+extern uint8_t crypto_alt_dma_out[CRYPTO_ALT_DMA_BUF_SIZE];
+
+void crypto_alt_init(void);
+void crypto_alt_lock(void);
+void crypto_alt_unlock(void);
+
+/* The SHA engine keeps one running digest between jobs, it belongs to one
+   context from its first cascade job until finish or free */
+int  crypto_alt_sha_acquire(const void *owner);
+void crypto_alt_sha_release(const void *owner);
+
+/* Known answer tests, built with MBEDTLS_SELF_TEST */
+int crypto_alt_self_test(int verbose);
+/* Record and handshake timings, built with CRYPTO_ALT_BENCHMARK */
+int crypto_alt_benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_ALT_H__ */
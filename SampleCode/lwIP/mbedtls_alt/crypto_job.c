@@ -0,0 +1,494 @@
+/**************************************************************************//**
+ * @file     crypto_job.c
+ * @brief    Asynchronous AES, SHA and ECC jobs on the CRYPTO engine.
+ *
+ *           Each engine has a FIFO of jobs. The arbiter task takes the
+ *           engine lock for a batch of up to CRYPTO_JOB_BATCH jobs, starts
+ *           the AES and SHA engines and runs ECC jobs itself while they
+ *           work. CRYPTO_IRQHandler completes AES and SHA jobs and starts
+ *           the next one on the same engine, so the arbiter only wakes up
+ *           when an engine runs dry, the batch ends or a job times out.
+ *           If an mbedTLS hash context holds the SHA engine digest, SHA
+ *           jobs are hashed in software once the lock has been released.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "NuMicro.h"
+#include "crypto_alt.h"
+#include "crypto_job.h"
+
+#include "mbedtls/error.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+
+#define JOB_ENGINES         3
+#define JOB_ALIGNED(p)      ((ptr_to_u32(p) & 0x3F) == 0)
+
+typedef struct
+{
+    crypto_job_t *head;
+    crypto_job_t *tail;
+    crypto_job_t *active;       /*!< On the engine, AES and SHA only */
+}
+job_queue_t;
+
+/* Shared with the interrupt handler, changed with interrupts masked */
+static job_queue_t job_q[JOB_ENGINES];
+static int batch_open;          /* the arbiter holds the engine lock */
+static int batch_budget;        /* jobs left to start in this batch */
+static int batch_sha_hw;        /* the arbiter holds the SHA engine digest */
+
+static TaskHandle_t job_task;
+static CRYPTO_CALLBACK_T job_prev_isr;  /* installed before, gets every event */
+
+static void job_push(job_queue_t *q, crypto_job_t *job)
+{
+    job->next = NULL;
+    if(q->tail == NULL)
+        q->head = job;
+    else
+        q->tail->next = job;
+    q->tail = job;
+}
+
+static crypto_job_t *job_pop(job_queue_t *q)
+{
+    crypto_job_t *job = q->head;
+
+    if(job != NULL)
+    {
+        q->head = job->next;
+        if(q->head == NULL)
+            q->tail = NULL;
+        job->next = NULL;
+    }
+    return job;
+}
+
+static int job_sha_len(uint32_t opmode)
+{
+    switch(opmode)
+    {
+        case SHA_MODE_SHA1:
+            return 20;
+        case SHA_MODE_SHA224:
+            return 28;
+        case SHA_MODE_SHA256:
+            return 32;
+        case SHA_MODE_SHA384:
+            return 48;
+        case SHA_MODE_SHA512:
+            return 64;
+        default:
+            return 0;
+    }
+}
+
+/* Program and start the engine, interrupts masked and the engine locked */
+static void job_start(int type, crypto_job_t *job, TickType_t now)
+{
+    job_queue_t *q = &job_q[type];
+
+    job->started = now;
+    q->active = job;
+
+    if(type == CRYPTO_JOB_AES)
+    {
+        AES_Open(CRPT, job->u.aes.encrypt, job->u.aes.opmode, job->u.aes.keysz, AES_IN_OUT_SWAP);
+        if(job->u.aes.ksnum < 0)
+            AES_SetKey(CRPT, job->u.aes.key, job->u.aes.keysz);
+        AES_SetInitVect(CRPT, job->u.aes.iv);
+        AES_SetDMATransfer(CRPT, 0, 0, ptr_to_u32(job->u.aes.in), ptr_to_u32(job->u.aes.out), job->u.aes.len);
+
+        if(job->u.aes.ksnum < 0)
+            AES_Trigger(CRPT, 0, CRYPTO_DMA_ONE_SHOT);
+        else
+            AES_Trigger_KS(CRPT, CRYPTO_DMA_ONE_SHOT, 0, job->u.aes.ksnum);
+    }
+    else
+    {
+        SHA_Open(CRPT, job->u.sha.opmode, SHA_IN_OUT_SWAP, 0);
+        SHA_SetDMATransfer(CRPT, ptr_to_u32(job->u.sha.in), job->u.sha.len);
+        SHA_Trigger(CRPT, CRYPTO_DMA_ONE_SHOT);
+    }
+}
+
+/* Start the next queued job if the engine is idle and the batch allows it */
+static void job_feed(int type, TickType_t now)
+{
+    job_queue_t *q = &job_q[type];
+
+    if(!batch_open || (batch_budget == 0) || (q->active != NULL) || (q->head == NULL))
+        return;
+
+    if((type == CRYPTO_JOB_SHA) && !batch_sha_hw)
+        return;
+
+    batch_budget--;
+    job_start(type, job_pop(q), now);
+}
+
+/* Report a finished job, status is 0 or an mbedTLS error code */
+static void job_done(crypto_job_t *job, int status, int from_isr, BaseType_t *woken)
+{
+    TaskHandle_t waiter = job->waiter;
+
+    job->status = status;
+
+    if(job->complete != NULL)
+        job->complete(job, from_isr);
+
+    if(waiter != NULL)
+    {
+        if(from_isr)
+            vTaskNotifyGiveFromISR(waiter, woken);
+        else
+            xTaskNotifyGive(waiter);
+    }
+}
+
+/*
+ * Take the finished job off an engine and chain the next one, interrupts
+ * masked. Returns NULL if the interrupt was not for a queued job.
+ */
+static crypto_job_t *job_finish(int type, int status, TickType_t now)
+{
+    job_queue_t *q = &job_q[type];
+    crypto_job_t *job = q->active;
+    uint32_t dgst[16];
+    int i;
+
+    if(job == NULL)
+        return NULL;    /* a synchronous AES_Start() or SHA_Start() user */
+
+    q->active = NULL;
+
+    if(status == 0)
+    {
+        if(type == CRYPTO_JOB_AES)
+        {
+            dcache_invalidate_by_mva(job->u.aes.out, job->u.aes.len);
+        }
+        else
+        {
+            SHA_Read(CRPT, dgst);
+            for(i = 0; i < job_sha_len(job->u.sha.opmode) / 4; i++)
+            {
+                job->u.sha.digest[4 * i] = (unsigned char)(dgst[i] >> 24);
+                job->u.sha.digest[4 * i + 1] = (unsigned char)(dgst[i] >> 16);
+                job->u.sha.digest[4 * i + 2] = (unsigned char)(dgst[i] >> 8);
+                job->u.sha.digest[4 * i + 3] = (unsigned char)dgst[i];
+            }
+        }
+    }
+
+    job_feed(type, now);
+
+    return job;
+}
+
+static void crypto_job_isr(uint32_t u32Events)
+{
+    static const uint32_t done_evt[2] = { CRYPTO_EVT_AES | CRYPTO_EVT_AES_ERR, CRYPTO_EVT_SHA | CRYPTO_EVT_SHA_ERR };
+    static const uint32_t err_evt[2] = { CRYPTO_EVT_AES_ERR, CRYPTO_EVT_SHA_ERR };
+    crypto_job_t *done[2] = { NULL, NULL };
+    int status[2] = { 0, 0 };
+    BaseType_t woken = pdFALSE;
+    TickType_t now = xTaskGetTickCountFromISR();
+    UBaseType_t mask;
+    int idle = 0, type;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    for(type = CRYPTO_JOB_AES; type <= CRYPTO_JOB_SHA; type++)
+    {
+        if(u32Events & done_evt[type])
+        {
+            status[type] = (u32Events & err_evt[type]) ? MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED : 0;
+            done[type] = job_finish(type, status[type], now);
+            if((done[type] != NULL) && (job_q[type].active == NULL))
+                idle = 1;
+        }
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    for(type = CRYPTO_JOB_AES; type <= CRYPTO_JOB_SHA; type++)
+    {
+        if(done[type] != NULL)
+            job_done(done[type], status[type], 1, &woken);
+    }
+
+    /* Nothing chained, the arbiter refills the engine or ends the batch */
+    if(idle)
+        vTaskNotifyGiveFromISR(job_task, &woken);
+
+    /* Other modules may run their own jobs through the callback */
+    if(job_prev_isr != NULL)
+        job_prev_isr(u32Events);
+
+    /* Switch at the next tick, as ethernetif does */
+    // portYIELD_FROM_ISR(woken);
+}
+
+/* Fail engine jobs that have not completed in time */
+static void job_expire(void)
+{
+    crypto_job_t *late[2] = { NULL, NULL };
+    TickType_t now = xTaskGetTickCount();
+    int type;
+
+    taskENTER_CRITICAL();
+    for(type = CRYPTO_JOB_AES; type <= CRYPTO_JOB_SHA; type++)
+    {
+        late[type] = job_q[type].active;
+        if((late[type] == NULL) || (now - late[type]->started < pdMS_TO_TICKS(CRYPTO_JOB_TIMEOUT_MS)))
+        {
+            late[type] = NULL;
+            continue;
+        }
+
+        if(type == CRYPTO_JOB_AES)
+            CRPT->AES_CTL = CRPT_AES_CTL_STOP_Msk;
+        else
+            CRPT->HMAC_CTL = CRPT_HMAC_CTL_STOP_Msk;
+        job_q[type].active = NULL;
+    }
+    taskEXIT_CRITICAL();
+
+    for(type = CRYPTO_JOB_AES; type <= CRYPTO_JOB_SHA; type++)
+    {
+        if(late[type] != NULL)
+            job_done(late[type], MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED, 0, NULL);
+    }
+}
+
+static int job_sha_sw(crypto_job_t *job)
+{
+    switch(job->u.sha.opmode)
+    {
+#if defined(MBEDTLS_SHA1_C)
+        case SHA_MODE_SHA1:
+            return mbedtls_sha1(job->u.sha.in, job->u.sha.len, job->u.sha.digest);
+#endif
+#if defined(MBEDTLS_SHA256_C)
+        case SHA_MODE_SHA224:
+        case SHA_MODE_SHA256:
+            return mbedtls_sha256(job->u.sha.in, job->u.sha.len, job->u.sha.digest,
+                                  job->u.sha.opmode == SHA_MODE_SHA224);
+#endif
+#if defined(MBEDTLS_SHA512_C)
+        case SHA_MODE_SHA384:
+        case SHA_MODE_SHA512:
+            return mbedtls_sha512(job->u.sha.in, job->u.sha.len, job->u.sha.digest,
+                                  job->u.sha.opmode == SHA_MODE_SHA384);
+#endif
+        default:
+            return MBEDTLS_ERR_PLATFORM_FEATURE_UNSUPPORTED;
+    }
+}
+
+static int job_pending(void)
+{
+    int type, pending = 0;
+
+    taskENTER_CRITICAL();
+    for(type = 0; type < JOB_ENGINES; type++)
+    {
+        if(job_q[type].head != NULL)
+            pending = 1;
+    }
+    taskEXIT_CRITICAL();
+
+    return pending;
+}
+
+/* Hold the engine for one batch of jobs, then give other users a turn */
+static void job_batch(void)
+{
+    crypto_job_t *job;
+    int sha_hw, busy, n;
+
+    crypto_alt_lock();
+    sha_hw = (crypto_alt_sha_acquire(job_q) == 0);
+
+    taskENTER_CRITICAL();
+    batch_open = 1;
+    batch_budget = CRYPTO_JOB_BATCH;
+    batch_sha_hw = sha_hw;
+    taskEXIT_CRITICAL();
+
+    for(;;)
+    {
+        taskENTER_CRITICAL();
+        job_feed(CRYPTO_JOB_AES, xTaskGetTickCount());
+        job_feed(CRYPTO_JOB_SHA, xTaskGetTickCount());
+        job = NULL;
+        if(batch_budget > 0)
+        {
+            job = job_pop(&job_q[CRYPTO_JOB_ECC]);
+            if(job != NULL)
+                batch_budget--;
+        }
+        busy = (job_q[CRYPTO_JOB_AES].active != NULL) || (job_q[CRYPTO_JOB_SHA].active != NULL);
+        taskEXIT_CRITICAL();
+
+        /* The ECC routines poll the engine, run them while AES and SHA work */
+        if(job != NULL)
+        {
+            job_done(job, job->u.ecc.fn(job->arg), 0, NULL);
+            continue;
+        }
+
+        if(!busy)
+            break;
+
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CRYPTO_JOB_TIMEOUT_MS));
+        job_expire();
+    }
+
+    taskENTER_CRITICAL();
+    batch_open = 0;
+    taskEXIT_CRITICAL();
+
+    if(sha_hw)
+        crypto_alt_sha_release(job_q);
+    crypto_alt_unlock();
+
+    /* An mbedTLS context owns the engine digest, hash without the lock held */
+    for(n = 0; !sha_hw && (n < CRYPTO_JOB_BATCH); n++)
+    {
+        taskENTER_CRITICAL();
+        job = job_pop(&job_q[CRYPTO_JOB_SHA]);
+        taskEXIT_CRITICAL();
+
+        if(job == NULL)
+            break;
+
+        job_done(job, job_sha_sw(job), 0, NULL);
+    }
+
+    taskYIELD();
+}
+
+static void crypto_job_task(void *arg)
+{
+    (void)arg;
+
+    for(;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while(job_pending())
+            job_batch();
+    }
+}
+
+/**
+ * Start the arbiter task and route CRYPTO interrupts to the job queue. The
+ * callback installed before keeps getting every event. Called on first
+ * submit; may also be called from main().
+ *
+ * @return 0 or MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED
+ */
+int crypto_job_init(void)
+{
+    BaseType_t ret = pdPASS;
+
+    crypto_alt_init();
+
+    vTaskSuspendAll();
+    if(job_task == NULL)
+    {
+        /* The completion callback calls interrupt safe API */
+        IRQ_SetPriority((IRQn_ID_t)CRPT_IRQn, (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY + 1) << portPRIORITY_SHIFT);
+        ret = xTaskCreate(crypto_job_task, "crypto", CRYPTO_JOB_TASK_STACK, NULL,
+                          CRYPTO_JOB_TASK_PRIORITY, &job_task);
+        if(ret == pdPASS)
+            job_prev_isr = CRYPTO_SetCallback(crypto_job_isr);
+    }
+    xTaskResumeAll();
+
+    return (ret == pdPASS) ? 0 : MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+}
+
+static int job_queue(crypto_job_t *job, TaskHandle_t waiter)
+{
+    int ret;
+
+    if((job_task == NULL) && ((ret = crypto_job_init()) != 0))
+        return ret;
+
+    switch(job->type)
+    {
+        case CRYPTO_JOB_AES:
+            if((job->u.aes.len == 0) || !JOB_ALIGNED(job->u.aes.in) || !JOB_ALIGNED(job->u.aes.out))
+                return MBEDTLS_ERR_ERROR_GENERIC_ERROR;
+
+            /* Flush the input and drop stale output lines before the DMA */
+            dcache_clean_by_mva((void *)job->u.aes.in, job->u.aes.len);
+            dcache_invalidate_by_mva(job->u.aes.out, job->u.aes.len);
+            break;
+
+        case CRYPTO_JOB_SHA:
+            if((job->u.sha.len == 0) || !JOB_ALIGNED(job->u.sha.in) || (job_sha_len(job->u.sha.opmode) == 0))
+                return MBEDTLS_ERR_ERROR_GENERIC_ERROR;
+
+            dcache_clean_by_mva((void *)job->u.sha.in, job->u.sha.len);
+            break;
+
+        case CRYPTO_JOB_ECC:
+            if(job->u.ecc.fn == NULL)
+                return MBEDTLS_ERR_ERROR_GENERIC_ERROR;
+            break;
+
+        default:
+            return MBEDTLS_ERR_ERROR_GENERIC_ERROR;
+    }
+
+    job->status = CRYPTO_JOB_PENDING;
+    job->waiter = waiter;
+
+    taskENTER_CRITICAL();
+    job_push(&job_q[job->type], job);
+    taskEXIT_CRITICAL();
+
+    xTaskNotifyGive(job_task);
+
+    return 0;
+}
+
+/**
+ * Queue a job and return at once. job->complete is called, or job->status
+ * leaves CRYPTO_JOB_PENDING, when it is done.
+ *
+ * @param job filled in job, owned by the queue until it completes
+ * @return 0 if queued, MBEDTLS_ERR_ERROR_GENERIC_ERROR for a bad job
+ */
+int crypto_job_submit(crypto_job_t *job)
+{
+    return job_queue(job, NULL);
+}
+
+/**
+ * Queue a job and sleep until it is done.
+ *
+ * @param job filled in job
+ * @return the job status, 0 or an mbedTLS error code
+ */
+int crypto_job_run(crypto_job_t *job)
+{
+    int ret;
+
+    if((ret = job_queue(job, xTaskGetCurrentTaskHandle())) != 0)
+        return ret;
+
+    while(job->status == CRYPTO_JOB_PENDING)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    return job->status;
+}
@@ -0,0 +1,112 @@
+/**************************************************************************//**
+ * @file     crypto_job.h
+ * @brief    Asynchronous AES, SHA and ECC jobs on the CRYPTO engine. Jobs are
+ *           queued per engine, started by an arbiter task and completed from
+ *           CRYPTO_IRQHandler, so several tasks can keep the engines busy
+ *           without polling.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __CRYPTO_JOB_H__
+#define __CRYPTO_JOB_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Jobs started per hold of the engine lock before other users get a turn */
+#ifndef CRYPTO_JOB_BATCH
+#define CRYPTO_JOB_BATCH        8
+#endif
+
+/* An engine job not completed within this many ms is failed */
+#ifndef CRYPTO_JOB_TIMEOUT_MS
+#define CRYPTO_JOB_TIMEOUT_MS   1000
+#endif
+
+#ifndef CRYPTO_JOB_TASK_PRIORITY
+#define CRYPTO_JOB_TASK_PRIORITY    (configMAX_PRIORITIES - 2)
+#endif
+
+#ifndef CRYPTO_JOB_TASK_STACK
+#define CRYPTO_JOB_TASK_STACK   (configMINIMAL_STACK_SIZE * 4)
+#endif
+
+#define CRYPTO_JOB_AES          0
+#define CRYPTO_JOB_SHA          1
+#define CRYPTO_JOB_ECC          2
+
+#define CRYPTO_JOB_PENDING      1       /* status while queued or running */
+
+typedef struct crypto_job crypto_job_t;
+
+/*
+ * Called once per job with its status set. Engine jobs complete from
+ * CRYPTO_IRQHandler (from_isr = 1) and may only use FromISR APIs there;
+ * ECC jobs, software SHA jobs and failed jobs complete from the arbiter task.
+ */
+typedef void (*crypto_job_complete_t)(crypto_job_t *job, int from_isr);
+
+/*
+ * AES and SHA data is moved by the engine DMA straight from and to the
+ * caller buffers, which must start and end on a 64-byte cache line and
+ * must not be touched until the job completes.
+ */
+struct crypto_job
+{
+    int type;                           /*!< CRYPTO_JOB_xxx */
+    union
+    {
+        struct
+        {
+            uint32_t opmode;            /*!< AES_MODE_ECB/CBC/CFB/OFB/CTR */
+            uint32_t encrypt;           /*!< AES_MODE_ENCRYPT or AES_MODE_DECRYPT */
+            uint32_t keysz;             /*!< AES_KEY_SIZE_xxx */
+            uint32_t key[8];            /*!< Key words, unused with a Key Store key */
+            int ksnum;                  /*!< Key Store SRAM key number, -1 to use key[] */
+            uint32_t iv[4];             /*!< IV or counter words */
+            const void *in;
+            void *out;
+            uint32_t len;
+        } aes;
+        struct
+        {
+            uint32_t opmode;            /*!< SHA_MODE_SHA1/224/256/384/512 */
+            const void *in;
+            uint32_t len;
+            unsigned char digest[64];   /*!< Result, big-endian */
+        } sha;
+        struct
+        {
+            /* Runs in the arbiter task with the engine locked, so it must
+               use the ECC_xxx driver calls and not mbedTLS */
+            int (*fn)(void *arg);
+        } ecc;
+    } u;
+
+    crypto_job_complete_t complete;     /*!< May be NULL */
+    void *arg;                          /*!< For complete and ecc.fn */
+    volatile int status;                /*!< CRYPTO_JOB_PENDING, then 0 or < 0 */
+
+    /* Owned by the queue */
+    crypto_job_t *next;
+    TaskHandle_t waiter;
+    TickType_t started;
+};
+
+int  crypto_job_init(void);
+int  crypto_job_submit(crypto_job_t *job);
+int  crypto_job_run(crypto_job_t *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_JOB_H__ */
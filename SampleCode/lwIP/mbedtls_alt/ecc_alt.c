@@ -0,0 +1,385 @@
+/**************************************************************************//**
+ * @file     ecc_alt.c
+ * @brief    mbedTLS MBEDTLS_ECDH_GEN_PUBLIC_ALT, MBEDTLS_ECDH_COMPUTE_SHARED_ALT,
+ *           MBEDTLS_ECDSA_SIGN_ALT and MBEDTLS_ECDSA_VERIFY_ALT on the CRYPTO
+ *           ECC engine. NIST prime curves P-224 to P-521 run on the engine,
+ *           other groups fall back to the mbedTLS ECP arithmetic.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "common.h"
+
+#if defined(MBEDTLS_ECP_C)
+
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include "NuMicro.h"
+#include "crypto_alt.h"
+
+#if defined(MBEDTLS_ECDH_GEN_PUBLIC_ALT) || defined(MBEDTLS_ECDH_COMPUTE_SHARED_ALT) || \
+    defined(MBEDTLS_ECDSA_SIGN_ALT) || defined(MBEDTLS_ECDSA_VERIFY_ALT)
+
+/* Big-endian operands of ECC_CurveBytes() bytes, the longest is a P-521 value */
+#define ECC_BIN_SIZE        66
+
+/* Operand buffers, only valid while the engine is locked */
+static unsigned char ecc_bin[5][ECC_BIN_SIZE];
+
+static E_ECC_CURVE ecc_alt_curve(const mbedtls_ecp_group *grp)
+{
+    switch(grp->id)
+    {
+        case MBEDTLS_ECP_DP_SECP224R1:
+            return CURVE_P_224;
+        case MBEDTLS_ECP_DP_SECP256R1:
+            return CURVE_P_256;
+        case MBEDTLS_ECP_DP_SECP384R1:
+            return CURVE_P_384;
+        case MBEDTLS_ECP_DP_SECP521R1:
+            return CURVE_P_521;
+        default:
+            return CURVE_UNDEF;
+    }
+}
+
+static void ecc_bin_zeroize(void)
+{
+    mbedtls_platform_zeroize(ecc_bin, sizeof(ecc_bin));
+}
+
+#endif
+
+#if defined(MBEDTLS_ECDH_GEN_PUBLIC_ALT)
+int mbedtls_ecdh_gen_public(mbedtls_ecp_group *grp, mbedtls_mpi *d, mbedtls_ecp_point *Q,
+                            int (*f_rng)(void *, unsigned char *, size_t),
+                            void *p_rng)
+{
+    E_ECC_CURVE curve = ecc_alt_curve(grp);
+    size_t len;
+    int ret;
+
+    if(curve == CURVE_UNDEF)
+        return mbedtls_ecp_gen_keypair(grp, d, Q, f_rng, p_rng);
+
+    len = (size_t)ECC_CurveBytes(curve);
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_gen_privkey(grp, d, f_rng, p_rng));
+
+    crypto_alt_lock();
+    if((ret = mbedtls_mpi_write_binary(d, ecc_bin[0], len)) == 0)
+    {
+        if(ECC_GeneratePublicKey_Bin(CRPT, curve, ecc_bin[0], ecc_bin[1], ecc_bin[2]) != 0)
+            ret = MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+    }
+    if(ret == 0)
+        ret = mbedtls_mpi_read_binary(&Q->X, ecc_bin[1], len);
+    if(ret == 0)
+        ret = mbedtls_mpi_read_binary(&Q->Y, ecc_bin[2], len);
+    ecc_bin_zeroize();
+    crypto_alt_unlock();
+
+    MBEDTLS_MPI_CHK(ret);
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&Q->Z, 1));
+
+cleanup:
+    return ret;
+}
+#endif /* MBEDTLS_ECDH_GEN_PUBLIC_ALT */
+
+#if defined(MBEDTLS_ECDH_COMPUTE_SHARED_ALT)
+static int ecdh_sw_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
+                                  const mbedtls_ecp_point *Q, const mbedtls_mpi *d,
+                                  int (*f_rng)(void *, unsigned char *, size_t),
+                                  void *p_rng)
+{
+    mbedtls_ecp_point P;
+    int ret;
+
+    mbedtls_ecp_point_init(&P);
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_mul(grp, &P, d, Q, f_rng, p_rng));
+    if(mbedtls_ecp_is_zero(&P))
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+    MBEDTLS_MPI_CHK(mbedtls_mpi_copy(z, &P.X));
+
+cleanup:
+    mbedtls_ecp_point_free(&P);
+    return ret;
+}
+
+int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
+                                const mbedtls_ecp_point *Q, const mbedtls_mpi *d,
+                                int (*f_rng)(void *, unsigned char *, size_t),
+                                void *p_rng)
+{
+    E_ECC_CURVE curve = ecc_alt_curve(grp);
+    size_t len;
+    int ret;
+
+    if(curve == CURVE_UNDEF)
+        return ecdh_sw_compute_shared(grp, z, Q, d, f_rng, p_rng);
+
+    /* The engine stops dead on a bad operand, check everything first */
+    if((ret = mbedtls_ecp_check_privkey(grp, d)) != 0)
+        return ret;
+    if((ret = mbedtls_ecp_check_pubkey(grp, Q)) != 0)
+        return ret;
+
+    len = (size_t)ECC_CurveBytes(curve);
+
+    crypto_alt_lock();
+    if(((ret = mbedtls_mpi_write_binary(d, ecc_bin[0], len)) == 0) &&
+            ((ret = mbedtls_mpi_write_binary(&Q->X, ecc_bin[1], len)) == 0) &&
+            ((ret = mbedtls_mpi_write_binary(&Q->Y, ecc_bin[2], len)) == 0))
+    {
+        if(ECC_GenerateSecretZ_Bin(CRPT, curve, ecc_bin[0], ecc_bin[1], ecc_bin[2], ecc_bin[3]) != 0)
+            ret = MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+        else
+            ret = mbedtls_mpi_read_binary(z, ecc_bin[3], len);
+    }
+    ecc_bin_zeroize();
+    crypto_alt_unlock();
+
+    return ret;
+}
+#endif /* MBEDTLS_ECDH_COMPUTE_SHARED_ALT */
+
+#if defined(MBEDTLS_ECDSA_C) && (defined(MBEDTLS_ECDSA_SIGN_ALT) || defined(MBEDTLS_ECDSA_VERIFY_ALT))
+
+/* Hash to integer, SEC1 4.1.3 step 5 */
+static int ecdsa_derive_mpi(const mbedtls_ecp_group *grp, mbedtls_mpi *x,
+                            const unsigned char *buf, size_t blen)
+{
+    size_t n_size = (grp->nbits + 7) / 8;
+    size_t use_size = (blen > n_size) ? n_size : blen;
+    int ret;
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(x, buf, use_size));
+    if(use_size * 8 > grp->nbits)
+        MBEDTLS_MPI_CHK(mbedtls_mpi_shift_r(x, use_size * 8 - grp->nbits));
+
+    if(mbedtls_mpi_cmp_mpi(x, &grp->N) >= 0)
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(x, x, &grp->N));
+
+cleanup:
+    return ret;
+}
+
+#endif
+
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECDSA_SIGN_ALT)
+
+/* ecdsa.c builds this only along with its own mbedtls_ecdsa_sign() */
+int mbedtls_ecdsa_can_do(mbedtls_ecp_group_id gid)
+{
+    switch(gid)
+    {
+#ifdef MBEDTLS_ECP_DP_CURVE25519_ENABLED
+        case MBEDTLS_ECP_DP_CURVE25519:
+            return 0;
+#endif
+#ifdef MBEDTLS_ECP_DP_CURVE448_ENABLED
+        case MBEDTLS_ECP_DP_CURVE448:
+            return 0;
+#endif
+        default:
+            return 1;
+    }
+}
+
+/* Software signature with a blinded inversion, for groups the engine lacks */
+static int ecdsa_sw_sign(mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
+                         const mbedtls_mpi *d, const mbedtls_mpi *e, const mbedtls_mpi *k,
+                         int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    mbedtls_ecp_point R;
+    mbedtls_mpi t, kt;
+    int ret;
+
+    mbedtls_ecp_point_init(&R);
+    mbedtls_mpi_init(&t);
+    mbedtls_mpi_init(&kt);
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_mul(grp, &R, k, &grp->G, f_rng, p_rng));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(r, &R.X, &grp->N));
+
+    /* s = (e + r * d) * t / (k * t) mod n */
+    MBEDTLS_MPI_CHK(mbedtls_ecp_gen_privkey(grp, &t, f_rng, p_rng));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(s, r, d));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(s, s, e));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(s, s, &t));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&kt, k, &t));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&kt, &kt, &grp->N));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&kt, &kt, &grp->N));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(s, s, &kt));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(s, s, &grp->N));
+
+cleanup:
+    mbedtls_ecp_point_free(&R);
+    mbedtls_mpi_free(&t);
+    mbedtls_mpi_free(&kt);
+    return ret;
+}
+
+int mbedtls_ecdsa_sign(mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
+                       const mbedtls_mpi *d, const unsigned char *buf, size_t blen,
+                       int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    E_ECC_CURVE curve = ecc_alt_curve(grp);
+    size_t len = (size_t)ECC_CurveBytes(curve);
+    mbedtls_mpi e, k;
+    int tries, ret;
+
+    if(!mbedtls_ecdsa_can_do(grp->id) || (grp->N.p == NULL))
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+
+    if((mbedtls_mpi_cmp_int(d, 1) < 0) || (mbedtls_mpi_cmp_mpi(d, &grp->N) >= 0))
+        return MBEDTLS_ERR_ECP_INVALID_KEY;
+
+    mbedtls_mpi_init(&e);
+    mbedtls_mpi_init(&k);
+
+    MBEDTLS_MPI_CHK(ecdsa_derive_mpi(grp, &e, buf, blen));
+
+    for(tries = 0; ; tries++)
+    {
+        if(tries >= 10)
+        {
+            ret = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+            goto cleanup;
+        }
+
+        MBEDTLS_MPI_CHK(mbedtls_ecp_gen_privkey(grp, &k, f_rng, p_rng));
+
+        if(curve == CURVE_UNDEF)
+        {
+            MBEDTLS_MPI_CHK(ecdsa_sw_sign(grp, r, s, d, &e, &k, f_rng, p_rng));
+        }
+        else
+        {
+            crypto_alt_lock();
+            if(((ret = mbedtls_mpi_write_binary(&e, ecc_bin[0], len)) == 0) &&
+                    ((ret = mbedtls_mpi_write_binary(d, ecc_bin[1], len)) == 0) &&
+                    ((ret = mbedtls_mpi_write_binary(&k, ecc_bin[2], len)) == 0))
+            {
+                if(ECC_GenerateSignature_Bin(CRPT, curve, ecc_bin[0], ecc_bin[1], ecc_bin[2], ecc_bin[3], ecc_bin[4]) != 0)
+                    ret = MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+            }
+            if(ret == 0)
+                ret = mbedtls_mpi_read_binary(r, ecc_bin[3], len);
+            if(ret == 0)
+                ret = mbedtls_mpi_read_binary(s, ecc_bin[4], len);
+            ecc_bin_zeroize();
+            crypto_alt_unlock();
+
+            MBEDTLS_MPI_CHK(ret);
+        }
+
+        /* Pick another k if either half came out zero */
+        if((mbedtls_mpi_cmp_int(r, 0) != 0) && (mbedtls_mpi_cmp_int(s, 0) != 0))
+            break;
+    }
+
+cleanup:
+    mbedtls_mpi_free(&e);
+    mbedtls_mpi_free(&k);
+    return ret;
+}
+#endif /* MBEDTLS_ECDSA_SIGN_ALT */
+
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECDSA_VERIFY_ALT)
+int mbedtls_ecdsa_verify(mbedtls_ecp_group *grp,
+                         const unsigned char *buf, size_t blen,
+                         const mbedtls_ecp_point *Q,
+                         const mbedtls_mpi *r,
+                         const mbedtls_mpi *s)
+{
+    E_ECC_CURVE curve = ecc_alt_curve(grp);
+    size_t len = (size_t)ECC_CurveBytes(curve);
+    mbedtls_ecp_point R;
+    mbedtls_mpi e, w, u1, u2;
+    int ret;
+
+    if(!mbedtls_ecdsa_can_do(grp->id) || (grp->N.p == NULL))
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+
+    /* SEC1 4.1.4 step 1, r and s in [1, n-1] */
+    if((mbedtls_mpi_cmp_int(r, 1) < 0) || (mbedtls_mpi_cmp_mpi(r, &grp->N) >= 0) ||
+            (mbedtls_mpi_cmp_int(s, 1) < 0) || (mbedtls_mpi_cmp_mpi(s, &grp->N) >= 0))
+        return MBEDTLS_ERR_ECP_VERIFY_FAILED;
+
+    if((ret = mbedtls_ecp_check_pubkey(grp, Q)) != 0)
+        return ret;
+
+    mbedtls_ecp_point_init(&R);
+    mbedtls_mpi_init(&e);
+    mbedtls_mpi_init(&w);
+    mbedtls_mpi_init(&u1);
+    mbedtls_mpi_init(&u2);
+
+    MBEDTLS_MPI_CHK(ecdsa_derive_mpi(grp, &e, buf, blen));
+
+    if(curve == CURVE_UNDEF)
+    {
+        /* R = (e / s) G + (r / s) Q, valid if R.x = r mod n */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&w, s, &grp->N));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&u1, &e, &w));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&u1, &u1, &grp->N));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&u2, r, &w));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&u2, &u2, &grp->N));
+        MBEDTLS_MPI_CHK(mbedtls_ecp_muladd(grp, &R, &u1, &grp->G, &u2, Q));
+
+        if(mbedtls_ecp_is_zero(&R))
+        {
+            ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+            goto cleanup;
+        }
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&R.X, &R.X, &grp->N));
+        if(mbedtls_mpi_cmp_mpi(&R.X, r) != 0)
+            ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+    }
+    else
+    {
+        crypto_alt_lock();
+        if(((ret = mbedtls_mpi_write_binary(&e, ecc_bin[0], len)) == 0) &&
+                ((ret = mbedtls_mpi_write_binary(&Q->X, ecc_bin[1], len)) == 0) &&
+                ((ret = mbedtls_mpi_write_binary(&Q->Y, ecc_bin[2], len)) == 0) &&
+                ((ret = mbedtls_mpi_write_binary(r, ecc_bin[3], len)) == 0) &&
+                ((ret = mbedtls_mpi_write_binary(s, ecc_bin[4], len)) == 0))
+        {
+            switch(ECC_VerifySignature_Bin(CRPT, curve, ecc_bin[0], ecc_bin[1], ecc_bin[2], ecc_bin[3], ecc_bin[4]))
+            {
+                case 0:
+                    break;
+                case -2:
+                    ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+                    break;
+                default:
+                    ret = MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+                    break;
+            }
+        }
+        crypto_alt_unlock();
+    }
+
+cleanup:
+    mbedtls_ecp_point_free(&R);
+    mbedtls_mpi_free(&e);
+    mbedtls_mpi_free(&w);
+    mbedtls_mpi_free(&u1);
+    mbedtls_mpi_free(&u2);
+    return ret;
+}
+#endif /* MBEDTLS_ECDSA_VERIFY_ALT */
+
+#endif /* MBEDTLS_ECP_C */
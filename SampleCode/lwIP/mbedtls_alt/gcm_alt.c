@@ -0,0 +1,624 @@
+/**************************************************************************//**
+ * @file     gcm_alt.c
+ * @brief    mbedTLS MBEDTLS_GCM_ALT on the CRYPTO AES engine. Whole blocks
+ *           of AES-GCM data are encrypted by the engine in CTR mode through
+ *           DMA; GHASH, the tag and short requests stay in software.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "common.h"
+
+#if defined(MBEDTLS_GCM_C) && defined(MBEDTLS_GCM_ALT)
+
+#include "mbedtls/gcm.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include "crypto_alt.h"
+
+void mbedtls_gcm_init(mbedtls_gcm_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_gcm_context));
+}
+
+/* Encrypt one block with the key given to mbedtls_gcm_setkey() */
+static int gcm_block(mbedtls_gcm_context *ctx, const unsigned char input[16],
+                     unsigned char output[16])
+{
+    size_t olen = 0;
+
+    if(ctx->use_aes)
+        return mbedtls_internal_aes_encrypt(&ctx->aes, input, output);
+
+    return mbedtls_cipher_update(&ctx->cipher_ctx, input, 16, output, &olen);
+}
+
+/*
+ * Precompute small multiples of H, that is set
+ *      HH[i] || HL[i] = H times i,
+ * where i is seen as a field element as in [MGV], ie high-order bits
+ * correspond to low powers of P.
+ */
+static int gcm_gen_table(mbedtls_gcm_context *ctx)
+{
+    int ret, i, j;
+    uint64_t vl, vh;
+    unsigned char h[16];
+
+    memset(h, 0, 16);
+    if((ret = gcm_block(ctx, h, h)) != 0)
+        return ret;
+
+    vh = ((uint64_t)MBEDTLS_GET_UINT32_BE(h, 0) << 32) | MBEDTLS_GET_UINT32_BE(h, 4);
+    vl = ((uint64_t)MBEDTLS_GET_UINT32_BE(h, 8) << 32) | MBEDTLS_GET_UINT32_BE(h, 12);
+
+    /* 8 = 1000 corresponds to 1 in GF(2^128) */
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+
+    /* 0 corresponds to 0 in GF(2^128) */
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for(i = 4; i > 0; i >>= 1)
+    {
+        uint32_t T = (vl & 1) * 0xe1000000U;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ ((uint64_t)T << 32);
+
+        ctx->HL[i] = vl;
+        ctx->HH[i] = vh;
+    }
+
+    for(i = 2; i <= 8; i *= 2)
+    {
+        uint64_t *HiL = ctx->HL + i, *HiH = ctx->HH + i;
+        vh = *HiH;
+        vl = *HiL;
+        for(j = 1; j < i; j++)
+        {
+            HiH[j] = vh ^ ctx->HH[j];
+            HiL[j] = vl ^ ctx->HL[j];
+        }
+    }
+
+    return 0;
+}
+
+int mbedtls_gcm_setkey(mbedtls_gcm_context *ctx,
+                       mbedtls_cipher_id_t cipher,
+                       const unsigned char *key,
+                       unsigned int keybits)
+{
+    const mbedtls_cipher_info_t *cipher_info;
+    int ret;
+
+    if((keybits != 128) && (keybits != 192) && (keybits != 256))
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    cipher_info = mbedtls_cipher_info_from_values(cipher, keybits, MBEDTLS_MODE_ECB);
+    if(cipher_info == NULL)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    if(mbedtls_cipher_info_get_block_size(cipher_info) != 16)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    mbedtls_cipher_free(&ctx->cipher_ctx);
+    mbedtls_aes_free(&ctx->aes);
+
+    ctx->use_aes = (cipher == MBEDTLS_CIPHER_ID_AES);
+    if(ctx->use_aes)
+    {
+        mbedtls_aes_init(&ctx->aes);
+        if((ret = mbedtls_aes_setkey_enc(&ctx->aes, key, keybits)) != 0)
+            return ret;
+    }
+    else
+    {
+        if((ret = mbedtls_cipher_setup(&ctx->cipher_ctx, cipher_info)) != 0)
+            return ret;
+
+        if((ret = mbedtls_cipher_setkey(&ctx->cipher_ctx, key, keybits, MBEDTLS_ENCRYPT)) != 0)
+            return ret;
+    }
+
+    return gcm_gen_table(ctx);
+}
+
+/**
+ * Use an AES key held in Key Store SRAM, see mbedtls_aes_setkey_ks().
+ *
+ * @param ctx GCM context
+ * @param ksnum Key Store SRAM key number
+ * @param keybits 128, 192 or 256
+ * @return 0, MBEDTLS_ERR_GCM_BAD_INPUT or an engine error
+ */
+int mbedtls_gcm_setkey_ks(mbedtls_gcm_context *ctx, int ksnum, unsigned int keybits)
+{
+    int ret;
+
+    if((keybits != 128) && (keybits != 192) && (keybits != 256))
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    mbedtls_cipher_free(&ctx->cipher_ctx);
+    mbedtls_aes_free(&ctx->aes);
+
+    ctx->use_aes = 1;
+    mbedtls_aes_init(&ctx->aes);
+    if((ret = mbedtls_aes_setkey_ks(&ctx->aes, ksnum, keybits)) != 0)
+        return ret;
+
+    return gcm_gen_table(ctx);
+}
+
+/*
+ * Shoup's method for multiplication use this table with
+ *      last4[x] = x times P^128
+ * where x and last4[x] are seen as elements of GF(2^128) as in [MGV]
+ */
+static const uint64_t last4[16] =
+{
+    0x0000, 0x1c20, 0x3840, 0x2460,
+    0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560,
+    0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/* Sets output to x times H using the precomputed tables */
+static void gcm_mult(mbedtls_gcm_context *ctx, const unsigned char x[16],
+                     unsigned char output[16])
+{
+    int i;
+    unsigned char lo, hi, rem;
+    uint64_t zh, zl;
+
+    lo = x[15] & 0xf;
+
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for(i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0xf;
+        hi = (x[i] >> 4) & 0xf;
+
+        if(i != 15)
+        {
+            rem = (unsigned char)zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4);
+            zh ^= (uint64_t)last4[rem] << 48;
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+
+        rem = (unsigned char)zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4);
+        zh ^= (uint64_t)last4[rem] << 48;
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+
+    MBEDTLS_PUT_UINT32_BE(zh >> 32, output, 0);
+    MBEDTLS_PUT_UINT32_BE(zh, output, 4);
+    MBEDTLS_PUT_UINT32_BE(zl >> 32, output, 8);
+    MBEDTLS_PUT_UINT32_BE(zl, output, 12);
+}
+
+/* Fold whole blocks into the authentication state */
+static void gcm_ghash(mbedtls_gcm_context *ctx, const unsigned char *p, size_t length)
+{
+    size_t i;
+
+    while(length >= 16)
+    {
+        for(i = 0; i < 16; i++)
+            ctx->buf[i] ^= p[i];
+
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        length -= 16;
+        p += 16;
+    }
+}
+
+int mbedtls_gcm_starts(mbedtls_gcm_context *ctx,
+                       int mode,
+                       const unsigned char *iv, size_t iv_len)
+{
+    unsigned char work_buf[16];
+    const unsigned char *p;
+    size_t i, use_len;
+
+    /* IV is limited to 2^64 bits, so 2^61 bytes */
+    /* IV is not allowed to be zero length */
+    if((iv_len == 0) || ((uint64_t)iv_len >> 61 != 0))
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    memset(ctx->y, 0x00, sizeof(ctx->y));
+    memset(ctx->buf, 0x00, sizeof(ctx->buf));
+
+    ctx->mode = mode;
+    ctx->len = 0;
+    ctx->add_len = 0;
+
+    if(iv_len == 12)
+    {
+        memcpy(ctx->y, iv, iv_len);
+        ctx->y[15] = 1;
+    }
+    else
+    {
+        memset(work_buf, 0x00, 16);
+        MBEDTLS_PUT_UINT64_BE((uint64_t)iv_len * 8, work_buf, 8);
+
+        p = iv;
+        while(iv_len > 0)
+        {
+            use_len = (iv_len < 16) ? iv_len : 16;
+
+            for(i = 0; i < use_len; i++)
+                ctx->y[i] ^= p[i];
+
+            gcm_mult(ctx, ctx->y, ctx->y);
+
+            iv_len -= use_len;
+            p += use_len;
+        }
+
+        for(i = 0; i < 16; i++)
+            ctx->y[i] ^= work_buf[i];
+
+        gcm_mult(ctx, ctx->y, ctx->y);
+    }
+
+    return gcm_block(ctx, ctx->y, ctx->base_ectr);
+}
+
+int mbedtls_gcm_update_ad(mbedtls_gcm_context *ctx,
+                          const unsigned char *add, size_t add_len)
+{
+    const unsigned char *p;
+    size_t use_len, i, offset;
+
+    /* AD is limited to 2^64 bits, so 2^61 bytes */
+    if((uint64_t)add_len >> 61 != 0)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    offset = ctx->add_len % 16;
+    p = add;
+
+    if(offset != 0)
+    {
+        use_len = 16 - offset;
+        if(use_len > add_len)
+            use_len = add_len;
+
+        for(i = 0; i < use_len; i++)
+            ctx->buf[i + offset] ^= p[i];
+
+        if(offset + use_len == 16)
+            gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        ctx->add_len += use_len;
+        add_len -= use_len;
+        p += use_len;
+    }
+
+    ctx->add_len += add_len;
+
+    gcm_ghash(ctx, p, add_len);
+    p += add_len & ~(size_t)15;
+    add_len &= 15;
+
+    for(i = 0; i < add_len; i++)
+        ctx->buf[i] ^= p[i];
+
+    return 0;
+}
+
+/* Increment the counter. */
+static void gcm_incr(unsigned char y[16])
+{
+    size_t i;
+
+    for(i = 16; i > 12; i--)
+        if(++y[i - 1] != 0)
+            break;
+}
+
+/* Calculate and apply the encryption mask. Process use_len bytes of data,
+ * starting at position offset in the mask block. */
+static int gcm_mask(mbedtls_gcm_context *ctx,
+                    unsigned char ectr[16],
+                    size_t offset, size_t use_len,
+                    const unsigned char *input,
+                    unsigned char *output)
+{
+    size_t i;
+    int ret;
+
+    if((ret = gcm_block(ctx, ctx->y, ectr)) != 0)
+    {
+        mbedtls_platform_zeroize(ectr, 16);
+        return ret;
+    }
+
+    for(i = 0; i < use_len; i++)
+    {
+        if(ctx->mode == MBEDTLS_GCM_DECRYPT)
+            ctx->buf[offset + i] ^= input[i];
+        output[i] = ectr[offset + i] ^ input[i];
+        if(ctx->mode == MBEDTLS_GCM_ENCRYPT)
+            ctx->buf[offset + i] ^= output[i];
+    }
+
+    return 0;
+}
+
+/*
+ * Encrypt whole blocks on the engine in CTR mode. GCM increments only the
+ * low 32 bits of the counter, so jobs are split where that word wraps and
+ * the upper 96 bits are restored from y for every job.
+ */
+static int gcm_hw_ctr(mbedtls_gcm_context *ctx, const unsigned char *input,
+                      unsigned char *output, size_t length)
+{
+    unsigned char ctr[16];
+    size_t blocks = length / 16, n;
+    uint32_t left;
+    int ret;
+
+    if(ctx->mode == MBEDTLS_GCM_DECRYPT)
+        gcm_ghash(ctx, input, length);
+
+    while(blocks > 0)
+    {
+        memcpy(ctr, ctx->y, 16);
+        gcm_incr(ctr);
+
+        n = blocks;
+        left = 0 - MBEDTLS_GET_UINT32_BE(ctr, 12);
+        if((left != 0) && (n > left))
+            n = left;
+
+        if((ret = mbedtls_aes_alt_hw_crypt(&ctx->aes, AES_ALT_CTR, 1, ctr, n * 16, input, output)) != 0)
+        {
+            mbedtls_platform_zeroize(ctr, sizeof(ctr));
+            return ret;
+        }
+
+        MBEDTLS_PUT_UINT32_BE(MBEDTLS_GET_UINT32_BE(ctx->y, 12) + (uint32_t)n, ctx->y, 12);
+
+        if(ctx->mode == MBEDTLS_GCM_ENCRYPT)
+            gcm_ghash(ctx, output, n * 16);
+
+        input += n * 16;
+        output += n * 16;
+        blocks -= n;
+    }
+
+    mbedtls_platform_zeroize(ctr, sizeof(ctr));
+
+    return 0;
+}
+
+int mbedtls_gcm_update(mbedtls_gcm_context *ctx,
+                       const unsigned char *input, size_t input_length,
+                       unsigned char *output, size_t output_size,
+                       size_t *output_length)
+{
+    const unsigned char *p = input;
+    unsigned char *out_p = output;
+    unsigned char ectr[16];
+    size_t offset, blk;
+    int ret;
+
+    if(output_size < input_length)
+        return MBEDTLS_ERR_GCM_BUFFER_TOO_SMALL;
+    *output_length = input_length;
+
+    /* Exit early if input_length==0 so that we don't do any pointer arithmetic
+     * on a potentially null pointer. The last partial block of AD remains
+     * untouched for mbedtls_gcm_finish */
+    if(input_length == 0)
+        return 0;
+
+    if((output > input) && ((size_t)(output - input) < input_length))
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    /* Total length is restricted to 2^39 - 256 bits, ie 2^36 - 2^5 bytes
+     * Also check for possible overflow */
+    if((ctx->len + input_length < ctx->len) ||
+       ((uint64_t)ctx->len + input_length > 0xFFFFFFFE0ull))
+    {
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+
+    if((ctx->len == 0) && (ctx->add_len % 16 != 0))
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+    offset = ctx->len % 16;
+    if(offset != 0)
+    {
+        size_t use_len = 16 - offset;
+        if(use_len > input_length)
+            use_len = input_length;
+
+        if((ret = gcm_mask(ctx, ectr, offset, use_len, p, out_p)) != 0)
+            return ret;
+
+        if(offset + use_len == 16)
+            gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        ctx->len += use_len;
+        input_length -= use_len;
+        p += use_len;
+        out_p += use_len;
+    }
+
+    ctx->len += input_length;
+
+    /* Records are the common case: hand all whole blocks to the engine */
+    if(ctx->use_aes && (input_length >= CRYPTO_ALT_AES_DMA_MIN))
+    {
+        blk = input_length & ~(size_t)15;
+        if((ret = gcm_hw_ctr(ctx, p, out_p, blk)) != 0)
+            return ret;
+
+        input_length -= blk;
+        p += blk;
+        out_p += blk;
+    }
+
+    while(input_length >= 16)
+    {
+        gcm_incr(ctx->y);
+        if((ret = gcm_mask(ctx, ectr, 0, 16, p, out_p)) != 0)
+            return ret;
+
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        input_length -= 16;
+        p += 16;
+        out_p += 16;
+    }
+
+    if(input_length > 0)
+    {
+        gcm_incr(ctx->y);
+        if((ret = gcm_mask(ctx, ectr, 0, input_length, p, out_p)) != 0)
+            return ret;
+    }
+
+    mbedtls_platform_zeroize(ectr, sizeof(ectr));
+
+    return 0;
+}
+
+int mbedtls_gcm_finish(mbedtls_gcm_context *ctx,
+                       unsigned char *output, size_t output_size,
+                       size_t *output_length,
+                       unsigned char *tag, size_t tag_len)
+{
+    unsigned char work_buf[16];
+    uint64_t orig_len;
+    uint64_t orig_add_len;
+    size_t i;
+
+    /* No output is ever left over, update() handles partial blocks */
+    (void)output;
+    (void)output_size;
+    *output_length = 0;
+
+    orig_len = ctx->len * 8;
+    orig_add_len = ctx->add_len * 8;
+
+    if((ctx->len == 0) && (ctx->add_len % 16 != 0))
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+    if((tag_len > 16) || (tag_len < 4))
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    if(ctx->len % 16 != 0)
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+    memcpy(tag, ctx->base_ectr, tag_len);
+
+    if(orig_len || orig_add_len)
+    {
+        memset(work_buf, 0x00, 16);
+
+        MBEDTLS_PUT_UINT32_BE((orig_add_len >> 32), work_buf, 0);
+        MBEDTLS_PUT_UINT32_BE((orig_add_len), work_buf, 4);
+        MBEDTLS_PUT_UINT32_BE((orig_len >> 32), work_buf, 8);
+        MBEDTLS_PUT_UINT32_BE((orig_len), work_buf, 12);
+
+        for(i = 0; i < 16; i++)
+            ctx->buf[i] ^= work_buf[i];
+
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        for(i = 0; i < tag_len; i++)
+            tag[i] ^= ctx->buf[i];
+    }
+
+    return 0;
+}
+
+int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context *ctx,
+                              int mode,
+                              size_t length,
+                              const unsigned char *iv,
+                              size_t iv_len,
+                              const unsigned char *add,
+                              size_t add_len,
+                              const unsigned char *input,
+                              unsigned char *output,
+                              size_t tag_len,
+                              unsigned char *tag)
+{
+    size_t olen;
+    int ret;
+
+    if((ret = mbedtls_gcm_starts(ctx, mode, iv, iv_len)) != 0)
+        return ret;
+
+    if((ret = mbedtls_gcm_update_ad(ctx, add, add_len)) != 0)
+        return ret;
+
+    if((ret = mbedtls_gcm_update(ctx, input, length, output, length, &olen)) != 0)
+        return ret;
+
+    return mbedtls_gcm_finish(ctx, NULL, 0, &olen, tag, tag_len);
+}
+
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context *ctx,
+                             size_t length,
+                             const unsigned char *iv,
+                             size_t iv_len,
+                             const unsigned char *add,
+                             size_t add_len,
+                             const unsigned char *tag,
+                             size_t tag_len,
+                             const unsigned char *input,
+                             unsigned char *output)
+{
+    unsigned char check_tag[16];
+    size_t i;
+    int diff, ret;
+
+    if((ret = mbedtls_gcm_crypt_and_tag(ctx, MBEDTLS_GCM_DECRYPT, length,
+                                        iv, iv_len, add, add_len,
+                                        input, output, tag_len, check_tag)) != 0)
+    {
+        return ret;
+    }
+
+    /* Check tag in "constant-time" */
+    for(diff = 0, i = 0; i < tag_len; i++)
+        diff |= tag[i] ^ check_tag[i];
+
+    if(diff != 0)
+    {
+        mbedtls_platform_zeroize(output, length);
+        return MBEDTLS_ERR_GCM_AUTH_FAILED;
+    }
+
+    return 0;
+}
+
+void mbedtls_gcm_free(mbedtls_gcm_context *ctx)
+{
+    if(ctx == NULL)
+        return;
+
+    mbedtls_cipher_free(&ctx->cipher_ctx);
+    mbedtls_aes_free(&ctx->aes);
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_gcm_context));
+}
+
+#endif /* MBEDTLS_GCM_C && MBEDTLS_GCM_ALT */
@@ -0,0 +1,52 @@
+/**************************************************************************//**
+ * @file     gcm_alt.h
+ * @brief    mbedTLS MBEDTLS_GCM_ALT context for the CRYPTO AES engine
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __GCM_ALT_H__
+#define __GCM_ALT_H__
+
+#include "mbedtls/aes.h"
+#include "mbedtls/cipher.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(MBEDTLS_GCM_ALT)
+
+#if !defined(MBEDTLS_AES_ALT)
+#error "MBEDTLS_GCM_ALT requires MBEDTLS_AES_ALT"
+#endif
+
+/**
+ * The GCM context. AES keys are kept in aes so bulk data can be run through
+ * the engine in CTR mode; other 128-bit block ciphers use cipher_ctx.
+ */
+typedef struct mbedtls_gcm_context
+{
+    mbedtls_cipher_context_t cipher_ctx;    /*!< Non-AES block cipher */
+    mbedtls_aes_context aes;                /*!< AES key for the engine */
+    int use_aes;                            /*!< 1 when aes holds the key */
+    uint64_t HL[16];                        /*!< Precalculated HTable low */
+    uint64_t HH[16];                        /*!< Precalculated HTable high */
+    uint64_t len;                           /*!< Total length of the encrypted data */
+    uint64_t add_len;                       /*!< Total length of the additional data */
+    unsigned char base_ectr[16];            /*!< The first ECTR for tag */
+    unsigned char y[16];                    /*!< The Y working value */
+    unsigned char buf[16];                  /*!< The buf working value */
+    int mode;                               /*!< MBEDTLS_GCM_ENCRYPT or MBEDTLS_GCM_DECRYPT */
+}
+mbedtls_gcm_context;
+
+int mbedtls_gcm_setkey_ks(mbedtls_gcm_context *ctx, int ksnum, unsigned int keybits);
+
+#endif /* MBEDTLS_GCM_ALT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GCM_ALT_H__ */
@@ -0,0 +1,279 @@
+/**************************************************************************//**
+ * @file     net_netconn.c
+ * @brief    mbedTLS BIO on the lwIP netconn API. Received TCP data is copied
+ *           once, straight from the pbuf chain into the mbedTLS record
+ *           buffer, and each pbuf is freed as soon as it has been consumed.
+ *           Read timeouts use the netconn receive timeout.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "net_netconn.h"
+
+#if LWIP_NETCONN && LWIP_TCP
+
+#include "lwip/ip.h"
+#include "mbedtls/ssl.h"
+
+static int net_netconn_port(const char *port, u16_t *num)
+{
+    char *end;
+    unsigned long n = strtoul(port, &end, 10);
+
+    if((*port == '\0') || (*end != '\0') || (n > 0xFFFF))
+        return -1;
+
+    *num = (u16_t)n;
+    return 0;
+}
+
+/* Map a netconn error to the mbedTLS code used by net_sockets.c */
+static int net_netconn_err(err_t err, int fail)
+{
+    switch(err)
+    {
+        case ERR_WOULDBLOCK:
+            return (fail == MBEDTLS_ERR_NET_SEND_FAILED) ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_SSL_WANT_READ;
+        case ERR_TIMEOUT:
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        case ERR_RST:
+        case ERR_ABRT:
+        case ERR_CONN:
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        default:
+            return fail;
+    }
+}
+
+void net_netconn_init(net_netconn_context *ctx)
+{
+    ctx->conn = NULL;
+    ctx->rx = NULL;
+}
+
+/**
+ * Resolve host and open a TCP connection to it.
+ *
+ * @param ctx closed context
+ * @param host host name or address
+ * @param port decimal port number
+ * @return 0 or MBEDTLS_ERR_NET_xxx
+ */
+int net_netconn_connect(net_netconn_context *ctx, const char *host, const char *port)
+{
+    ip_addr_t addr;
+    u16_t num;
+
+    if(net_netconn_port(port, &num) != 0)
+        return MBEDTLS_ERR_NET_BAD_INPUT_DATA;
+
+    if(netconn_gethostbyname(host, &addr) != ERR_OK)
+        return MBEDTLS_ERR_NET_UNKNOWN_HOST;
+
+#if LWIP_IPV6
+    ctx->conn = netconn_new(IP_IS_V6(&addr) ? NETCONN_TCP_IPV6 : NETCONN_TCP);
+#else
+    ctx->conn = netconn_new(NETCONN_TCP);
+#endif
+    if(ctx->conn == NULL)
+        return MBEDTLS_ERR_NET_SOCKET_FAILED;
+
+    if(netconn_connect(ctx->conn, &addr, num) != ERR_OK)
+    {
+        netconn_delete(ctx->conn);
+        ctx->conn = NULL;
+        return MBEDTLS_ERR_NET_CONNECT_FAILED;
+    }
+
+    return 0;
+}
+
+/**
+ * Listen for TCP connections on bind_ip:port.
+ *
+ * @param ctx closed context
+ * @param bind_ip local address, NULL for any
+ * @param port decimal port number
+ * @return 0 or MBEDTLS_ERR_NET_xxx
+ */
+int net_netconn_bind(net_netconn_context *ctx, const char *bind_ip, const char *port)
+{
+    ip_addr_t addr;
+    u16_t num;
+
+    if(net_netconn_port(port, &num) != 0)
+        return MBEDTLS_ERR_NET_BAD_INPUT_DATA;
+
+    if(bind_ip == NULL)
+        ip_addr_set_any(0, &addr);
+    else if(!ipaddr_aton(bind_ip, &addr))
+        return MBEDTLS_ERR_NET_UNKNOWN_HOST;
+
+    ctx->conn = netconn_new(NETCONN_TCP);
+    if(ctx->conn == NULL)
+        return MBEDTLS_ERR_NET_SOCKET_FAILED;
+
+#if SO_REUSE
+    ip_set_option(ctx->conn->pcb.ip, SOF_REUSEADDR);
+#endif
+
+    if(netconn_bind(ctx->conn, &addr, num) != ERR_OK)
+    {
+        netconn_delete(ctx->conn);
+        ctx->conn = NULL;
+        return MBEDTLS_ERR_NET_BIND_FAILED;
+    }
+
+    if(netconn_listen_with_backlog(ctx->conn, MBEDTLS_NET_LISTEN_BACKLOG) != ERR_OK)
+    {
+        netconn_delete(ctx->conn);
+        ctx->conn = NULL;
+        return MBEDTLS_ERR_NET_LISTEN_FAILED;
+    }
+
+    return 0;
+}
+
+/**
+ * Wait for a connection on a listening context.
+ *
+ * @param bind_ctx listening context
+ * @param client_ctx closed context for the new connection
+ * @param client_ip if not NULL, receives the peer address
+ * @param buf_size size of client_ip
+ * @param ip_len receives the length of the peer address
+ * @return 0 or MBEDTLS_ERR_NET_xxx
+ */
+int net_netconn_accept(net_netconn_context *bind_ctx, net_netconn_context *client_ctx,
+                       void *client_ip, size_t buf_size, size_t *ip_len)
+{
+    ip_addr_t addr;
+    u16_t port;
+    err_t err;
+
+    if(bind_ctx->conn == NULL)
+        return MBEDTLS_ERR_NET_INVALID_CONTEXT;
+
+    err = netconn_accept(bind_ctx->conn, &client_ctx->conn);
+    if(err != ERR_OK)
+    {
+        client_ctx->conn = NULL;
+        return (err == ERR_WOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_ACCEPT_FAILED;
+    }
+
+    if(client_ip != NULL)
+    {
+        if(netconn_peer(client_ctx->conn, &addr, &port) != ERR_OK)
+            return MBEDTLS_ERR_NET_ACCEPT_FAILED;
+
+#if LWIP_IPV6
+        if(IP_IS_V6(&addr))
+        {
+            *ip_len = sizeof(ip_2_ip6(&addr)->addr);
+            if(buf_size < *ip_len)
+                return MBEDTLS_ERR_NET_BUFFER_TOO_SMALL;
+
+            memcpy(client_ip, ip_2_ip6(&addr)->addr, *ip_len);
+        }
+        else
+#endif
+        {
+            *ip_len = sizeof(ip_2_ip4(&addr)->addr);
+            if(buf_size < *ip_len)
+                return MBEDTLS_ERR_NET_BUFFER_TOO_SMALL;
+
+            memcpy(client_ip, &ip_2_ip4(&addr)->addr, *ip_len);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * mbedTLS reuses its output buffer as soon as this returns, so the record is
+ * copied into TCP segments. NETCONN_NOCOPY would need the buffer to stay put
+ * until the peer acknowledges it.
+ */
+int net_netconn_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    net_netconn_context *nc = (net_netconn_context *)ctx;
+    size_t written = 0;
+    err_t err;
+
+    if(nc->conn == NULL)
+        return MBEDTLS_ERR_NET_INVALID_CONTEXT;
+
+    err = netconn_write_partly(nc->conn, buf, len, NETCONN_COPY, &written);
+    if((err != ERR_OK) && (written == 0))
+        return net_netconn_err(err, MBEDTLS_ERR_NET_SEND_FAILED);
+
+    return (int)written;
+}
+
+int net_netconn_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    return net_netconn_recv_timeout(ctx, buf, len, 0);
+}
+
+/**
+ * Read at most len bytes, waiting at most timeout ms for data (0 waits
+ * forever). Data left over from the last pbuf chain is returned first.
+ *
+ * @return bytes read, 0 when the peer closed the connection,
+ *         MBEDTLS_ERR_SSL_TIMEOUT or MBEDTLS_ERR_NET_xxx
+ */
+int net_netconn_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
+{
+    net_netconn_context *nc = (net_netconn_context *)ctx;
+    u16_t n;
+    err_t err;
+
+    if(nc->conn == NULL)
+        return MBEDTLS_ERR_NET_INVALID_CONTEXT;
+
+    if(nc->rx == NULL)
+    {
+#if LWIP_SO_RCVTIMEO
+        netconn_set_recvtimeout(nc->conn, (u32_t)timeout);
+#else
+        (void)timeout;
+#endif
+        err = netconn_recv_tcp_pbuf(nc->conn, &nc->rx);
+        if(err != ERR_OK)
+        {
+            nc->rx = NULL;
+            if(err == ERR_CLSD)
+                return 0;
+
+            return net_netconn_err(err, MBEDTLS_ERR_NET_RECV_FAILED);
+        }
+    }
+
+    n = (len < nc->rx->tot_len) ? (u16_t)len : nc->rx->tot_len;
+    pbuf_copy_partial(nc->rx, buf, n, 0);
+
+    /* Give consumed pbufs back to the pool right away */
+    nc->rx = pbuf_free_header(nc->rx, n);
+
+    return (int)n;
+}
+
+void net_netconn_free(net_netconn_context *ctx)
+{
+    if(ctx->rx != NULL)
+    {
+        pbuf_free(ctx->rx);
+        ctx->rx = NULL;
+    }
+
+    if(ctx->conn != NULL)
+    {
+        netconn_close(ctx->conn);
+        netconn_delete(ctx->conn);
+        ctx->conn = NULL;
+    }
+}
+
+#endif /* LWIP_NETCONN && LWIP_TCP */
@@ -0,0 +1,52 @@
+/**************************************************************************//**
+ * @file     net_netconn.h
+ * @brief    mbedTLS BIO on the lwIP netconn API, used in place of the BSD
+ *           socket net_sockets.c
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __NET_NETCONN_H__
+#define __NET_NETCONN_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lwip/opt.h"
+/* MBEDTLS_ERR_NET_xxx, returned by the functions below */
+#include "mbedtls/net_sockets.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if LWIP_NETCONN && LWIP_TCP
+
+#include "lwip/api.h"
+#include "lwip/pbuf.h"
+
+/* A TCP connection or listener */
+typedef struct
+{
+    struct netconn *conn;   /*!< NULL when closed */
+    struct pbuf *rx;        /*!< Received data not yet handed to mbedTLS */
+}
+net_netconn_context;
+
+void net_netconn_init(net_netconn_context *ctx);
+int  net_netconn_connect(net_netconn_context *ctx, const char *host, const char *port);
+int  net_netconn_bind(net_netconn_context *ctx, const char *bind_ip, const char *port);
+int  net_netconn_accept(net_netconn_context *bind_ctx, net_netconn_context *client_ctx,
+                        void *client_ip, size_t buf_size, size_t *ip_len);
+int  net_netconn_send(void *ctx, const unsigned char *buf, size_t len);
+int  net_netconn_recv(void *ctx, unsigned char *buf, size_t len);
+int  net_netconn_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout);
+void net_netconn_free(net_netconn_context *ctx);
+
+#endif /* LWIP_NETCONN && LWIP_TCP */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NET_NETCONN_H__ */
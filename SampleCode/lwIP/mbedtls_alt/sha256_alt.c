@@ -0,0 +1,380 @@
+/**************************************************************************//**
+ * @file     sha256_alt.c
+ * @brief    mbedTLS MBEDTLS_SHA256_ALT on the CRYPTO SHA engine. A digest
+ *           starts in software and moves to the engine in DMA cascade mode
+ *           when enough data is queued before its first block, provided no
+ *           other context holds the engine.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "common.h"
+
+#if defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA256_ALT)
+
+#include "mbedtls/sha256.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include "NuMicro.h"
+#include "crypto_alt.h"
+
+/* Bytes kept back for the final job while the engine holds the digest */
+#define SHA256_HW_LEFT(ctx)     ((size_t)((((ctx)->total[0] - 1) & 0x3F) + 1))
+
+/*---------------------------------------------------------------------------*/
+/* Software compression                                                      */
+/*---------------------------------------------------------------------------*/
+
+static const uint32_t K[64] =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+#define ROTR(x, n)      (((x) >> (n)) | ((x) << (32 - (n))))
+
+#define S0(x)           (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define S1(x)           (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+#define S2(x)           (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S3(x)           (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+
+#define F0(x, y, z)     (((x) & (y)) | ((z) & ((x) | (y))))
+#define F1(x, y, z)     ((z) ^ ((x) & ((y) ^ (z))))
+
+static void sha256_process(mbedtls_sha256_context *ctx, const unsigned char data[64])
+{
+    uint32_t W[64], A[8], temp1, temp2;
+    int i;
+
+    for(i = 0; i < 8; i++)
+        A[i] = ctx->state[i];
+
+    for(i = 0; i < 16; i++)
+        W[i] = MBEDTLS_GET_UINT32_BE(data, 4 * i);
+    for(i = 16; i < 64; i++)
+        W[i] = S1(W[i - 2]) + W[i - 7] + S0(W[i - 15]) + W[i - 16];
+
+    for(i = 0; i < 64; i++)
+    {
+        temp1 = A[7] + S3(A[4]) + F1(A[4], A[5], A[6]) + K[i] + W[i];
+        temp2 = S2(A[0]) + F0(A[0], A[1], A[2]);
+        A[7] = A[6];
+        A[6] = A[5];
+        A[5] = A[4];
+        A[4] = A[3] + temp1;
+        A[3] = A[2];
+        A[2] = A[1];
+        A[1] = A[0];
+        A[0] = temp1 + temp2;
+    }
+
+    for(i = 0; i < 8; i++)
+        ctx->state[i] += A[i];
+
+    mbedtls_platform_zeroize(W, sizeof(W));
+    mbedtls_platform_zeroize(A, sizeof(A));
+}
+
+/*---------------------------------------------------------------------------*/
+/* Engine cascade, the caller owns the engine digest                         */
+/*---------------------------------------------------------------------------*/
+
+/* Hash n bytes from crypto_alt_dma_in, the engine must be locked */
+static int sha256_hw_job(mbedtls_sha256_context *ctx, size_t n, uint32_t dma_mode)
+{
+    if(dma_mode == CRYPTO_DMA_FIRST)
+        SHA_Open(CRPT, ctx->is224 ? SHA_MODE_SHA224 : SHA_MODE_SHA256, SHA_IN_OUT_SWAP, 0);
+
+    dcache_clean_by_mva(crypto_alt_dma_in, n);
+    SHA_SetDMATransfer(CRPT, ptr_to_u32(crypto_alt_dma_in), (uint32_t)n);
+
+    if(SHA_Start(CRPT, dma_mode) != 0)
+        return MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+
+    return 0;
+}
+
+/*
+ * Hash the left buffered bytes and the input on the engine, keeping back
+ * the last 1 to 64 bytes. left + ilen must be more than one block.
+ */
+static int sha256_hw_update(mbedtls_sha256_context *ctx, size_t left,
+                            const unsigned char *input, size_t ilen)
+{
+    uint32_t dma_mode = ctx->hw ? CRYPTO_DMA_CONTINUE : CRYPTO_DMA_FIRST;
+    size_t n, take;
+    int ret = 0;
+
+    crypto_alt_lock();
+
+    memcpy(crypto_alt_dma_in, ctx->buffer, left);
+    n = left;
+
+    while(n + ilen > 64)
+    {
+        take = (n + ilen - 1) & ~(size_t)0x3F;
+        if(take > CRYPTO_ALT_DMA_BUF_SIZE)
+            take = CRYPTO_ALT_DMA_BUF_SIZE;
+        take -= n;
+
+        memcpy(crypto_alt_dma_in + n, input, take);
+        input += take;
+        ilen -= take;
+
+        if((ret = sha256_hw_job(ctx, n + take, dma_mode)) != 0)
+            break;
+
+        dma_mode = CRYPTO_DMA_CONTINUE;
+        ctx->hw = 1;
+        n = 0;
+    }
+
+    crypto_alt_unlock();
+
+    if(ret == 0)
+        memcpy(ctx->buffer, input, ilen);
+
+    return ret;
+}
+
+/* Continue the digest held by the engine for src in software in dst */
+static void sha256_hw_export(const mbedtls_sha256_context *src, mbedtls_sha256_context *dst)
+{
+    size_t left = SHA256_HW_LEFT(src);
+    int i;
+
+    /* In cascade mode the digest registers hold the intermediate state */
+    crypto_alt_lock();
+    for(i = 0; i < 8; i++)
+        dst->state[i] = CRPT->HMAC_DGST[i];
+    crypto_alt_unlock();
+
+    dst->total[0] = src->total[0];
+    dst->total[1] = src->total[1];
+    dst->is224 = src->is224;
+    dst->hw = 0;
+    memmove(dst->buffer, src->buffer, left);
+
+    /* A full block is kept back only for the final job */
+    if(left == 64)
+        sha256_process(dst, dst->buffer);
+}
+
+static int sha256_hw_finish(mbedtls_sha256_context *ctx, unsigned char *output)
+{
+    size_t left = SHA256_HW_LEFT(ctx);
+    uint32_t dgst[8];
+    int i, ret;
+
+    crypto_alt_lock();
+    memcpy(crypto_alt_dma_in, ctx->buffer, left);
+    if((ret = sha256_hw_job(ctx, left, CRYPTO_DMA_LAST)) == 0)
+        SHA_Read(CRPT, dgst);
+    crypto_alt_unlock();
+
+    ctx->hw = 0;
+    crypto_alt_sha_release(ctx);
+
+    if(ret != 0)
+        return ret;
+
+    for(i = 0; i < (ctx->is224 ? 7 : 8); i++)
+        MBEDTLS_PUT_UINT32_BE(dgst[i], output, 4 * i);
+
+    mbedtls_platform_zeroize(dgst, sizeof(dgst));
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* mbedTLS API                                                               */
+/*---------------------------------------------------------------------------*/
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    if(ctx == NULL)
+        return;
+
+    crypto_alt_sha_release(ctx);
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst,
+                          const mbedtls_sha256_context *src)
+{
+    if(dst == src)
+        return;
+
+    crypto_alt_sha_release(dst);
+
+    /* The engine holds a single digest, a copy always continues in software */
+    if(src->hw)
+        sha256_hw_export(src, dst);
+    else
+        *dst = *src;
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+#if defined(MBEDTLS_SHA224_C)
+    if((is224 != 0) && (is224 != 1))
+        return MBEDTLS_ERR_SHA256_BAD_INPUT_DATA;
+#else
+    if(is224 != 0)
+        return MBEDTLS_ERR_SHA256_BAD_INPUT_DATA;
+#endif
+
+    crypto_alt_sha_release(ctx);
+    ctx->hw = 0;
+
+    ctx->total[0] = 0;
+    ctx->total[1] = 0;
+
+    if(is224 == 0)
+    {
+        ctx->state[0] = 0x6A09E667;
+        ctx->state[1] = 0xBB67AE85;
+        ctx->state[2] = 0x3C6EF372;
+        ctx->state[3] = 0xA54FF53A;
+        ctx->state[4] = 0x510E527F;
+        ctx->state[5] = 0x9B05688C;
+        ctx->state[6] = 0x1F83D9AB;
+        ctx->state[7] = 0x5BE0CD19;
+    }
+    else
+    {
+        ctx->state[0] = 0xC1059ED8;
+        ctx->state[1] = 0x367CD507;
+        ctx->state[2] = 0x3070DD17;
+        ctx->state[3] = 0xF70E5939;
+        ctx->state[4] = 0xFFC00B31;
+        ctx->state[5] = 0x68581511;
+        ctx->state[6] = 0x64F98FA7;
+        ctx->state[7] = 0xBEFA4FA4;
+    }
+
+    ctx->is224 = is224;
+
+    return 0;
+}
+
+int mbedtls_internal_sha256_process(mbedtls_sha256_context *ctx,
+                                    const unsigned char data[64])
+{
+    /* Raw block processing needs the state in software */
+    if(ctx->hw)
+    {
+        sha256_hw_export(ctx, ctx);
+        crypto_alt_sha_release(ctx);
+    }
+
+    sha256_process(ctx, data);
+
+    return 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx,
+                          const unsigned char *input,
+                          size_t ilen)
+{
+    size_t fill, left;
+
+    if(ilen == 0)
+        return 0;
+
+    left = ctx->hw ? SHA256_HW_LEFT(ctx) : (ctx->total[0] & 0x3F);
+
+    ctx->total[0] += (uint32_t)ilen;
+    if(ctx->total[0] < (uint32_t)ilen)
+        ctx->total[1]++;
+
+    if(ctx->hw)
+    {
+        if(left + ilen <= 64)
+        {
+            memcpy(ctx->buffer + left, input, ilen);
+            return 0;
+        }
+        return sha256_hw_update(ctx, left, input, ilen);
+    }
+
+    /* Nothing compressed yet and enough data queued, move to the engine */
+    if((ctx->total[1] == 0) && (ctx->total[0] == left + ilen) &&
+            (left + ilen >= CRYPTO_ALT_SHA_DMA_MIN) && (crypto_alt_sha_acquire(ctx) == 0))
+        return sha256_hw_update(ctx, left, input, ilen);
+
+    fill = 64 - left;
+
+    if(left && (ilen >= fill))
+    {
+        memcpy(ctx->buffer + left, input, fill);
+        sha256_process(ctx, ctx->buffer);
+        input += fill;
+        ilen -= fill;
+        left = 0;
+    }
+
+    while(ilen >= 64)
+    {
+        sha256_process(ctx, input);
+        input += 64;
+        ilen -= 64;
+    }
+
+    if(ilen > 0)
+        memcpy(ctx->buffer + left, input, ilen);
+
+    return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx,
+                          unsigned char *output)
+{
+    uint32_t used, high, low;
+    int i;
+
+    if(ctx->hw)
+        return sha256_hw_finish(ctx, output);
+
+    used = ctx->total[0] & 0x3F;
+    ctx->buffer[used++] = 0x80;
+
+    if(used <= 56)
+    {
+        memset(ctx->buffer + used, 0, 56 - used);
+    }
+    else
+    {
+        memset(ctx->buffer + used, 0, 64 - used);
+        sha256_process(ctx, ctx->buffer);
+        memset(ctx->buffer, 0, 56);
+    }
+
+    high = (ctx->total[0] >> 29) | (ctx->total[1] << 3);
+    low = (ctx->total[0] << 3);
+
+    MBEDTLS_PUT_UINT32_BE(high, ctx->buffer, 56);
+    MBEDTLS_PUT_UINT32_BE(low, ctx->buffer, 60);
+
+    sha256_process(ctx, ctx->buffer);
+
+    for(i = 0; i < (ctx->is224 ? 7 : 8); i++)
+        MBEDTLS_PUT_UINT32_BE(ctx->state[i], output, 4 * i);
+
+    return 0;
+}
+
+#endif /* MBEDTLS_SHA256_C && MBEDTLS_SHA256_ALT */
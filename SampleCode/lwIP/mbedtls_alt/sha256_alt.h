@@ -0,0 +1,41 @@
+/**************************************************************************//**
+ * @file     sha256_alt.h
+ * @brief    mbedTLS MBEDTLS_SHA256_ALT context for the CRYPTO SHA engine
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __SHA256_ALT_H__
+#define __SHA256_ALT_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(MBEDTLS_SHA256_ALT)
+
+/**
+ * The SHA-224/256 context. While hw is 0 the digest state is in state and
+ * the context works like the software implementation. Once hw is set the
+ * running digest is held by the engine and buffer keeps the last 1 to 64
+ * bytes, which are sent with the final DMA job.
+ */
+typedef struct mbedtls_sha256_context
+{
+    uint32_t total[2];          /*!< Number of bytes processed */
+    uint32_t state[8];          /*!< Software intermediate digest state */
+    unsigned char buffer[64];   /*!< Data block being processed */
+    int is224;                  /*!< 0: SHA-256, 1: SHA-224 */
+    int hw;                     /*!< 1 while the engine holds the digest */
+}
+mbedtls_sha256_context;
+
+#endif /* MBEDTLS_SHA256_ALT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SHA256_ALT_H__ */
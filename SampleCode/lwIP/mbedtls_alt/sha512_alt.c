@@ -0,0 +1,391 @@
+/**************************************************************************//**
+ * @file     sha512_alt.c
+ * @brief    mbedTLS MBEDTLS_SHA512_ALT on the CRYPTO SHA engine, working the
+ *           same way as sha256_alt.c with 128-byte blocks.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "common.h"
+
+#if defined(MBEDTLS_SHA512_C) && defined(MBEDTLS_SHA512_ALT)
+
+#include "mbedtls/sha512.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include "NuMicro.h"
+#include "crypto_alt.h"
+
+/* Bytes kept back for the final job while the engine holds the digest */
+#define SHA512_HW_LEFT(ctx)     ((size_t)((((ctx)->total[0] - 1) & 0x7F) + 1))
+
+/*---------------------------------------------------------------------------*/
+/* Software compression                                                      */
+/*---------------------------------------------------------------------------*/
+
+static const uint64_t K[80] =
+{
+    0x428A2F98D728AE22ULL, 0x7137449123EF65CDULL, 0xB5C0FBCFEC4D3B2FULL, 0xE9B5DBA58189DBBCULL,
+    0x3956C25BF348B538ULL, 0x59F111F1B605D019ULL, 0x923F82A4AF194F9BULL, 0xAB1C5ED5DA6D8118ULL,
+    0xD807AA98A3030242ULL, 0x12835B0145706FBEULL, 0x243185BE4EE4B28CULL, 0x550C7DC3D5FFB4E2ULL,
+    0x72BE5D74F27B896FULL, 0x80DEB1FE3B1696B1ULL, 0x9BDC06A725C71235ULL, 0xC19BF174CF692694ULL,
+    0xE49B69C19EF14AD2ULL, 0xEFBE4786384F25E3ULL, 0x0FC19DC68B8CD5B5ULL, 0x240CA1CC77AC9C65ULL,
+    0x2DE92C6F592B0275ULL, 0x4A7484AA6EA6E483ULL, 0x5CB0A9DCBD41FBD4ULL, 0x76F988DA831153B5ULL,
+    0x983E5152EE66DFABULL, 0xA831C66D2DB43210ULL, 0xB00327C898FB213FULL, 0xBF597FC7BEEF0EE4ULL,
+    0xC6E00BF33DA88FC2ULL, 0xD5A79147930AA725ULL, 0x06CA6351E003826FULL, 0x142929670A0E6E70ULL,
+    0x27B70A8546D22FFCULL, 0x2E1B21385C26C926ULL, 0x4D2C6DFC5AC42AEDULL, 0x53380D139D95B3DFULL,
+    0x650A73548BAF63DEULL, 0x766A0ABB3C77B2A8ULL, 0x81C2C92E47EDAEE6ULL, 0x92722C851482353BULL,
+    0xA2BFE8A14CF10364ULL, 0xA81A664BBC423001ULL, 0xC24B8B70D0F89791ULL, 0xC76C51A30654BE30ULL,
+    0xD192E819D6EF5218ULL, 0xD69906245565A910ULL, 0xF40E35855771202AULL, 0x106AA07032BBD1B8ULL,
+    0x19A4C116B8D2D0C8ULL, 0x1E376C085141AB53ULL, 0x2748774CDF8EEB99ULL, 0x34B0BCB5E19B48A8ULL,
+    0x391C0CB3C5C95A63ULL, 0x4ED8AA4AE3418ACBULL, 0x5B9CCA4F7763E373ULL, 0x682E6FF3D6B2B8A3ULL,
+    0x748F82EE5DEFB2FCULL, 0x78A5636F43172F60ULL, 0x84C87814A1F0AB72ULL, 0x8CC702081A6439ECULL,
+    0x90BEFFFA23631E28ULL, 0xA4506CEBDE82BDE9ULL, 0xBEF9A3F7B2C67915ULL, 0xC67178F2E372532BULL,
+    0xCA273ECEEA26619CULL, 0xD186B8C721C0C207ULL, 0xEADA7DD6CDE0EB1EULL, 0xF57D4F7FEE6ED178ULL,
+    0x06F067AA72176FBAULL, 0x0A637DC5A2C898A6ULL, 0x113F9804BEF90DAEULL, 0x1B710B35131C471BULL,
+    0x28DB77F523047D84ULL, 0x32CAAB7B40C72493ULL, 0x3C9EBE0A15C9BEBCULL, 0x431D67C49C100D4CULL,
+    0x4CC5D4BECB3E42B6ULL, 0x597F299CFC657E2AULL, 0x5FCB6FAB3AD6FAECULL, 0x6C44198C4A475817ULL,
+};
+
+#define ROTR(x, n)      (((x) >> (n)) | ((x) << (64 - (n))))
+
+#define S0(x)           (ROTR(x, 1) ^ ROTR(x, 8) ^ ((x) >> 7))
+#define S1(x)           (ROTR(x, 19) ^ ROTR(x, 61) ^ ((x) >> 6))
+#define S2(x)           (ROTR(x, 28) ^ ROTR(x, 34) ^ ROTR(x, 39))
+#define S3(x)           (ROTR(x, 14) ^ ROTR(x, 18) ^ ROTR(x, 41))
+
+#define F0(x, y, z)     (((x) & (y)) | ((z) & ((x) | (y))))
+#define F1(x, y, z)     ((z) ^ ((x) & ((y) ^ (z))))
+
+static void sha512_process(mbedtls_sha512_context *ctx, const unsigned char data[128])
+{
+    uint64_t W[80], A[8], temp1, temp2;
+    int i;
+
+    for(i = 0; i < 8; i++)
+        A[i] = ctx->state[i];
+
+    for(i = 0; i < 16; i++)
+        W[i] = MBEDTLS_GET_UINT64_BE(data, 8 * i);
+    for(i = 16; i < 80; i++)
+        W[i] = S1(W[i - 2]) + W[i - 7] + S0(W[i - 15]) + W[i - 16];
+
+    for(i = 0; i < 80; i++)
+    {
+        temp1 = A[7] + S3(A[4]) + F1(A[4], A[5], A[6]) + K[i] + W[i];
+        temp2 = S2(A[0]) + F0(A[0], A[1], A[2]);
+        A[7] = A[6];
+        A[6] = A[5];
+        A[5] = A[4];
+        A[4] = A[3] + temp1;
+        A[3] = A[2];
+        A[2] = A[1];
+        A[1] = A[0];
+        A[0] = temp1 + temp2;
+    }
+
+    for(i = 0; i < 8; i++)
+        ctx->state[i] += A[i];
+
+    mbedtls_platform_zeroize(W, sizeof(W));
+    mbedtls_platform_zeroize(A, sizeof(A));
+}
+
+/*---------------------------------------------------------------------------*/
+/* Engine cascade, the caller owns the engine digest                         */
+/*---------------------------------------------------------------------------*/
+
+/* Hash n bytes from crypto_alt_dma_in, the engine must be locked */
+static int sha512_hw_job(mbedtls_sha512_context *ctx, size_t n, uint32_t dma_mode)
+{
+    if(dma_mode == CRYPTO_DMA_FIRST)
+        SHA_Open(CRPT, ctx->is384 ? SHA_MODE_SHA384 : SHA_MODE_SHA512, SHA_IN_OUT_SWAP, 0);
+
+    dcache_clean_by_mva(crypto_alt_dma_in, n);
+    SHA_SetDMATransfer(CRPT, ptr_to_u32(crypto_alt_dma_in), (uint32_t)n);
+
+    if(SHA_Start(CRPT, dma_mode) != 0)
+        return MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+
+    return 0;
+}
+
+/*
+ * Hash the left buffered bytes and the input on the engine, keeping back
+ * the last 1 to 128 bytes. left + ilen must be more than one block.
+ */
+static int sha512_hw_update(mbedtls_sha512_context *ctx, size_t left,
+                            const unsigned char *input, size_t ilen)
+{
+    uint32_t dma_mode = ctx->hw ? CRYPTO_DMA_CONTINUE : CRYPTO_DMA_FIRST;
+    size_t n, take;
+    int ret = 0;
+
+    crypto_alt_lock();
+
+    memcpy(crypto_alt_dma_in, ctx->buffer, left);
+    n = left;
+
+    while(n + ilen > 128)
+    {
+        take = (n + ilen - 1) & ~(size_t)0x7F;
+        if(take > CRYPTO_ALT_DMA_BUF_SIZE)
+            take = CRYPTO_ALT_DMA_BUF_SIZE;
+        take -= n;
+
+        memcpy(crypto_alt_dma_in + n, input, take);
+        input += take;
+        ilen -= take;
+
+        if((ret = sha512_hw_job(ctx, n + take, dma_mode)) != 0)
+            break;
+
+        dma_mode = CRYPTO_DMA_CONTINUE;
+        ctx->hw = 1;
+        n = 0;
+    }
+
+    crypto_alt_unlock();
+
+    if(ret == 0)
+        memcpy(ctx->buffer, input, ilen);
+
+    return ret;
+}
+
+/* Continue the digest held by the engine for src in software in dst */
+static void sha512_hw_export(const mbedtls_sha512_context *src, mbedtls_sha512_context *dst)
+{
+    size_t left = SHA512_HW_LEFT(src);
+    int i;
+
+    /* In cascade mode the digest registers hold the intermediate state */
+    crypto_alt_lock();
+    for(i = 0; i < 8; i++)
+        dst->state[i] = ((uint64_t)CRPT->HMAC_DGST[2 * i] << 32) | CRPT->HMAC_DGST[2 * i + 1];
+    crypto_alt_unlock();
+
+    dst->total[0] = src->total[0];
+    dst->total[1] = src->total[1];
+    dst->is384 = src->is384;
+    dst->hw = 0;
+    memmove(dst->buffer, src->buffer, left);
+
+    /* A full block is kept back only for the final job */
+    if(left == 128)
+        sha512_process(dst, dst->buffer);
+}
+
+static int sha512_hw_finish(mbedtls_sha512_context *ctx, unsigned char *output)
+{
+    size_t left = SHA512_HW_LEFT(ctx);
+    uint32_t dgst[16];
+    int i, ret;
+
+    crypto_alt_lock();
+    memcpy(crypto_alt_dma_in, ctx->buffer, left);
+    if((ret = sha512_hw_job(ctx, left, CRYPTO_DMA_LAST)) == 0)
+        SHA_Read(CRPT, dgst);
+    crypto_alt_unlock();
+
+    ctx->hw = 0;
+    crypto_alt_sha_release(ctx);
+
+    if(ret != 0)
+        return ret;
+
+    for(i = 0; i < (ctx->is384 ? 12 : 16); i++)
+        MBEDTLS_PUT_UINT32_BE(dgst[i], output, 4 * i);
+
+    mbedtls_platform_zeroize(dgst, sizeof(dgst));
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* mbedTLS API                                                               */
+/*---------------------------------------------------------------------------*/
+
+void mbedtls_sha512_init(mbedtls_sha512_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_sha512_context));
+}
+
+void mbedtls_sha512_free(mbedtls_sha512_context *ctx)
+{
+    if(ctx == NULL)
+        return;
+
+    crypto_alt_sha_release(ctx);
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_sha512_context));
+}
+
+void mbedtls_sha512_clone(mbedtls_sha512_context *dst,
+                          const mbedtls_sha512_context *src)
+{
+    if(dst == src)
+        return;
+
+    crypto_alt_sha_release(dst);
+
+    /* The engine holds a single digest, a copy always continues in software */
+    if(src->hw)
+        sha512_hw_export(src, dst);
+    else
+        *dst = *src;
+}
+
+int mbedtls_sha512_starts(mbedtls_sha512_context *ctx, int is384)
+{
+#if defined(MBEDTLS_SHA384_C)
+    if((is384 != 0) && (is384 != 1))
+        return MBEDTLS_ERR_SHA512_BAD_INPUT_DATA;
+#else
+    if(is384 != 0)
+        return MBEDTLS_ERR_SHA512_BAD_INPUT_DATA;
+#endif
+
+    crypto_alt_sha_release(ctx);
+    ctx->hw = 0;
+
+    ctx->total[0] = 0;
+    ctx->total[1] = 0;
+
+    if(is384 == 0)
+    {
+        ctx->state[0] = 0x6A09E667F3BCC908ULL;
+        ctx->state[1] = 0xBB67AE8584CAA73BULL;
+        ctx->state[2] = 0x3C6EF372FE94F82BULL;
+        ctx->state[3] = 0xA54FF53A5F1D36F1ULL;
+        ctx->state[4] = 0x510E527FADE682D1ULL;
+        ctx->state[5] = 0x9B05688C2B3E6C1FULL;
+        ctx->state[6] = 0x1F83D9ABFB41BD6BULL;
+        ctx->state[7] = 0x5BE0CD19137E2179ULL;
+    }
+    else
+    {
+        ctx->state[0] = 0xCBBB9D5DC1059ED8ULL;
+        ctx->state[1] = 0x629A292A367CD507ULL;
+        ctx->state[2] = 0x9159015A3070DD17ULL;
+        ctx->state[3] = 0x152FECD8F70E5939ULL;
+        ctx->state[4] = 0x67332667FFC00B31ULL;
+        ctx->state[5] = 0x8EB44A8768581511ULL;
+        ctx->state[6] = 0xDB0C2E0D64F98FA7ULL;
+        ctx->state[7] = 0x47B5481DBEFA4FA4ULL;
+    }
+
+    ctx->is384 = is384;
+
+    return 0;
+}
+
+int mbedtls_internal_sha512_process(mbedtls_sha512_context *ctx,
+                                    const unsigned char data[128])
+{
+    /* Raw block processing needs the state in software */
+    if(ctx->hw)
+    {
+        sha512_hw_export(ctx, ctx);
+        crypto_alt_sha_release(ctx);
+    }
+
+    sha512_process(ctx, data);
+
+    return 0;
+}
+
+int mbedtls_sha512_update(mbedtls_sha512_context *ctx,
+                          const unsigned char *input,
+                          size_t ilen)
+{
+    size_t fill, left;
+
+    if(ilen == 0)
+        return 0;
+
+    left = ctx->hw ? SHA512_HW_LEFT(ctx) : (ctx->total[0] & 0x7F);
+
+    ctx->total[0] += (uint64_t)ilen;
+    if(ctx->total[0] < (uint64_t)ilen)
+        ctx->total[1]++;
+
+    if(ctx->hw)
+    {
+        if(left + ilen <= 128)
+        {
+            memcpy(ctx->buffer + left, input, ilen);
+            return 0;
+        }
+        return sha512_hw_update(ctx, left, input, ilen);
+    }
+
+    /* Nothing compressed yet and enough data queued, move to the engine */
+    if((ctx->total[1] == 0) && (ctx->total[0] == left + ilen) &&
+            (left + ilen >= CRYPTO_ALT_SHA_DMA_MIN) && (crypto_alt_sha_acquire(ctx) == 0))
+        return sha512_hw_update(ctx, left, input, ilen);
+
+    fill = 128 - left;
+
+    if(left && (ilen >= fill))
+    {
+        memcpy(ctx->buffer + left, input, fill);
+        sha512_process(ctx, ctx->buffer);
+        input += fill;
+        ilen -= fill;
+        left = 0;
+    }
+
+    while(ilen >= 128)
+    {
+        sha512_process(ctx, input);
+        input += 128;
+        ilen -= 128;
+    }
+
+    if(ilen > 0)
+        memcpy(ctx->buffer + left, input, ilen);
+
+    return 0;
+}
+
+int mbedtls_sha512_finish(mbedtls_sha512_context *ctx,
+                          unsigned char *output)
+{
+    uint64_t high, low;
+    unsigned int used;
+    int i;
+
+    if(ctx->hw)
+        return sha512_hw_finish(ctx, output);
+
+    used = ctx->total[0] & 0x7F;
+    ctx->buffer[used++] = 0x80;
+
+    if(used <= 112)
+    {
+        memset(ctx->buffer + used, 0, 112 - used);
+    }
+    else
+    {
+        memset(ctx->buffer + used, 0, 128 - used);
+        sha512_process(ctx, ctx->buffer);
+        memset(ctx->buffer, 0, 112);
+    }
+
+    high = (ctx->total[0] >> 61) | (ctx->total[1] << 3);
+    low = (ctx->total[0] << 3);
+
+    MBEDTLS_PUT_UINT64_BE(high, ctx->buffer, 112);
+    MBEDTLS_PUT_UINT64_BE(low, ctx->buffer, 120);
+
+    sha512_process(ctx, ctx->buffer);
+
+    for(i = 0; i < (ctx->is384 ? 6 : 8); i++)
+        MBEDTLS_PUT_UINT64_BE(ctx->state[i], output, 8 * i);
+
+    return 0;
+}
+
+#endif /* MBEDTLS_SHA512_C && MBEDTLS_SHA512_ALT */
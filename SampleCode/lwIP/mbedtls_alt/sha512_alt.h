@@ -0,0 +1,39 @@
+/**************************************************************************//**
+ * @file     sha512_alt.h
+ * @brief    mbedTLS MBEDTLS_SHA512_ALT context for the CRYPTO SHA engine
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __SHA512_ALT_H__
+#define __SHA512_ALT_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(MBEDTLS_SHA512_ALT)
+
+/**
+ * The SHA-384/512 context, see mbedtls_sha256_context. In hardware mode
+ * buffer keeps the last 1 to 128 bytes for the final DMA job.
+ */
+typedef struct mbedtls_sha512_context
+{
+    uint64_t total[2];          /*!< Number of bytes processed */
+    uint64_t state[8];          /*!< Software intermediate digest state */
+    unsigned char buffer[128];  /*!< Data block being processed */
+    int is384;                  /*!< 0: SHA-512, 1: SHA-384 */
+    int hw;                     /*!< 1 while the engine holds the digest */
+}
+mbedtls_sha512_context;
+
+#endif /* MBEDTLS_SHA512_ALT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SHA512_ALT_H__ */
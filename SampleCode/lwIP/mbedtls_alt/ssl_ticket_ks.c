@@ -0,0 +1,266 @@
+/**************************************************************************//**
+ * @file     ssl_ticket_ks.c
+ * @brief    RFC 5077 session tickets protected by AES-256-GCM keys that are
+ *           generated into and rotated within Key Store SRAM. The ticket
+ *           layout follows mbedTLS ssl_ticket.c; the encrypted state starts
+ *           with the issue time so tickets expire without MBEDTLS_HAVE_TIME.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "common.h"
+
+#include "ssl_ticket_ks.h"
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_GCM_ALT)
+
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "NuMicro.h"
+#include "crypto_alt.h"
+
+#define TICKET_KEY_NAME_BYTES   4
+#define TICKET_IV_BYTES         12
+#define TICKET_CRYPT_LEN_BYTES  2
+#define TICKET_AUTH_TAG_BYTES   16
+#define TICKET_TIME_BYTES       4
+
+#define TICKET_MIN_LEN      (TICKET_KEY_NAME_BYTES + TICKET_IV_BYTES + \
+                             TICKET_CRYPT_LEN_BYTES + TICKET_AUTH_TAG_BYTES)
+#define TICKET_ADD_DATA_LEN (TICKET_KEY_NAME_BYTES + TICKET_IV_BYTES + \
+                             TICKET_CRYPT_LEN_BYTES)
+
+static uint32_t ticket_time(void)
+{
+    return (uint32_t)(xTaskGetTickCount() / configTICK_RATE_HZ);
+}
+
+static void ticket_ks_erase(ssl_ticket_ks_key *key)
+{
+    if(key->ksnum >= 0)
+    {
+        crypto_alt_lock();
+        KS_EraseKey(KS_SRAM, key->ksnum);
+        crypto_alt_unlock();
+        key->ksnum = -1;
+    }
+}
+
+/* Replace a key; the new AES key goes straight from the RNG to the Key Store */
+static int ticket_ks_gen_key(ssl_ticket_ks_context *ctx, unsigned char index)
+{
+    ssl_ticket_ks_key *key = &ctx->keys[index];
+    uint32_t buf[8];
+    int ksnum, ret;
+
+    ticket_ks_erase(key);
+
+    if((ret = ctx->f_rng(ctx->p_rng, key->name, sizeof(key->name))) != 0)
+        return ret;
+
+    if((ret = ctx->f_rng(ctx->p_rng, (unsigned char *)buf, sizeof(buf))) != 0)
+        return ret;
+
+    /* AES use only, never readable by the CPU */
+    crypto_alt_lock();
+    ksnum = KS_Write(KS_SRAM, KS_META_AES | KS_META_256, buf);
+    crypto_alt_unlock();
+
+    mbedtls_platform_zeroize(buf, sizeof(buf));
+
+    if(ksnum < 0)
+        return MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+
+    key->ksnum = ksnum;
+    key->generation_time = ticket_time();
+
+    return mbedtls_gcm_setkey_ks(&key->gcm, ksnum, 256);
+}
+
+static int ticket_ks_update_keys(ssl_ticket_ks_context *ctx)
+{
+    uint32_t now = ticket_time();
+    uint32_t key_time = ctx->keys[ctx->active].generation_time;
+
+    if((now >= key_time) && (now - key_time < ctx->ticket_lifetime))
+        return 0;
+
+    ctx->active = 1 - ctx->active;
+
+    return ticket_ks_gen_key(ctx, ctx->active);
+}
+
+void ssl_ticket_ks_init(ssl_ticket_ks_context *ctx)
+{
+    memset(ctx, 0, sizeof(ssl_ticket_ks_context));
+    ctx->keys[0].ksnum = -1;
+    ctx->keys[1].ksnum = -1;
+    mbedtls_gcm_init(&ctx->keys[0].gcm);
+    mbedtls_gcm_init(&ctx->keys[1].gcm);
+}
+
+/**
+ * Start the Key Store if needed and generate both ticket keys.
+ *
+ * @param ctx ticket context
+ * @param f_rng RNG for key names, keys and IVs
+ * @param p_rng RNG context
+ * @param lifetime ticket lifetime and key rotation period in seconds
+ * @return 0 or an mbedTLS error code
+ */
+int ssl_ticket_ks_setup(ssl_ticket_ks_context *ctx,
+                        int (*f_rng)(void *, unsigned char *, size_t), void *p_rng,
+                        uint32_t lifetime)
+{
+    int ret;
+
+    if((f_rng == NULL) || (lifetime == 0))
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+    ctx->f_rng = f_rng;
+    ctx->p_rng = p_rng;
+    ctx->ticket_lifetime = lifetime;
+
+    crypto_alt_lock();
+    /* Enable Key Store clock */
+    outpw(TSI_CLK_BASE + 0x4, inpw(TSI_CLK_BASE + 0x4) | (1 << 14));
+    if(!(KS->STS & KS_STS_INITDONE_Msk))
+        KS_Init();
+    crypto_alt_unlock();
+
+    if(((ret = ticket_ks_gen_key(ctx, 0)) != 0) ||
+            ((ret = ticket_ks_gen_key(ctx, 1)) != 0))
+        return ret;
+
+    return 0;
+}
+
+int ssl_ticket_ks_write(void *p_ticket, const mbedtls_ssl_session *session,
+                        unsigned char *start, const unsigned char *end,
+                        size_t *tlen, uint32_t *ticket_lifetime)
+{
+    ssl_ticket_ks_context *ctx = p_ticket;
+    ssl_ticket_ks_key *key;
+    unsigned char *key_name = start;
+    unsigned char *iv = key_name + TICKET_KEY_NAME_BYTES;
+    unsigned char *state_len_bytes = iv + TICKET_IV_BYTES;
+    unsigned char *state = state_len_bytes + TICKET_CRYPT_LEN_BYTES;
+    size_t clear_len;
+    int ret;
+
+    *tlen = 0;
+
+    if((ctx == NULL) || (ctx->f_rng == NULL))
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+    if((end < start) || ((size_t)(end - start) < TICKET_MIN_LEN + TICKET_TIME_BYTES))
+        return MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL;
+
+    if((ret = ticket_ks_update_keys(ctx)) != 0)
+        return ret;
+
+    key = &ctx->keys[ctx->active];
+
+    *ticket_lifetime = ctx->ticket_lifetime;
+
+    memcpy(key_name, key->name, TICKET_KEY_NAME_BYTES);
+
+    if((ret = ctx->f_rng(ctx->p_rng, iv, TICKET_IV_BYTES)) != 0)
+        return ret;
+
+    /* Issue time, then the session state */
+    MBEDTLS_PUT_UINT32_BE(ticket_time(), state, 0);
+    if((ret = mbedtls_ssl_session_save(session, state + TICKET_TIME_BYTES,
+                                       end - state - TICKET_TIME_BYTES - TICKET_AUTH_TAG_BYTES,
+                                       &clear_len)) != 0)
+        return ret;
+
+    clear_len += TICKET_TIME_BYTES;
+    if(clear_len > 65535)
+        return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+
+    MBEDTLS_PUT_UINT16_BE(clear_len, state_len_bytes, 0);
+
+    /* Additional data: key name, IV and length */
+    if((ret = mbedtls_gcm_crypt_and_tag(&key->gcm, MBEDTLS_GCM_ENCRYPT, clear_len,
+                                        iv, TICKET_IV_BYTES, key_name, TICKET_ADD_DATA_LEN,
+                                        state, state, TICKET_AUTH_TAG_BYTES, state + clear_len)) != 0)
+        return ret;
+
+    *tlen = TICKET_MIN_LEN + clear_len;
+
+    return 0;
+}
+
+int ssl_ticket_ks_parse(void *p_ticket, mbedtls_ssl_session *session,
+                        unsigned char *buf, size_t len)
+{
+    ssl_ticket_ks_context *ctx = p_ticket;
+    ssl_ticket_ks_key *key = NULL;
+    unsigned char *key_name = buf;
+    unsigned char *iv = buf + TICKET_KEY_NAME_BYTES;
+    unsigned char *enc_len_p = iv + TICKET_IV_BYTES;
+    unsigned char *ticket = enc_len_p + TICKET_CRYPT_LEN_BYTES;
+    uint32_t issued, now;
+    size_t enc_len;
+    int i, ret;
+
+    if((ctx == NULL) || (ctx->f_rng == NULL))
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+    if(len < TICKET_MIN_LEN)
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+    if((ret = ticket_ks_update_keys(ctx)) != 0)
+        return ret;
+
+    enc_len = (enc_len_p[0] << 8) | enc_len_p[1];
+
+    if((len != TICKET_MIN_LEN + enc_len) || (enc_len < TICKET_TIME_BYTES))
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+    for(i = 0; i < 2; i++)
+    {
+        if((ctx->keys[i].ksnum >= 0) && (memcmp(key_name, ctx->keys[i].name, TICKET_KEY_NAME_BYTES) == 0))
+            key = &ctx->keys[i];
+    }
+
+    /* Most likely issued under a key that has been rotated out */
+    if(key == NULL)
+        return MBEDTLS_ERR_SSL_SESSION_TICKET_EXPIRED;
+
+    ret = mbedtls_gcm_auth_decrypt(&key->gcm, enc_len, iv, TICKET_IV_BYTES,
+                                   key_name, TICKET_ADD_DATA_LEN,
+                                   ticket + enc_len, TICKET_AUTH_TAG_BYTES, ticket, ticket);
+    if(ret == MBEDTLS_ERR_GCM_AUTH_FAILED)
+        return MBEDTLS_ERR_SSL_INVALID_MAC;
+    if(ret != 0)
+        return ret;
+
+    issued = MBEDTLS_GET_UINT32_BE(ticket, 0);
+    now = ticket_time();
+    if((now < issued) || (now - issued > ctx->ticket_lifetime))
+        return MBEDTLS_ERR_SSL_SESSION_TICKET_EXPIRED;
+
+    return mbedtls_ssl_session_load(session, ticket + TICKET_TIME_BYTES, enc_len - TICKET_TIME_BYTES);
+}
+
+void ssl_ticket_ks_free(ssl_ticket_ks_context *ctx)
+{
+    int i;
+
+    for(i = 0; i < 2; i++)
+    {
+        ticket_ks_erase(&ctx->keys[i]);
+        mbedtls_gcm_free(&ctx->keys[i].gcm);
+    }
+
+    mbedtls_platform_zeroize(ctx, sizeof(ssl_ticket_ks_context));
+}
+
+#endif /* MBEDTLS_SSL_SESSION_TICKETS && MBEDTLS_SSL_SRV_C && MBEDTLS_GCM_ALT */
@@ -0,0 +1,63 @@
+/**************************************************************************//**
+ * @file     ssl_ticket_ks.h
+ * @brief    RFC 5077 session tickets protected by AES-256-GCM keys that are
+ *           generated into and rotated within Key Store SRAM
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __SSL_TICKET_KS_H__
+#define __SSL_TICKET_KS_H__
+
+#include <stdint.h>
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/gcm.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_GCM_ALT)
+
+/* A ticket key, the AES key itself only exists in the Key Store */
+typedef struct
+{
+    unsigned char name[4];      /*!< Random key name sent in the clear */
+    int ksnum;                  /*!< Key Store SRAM key number, -1 if none */
+    uint32_t generation_time;   /*!< Seconds since boot when generated */
+    mbedtls_gcm_context gcm;    /*!< GCM context using the Key Store key */
+}
+ssl_ticket_ks_key;
+
+/**
+ * Ticket context for mbedtls_ssl_conf_session_tickets_cb(). The active key
+ * is replaced every lifetime seconds; the previous key is kept so tickets
+ * issued just before a rotation still resume. Not thread safe, use one
+ * context per server task.
+ */
+typedef struct
+{
+    ssl_ticket_ks_key keys[2];  /*!< Current and previous key */
+    unsigned char active;       /*!< Index of the key used for new tickets */
+    uint32_t ticket_lifetime;   /*!< Ticket and key lifetime in seconds */
+    int (*f_rng)(void *, unsigned char *, size_t);
+    void *p_rng;
+}
+ssl_ticket_ks_context;
+
+void ssl_ticket_ks_init(ssl_ticket_ks_context *ctx);
+int  ssl_ticket_ks_setup(ssl_ticket_ks_context *ctx,
+                         int (*f_rng)(void *, unsigned char *, size_t), void *p_rng,
+                         uint32_t lifetime);
+mbedtls_ssl_ticket_write_t ssl_ticket_ks_write;
+mbedtls_ssl_ticket_parse_t ssl_ticket_ks_parse;
+void ssl_ticket_ks_free(ssl_ticket_ks_context *ctx);
+
+#endif /* MBEDTLS_SSL_SESSION_TICKETS && MBEDTLS_SSL_SRV_C && MBEDTLS_GCM_ALT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SSL_TICKET_KS_H__ */
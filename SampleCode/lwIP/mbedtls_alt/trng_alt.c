@@ -0,0 +1,220 @@
+/**************************************************************************//**
+ * @file     trng_alt.c
+ * @brief    Buffered TRNG entropy pool. A low priority task keeps the pool
+ *           topped up so mbedTLS reseeds and key generation never wait for
+ *           the TRNG. Provides mbedtls_hardware_poll() for
+ *           MBEDTLS_ENTROPY_HARDWARE_ALT.
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "NuMicro.h"
+#include "trng_alt.h"
+
+#include "common.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/platform_util.h"
+#include "entropy_poll.h"
+
+#define TRNG_ALT_IDLE       0
+#define TRNG_ALT_STARTING   1
+#define TRNG_ALT_READY      2
+#define TRNG_ALT_FAILED     3
+
+static uint8_t pool[TRNG_ALT_POOL_SIZE];
+static size_t pool_head;                /* Oldest byte not handed out yet */
+static size_t pool_level;               /* Bytes available from pool_head */
+static volatile int trng_state;
+static TaskHandle_t refill_task;
+
+static int trng_start(void)
+{
+    /* Enable TRNG engine clock */
+    outpw(TSI_CLK_BASE + 0xC, inpw(TSI_CLK_BASE + 0xC) | (1 << 25));
+
+    if(TRNG_Init() != 0)
+        return -1;
+
+    /* Self-seeding from the noise source */
+    if(TRNG_GenNoise() != 0)
+        return -1;
+
+    return TRNG_CreateState();
+}
+
+/*
+ * Top the pool up one TRNG command at a time, while a whole command output
+ * fits. Only the refill task (or trng_alt_init() before that task exists)
+ * writes to the pool, readers only ever lower pool_level, so the free space
+ * seen here can only grow.
+ */
+static int trng_fill(void)
+{
+    uint32_t rnd[4];
+    size_t tail, first;
+    int ret = 0;
+
+    while(TRNG_ALT_POOL_SIZE - pool_level >= sizeof(rnd))
+    {
+        if(TRNG_GenerateRandomNumber(rnd, 4) != 0)
+        {
+            /* Reseed once from the noise source before giving up */
+            if((trng_start() != 0) || (TRNG_GenerateRandomNumber(rnd, 4) != 0))
+            {
+                ret = -1;
+                break;
+            }
+        }
+
+        vTaskSuspendAll();
+        tail = (pool_head + pool_level) % TRNG_ALT_POOL_SIZE;
+        first = TRNG_ALT_POOL_SIZE - tail;
+        if(first > sizeof(rnd))
+            first = sizeof(rnd);
+        memcpy(&pool[tail], rnd, first);
+        memcpy(pool, (uint8_t *)rnd + first, sizeof(rnd) - first);
+        pool_level += sizeof(rnd);
+        xTaskResumeAll();
+    }
+
+    mbedtls_platform_zeroize(rnd, sizeof(rnd));
+    return ret;
+}
+
+static void trng_alt_task(void *arg)
+{
+    (void)arg;
+
+    for(;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if(trng_fill() != 0)
+            sysprintf("TRNG refill failed!\n");
+    }
+}
+
+/**
+ * Start the TRNG, fill the pool and create the refill task. Called on first
+ * use; must run from a task as the TRNG commands complete by interrupt.
+ *
+ * @return 0 if the pool is running, -1 if the TRNG failed to start
+ */
+int trng_alt_init(void)
+{
+    int starter = 0;
+
+    if(trng_state == TRNG_ALT_READY)
+        return 0;
+
+    vTaskSuspendAll();
+    if(trng_state == TRNG_ALT_IDLE)
+    {
+        trng_state = TRNG_ALT_STARTING;
+        starter = 1;
+    }
+    xTaskResumeAll();
+
+    if(starter)
+    {
+        if((trng_start() == 0) && (trng_fill() == 0) &&
+                (xTaskCreate(trng_alt_task, "TrngTask", TRNG_ALT_TASK_STACK_SIZE, NULL,
+                             TRNG_ALT_TASK_PRIORITY, &refill_task) == pdPASS))
+            trng_state = TRNG_ALT_READY;
+        else
+            trng_state = TRNG_ALT_FAILED;
+    }
+    else
+    {
+        while(trng_state == TRNG_ALT_STARTING)
+            vTaskDelay(1);
+    }
+
+    return (trng_state == TRNG_ALT_READY) ? 0 : -1;
+}
+
+/**
+ * Take random bytes from the pool. Never waits for the TRNG, a short read
+ * means the pool is drained and the refill task is catching up.
+ *
+ * @param buf output buffer
+ * @param len bytes wanted
+ * @return bytes written to buf
+ */
+size_t trng_alt_read(void *buf, size_t len)
+{
+    size_t n, first, level;
+
+    vTaskSuspendAll();
+    n = (len < pool_level) ? len : pool_level;
+    first = TRNG_ALT_POOL_SIZE - pool_head;
+    if(first > n)
+        first = n;
+    memcpy(buf, &pool[pool_head], first);
+    memcpy((uint8_t *)buf + first, pool, n - first);
+
+    /* Each byte is handed out once */
+    mbedtls_platform_zeroize(&pool[pool_head], first);
+    mbedtls_platform_zeroize(pool, n - first);
+
+    pool_head = (pool_head + n) % TRNG_ALT_POOL_SIZE;
+    pool_level -= n;
+    level = pool_level;
+    xTaskResumeAll();
+
+    if((level < TRNG_ALT_REFILL_LEVEL) && (refill_task != NULL))
+        xTaskNotifyGive(refill_task);
+
+    return n;
+}
+
+/**
+ * Read a 256-bit key straight from the pool. The CRYPTO PRNG is not used:
+ * its seed register is 32 bits wide, so a key it generates carries no more
+ * than 32 bits of entropy. If the pool runs short, wait a few ticks for the
+ * refill task.
+ *
+ * @param key eight words of output
+ * @return 0 on success, -1 if the TRNG failed or the pool stayed empty
+ */
+int trng_alt_key_read(uint32_t key[8])
+{
+    size_t got = 0;
+    int tries = TRNG_ALT_KEY_WAIT_TICKS;
+
+    if(trng_alt_init() != 0)
+        return -1;
+
+    for(;;)
+    {
+        got += trng_alt_read((uint8_t *)key + got, 32 - got);
+        if((got == 32) || (tries-- <= 0))
+            break;
+        vTaskDelay(1);
+    }
+
+    if(got != 32)
+    {
+        mbedtls_platform_zeroize(key, 32);
+        return -1;
+    }
+    return 0;
+}
+
+#if defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+/* Strong entropy source registered by mbedtls_entropy_init() */
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    (void)data;
+
+    if(trng_alt_init() != 0)
+        return MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+
+    *olen = trng_alt_read(output, len);
+    return 0;
+}
+#endif /* MBEDTLS_ENTROPY_HARDWARE_ALT */
@@ -0,0 +1,50 @@
+/**************************************************************************//**
+ * @file     trng_alt.h
+ * @brief    Buffered TRNG entropy pool shared by mbedTLS and key generation
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __TRNG_ALT_H__
+#define __TRNG_ALT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Random bytes kept ready, a multiple of the 16 bytes one TRNG command makes */
+#ifndef TRNG_ALT_POOL_SIZE
+#define TRNG_ALT_POOL_SIZE          1024
+#endif
+
+/* The refill task is woken when a read leaves fewer bytes than this */
+#ifndef TRNG_ALT_REFILL_LEVEL
+#define TRNG_ALT_REFILL_LEVEL       (TRNG_ALT_POOL_SIZE / 2)
+#endif
+
+/* The refill task only runs when nothing else wants the CPU */
+#ifndef TRNG_ALT_TASK_PRIORITY
+#define TRNG_ALT_TASK_PRIORITY      (tskIDLE_PRIORITY + 1)
+#endif
+
+#ifndef TRNG_ALT_TASK_STACK_SIZE
+#define TRNG_ALT_TASK_STACK_SIZE    512
+#endif
+
+/* Ticks trng_alt_key_read() waits for the refill task when the pool is short */
+#ifndef TRNG_ALT_KEY_WAIT_TICKS
+#define TRNG_ALT_KEY_WAIT_TICKS     10
+#endif
+
+int    trng_alt_init(void);
+size_t trng_alt_read(void *buf, size_t len);
+int    trng_alt_key_read(uint32_t key[8]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRNG_ALT_H__ */
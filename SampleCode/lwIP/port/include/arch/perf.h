@@ -32,7 +32,21 @@
 #ifndef __PERF_H__
 #define __PERF_H__
 
-#define PERF_START    /* null definition */
-#define PERF_STOP(x)  /* null definition */
+#include "NuMicro.h"
+
+/*
+ * Packet path profiling. When LWIP_PERF is set to 1 in lwipopts.h, every
+ * PERF_START/PERF_STOP pair in the lwIP core and in the EMAC port measures
+ * the elapsed generic timer ticks (12 MHz) and accumulates them per name.
+ * Call perf_dump() to print the table and perf_reset() to clear it.
+ */
+#define PERF_TICKS_PER_US   12
+
+#define PERF_START    uint64_t __perf_start = EL0_GetCurrentPhysicalValue()
+#define PERF_STOP(x)  perf_record(x, EL0_GetCurrentPhysicalValue() - __perf_start)
+
+void perf_record(const char *name, uint64_t ticks);
+void perf_reset(void);
+void perf_dump(void);
 
 #endif /* __PERF_H__ */
@@ -0,0 +1,27 @@
+/**************************************************************************//**
+ * @file     lwippools.h
+ * @brief    lwIP malloc pools used when MEM_USE_POOLS is enabled
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+
+/*
+ * No include guard: lwIP includes this file several times with different
+ * definitions of LWIP_MALLOC_MEMPOOL.
+ *
+ * Pools must be listed in ascending size. Sizes cover the typical PBUF_RAM
+ * requests on this port (struct pbuf is 24 bytes on AArch64, TCP/IP/Ethernet
+ * headers are 54 bytes):
+ *  - 128  : ARP, ICMP, pure TCP ACK/SYN/FIN segments
+ *  - 320  : DHCP/DNS/SNTP datagrams, short HTTP and MQTT messages
+ *  - 640  : segments to peers advertising the default 536-byte MSS
+ *  - 1600 : full TCP_MSS segments and maximum size UDP datagrams
+ */
+#if MEM_USE_POOLS
+LWIP_MALLOC_MEMPOOL_START
+LWIP_MALLOC_MEMPOOL(32, 128)
+LWIP_MALLOC_MEMPOOL(32, 320)
+LWIP_MALLOC_MEMPOOL(16, 640)
+LWIP_MALLOC_MEMPOOL(TCP_SND_QUEUELEN, 1600)
+LWIP_MALLOC_MEMPOOL_END
+#endif /* MEM_USE_POOLS */
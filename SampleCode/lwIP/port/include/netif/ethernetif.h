@@ -9,6 +9,16 @@
 
 #include "lwip/netif.h"
 
+/* Set LWIP_PTP to 1 in lwipopts.h to pass EMAC timestamps to the PTP slave (ptp.h) */
+#ifndef LWIP_PTP
+#define LWIP_PTP    0
+#endif
+
+/* Set LWIP_VLANIF to 1 in lwipopts.h to add 802.1Q VLAN netifs on top of EMAC0/1 (vlanif.h) */
+#ifndef LWIP_VLANIF
+#define LWIP_VLANIF 0
+#endif
+
 err_t ethernetif_init0(struct netif *netif);
 err_t ethernetif_init1(struct netif *netif);
 void ethernetif_input0(uint32_t packetCnt);
@@ -36,6 +36,7 @@ void EMAC_giveup_rx_desc_queue(EMACdevice *emacdev, u32 desc_mode);
 void EMAC_giveup_tx_desc_queue(EMACdevice *emacdev, u32 desc_mode);
 s32 EMAC_close(int intf);
 s32 EMAC_xmit_frames(struct sk_buff *skb, int intf, u32 offload_needed, u32 ts);
+struct sk_buff *EMAC_get_tx_skb(int intf);
 void EMAC_handle_transmit_over(int intf);
 uint32_t EMAC_handle_received_data(int intf, struct sk_buff *prskb);
 static void EMAC_powerup_mac(EMACdevice *emacdev);
@@ -47,7 +48,6 @@ extern void notify_rx_task(int intf);
 extern EMACdevice EMACdev[];
 extern u8 mac_addr0[];
 extern u8 mac_addr1[];
-extern struct sk_buff txbuf[];
 extern struct sk_buff rxbuf[];
 
 #endif /* __MA35H0_MAC_H__ */
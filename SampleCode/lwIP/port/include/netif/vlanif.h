@@ -0,0 +1,51 @@
+/**************************************************************************//**
+ * @file     vlanif.h
+ * @brief    IEEE 802.1Q VLAN virtual network interfaces on top of EMAC0/1
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __VLANIF_H__
+#define __VLANIF_H__
+
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+/*
+ * Each VLAN is an ordinary lwIP netif sharing the MAC address of its parent
+ * EMAC netif. Received tagged frames are demultiplexed by VID and passed to
+ * the matching VLAN netif without the tag; untagged frames keep going to the
+ * parent. On transmit the tag is inserted by the EMAC, so lwIP builds plain
+ * Ethernet frames for every interface.
+ *
+ * Usage:
+ *     static struct vlanif vlan10 = { &netif, 10, 0, 0 };
+ *     netif_add(&vnetif, &ip, &mask, &gw, &vlan10, vlanif_init, tcpip_input);
+ *
+ * The parent netif must be added before its VLAN netifs.
+ */
+
+#ifndef VLANIF_MAX
+#define VLANIF_MAX              4
+#endif
+
+#define VLANIF_TPID_STAG        0x88A8      /* 802.1ad service tag */
+
+/* Tag word programmed into the EMAC: PCP[15:13], VID[11:0], S-VLAN flag */
+#define VLANIF_TAG_SVLAN        0x10000
+#define VLANIF_TAG(vid, pcp)    ((((u32_t)(pcp) & 0x7) << 13) | ((u32_t)(vid) & 0xFFF))
+
+struct vlanif
+{
+    struct netif *parent;   /* EMAC netif the VLAN runs on    */
+    u16_t vid;              /* VLAN ID, 1..4094               */
+    u8_t  pcp;              /* Priority code point for TX     */
+    u8_t  svlan;            /* 1: S-VLAN (0x88A8), 0: C-VLAN  */
+};
+
+err_t vlanif_init(struct netif *netif);
+
+/* Called by ethernetif.c */
+void vlanif_input(struct netif *parent, struct pbuf *p);
+u32_t vlanif_tx_tag(struct netif *netif);
+
+#endif /* __VLANIF_H__ */
@@ -0,0 +1,68 @@
+/**************************************************************************//**
+ * @file     ptp.h
+ * @brief    IEEE 1588-2008 (PTPv2) ordinary clock slave on the EMAC timestamp unit
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __PTP_H__
+#define __PTP_H__
+
+#include "lwip/netif.h"
+
+/*
+ * Transport is UDP/IPv4 (IEEE 1588 Annex D), end-to-end delay mechanism,
+ * one-step or two-step masters. Sync and Delay_Req are timestamped by the
+ * EMAC; the slave disciplines the EMAC system time with a PI servo that
+ * drives the fine-update addend register.
+ */
+
+/* PTP reference clock of the EMAC timestamp unit (EPLL 500 MHz / 8) */
+#ifndef PTP_REF_CLK_HZ
+#define PTP_REF_CLK_HZ          62500000
+#endif
+
+#ifndef PTP_DOMAIN
+#define PTP_DOMAIN              0
+#endif
+
+/* Servo gains in 1/1000, tuned for one Sync per second */
+#ifndef PTP_SERVO_KP
+#define PTP_SERVO_KP            700
+#endif
+#ifndef PTP_SERVO_KI
+#define PTP_SERVO_KI            300
+#endif
+
+#define PTP_MAX_FREQ_PPB        500000      /* Servo output limit, +-500 ppm */
+#define PTP_STEP_THRESHOLD_NS   1000000     /* Step the clock above 1 ms offset */
+#define PTP_LOCK_THRESHOLD_NS   1000        /* Report locked below 1 us offset  */
+#define PTP_STATS_WINDOW        16          /* Sync intervals per statistics window */
+
+#define PTP_TASK_PRIORITY       (tskIDLE_PRIORITY + 5)
+#define PTP_TASK_STACKSIZE      (1024)
+
+struct ptp_stats
+{
+    int32_t  offset_ns;         /* Last offset from master (slave - master)  */
+    int32_t  offset_min_ns;     /* Minimum offset over the last window       */
+    int32_t  offset_max_ns;     /* Maximum offset over the last window       */
+    uint32_t offset_rms_ns;     /* RMS offset over the last window           */
+    uint32_t jitter_ns;         /* Offset standard deviation over the window */
+    int32_t  path_delay_ns;     /* Filtered mean path delay                  */
+    int32_t  freq_ppb;          /* Current frequency correction              */
+    uint32_t sync_count;
+    uint32_t delay_count;
+    uint32_t step_count;
+    uint8_t  locked;            /* 1 if |offset| < PTP_LOCK_THRESHOLD_NS over the window */
+    uint8_t  master_id[10];     /* Port identity of the selected master      */
+};
+
+int ptp_init(struct netif *netif, int intf);
+void ptp_get_stats(struct ptp_stats *stats);
+void ptp_get_time(uint32_t *sec, uint32_t *nsec);
+
+/* Called by ethernetif.c */
+int ptp_is_event_frame(const u8_t *frame, u16_t len);
+void ptp_rx_timestamp(const u8_t *frame, u16_t len, uint32_t sec, uint32_t nsec);
+
+#endif /* __PTP_H__ */
@@ -57,6 +57,19 @@
 #include "netif/ethernetif.h"
 #include "string.h"
 #include "lwipopts.h"
+#if LWIP_PTP
+#include "ptp.h"
+#endif
+#if LWIP_VLANIF
+#include "netif/vlanif.h"
+#endif
+
+/* Request a hardware transmit timestamp for PTP event messages only */
+#if LWIP_PTP
+#define ETH_TX_TS(frame, len)   ptp_is_event_frame((const u8_t *)(frame), (len))
+#else
+#define ETH_TX_TS(frame, len)   0
+#endif
 
 /* Define those to better describe your network interface. */
 #define IFNAME  'e'
@@ -75,7 +88,6 @@ struct sk_buff rxskbuf[NUM_OF_RXSKB]; // application buffer queue
 
 extern u8_t mac_addr0[6];
 extern u8_t mac_addr1[6];
-extern struct sk_buff txbuf[EMAC_CNT];
 extern struct sk_buff rxbuf[EMAC_CNT];
 
 static TaskHandle_t post_rx_task = NULL;
@@ -228,16 +240,18 @@ int32_t EMAC0_TransmitPkt(struct sk_buff *ptskb, uint8_t *pbuf, uint32_t len)
 
     if(ptskb == NULL)
     {
-        tskb = (struct sk_buff *)((uint64_t)&txbuf[EMACINTF0] | NON_CACHE);
+        tskb = EMAC_get_tx_skb(EMACINTF0);
+        if(tskb == NULL)
+            return -1;
 
         tskb->len = len;
         memcpy((uint8_t *)((u64)(tskb->data)), pbuf, len);
-        return EMAC_xmit_frames(tskb, EMACINTF0, offload_needed, 0);
+        return EMAC_xmit_frames(tskb, EMACINTF0, offload_needed, ETH_TX_TS(tskb->data, len));
     }
     else
     {
         ptskb->len = len;
-        return EMAC_xmit_frames(ptskb, EMACINTF0, offload_needed, 0);
+        return EMAC_xmit_frames(ptskb, EMACINTF0, offload_needed, ETH_TX_TS(ptskb->data, len));
     }
 }
 
@@ -253,19 +267,74 @@ int32_t EMAC1_TransmitPkt(struct sk_buff *ptskb, uint8_t *pbuf, uint32_t len)
 
     if(ptskb == NULL)
     {
-        tskb = (struct sk_buff *)((uint64_t)&txbuf[EMACINTF1] | NON_CACHE);
+        tskb = EMAC_get_tx_skb(EMACINTF1);
+        if(tskb == NULL)
+            return -1;
 
         tskb->len = len;
         memcpy((uint8_t *)((u64)(tskb->data)), pbuf, len);
-        return EMAC_xmit_frames(tskb, EMACINTF1, offload_needed, 0);
+        return EMAC_xmit_frames(tskb, EMACINTF1, offload_needed, ETH_TX_TS(tskb->data, len));
     }
     else
     {
         ptskb->len = len;
-        return EMAC_xmit_frames(ptskb, EMACINTF1, offload_needed, 0);
+        return EMAC_xmit_frames(ptskb, EMACINTF1, offload_needed, ETH_TX_TS(ptskb->data, len));
     }
 }
 
+#if LWIP_VLANIF
+/* VLAN tag word currently programmed into each EMAC, 0 for untagged */
+static u32_t tx_vlan_tag[EMAC_CNT];
+
+/**
+ * Select the VLAN tag the EMAC inserts for the next frame sent by netif.
+ * The tag register applies to every frame and may only be changed while
+ * the transmitter is idle, so the DMA is drained before switching; the
+ * calling thread sleeps while it drains. The register is left alone as
+ * long as one netif keeps sending.
+ *
+ * @param intf EMAC interface
+ * @param netif the parent netif or one of its VLAN netifs
+ * @return ERR_OK if the frame can be sent with the tag of netif,
+ *         ERR_IF if the queued frames did not drain; the tag is then left
+ *         unchanged and the frame must be dropped
+ */
+static err_t low_level_tx_vlan(int intf, struct netif *netif)
+{
+    EMACdevice *emacdev = &EMACdev[intf];
+    u32_t tag = vlanif_tx_tag(netif);
+    int i;
+
+    if(tag == tx_vlan_tag[intf])
+        return ERR_OK;
+
+    /* Wait up to 10 ms for the queued frames to go out. Sleep rather than
+       spin, the Tx interrupt and the other tasks keep running meanwhile. */
+    for(i = 0; *(volatile u32 *)&emacdev->BusyTxDesc != 0; i++)
+    {
+        if(i == 10)
+        {
+            LWIP_DEBUGF(NETIF_DEBUG, ("low_level_tx_vlan: Tx not idle\n"));
+            return ERR_IF;
+        }
+        sys_msleep(1);
+    }
+
+    if(tag == 0)
+        EMAC_vlan_no_act_enable(emacdev);
+    else if(tag & VLANIF_TAG_SVLAN)
+        EMAC_svlan_insertion_enable(emacdev, (u16)tag);
+    else
+        EMAC_cvlan_insertion_enable(emacdev, (u16)tag);
+
+    tx_vlan_tag[intf] = tag;
+    return ERR_OK;
+}
+#define ETH_TX_VLAN(intf, netif)    low_level_tx_vlan((intf), (netif))
+#else
+#define ETH_TX_VLAN(intf, netif)    ERR_OK
+#endif
+
 /**
  * This function should do the actual transmission of the packet. The packet is
  * contained in the pbuf that is passed to the function. This pbuf
@@ -287,7 +356,26 @@ low_level_output0(struct netif *netif, struct pbuf *p)
     struct pbuf *q;
     u8_t *buf = NULL;
     u16_t len = 0;
-    struct sk_buff *tskb = (struct sk_buff *)((uint64_t)&txbuf[EMACINTF0] | NON_CACHE);
+    struct sk_buff *tskb;
+
+    PERF_START;
+
+    if(ETH_TX_VLAN(EMACINTF0, netif) != ERR_OK)
+    {
+        /* frames for the old tag are still queued, do not retag them */
+        LINK_STATS_INC(link.drop);
+        PERF_STOP("low_level_output");
+        return ERR_IF;
+    }
+
+    /* the DMA still owns every Tx buffer, do not overwrite a queued frame */
+    tskb = EMAC_get_tx_skb(EMACINTF0);
+    if(tskb == NULL)
+    {
+        LINK_STATS_INC(link.drop);
+        PERF_STOP("low_level_output");
+        return ERR_IF;
+    }
 
 #if ETH_PAD_SIZE
     pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
@@ -307,6 +395,8 @@ low_level_output0(struct netif *netif, struct pbuf *p)
 
     LINK_STATS_INC(link.xmit);
 
+    PERF_STOP("low_level_output");
+
     return ERR_OK;
 }
 
@@ -331,7 +421,26 @@ low_level_output1(struct netif *netif, struct pbuf *p)
     struct pbuf *q;
     u8_t *buf = NULL;
     u16_t len = 0;
-    struct sk_buff *tskb = (struct sk_buff *)((uint64_t)&txbuf[EMACINTF1] | NON_CACHE);
+    struct sk_buff *tskb;
+
+    PERF_START;
+
+    if(ETH_TX_VLAN(EMACINTF1, netif) != ERR_OK)
+    {
+        /* frames for the old tag are still queued, do not retag them */
+        LINK_STATS_INC(link.drop);
+        PERF_STOP("low_level_output");
+        return ERR_IF;
+    }
+
+    /* the DMA still owns every Tx buffer, do not overwrite a queued frame */
+    tskb = EMAC_get_tx_skb(EMACINTF1);
+    if(tskb == NULL)
+    {
+        LINK_STATS_INC(link.drop);
+        PERF_STOP("low_level_output");
+        return ERR_IF;
+    }
 
 #if ETH_PAD_SIZE
     pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
@@ -351,6 +460,8 @@ low_level_output1(struct netif *netif, struct pbuf *p)
 
     LINK_STATS_INC(link.xmit);
 
+    PERF_STOP("low_level_output");
+
     return ERR_OK;
 }
 
@@ -417,6 +528,8 @@ ethernetif_input0(uint32_t packetCnt)
     struct pbuf *p;
     u16_t i;
 
+    PERF_START;
+
     for(i = 0; i < packetCnt; i++) {
         /* move received packet into a new pbuf */
 #if (LWIP_USING_HW_CHECKSUM == 1)
@@ -425,11 +538,16 @@ ethernetif_input0(uint32_t packetCnt)
         p = low_level_input(_netif0, (&rxskbuf[i])->len + 4, (&rxskbuf[i])->pData);
 #endif
         /* no packet could be read, silently ignore this */
-        if (p == NULL) return;
+        if (p == NULL) break;
 
         /* points to packet payload, which starts with an Ethernet header */
         ethhdr = p->payload;
 
+#if LWIP_PTP
+        if((&rxskbuf[i])->ts_sec | (&rxskbuf[i])->ts_subsec)
+            ptp_rx_timestamp(p->payload, p->len, (&rxskbuf[i])->ts_sec, (&rxskbuf[i])->ts_subsec);
+#endif
+
         switch (htons(ethhdr->type))
         {
         /* IP or ARP packet? */
@@ -449,12 +567,23 @@ ethernetif_input0(uint32_t packetCnt)
             }
             break;
 
+#if LWIP_VLANIF
+        /* 802.1Q/802.1ad tagged frame for one of the VLAN netifs */
+        case ETHTYPE_VLAN:
+        case VLANIF_TPID_STAG:
+            vlanif_input(_netif0, p);
+            p = NULL;
+            break;
+#endif
+
         default:
             pbuf_free(p);
             p = NULL;
             break;
         }
     }
+
+    PERF_STOP("ethernetif_input");
 }
 
 
@@ -474,6 +603,8 @@ ethernetif_input1(uint32_t packetCnt)
     struct pbuf *p;
     u16_t i;
 
+    PERF_START;
+
     for(i = 0; i < packetCnt; i++) {
         /* move received packet into a new pbuf */
 #if (LWIP_USING_HW_CHECKSUM == 1)
@@ -482,11 +613,16 @@ ethernetif_input1(uint32_t packetCnt)
         p = low_level_input(_netif1, (&rxskbuf[i])->len + 4, (&rxskbuf[i])->pData);
 #endif
         /* no packet could be read, silently ignore this */
-        if (p == NULL) return;
+        if (p == NULL) break;
 
         /* points to packet payload, which starts with an Ethernet header */
         ethhdr = p->payload;
 
+#if LWIP_PTP
+        if((&rxskbuf[i])->ts_sec | (&rxskbuf[i])->ts_subsec)
+            ptp_rx_timestamp(p->payload, p->len, (&rxskbuf[i])->ts_sec, (&rxskbuf[i])->ts_subsec);
+#endif
+
         switch (htons(ethhdr->type))
         {
         /* IP or ARP packet? */
@@ -506,12 +642,23 @@ ethernetif_input1(uint32_t packetCnt)
             }
             break;
 
+#if LWIP_VLANIF
+        /* 802.1Q/802.1ad tagged frame for one of the VLAN netifs */
+        case ETHTYPE_VLAN:
+        case VLANIF_TPID_STAG:
+            vlanif_input(_netif1, p);
+            p = NULL;
+            break;
+#endif
+
         default:
             pbuf_free(p);
             p = NULL;
             break;
         }
     }
+
+    PERF_STOP("ethernetif_input");
 }
 
 /**
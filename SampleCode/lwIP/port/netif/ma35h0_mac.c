@@ -12,10 +12,10 @@ static DmaDesc tx_desc[EMAC_CNT][TRANSMIT_DESC_SIZE] __attribute__ ((aligned (64
 static DmaDesc rx_desc[EMAC_CNT][RECEIVE_DESC_SIZE] __attribute__ ((aligned (64)));
 
 static struct sk_buff rx_buf[EMAC_CNT][RECEIVE_DESC_SIZE] __attribute__ ((aligned (64)));
+static struct sk_buff tx_buf[EMAC_CNT][TRANSMIT_DESC_SIZE] __attribute__ ((aligned (64)));
 
-// These 2 are accessable from application
-struct sk_buff txbuf[EMAC_CNT] __attribute__ ((aligned (64))); // set align to separate cacheable and non-cacheable data to different cache line.
-struct sk_buff rxbuf[EMAC_CNT] __attribute__ ((aligned (64)));
+// This is accessable from application
+struct sk_buff rxbuf[EMAC_CNT] __attribute__ ((aligned (64))); // set align to separate cacheable and non-cacheable data to different cache line.
 
 u8 mac_addr0[6] = DEFAULT_MAC0_ADDRESS;
 u8 mac_addr1[6] = DEFAULT_MAC1_ADDRESS;
@@ -387,6 +387,31 @@ s32 EMAC_xmit_frames(struct sk_buff *skb, int intf, u32 offload_needed, u32 ts)
     return 0;
 }
 
+/**
+ * @brief Get the frame buffer of the next free Tx descriptor.
+ * Each Tx descriptor owns one buffer, so a frame copied in here stays
+ * intact until the DMA has sent it, however many frames are queued.
+ * @param[in] intf EMAC interface
+ *          - \ref EMACINTF0
+ *          - \ref EMACINTF1
+ * @return The buffer to fill and pass to EMAC_xmit_frames(), or NULL if all
+ *         Tx descriptors are still owned by the DMA.
+ */
+struct sk_buff *EMAC_get_tx_skb(int intf)
+{
+    EMACdevice *emacdev = &EMACdev[intf];
+#ifdef CACHE_ON
+    DmaDesc *txdesc = (DmaDesc *)((u64)(emacdev->TxNextDesc) | NON_CACHE);
+#else
+    DmaDesc *txdesc = emacdev->TxNextDesc;
+#endif
+
+    if(!EMAC_is_desc_empty(emacdev, txdesc))
+        return NULL;
+
+    return (struct sk_buff *)((u64)&tx_buf[intf][emacdev->TxNext] | NON_CACHE);
+}
+
 /**
  * @brief Function to handle housekeeping after a packet is transmitted over the wire.
  * After the transmission of a packet DMA generates corresponding interrupt
@@ -431,12 +456,11 @@ void EMAC_handle_transmit_over(int intf)
             if(EMAC_is_desc_valid(status)) {
                 emacdev->NetStats.tx_bytes += length;
                 emacdev->NetStats.tx_packets++;
+                /* Keep the last captured timestamp until the owner of the
+                   timestamped frame (e.g. PTP Delay_Req) has read it */
                 if(status & DescTxTSStatus) {
-                    emacdev->tx_sec = time_stamp_high;
                     emacdev->tx_subsec = time_stamp_low;
-                } else {
-                    emacdev->tx_sec = 0;
-                    emacdev->tx_subsec = 0;
+                    emacdev->tx_sec = time_stamp_high;
                 }
             } else {
                 TR("Error in Status %08x\n",status);
@@ -559,8 +583,6 @@ uint32_t EMAC_handle_received_data(int intf, struct sk_buff *prskb)
                 rb->rdy = 1;
                 rb->len = len;
                 rb->pData = (void *)((u64)dma_addr1 | NON_CACHE);
-                ret++;
-                rb = (struct sk_buff *)rb + 1;
 
                 emacdev->NetStats.rx_packets++;
                 emacdev->NetStats.rx_bytes += len;
@@ -571,6 +593,10 @@ uint32_t EMAC_handle_received_data(int intf, struct sk_buff *prskb)
                     emacdev->rx_sec = 0;
                     emacdev->rx_subsec = 0;
                 }
+                rb->ts_sec = emacdev->rx_sec;
+                rb->ts_subsec = emacdev->rx_subsec;
+                ret++;
+                rb = (struct sk_buff *)rb + 1;
             } else {
                 /*Now the present skb should be set free*/
                 TR("s: %08x\n",status);
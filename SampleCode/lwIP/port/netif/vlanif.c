@@ -0,0 +1,164 @@
+/**************************************************************************//**
+ * @file     vlanif.c
+ * @brief    IEEE 802.1Q VLAN virtual network interfaces on top of EMAC0/1
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+
+#include "lwip/opt.h"
+
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/snmp.h"
+#include "lwip/stats.h"
+#include "netif/etharp.h"
+#include "netif/ethernetif.h"
+
+#if LWIP_VLANIF
+
+#include <string.h>
+#include "netif/vlanif.h"
+
+static struct netif *vlanif_table[VLANIF_MAX];
+
+/**
+ * Set up a VLAN netif. Pass this to netif_add() with a struct vlanif as the
+ * state argument. The VLAN netif reuses the parent's hardware address and
+ * link output function; the parent's low level output picks the tag from
+ * vlanif_tx_tag().
+ *
+ * @param netif the VLAN netif being added
+ * @return ERR_OK, ERR_ARG on a bad configuration or ERR_MEM if all
+ *         VLANIF_MAX entries are in use
+ */
+err_t vlanif_init(struct netif *netif)
+{
+    struct vlanif *vlan = (struct vlanif *)netif->state;
+    int i, slot = -1;
+
+    LWIP_ASSERT("netif != NULL", (netif != NULL));
+
+    if((vlan == NULL) || (vlan->parent == NULL) || (vlan->parent->linkoutput == NULL) ||
+       (vlan->vid == 0) || (vlan->vid >= 0xFFF))
+        return ERR_ARG;
+
+    for(i = 0; i < VLANIF_MAX; i++)
+    {
+        if(vlanif_table[i] == NULL)
+        {
+            if(slot < 0)
+                slot = i;
+            continue;
+        }
+        if((((struct vlanif *)vlanif_table[i]->state)->parent == vlan->parent) &&
+           (((struct vlanif *)vlanif_table[i]->state)->vid == vlan->vid))
+            return ERR_ARG;
+    }
+    if(slot < 0)
+    {
+        LWIP_DEBUGF(NETIF_DEBUG, ("vlanif_init: no free entry\n"));
+        return ERR_MEM;
+    }
+
+#if LWIP_NETIF_HOSTNAME
+    netif->hostname = vlan->parent->hostname;
+#endif /* LWIP_NETIF_HOSTNAME */
+
+    netif->name[0] = 'v';
+    netif->name[1] = '0' + slot;
+
+    netif->hwaddr_len = vlan->parent->hwaddr_len;
+    memcpy(netif->hwaddr, vlan->parent->hwaddr, netif->hwaddr_len);
+    netif->mtu = vlan->parent->mtu;
+    netif->flags = vlan->parent->flags & (NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_IGMP);
+    netif->flags |= NETIF_FLAG_LINK_UP;
+
+    netif->output = etharp_output;
+    netif->linkoutput = vlan->parent->linkoutput;
+
+    vlanif_table[slot] = netif;
+
+    return ERR_OK;
+}
+
+/**
+ * Tag word for frames sent on a netif, 0 for an untagged (parent) netif.
+ * Called by the EMAC low level output in the tcpip thread.
+ */
+u32_t vlanif_tx_tag(struct netif *netif)
+{
+    int i;
+
+    for(i = 0; i < VLANIF_MAX; i++)
+    {
+        if(vlanif_table[i] == netif)
+        {
+            struct vlanif *vlan = (struct vlanif *)netif->state;
+
+            return VLANIF_TAG(vlan->vid, vlan->pcp) | (vlan->svlan ? VLANIF_TAG_SVLAN : 0);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Demultiplex a tagged frame received on a parent netif. The tag is removed
+ * in place by moving the two MAC addresses over it, so the pbuf payload
+ * handed to the VLAN netif is a plain Ethernet frame. Frames for unknown
+ * VLANs are dropped.
+ *
+ * @param parent the EMAC netif the frame was received on
+ * @param p the received frame, starting with the Ethernet header
+ */
+void vlanif_input(struct netif *parent, struct pbuf *p)
+{
+    struct eth_hdr *ethhdr = (struct eth_hdr *)p->payload;
+    struct eth_vlan_hdr *vlanhdr;
+    struct netif *netif = NULL;
+    u16_t tpid, vid;
+    int i;
+
+    if(p->len < SIZEOF_ETH_HDR + SIZEOF_VLAN_HDR)
+        goto drop;
+
+    tpid = lwip_htons(ethhdr->type);
+    vlanhdr = (struct eth_vlan_hdr *)((u8_t *)p->payload + SIZEOF_ETH_HDR);
+    vid = VLAN_ID(vlanhdr);
+
+    for(i = 0; i < VLANIF_MAX; i++)
+    {
+        struct vlanif *vlan;
+
+        if(vlanif_table[i] == NULL)
+            continue;
+
+        vlan = (struct vlanif *)vlanif_table[i]->state;
+        if((vlan->parent == parent) && (vlan->vid == vid) &&
+           ((tpid == VLANIF_TPID_STAG) == (vlan->svlan != 0)))
+        {
+            netif = vlanif_table[i];
+            break;
+        }
+    }
+
+    if((netif == NULL) || !netif_is_up(netif))
+        goto drop;
+
+    /* Drop the 4-byte tag: DA/SA move up, the inner type becomes the type */
+    memmove((u8_t *)p->payload + SIZEOF_VLAN_HDR, p->payload, 2 * ETH_HWADDR_LEN);
+    pbuf_remove_header(p, SIZEOF_VLAN_HDR);
+
+    if(netif->input(p, netif) != ERR_OK)
+    {
+        LWIP_DEBUGF(NETIF_DEBUG, ("vlanif_input: IP input error\n"));
+        pbuf_free(p);
+    }
+    return;
+
+drop:
+    LINK_STATS_INC(link.drop);
+    pbuf_free(p);
+}
+
+#endif /* LWIP_VLANIF */
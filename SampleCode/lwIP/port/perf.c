@@ -0,0 +1,107 @@
+/**************************************************************************//**
+ * @file     perf.c
+ * @brief    lwIP packet path profiling for the MA35H0 port
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+
+/* lwIP includes. */
+#include "lwip/opt.h"
+
+#include "lwip/def.h"
+#include "lwip/sys.h"
+
+#if LWIP_PERF
+
+#include <string.h>
+
+#define PERF_MAX_ENTRIES    16
+
+struct perf_entry
+{
+    const char *name;
+    u32_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+};
+
+static struct perf_entry perf_table[PERF_MAX_ENTRIES];
+
+/**
+ * Accumulate one measurement. Called by PERF_STOP() from the tcpip thread and
+ * from the EMAC receive tasks, so the table update is done under
+ * SYS_ARCH_PROTECT. Names are string literals and are compared by address
+ * first to keep the hot path short.
+ */
+void perf_record(const char *name, uint64_t ticks)
+{
+    struct perf_entry *e = NULL;
+    int i;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    for(i = 0; i < PERF_MAX_ENTRIES; i++)
+    {
+        if(perf_table[i].name == NULL)
+        {
+            perf_table[i].name = name;
+            perf_table[i].min = ticks;
+            e = &perf_table[i];
+            break;
+        }
+        if((perf_table[i].name == name) || (strcmp(perf_table[i].name, name) == 0))
+        {
+            e = &perf_table[i];
+            break;
+        }
+    }
+
+    if(e != NULL)
+    {
+        e->count++;
+        e->total += ticks;
+        if(ticks < e->min)
+            e->min = ticks;
+        if(ticks > e->max)
+            e->max = ticks;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+void perf_reset(void)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    memset(perf_table, 0, sizeof(perf_table));
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+/**
+ * Print call count and average/min/max time in nanoseconds of every
+ * measured section.
+ */
+void perf_dump(void)
+{
+    struct perf_entry snap[PERF_MAX_ENTRIES];
+    int i;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    memcpy(snap, perf_table, sizeof(snap));
+    SYS_ARCH_UNPROTECT(lev);
+
+    sysprintf("%-20s %10s %10s %10s %10s\n", "section", "count", "avg(ns)", "min(ns)", "max(ns)");
+    for(i = 0; i < PERF_MAX_ENTRIES; i++)
+    {
+        if(snap[i].name == NULL)
+            break;
+        sysprintf("%-20s %10u %10u %10u %10u\n", snap[i].name, snap[i].count,
+                  (u32_t)((snap[i].total * 1000) / PERF_TICKS_PER_US / snap[i].count),
+                  (u32_t)((snap[i].min * 1000) / PERF_TICKS_PER_US),
+                  (u32_t)((snap[i].max * 1000) / PERF_TICKS_PER_US));
+    }
+}
+
+#endif /* LWIP_PERF */
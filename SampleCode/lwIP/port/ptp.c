@@ -0,0 +1,688 @@
+/**************************************************************************//**
+ * @file     ptp.c
+ * @brief    IEEE 1588-2008 (PTPv2) ordinary clock slave on the EMAC timestamp unit
+ *
+ * @copyright (C) 2023 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+
+/* lwIP includes. */
+#include "lwip/opt.h"
+
+#include "lwip/def.h"
+#include "lwip/sys.h"
+#include "lwip/udp.h"
+#include "lwip/igmp.h"
+#include "lwip/tcpip.h"
+#include "netif/ethernetif.h"
+
+#if LWIP_PTP
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "netif/ma35h0_mac.h"
+#include "ptp.h"
+#include <string.h>
+
+#define PTP_EVENT_PORT          319
+#define PTP_GENERAL_PORT        320
+#define PTP_VERSION             2
+#define PTP_HDR_LEN             34
+#define PTP_DELAY_REQ_LEN       44
+#define PTP_MSG_MAX             64
+#define PTP_FLAG0_TWO_STEP      0x02
+
+#define PTP_NS_PER_SEC          1000000000LL
+
+#define PTP_RX_TS_RING          8
+#define PTP_QUEUE_LEN           8
+#define PTP_ANNOUNCE_TIMEOUT    pdMS_TO_TICKS(6000)  /* 3 x default 2 s announce interval */
+#define PTP_TX_TS_TIMEOUT       pdMS_TO_TICKS(10)
+
+/* Offsets in the common message header */
+#define PTP_OFS_FLAGS           6
+#define PTP_OFS_CORRECTION      8
+#define PTP_OFS_SOURCE_PORT     20
+#define PTP_OFS_SEQUENCE        30
+#define PTP_OFS_LOG_INTERVAL    33
+#define PTP_OFS_TIMESTAMP       34      /* origin/precise origin/receive timestamp */
+#define PTP_OFS_REQ_PORT        44      /* Delay_Resp requestingPortIdentity */
+#define PTP_OFS_GM_PRIORITY1    47      /* Announce priority1 .. grandmasterIdentity */
+#define PTP_GM_DATASET_LEN      14
+
+struct ptp_rx_ts
+{
+    u8_t type;
+    u16_t seq;
+    int64_t ts;
+};
+
+struct ptp_msg
+{
+    u16_t len;
+    int64_t rx_ts;      /* Hardware receive timestamp of event messages, 0 if none */
+    u8_t buf[PTP_MSG_MAX];
+};
+
+static struct
+{
+    struct netif *netif;
+    EMACdevice *emacdev;
+    struct udp_pcb *event_pcb;
+    struct udp_pcb *general_pcb;
+    QueueHandle_t queue;
+    u8_t port_id[10];
+    u32_t base_addend;
+
+    /* Selected master */
+    u8_t has_master;
+    u8_t master_id[10];
+    u8_t master_dataset[PTP_GM_DATASET_LEN];
+    TickType_t last_announce;
+
+    /* Sync / Follow_Up */
+    u8_t sync_pending;
+    u8_t sync_valid;
+    u16_t sync_seq;
+    int64_t t1, t2, sync_corr;
+
+    /* Delay_Req / Delay_Resp */
+    u8_t delay_pending;
+    u16_t delay_seq;
+    int64_t t3;
+    TickType_t last_delay_req;
+    TickType_t delay_req_interval;
+    u8_t path_delay_valid;
+    int64_t path_delay;
+
+    /* Servo */
+    int64_t drift_ppb;
+    int32_t freq_ppb;
+
+    /* Statistics window */
+    u32_t win_cnt;
+    u8_t win_locked;
+    int32_t win_min, win_max;
+    int64_t win_sum;
+    uint64_t win_sumsq;
+    struct ptp_stats stats;
+} ptp;
+
+static struct ptp_rx_ts rx_ts_ring[PTP_RX_TS_RING];
+static u32_t rx_ts_idx;
+
+static u16_t ptp_get16(const u8_t *p)
+{
+    return (u16_t)((p[0] << 8) | p[1]);
+}
+
+static int64_t ptp_get_correction(const u8_t *p)
+{
+    int64_t v = 0;
+    int i;
+
+    for(i = 0; i < 8; i++)
+        v = (v << 8) | p[i];
+
+    return v >> 16; /* scaled nanoseconds to nanoseconds */
+}
+
+static int64_t ptp_get_timestamp(const u8_t *p)
+{
+    int64_t sec = 0;
+    u32_t nsec;
+    int i;
+
+    for(i = 0; i < 6; i++)
+        sec = (sec << 8) | p[i];
+    nsec = ((u32_t)p[6] << 24) | ((u32_t)p[7] << 16) | ((u32_t)p[8] << 8) | p[9];
+
+    return sec * PTP_NS_PER_SEC + nsec;
+}
+
+static uint32_t ptp_isqrt(uint64_t v)
+{
+    uint64_t r = 0, b = (uint64_t)1 << 62;
+
+    while(b > v)
+        b >>= 2;
+    while(b != 0)
+    {
+        if(v >= r + b)
+        {
+            v -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+            r >>= 1;
+        b >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+/* Return the PTP message inside an Ethernet/IPv4/UDP event frame, or NULL */
+static const u8_t *ptp_event_payload(const u8_t *frame, u16_t len)
+{
+    const u8_t *udp;
+    u16_t ihl;
+
+    if(len < 14 + 20 + 8 + PTP_HDR_LEN)
+        return NULL;
+    if((frame[12] != 0x08) || (frame[13] != 0x00) || ((frame[14] >> 4) != 4))
+        return NULL;
+    if(frame[14 + 9] != IP_PROTO_UDP)
+        return NULL;
+    ihl = (frame[14] & 0x0f) * 4;
+    if(len < 14 + ihl + 8 + PTP_HDR_LEN)
+        return NULL;
+    udp = frame + 14 + ihl;
+    if(ptp_get16(&udp[2]) != PTP_EVENT_PORT)
+        return NULL;
+
+    return udp + 8;
+}
+
+/**
+ * Called by low-level transmit to decide whether the frame needs a hardware
+ * transmit timestamp.
+ */
+int ptp_is_event_frame(const u8_t *frame, u16_t len)
+{
+    if(ptp.emacdev == NULL)
+        return 0;
+
+    return (ptp_event_payload(frame, len) != NULL) ? 1 : 0;
+}
+
+/**
+ * Called by ethernetif_input for every timestamped frame before it is queued
+ * to the tcpip thread. Event message timestamps are kept in a small ring and
+ * matched to the message by type and sequence id in ptp_recv().
+ */
+void ptp_rx_timestamp(const u8_t *frame, u16_t len, uint32_t sec, uint32_t nsec)
+{
+    const u8_t *msg;
+    struct ptp_rx_ts *e;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    if(ptp.emacdev == NULL)
+        return;
+
+    msg = ptp_event_payload(frame, len);
+    if(msg == NULL)
+        return;
+
+    SYS_ARCH_PROTECT(lev);
+    e = &rx_ts_ring[rx_ts_idx++ % PTP_RX_TS_RING];
+    e->type = msg[0] & 0x0f;
+    e->seq = ptp_get16(&msg[PTP_OFS_SEQUENCE]);
+    e->ts = (int64_t)sec * PTP_NS_PER_SEC + nsec;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+static int64_t ptp_lookup_rx_ts(u8_t type, u16_t seq)
+{
+    int64_t ts = 0;
+    int i;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    for(i = 0; i < PTP_RX_TS_RING; i++)
+    {
+        if((rx_ts_ring[i].ts != 0) && (rx_ts_ring[i].type == type) && (rx_ts_ring[i].seq == seq))
+        {
+            ts = rx_ts_ring[i].ts;
+            rx_ts_ring[i].ts = 0;
+            break;
+        }
+    }
+    SYS_ARCH_UNPROTECT(lev);
+
+    return ts;
+}
+
+/* Runs in the tcpip thread; hand the message over to the PTP task */
+static void ptp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    struct ptp_msg msg;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    msg.len = pbuf_copy_partial(p, msg.buf, sizeof(msg.buf), 0);
+    pbuf_free(p);
+
+    if(msg.len < PTP_HDR_LEN)
+        return;
+    if(((msg.buf[1] & 0x0f) != PTP_VERSION) || (msg.buf[4] != PTP_DOMAIN))
+        return;
+
+    msg.rx_ts = 0;
+    if(pcb == ptp.event_pcb)
+    {
+        msg.rx_ts = ptp_lookup_rx_ts(msg.buf[0] & 0x0f, ptp_get16(&msg.buf[PTP_OFS_SEQUENCE]));
+        if(msg.rx_ts == 0)
+            return; /* event message without hardware timestamp is useless */
+    }
+
+    xQueueSend(ptp.queue, &msg, 0);
+}
+
+static void ptp_read_time(int64_t *now)
+{
+    u16_t hi;
+    u32_t sec, nsec, sec2;
+
+    /* Re-read seconds to catch a rollover between the two registers */
+    do
+    {
+        EMAC_TS_read_timestamp(ptp.emacdev, &hi, &sec, &nsec);
+        sec2 = EMAC_READ((u64)&ptp.emacdev->MacBase->TSSec);
+    } while(sec != sec2);
+
+    *now = (int64_t)sec * PTP_NS_PER_SEC + nsec;
+}
+
+static void ptp_step(int64_t delta)
+{
+    int64_t now;
+
+    ptp_read_time(&now);
+    now += delta;
+    if(now < 0)
+        now = 0;
+    EMAC_TS_timestamp_init(ptp.emacdev, (u32_t)(now / PTP_NS_PER_SEC), (u32_t)(now % PTP_NS_PER_SEC));
+
+    /* Timestamps taken before the step are meaningless now */
+    ptp.sync_pending = 0;
+    ptp.sync_valid = 0;
+    ptp.delay_pending = 0;
+    ptp.drift_ppb = 0;
+    ptp.stats.step_count++;
+}
+
+static void ptp_set_freq(int32_t ppb)
+{
+    int64_t addend = (int64_t)ptp.base_addend + ((int64_t)ptp.base_addend * ppb) / PTP_NS_PER_SEC;
+
+    EMAC_TS_addend_update(ptp.emacdev, (u32_t)addend);
+    ptp.freq_ppb = ppb;
+}
+
+static void ptp_update_stats(int32_t offset)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    if(ptp.win_cnt == 0)
+    {
+        ptp.win_min = ptp.win_max = offset;
+        ptp.win_sum = 0;
+        ptp.win_sumsq = 0;
+        ptp.win_locked = 1;
+    }
+    if(offset < ptp.win_min)
+        ptp.win_min = offset;
+    if(offset > ptp.win_max)
+        ptp.win_max = offset;
+    if((offset >= PTP_LOCK_THRESHOLD_NS) || (offset <= -PTP_LOCK_THRESHOLD_NS))
+        ptp.win_locked = 0;
+    ptp.win_sum += offset;
+    ptp.win_sumsq += (uint64_t)((int64_t)offset * offset);
+    ptp.win_cnt++;
+
+    SYS_ARCH_PROTECT(lev);
+    ptp.stats.offset_ns = offset;
+    ptp.stats.path_delay_ns = (int32_t)ptp.path_delay;
+    ptp.stats.freq_ppb = ptp.freq_ppb;
+    if(ptp.win_cnt == PTP_STATS_WINDOW)
+    {
+        int64_t mean = ptp.win_sum / PTP_STATS_WINDOW;
+        uint64_t meansq = ptp.win_sumsq / PTP_STATS_WINDOW;
+        uint64_t var = meansq - (uint64_t)(mean * mean);
+
+        ptp.stats.offset_min_ns = ptp.win_min;
+        ptp.stats.offset_max_ns = ptp.win_max;
+        ptp.stats.offset_rms_ns = ptp_isqrt(meansq);
+        ptp.stats.jitter_ns = ptp_isqrt(var);
+        ptp.stats.locked = ptp.win_locked;
+        ptp.win_cnt = 0;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+/* PI servo: the output is the frequency correction applied to the addend */
+static void ptp_servo(int64_t offset)
+{
+    int64_t adj;
+
+    if((offset > PTP_STEP_THRESHOLD_NS) || (offset < -PTP_STEP_THRESHOLD_NS))
+    {
+        ptp_step(-offset);
+        return;
+    }
+
+    ptp.drift_ppb += offset * PTP_SERVO_KI / 1000;
+    if(ptp.drift_ppb > PTP_MAX_FREQ_PPB)
+        ptp.drift_ppb = PTP_MAX_FREQ_PPB;
+    else if(ptp.drift_ppb < -PTP_MAX_FREQ_PPB)
+        ptp.drift_ppb = -PTP_MAX_FREQ_PPB;
+
+    adj = offset * PTP_SERVO_KP / 1000 + ptp.drift_ppb;
+    if(adj > PTP_MAX_FREQ_PPB)
+        adj = PTP_MAX_FREQ_PPB;
+    else if(adj < -PTP_MAX_FREQ_PPB)
+        adj = -PTP_MAX_FREQ_PPB;
+
+    /* Positive offset: the slave runs ahead and has to slow down */
+    ptp_set_freq((int32_t)-adj);
+    ptp_update_stats((int32_t)offset);
+}
+
+static void ptp_send_delay_req(void)
+{
+    volatile u32_t *tx_sec = &ptp.emacdev->tx_sec;
+    volatile u32_t *tx_subsec = &ptp.emacdev->tx_subsec;
+    struct pbuf *p;
+    u8_t *m;
+    ip_addr_t dst;
+    err_t err;
+    TickType_t start;
+
+    p = pbuf_alloc(PBUF_TRANSPORT, PTP_DELAY_REQ_LEN, PBUF_RAM);
+    if(p == NULL)
+        return;
+
+    m = (u8_t *)p->payload;
+    memset(m, 0, PTP_DELAY_REQ_LEN);
+    m[0] = Delay_Req;
+    m[1] = PTP_VERSION;
+    m[3] = PTP_DELAY_REQ_LEN;
+    m[4] = PTP_DOMAIN;
+    memcpy(&m[PTP_OFS_SOURCE_PORT], ptp.port_id, sizeof(ptp.port_id));
+    ptp.delay_seq++;
+    m[PTP_OFS_SEQUENCE] = (u8_t)(ptp.delay_seq >> 8);
+    m[PTP_OFS_SEQUENCE + 1] = (u8_t)ptp.delay_seq;
+    m[32] = 1;      /* controlField: Delay_Req */
+    m[PTP_OFS_LOG_INTERVAL] = 0x7f;
+
+    /* EMAC_handle_transmit_over() stores the timestamp of the frame */
+    *tx_sec = 0;
+    *tx_subsec = 0;
+    IP_ADDR4(&dst, 224, 0, 1, 129);
+    LOCK_TCPIP_CORE();
+    err = udp_sendto(ptp.event_pcb, p, &dst, PTP_EVENT_PORT);
+    UNLOCK_TCPIP_CORE();
+    pbuf_free(p);
+    ptp.last_delay_req = xTaskGetTickCount();
+    if(err != ERR_OK)
+        return;
+
+    start = xTaskGetTickCount();
+    while((*tx_sec | *tx_subsec) == 0)
+    {
+        if((xTaskGetTickCount() - start) > PTP_TX_TS_TIMEOUT)
+            return;
+        vTaskDelay(1);
+    }
+    ptp.t3 = (int64_t)*tx_sec * PTP_NS_PER_SEC + *tx_subsec;
+    ptp.delay_pending = 1;
+}
+
+static void ptp_sync_complete(void)
+{
+    int64_t offset;
+
+    ptp.sync_valid = 1;
+    ptp.stats.sync_count++;
+
+    offset = ptp.t2 - ptp.t1 - ptp.sync_corr;
+    if(ptp.path_delay_valid)
+        ptp_servo(offset - ptp.path_delay);
+    else if((offset > PTP_STEP_THRESHOLD_NS) || (offset < -PTP_STEP_THRESHOLD_NS))
+        ptp_step(-offset); /* coarse alignment before the first delay measurement */
+
+    if(ptp.sync_valid && ((xTaskGetTickCount() - ptp.last_delay_req) >= ptp.delay_req_interval))
+        ptp_send_delay_req();
+}
+
+static void ptp_handle_announce(const struct ptp_msg *msg)
+{
+    const u8_t *src = &msg->buf[PTP_OFS_SOURCE_PORT];
+    const u8_t *ds = &msg->buf[PTP_OFS_GM_PRIORITY1];
+
+    if(msg->len < PTP_OFS_GM_PRIORITY1 + PTP_GM_DATASET_LEN)
+        return;
+
+    /* Simplified BMCA: keep the current master unless a better grandmaster
+       (priority1, clockQuality, priority2, identity) is announced */
+    if(ptp.has_master && memcmp(src, ptp.master_id, sizeof(ptp.master_id)) != 0)
+    {
+        if(memcmp(ds, ptp.master_dataset, PTP_GM_DATASET_LEN) >= 0)
+            return;
+    }
+
+    if(!ptp.has_master || memcmp(src, ptp.master_id, sizeof(ptp.master_id)) != 0)
+    {
+        memcpy(ptp.master_id, src, sizeof(ptp.master_id));
+        memcpy(ptp.stats.master_id, src, sizeof(ptp.master_id));
+        ptp.sync_pending = 0;
+        ptp.sync_valid = 0;
+        ptp.delay_pending = 0;
+        ptp.path_delay_valid = 0;
+        ptp.has_master = 1;
+    }
+    memcpy(ptp.master_dataset, ds, PTP_GM_DATASET_LEN);
+    ptp.last_announce = xTaskGetTickCount();
+}
+
+static void ptp_handle(const struct ptp_msg *msg)
+{
+    const u8_t *m = msg->buf;
+    u8_t type = m[0] & 0x0f;
+    u16_t seq = ptp_get16(&m[PTP_OFS_SEQUENCE]);
+    int64_t t4, delay;
+    int8_t log_interval;
+
+    if(type == Announce)
+    {
+        ptp_handle_announce(msg);
+        return;
+    }
+
+    if(!ptp.has_master || memcmp(&m[PTP_OFS_SOURCE_PORT], ptp.master_id, sizeof(ptp.master_id)) != 0)
+        return;
+
+    switch(type)
+    {
+    case SYNC:
+        if(msg->len < PTP_OFS_TIMESTAMP + 10)
+            break;
+        ptp.sync_seq = seq;
+        ptp.t2 = msg->rx_ts;
+        ptp.sync_corr = ptp_get_correction(&m[PTP_OFS_CORRECTION]);
+        if(m[PTP_OFS_FLAGS] & PTP_FLAG0_TWO_STEP)
+        {
+            ptp.sync_pending = 1;
+        }
+        else
+        {
+            ptp.sync_pending = 0;
+            ptp.t1 = ptp_get_timestamp(&m[PTP_OFS_TIMESTAMP]);
+            ptp_sync_complete();
+        }
+        break;
+
+    case Follow_up:
+        if(!ptp.sync_pending || (seq != ptp.sync_seq) || (msg->len < PTP_OFS_TIMESTAMP + 10))
+            break;
+        ptp.sync_pending = 0;
+        ptp.t1 = ptp_get_timestamp(&m[PTP_OFS_TIMESTAMP]);
+        ptp.sync_corr += ptp_get_correction(&m[PTP_OFS_CORRECTION]);
+        ptp_sync_complete();
+        break;
+
+    case Delay_Resp:
+        if(!ptp.delay_pending || !ptp.sync_valid || (seq != ptp.delay_seq) || (msg->len < PTP_OFS_REQ_PORT + 10))
+            break;
+        if(memcmp(&m[PTP_OFS_REQ_PORT], ptp.port_id, sizeof(ptp.port_id)) != 0)
+            break;
+        ptp.delay_pending = 0;
+        t4 = ptp_get_timestamp(&m[PTP_OFS_TIMESTAMP]);
+        delay = ((ptp.t2 - ptp.t1 - ptp.sync_corr) + (t4 - ptp.t3 - ptp_get_correction(&m[PTP_OFS_CORRECTION]))) / 2;
+        if(delay < 0)
+            break;
+        if(!ptp.path_delay_valid)
+        {
+            ptp.path_delay = delay;
+            ptp.path_delay_valid = 1;
+        }
+        else
+        {
+            ptp.path_delay += (delay - ptp.path_delay) / 8;
+        }
+        ptp.stats.delay_count++;
+
+        /* logMinDelayReqInterval, limited to 1/16 s .. 16 s */
+        log_interval = (int8_t)m[PTP_OFS_LOG_INTERVAL];
+        if(log_interval < -4)
+            log_interval = -4;
+        if(log_interval > 4)
+            log_interval = 4;
+        ptp.delay_req_interval = (log_interval >= 0) ? (pdMS_TO_TICKS(1000) << log_interval) : (pdMS_TO_TICKS(1000) >> -log_interval);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void ptp_task(void *pvParameters)
+{
+    struct ptp_msg msg;
+
+    (void)pvParameters;
+
+    for(;;)
+    {
+        if(xQueueReceive(ptp.queue, &msg, pdMS_TO_TICKS(100)) == pdPASS)
+            ptp_handle(&msg);
+
+        if(ptp.has_master && ((xTaskGetTickCount() - ptp.last_announce) > PTP_ANNOUNCE_TIMEOUT))
+        {
+            ptp.has_master = 0;
+            ptp.stats.locked = 0;
+        }
+    }
+}
+
+/**
+ * Enable the EMAC timestamp unit and start the PTP slave on the netif.
+ *
+ * @param netif the lwIP network interface, already added and up
+ * @param intf EMAC interface of the netif (EMACINTF0 or EMACINTF1)
+ * @return 0 on success, -1 on failure
+ */
+int ptp_init(struct netif *netif, int intf)
+{
+    EMACdevice *emacdev = &EMACdev[intf];
+    u32_t ssinc;
+#if LWIP_IGMP
+    ip4_addr_t group;
+#endif
+
+    memset(&ptp, 0, sizeof(ptp));
+    memset(rx_ts_ring, 0, sizeof(rx_ts_ring));
+
+    /* clockIdentity is the EUI-64 derived from the MAC address, port number 1 */
+    ptp.port_id[0] = netif->hwaddr[0];
+    ptp.port_id[1] = netif->hwaddr[1];
+    ptp.port_id[2] = netif->hwaddr[2];
+    ptp.port_id[3] = 0xFF;
+    ptp.port_id[4] = 0xFE;
+    ptp.port_id[5] = netif->hwaddr[3];
+    ptp.port_id[6] = netif->hwaddr[4];
+    ptp.port_id[7] = netif->hwaddr[5];
+    ptp.port_id[9] = 1;
+    ptp.delay_req_interval = pdMS_TO_TICKS(1000);
+
+    /* PTPv2 over IPv4, event messages only, ordinary clock slave, 1 ns sub-second resolution */
+    EMAC_TS_ENABLE(emacdev);
+    EMAC_TS_ROLLOVER_ENABLE(emacdev);
+    EMAC_TS_PTPV2(emacdev);
+    EMAC_TS_IPV4_ENABLE(emacdev);
+    EMAC_TS_EVENT_ENABLE(emacdev);
+    EMAC_TS_set_clk_type(emacdev, EmacTSOrdClk);
+
+    /* TSCFUPDT set selects the fine (addend) update method. The accumulator
+       overflows at half the reference clock and adds ssinc ns each time. */
+    EMAC_SETBITS((u64)&emacdev->MacBase->TSControl, EMAC_TSControl_TSCFUPDT_Msk);
+    ssinc = (2 * 1000000000UL + PTP_REF_CLK_HZ - 1) / PTP_REF_CLK_HZ;
+    EMAC_TS_subsecond_incr_init(emacdev, ssinc);
+    ptp.base_addend = (u32_t)((1000000000ULL << 32) / ((uint64_t)ssinc * PTP_REF_CLK_HZ));
+    if(EMAC_TS_addend_update(emacdev, ptp.base_addend) < 0)
+        return -1;
+    if(EMAC_TS_timestamp_init(emacdev, 0, 0) < 0)
+        return -1;
+
+    /* Sync/Follow_Up/Delay_Resp are sent to 224.0.1.129 */
+    EMAC_MULTICAST_ENABLE(emacdev);
+
+    ptp.queue = xQueueCreate(PTP_QUEUE_LEN, sizeof(struct ptp_msg));
+    if(ptp.queue == NULL)
+        return -1;
+
+    LOCK_TCPIP_CORE();
+    ptp.event_pcb = udp_new();
+    ptp.general_pcb = udp_new();
+    if((ptp.event_pcb == NULL) || (ptp.general_pcb == NULL))
+    {
+        UNLOCK_TCPIP_CORE();
+        return -1;
+    }
+    udp_bind(ptp.event_pcb, IP_ADDR_ANY, PTP_EVENT_PORT);
+    udp_bind(ptp.general_pcb, IP_ADDR_ANY, PTP_GENERAL_PORT);
+    udp_recv(ptp.event_pcb, ptp_recv, NULL);
+    udp_recv(ptp.general_pcb, ptp_recv, NULL);
+#if LWIP_IGMP
+    IP4_ADDR(&group, 224, 0, 1, 129);
+    igmp_joingroup_netif(netif, &group);
+#endif
+    UNLOCK_TCPIP_CORE();
+
+    ptp.netif = netif;
+    ptp.emacdev = emacdev;
+
+    if(xTaskCreate(ptp_task, "PTP", PTP_TASK_STACKSIZE, NULL, PTP_TASK_PRIORITY, NULL) != pdPASS)
+        return -1;
+
+    return 0;
+}
+
+/**
+ * Copy the latest servo statistics. Window values are refreshed every
+ * PTP_STATS_WINDOW Sync messages.
+ */
+void ptp_get_stats(struct ptp_stats *stats)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    memcpy(stats, &ptp.stats, sizeof(*stats));
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+/**
+ * Read the disciplined EMAC system time.
+ */
+void ptp_get_time(uint32_t *sec, uint32_t *nsec)
+{
+    int64_t now = 0;
+
+    if(ptp.emacdev != NULL)
+        ptp_read_time(&now);
+    *sec = (uint32_t)(now / PTP_NS_PER_SEC);
+    *nsec = (uint32_t)(now % PTP_NS_PER_SEC);
+}
+
+#endif /* LWIP_PTP */